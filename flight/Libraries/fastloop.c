@@ -0,0 +1,164 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       fastloop.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @brief      Direct hand off of the control loop data between tasks
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * Normally every gyro sample reaches the PIDs through GyrosSet, the UAVO event
+ * queue and GyrosGet, and the PID output reaches the mixer the same way again
+ * through ActuatorDesired. Each hop copies the object under its mutex and
+ * dispatches an event to every listener.
+ *
+ * In fast loop mode the samples are instead passed through one lock free
+ * single producer, single consumer slot per hop and the consumer is woken
+ * with a semaphore. Each sample overwrites the one before, so the consumer
+ * always gets the newest one and falling behind never adds latency. The
+ * sequence count of a slot is odd while the producer writes it, the consumer
+ * copies the sample again when the count changed under it.
+ */
+
+#include "openpilot.h"
+#include "fastloop.h"
+#include "pios_semaphore.h"
+#include "actuatordesired.h"
+
+// Private types
+struct fastloop_channel_state {
+	uint8_t *slot;
+	volatile uint32_t seq;		// written by the producer only
+	uint32_t received_seq;		// of the last sample the consumer took
+	struct pios_semaphore *sema;
+	uint16_t size;
+};
+
+// Private variables
+static const uint16_t record_sizes[FASTLOOP_NUM_CHANNELS] = {
+	[FASTLOOP_GYROS] = sizeof(float[3]),
+	[FASTLOOP_ACTUATOR] = sizeof(ActuatorDesiredData),
+};
+static struct fastloop_channel_state channels[FASTLOOP_NUM_CHANNELS];
+static bool enabled;
+
+/**
+ * Switch the control loop to the fast loop hand offs. Must be called while the
+ * modules are initialized, before their tasks start.
+ * @return 0 on success, -1 if the buffers cannot be allocated
+ */
+int32_t FastLoopEnable(void)
+{
+	if (enabled)
+		return 0;
+
+	for (uint32_t i = 0; i < FASTLOOP_NUM_CHANNELS; i++) {
+		struct fastloop_channel_state *channel = &channels[i];
+		channel->size = record_sizes[i];
+
+		channel->slot = PIOS_malloc(channel->size);
+		channel->sema = PIOS_Semaphore_Create();
+		if (channel->slot == NULL || channel->sema == NULL)
+			return -1;
+
+		channel->seq = 0;
+		channel->received_seq = 0;
+	}
+
+	enabled = true;
+	return 0;
+}
+
+/**
+ * @return true when the control loop uses the fast loop hand offs
+ */
+bool FastLoopEnabled(void)
+{
+	return enabled;
+}
+
+/**
+ * Pass a sample on to the consumer of a channel, replacing any sample it has
+ * not taken yet. Never blocks.
+ * @param[in] channel the hand off to use
+ * @param[in] data the sample, of the size the channel carries
+ * @return true if sent, false if not enabled
+ */
+bool FastLoopSend(enum fastloop_channel channel, const void *data)
+{
+	if (!enabled)
+		return false;
+
+	struct fastloop_channel_state *ch = &channels[channel];
+
+	ch->seq++;
+	__sync_synchronize();
+	memcpy(ch->slot, data, ch->size);
+	__sync_synchronize();
+	ch->seq++;
+
+	PIOS_Semaphore_Give(ch->sema);
+
+	return true;
+}
+
+/**
+ * Wait for the newest sample on a channel
+ * @param[in] channel the hand off to use
+ * @param[out] data the sample, of the size the channel carries
+ * @param[in] timeout_ms how long to wait for a sample
+ * @return true if a sample was received, false on timeout or if not enabled
+ */
+bool FastLoopReceive(enum fastloop_channel channel, void *data, uint32_t timeout_ms)
+{
+	if (!enabled)
+		return false;
+
+	struct fastloop_channel_state *ch = &channels[channel];
+
+	uint32_t seq;
+	while (1) {
+		seq = ch->seq;
+
+		// Wait when there is no new sample or the producer is in the middle
+		// of writing one, it gives the semaphore once done. The semaphore may
+		// also still be given for samples that were already taken.
+		if (seq == ch->received_seq || (seq & 1)) {
+			if (PIOS_Semaphore_Take(ch->sema, timeout_ms) != true)
+				return false;
+			continue;
+		}
+
+		__sync_synchronize();
+		memcpy(data, ch->slot, ch->size);
+		__sync_synchronize();
+		if (seq == ch->seq)
+			break;
+	}
+	ch->received_seq = seq;
+
+	return true;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -257,6 +257,42 @@ uint16_t fifoBuf_putData(t_fifo_buffer *buf, const void *data, uint16_t len)
     return i;                   // return number of bytes copied
 }
 
+uint16_t fifoBuf_reserveData(t_fifo_buffer *buf, uint16_t len, uint8_t **span1, uint16_t *span1_len, uint8_t **span2, uint16_t *span2_len)
+{       // get the free space for len bytes, to be written in place and added by fifoBuf_commitData
+
+    uint16_t wr = buf->wr;
+    uint16_t buf_size = buf->buf_size;
+
+    if (len > fifoBuf_getFree(buf))
+        return 0;               // not enough space
+
+    uint16_t j = buf_size - wr;
+
+    *span1 = buf->buf_ptr + wr;
+    if (j >= len)
+    {
+        *span1_len = len;
+        *span2 = NULL;
+        *span2_len = 0;
+        return 1;               // return number of spans
+    }
+
+    *span1_len = j;
+    *span2 = buf->buf_ptr;
+    *span2_len = len - j;
+    return 2;                   // return number of spans
+}
+
+void fifoBuf_commitData(t_fifo_buffer *buf, uint16_t len)
+{       // add the bytes written into the space from fifoBuf_reserveData to the buffer
+
+    uint16_t wr = buf->wr + len;
+    if (wr >= buf->buf_size)
+        wr -= buf->buf_size;
+
+    buf->wr = wr;
+}
+
 void fifoBuf_init(t_fifo_buffer *buf, const void *buffer, const uint16_t buffer_size)
 {
     buf->buf_ptr = (uint8_t *)buffer;
@@ -0,0 +1,52 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       fastloop.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @brief      Direct hand off of the control loop data between tasks
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef FASTLOOP_H
+#define FASTLOOP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//! The UAVO hand offs of the control loop that the fast loop replaces
+enum fastloop_channel {
+	FASTLOOP_GYROS,		//!< Sensors to stabilization, float[3] in deg/s
+	FASTLOOP_ACTUATOR,	//!< Stabilization to actuator, ActuatorDesiredData
+	FASTLOOP_NUM_CHANNELS
+};
+
+//! Period of the UAVO updates the fast loop still makes for telemetry and logging
+#define FASTLOOP_PUBLISH_PERIOD_US 10000
+
+int32_t FastLoopEnable(void);
+bool FastLoopEnabled(void);
+bool FastLoopSend(enum fastloop_channel channel, const void *data);
+bool FastLoopReceive(enum fastloop_channel channel, void *data, uint32_t timeout_ms);
+
+#endif // FASTLOOP_H
+
+/**
+ * @}
+ * @}
+ */
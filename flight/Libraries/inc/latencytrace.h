@@ -0,0 +1,50 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       latencytrace.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @brief      Traces the latency of the control loop from sensor to actuator
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef LATENCYTRACE_H
+#define LATENCYTRACE_H
+
+#include <stdint.h>
+
+//! The stages of the control loop, in the order a gyro sample passes them and
+//! in the element order of LoopLatency
+enum latency_trace_stage {
+	LATENCY_TRACE_SENSORS,
+	LATENCY_TRACE_ATTITUDE,
+	LATENCY_TRACE_STABILIZATION,
+	LATENCY_TRACE_ACTUATOR,
+	LATENCY_TRACE_NUM_STAGES
+};
+
+void LatencyTraceStamp(enum latency_trace_stage stage, uint32_t origin);
+uint32_t LatencyTraceOrigin(enum latency_trace_stage stage);
+void LatencyTraceUpdate(void);
+
+#endif // LATENCYTRACE_H
+
+/**
+ * @}
+ * @}
+ */
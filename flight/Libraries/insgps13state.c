@@ -64,6 +64,15 @@ static float P[NUMX][NUMX], X[NUMX];	// covariance matrix and state vector
 static float Q[NUMW], R[NUMV];   // input noise and measurement noise variances
 static float K[NUMX][NUMV];	     // feedback gain matrix
 
+// Columns of the elements LinearizeH can set in each row of H, all the others
+// stay zero. SerialUpdate only multiplies through these, so keep them in step.
+static const uint8_t HNumCols[NUMV] = { 1, 1, 1, 1, 1, 1, 4, 4, 4, 1 };
+static const uint8_t HCols[NUMV][4] = {
+	{ 0 }, { 1 }, { 2 }, { 3 }, { 4 }, { 5 },
+	{ 6, 7, 8, 9 }, { 6, 7, 8, 9 }, { 6, 7, 8, 9 },
+	{ 2 }
+};
+
 //  *************  Exposed Functions ****************
 //  *************************************************
 
@@ -1361,16 +1370,21 @@ static void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
 
 	for (m = 0; m < NUMV; m++) {
 
-		if (SensorsUsed & (0x01 << m)) {	// use this sensor for update
+		// skip unused sensors and the rows of H that are all zero, which
+		// would not change P or X
+		if ((SensorsUsed & (0x01 << m)) && HNumCols[m] > 0) {	// use this sensor for update
+
+			const uint8_t *cols = HCols[m];
+			const uint8_t num_cols = HNumCols[m];
 
-			for (j = 0; j < NUMX; j++) {	// Find Hp = H*P
+			for (j = 0; j < NUMX; j++) {	// Find Hp = H*P, H is sparse
 				HP[j] = 0;
-				for (k = 0; k < NUMX; k++)
-					HP[j] += H[m][k] * P[k][j];
+				for (k = 0; k < num_cols; k++)
+					HP[j] += H[m][cols[k]] * P[cols[k]][j];
 			}
 			HPHR = R[m];	// Find  HPHR = H*P*H' + R
-			for (k = 0; k < NUMX; k++)
-				HPHR += HP[k] * H[m][k];
+			for (k = 0; k < num_cols; k++)
+				HPHR += HP[cols[k]] * H[m][cols[k]];
 
 			for (k = 0; k < NUMX; k++)
 				K[k][m] = HP[k] / HPHR;	// find K = HP/HPHR
@@ -48,25 +48,35 @@
 #endif
 
 // Private functions
-void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
+static void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
 			  float Q[NUMW], float dT, float P[NUMX][NUMX]);
-void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
+static void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
 		  float Y[NUMV], float P[NUMX][NUMX], float X[NUMX],
 		  uint16_t SensorsUsed);
-void RungeKutta(float X[NUMX], float U[NUMU], float dT);
-void StateEq(float X[NUMX], float U[NUMU], float Xdot[NUMX]);
-void LinearizeFG(float X[NUMX], float U[NUMU], float F[NUMX][NUMX],
+static void RungeKutta(float X[NUMX], float U[NUMU], float dT);
+static void StateEq(float X[NUMX], float U[NUMU], float Xdot[NUMX]);
+static void LinearizeFG(float X[NUMX], float U[NUMU], float F[NUMX][NUMX],
 		 float G[NUMX][NUMW]);
-void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV]);
-void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX]);
+static void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV]);
+static void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX]);
+static void INSLimitBias();
 
 // Private variables
-float F[NUMX][NUMX], G[NUMX][NUMW], H[NUMV][NUMX];	// linearized system matrices
+static float F[NUMX][NUMX], G[NUMX][NUMW], H[NUMV][NUMX];	// linearized system matrices
 													// global to init to zero and maintain zero elements
-float Be[3];			// local magnetic unit vector in NED frame
-float P[NUMX][NUMX], X[NUMX];	// covariance matrix and state vector
-float Q[NUMW], R[NUMV];		// input noise and measurement noise variances
-float K[NUMX][NUMV];		// feedback gain matrix
+static float Be[3];			// local magnetic unit vector in NED frame
+static float P[NUMX][NUMX], X[NUMX];	// covariance matrix and state vector
+static float Q[NUMW], R[NUMV];		// input noise and measurement noise variances
+static float K[NUMX][NUMV];		// feedback gain matrix
+
+// Columns of the elements LinearizeH can set in each row of H, all the others
+// stay zero. SerialUpdate only multiplies through these, so keep them in step.
+static const uint8_t HNumCols[NUMV] = { 1, 1, 1, 1, 1, 1, 4, 4, 0, 1 };
+static const uint8_t HCols[NUMV][4] = {
+	{ 0 }, { 1 }, { 2 }, { 3 }, { 4 }, { 5 },
+	{ 6, 7, 8, 9 }, { 6, 7, 8, 9 }, { 0 },
+	{ 2 }
+};
 
 //  *************  Exposed Functions ****************
 //  *************************************************
@@ -301,7 +311,7 @@ void INSSetMagNorth(const float B[3])
 	Be[2] = B[2];
 }
 
-void INSLimitBias()
+static void INSLimitBias()
 {
 	// The Z accel bias should never wander too much. This helps ensure the filter
 	// remains stable.
@@ -422,7 +432,7 @@ void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[
 
 #ifdef COVARIANCE_PREDICTION_GENERAL
 
-void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
+static void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
 			  float Q[NUMW], float dT, float P[NUMX][NUMX])
 {
 	float Dummy[NUMX][NUMX], dTsq;
@@ -451,7 +461,7 @@ void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
 
 #else
 
-void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
+static void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
 			  float Q[NUMW], float dT, float P[NUMX][NUMX])
 {
 	float D[NUMX][NUMX], T, Tsq;
@@ -592,7 +602,7 @@ void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
 //     should be used in the update.
 //  ************************************************
 
-void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
+static void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
 		  float Y[NUMV], float P[NUMX][NUMX], float X[NUMX],
 		  uint16_t SensorsUsed)
 {
@@ -603,16 +613,21 @@ void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
 	// appropriate corrections
 	for (m = 0; m < NUMV; m++) {
 
-		if (SensorsUsed & (0x01 << m)) {	// use this sensor for update
+		// skip unused sensors and the rows of H that are all zero, which
+		// would not change P or X
+		if ((SensorsUsed & (0x01 << m)) && HNumCols[m] > 0) {	// use this sensor for update
 
-			for (j = 0; j < NUMX; j++) {	// Find Hp = H*P
+			const uint8_t *cols = HCols[m];
+			const uint8_t num_cols = HNumCols[m];
+
+			for (j = 0; j < NUMX; j++) {	// Find Hp = H*P, H is sparse
 				HP[j] = 0.0f;
-				for (k = 0; k < NUMX; k++)
-					HP[j] += H[m][k] * P[k][j];
+				for (k = 0; k < num_cols; k++)
+					HP[j] += H[m][cols[k]] * P[cols[k]][j];
 			}
 			HPHR = R[m];	// Find  HPHR = H*P*H' + R
-			for (k = 0; k < NUMX; k++)
-				HPHR += HP[k] * H[m][k];
+			for (k = 0; k < num_cols; k++)
+				HPHR += HP[cols[k]] * H[m][cols[k]];
 
 			for (k = 0; k < NUMX; k++)
 				K[k][m] = HP[k] / HPHR;	// find K = HP/HPHR
@@ -640,7 +655,7 @@ void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
 //    constant inputs over integration step
 //  ************************************************
 
-void RungeKutta(float X[NUMX], float U[NUMU], float dT)
+static void RungeKutta(float X[NUMX], float U[NUMU], float dT)
 {
 
 	float dT2 =
@@ -687,7 +702,7 @@ void RungeKutta(float X[NUMX], float U[NUMU], float dT)
 //  H is output of LinearizeH(), all elements not set should be zero
 //  ************************************************
 
-void StateEq(float X[NUMX], float U[NUMU], float Xdot[NUMX])
+static void StateEq(float X[NUMX], float U[NUMU], float Xdot[NUMX])
 {
 	const float wx = U[0] - X[10];
 	const float wy = U[1] - X[11];
@@ -749,7 +764,7 @@ void StateEq(float X[NUMX], float U[NUMU], float Xdot[NUMX])
  * For reference the state order (in F) is pos, vel, attitude, gyro bias, accel bias
  * and the input order is gyro, bias
  */
-void LinearizeFG(float X[NUMX], float U[NUMU], float F[NUMX][NUMX],
+static void LinearizeFG(float X[NUMX], float U[NUMU], float F[NUMX][NUMX],
 		 float G[NUMX][NUMW])
 {
 	const float wx = U[0] - X[10];
@@ -843,7 +858,7 @@ void LinearizeFG(float X[NUMX], float U[NUMU], float F[NUMX][NUMX],
  * directly computes the outputs instead of a matrix that
  * you transform the state by
  */
-void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV])
+static void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV])
 {
 	const float q0 = X[6];
 	const float q1 = X[7];
@@ -877,7 +892,7 @@ void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV])
  * so the predicted measurements are
  *    Z = H * X
  */
-void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX])
+static void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX])
 {
 	const float q0 = X[6];
 	const float q1 = X[7];
@@ -0,0 +1,156 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       latencytrace.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @brief      Traces the latency of the control loop from sensor to actuator
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * Every gyro sample is stamped with PIOS_DELAY_GetRaw() when it is read. Each
+ * stage of the loop picks up the stamp of the sample it is working on with
+ * LatencyTraceOrigin() from the stage whose output woke it up (stabilization
+ * runs on the gyros, not on the attitude) and, when it publishes its own
+ * output, passes it on with LatencyTraceStamp(), which also records how long
+ * ago the sample was read. The actuator stage therefore sees the full sensor
+ * to output latency.
+ *
+ * A stage can publish without a new sample from the stage before, like the
+ * actuator in manual mode where stabilization doesn't run or attitude after
+ * the gyros timed out. Only the first output for a sample is recorded, the
+ * others would count the age of an old sample as latency.
+ *
+ * Each stage only writes its own statistics and the system task only reads
+ * them, so no locking is needed in the loop.
+ */
+
+#include "openpilot.h"
+#include "latencytrace.h"
+
+#if defined(LOOP_LATENCY_DIAGNOSTICS)
+
+#include "looplatency.h"
+
+// Private constants
+#define NUM_BINS LOOPLATENCY_SENSORS_NUMELEM
+#define FIRST_BIN_US 125	// upper edge of the first bin, each next one doubles
+
+// Private types
+struct stage_stats {
+	uint32_t origin;		// when the last sample out of this stage was read
+	uint32_t count[NUM_BINS];	// samples per bin since boot
+	uint32_t total_us;		// sum of all latencies, wraps
+	uint32_t max_us;
+	bool reset_max;			// set by the reporter, cleared by the stage
+};
+
+// Private variables
+static struct stage_stats stages[LATENCY_TRACE_NUM_STAGES];
+static uint32_t reported_count[LATENCY_TRACE_NUM_STAGES][NUM_BINS];
+static uint32_t reported_total_us[LATENCY_TRACE_NUM_STAGES];
+
+/**
+ * Record that a stage published its output for a sample, unless it already
+ * did so for this sample
+ * @param[in] stage the stage that produced the output
+ * @param[in] origin the time the sample was read, from PIOS_DELAY_GetRaw()
+ */
+void LatencyTraceStamp(enum latency_trace_stage stage, uint32_t origin)
+{
+	struct stage_stats *stats = &stages[stage];
+
+	// The origin hasn't advanced since the last stamp, or no sample
+	// reached this stage yet
+	if (origin == stats->origin)
+		return;
+
+	uint32_t latency_us = PIOS_DELAY_DiffuS(origin);
+
+	uint32_t bin = 0;
+	for (uint32_t edge = FIRST_BIN_US; latency_us >= edge && bin < NUM_BINS - 1; edge *= 2)
+		bin++;
+
+	stats->count[bin]++;
+	stats->total_us += latency_us;
+
+	if (stats->reset_max) {
+		stats->max_us = 0;
+		stats->reset_max = false;
+	}
+	if (latency_us > stats->max_us)
+		stats->max_us = latency_us;
+
+	stats->origin = origin;
+}
+
+/**
+ * Get the read time of the sample behind the latest output of a stage
+ * @param[in] stage the stage whose output is being consumed
+ * @return the time the sample was read, from PIOS_DELAY_GetRaw()
+ */
+uint32_t LatencyTraceOrigin(enum latency_trace_stage stage)
+{
+	return stages[stage].origin;
+}
+
+/**
+ * Publish the statistics since the previous call in the LoopLatency object
+ */
+void LatencyTraceUpdate(void)
+{
+	uint16_t histogram[LATENCY_TRACE_NUM_STAGES][NUM_BINS];
+	LoopLatencyData loopLatency;
+
+	for (uint32_t i = 0; i < LATENCY_TRACE_NUM_STAGES; i++) {
+		struct stage_stats *stats = &stages[i];
+		uint32_t samples = 0;
+
+		for (uint32_t bin = 0; bin < NUM_BINS; bin++) {
+			uint32_t count = stats->count[bin];
+			uint32_t new_samples = count - reported_count[i][bin];
+			reported_count[i][bin] = count;
+
+			histogram[i][bin] = new_samples > UINT16_MAX ? UINT16_MAX : new_samples;
+			samples += new_samples;
+		}
+
+		uint32_t total_us = stats->total_us;
+		loopLatency.Mean[i] = samples > 0 ? (total_us - reported_total_us[i]) / samples : 0;
+		reported_total_us[i] = total_us;
+
+		loopLatency.Max[i] = stats->max_us;
+		stats->reset_max = true;
+	}
+
+	memcpy(loopLatency.Sensors, histogram[LATENCY_TRACE_SENSORS], sizeof(loopLatency.Sensors));
+	memcpy(loopLatency.Attitude, histogram[LATENCY_TRACE_ATTITUDE], sizeof(loopLatency.Attitude));
+	memcpy(loopLatency.Stabilization, histogram[LATENCY_TRACE_STABILIZATION], sizeof(loopLatency.Stabilization));
+	memcpy(loopLatency.Actuator, histogram[LATENCY_TRACE_ACTUATOR], sizeof(loopLatency.Actuator));
+
+	LoopLatencySet(&loopLatency);
+}
+
+#endif /* LOOP_LATENCY_DIAGNOSTICS */
+
+/**
+ * @}
+ * @}
+ */
@@ -46,6 +46,8 @@
 #include "mixerstatus.h"
 #include "cameradesired.h"
 #include "manualcontrolcommand.h"
+#include "latencytrace.h"
+#include "fastloop.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
 
@@ -158,6 +160,9 @@ static void actuatorTask(void* parameters)
 	uint32_t thisSysTime;
 	float dT = 0.0f;
 
+	// Kept here, the fast loop only publishes ActuatorCommand now and then
+	float maxUpdateTime = 0.0f;
+
 	ActuatorCommandData command;
 	ActuatorDesiredData desired;
 	MixerStatusData mixerStatus;
@@ -181,12 +186,26 @@ static void actuatorTask(void* parameters)
 
 	// Main task loop
 	lastSysTime = PIOS_Thread_Systime();
+	uint32_t publish_timeval = PIOS_DELAY_GetRaw();
 	while (1)
 	{
 		PIOS_WDG_UpdateFlag(PIOS_WDG_ACTUATOR);
 
-		// Wait until the ActuatorDesired object is updated
-		bool rc = PIOS_Queue_Receive(queue, &ev, FAILSAFE_TIMEOUT_MS);
+		// Wait until the ActuatorDesired object is updated. In manual mode
+		// it comes from manual control, also with the fast loop, so that it
+		// doesn't depend on the gyros.
+		uint8_t flightMode;
+		FlightStatusFlightModeGet(&flightMode);
+		bool fastLoop = FastLoopEnabled() && flightMode != FLIGHTSTATUS_FLIGHTMODE_MANUAL;
+
+		bool rc;
+		if (fastLoop) {
+			// The object is only updated for telemetry, ignore its events
+			PIOS_Queue_Receive(queue, &ev, 0);
+			rc = FastLoopReceive(FASTLOOP_ACTUATOR, &desired, FAILSAFE_TIMEOUT_MS);
+		} else {
+			rc = PIOS_Queue_Receive(queue, &ev, FAILSAFE_TIMEOUT_MS);
+		}
 
 		/* Process settings updated events even in timeout case so we always act on the latest settings */
 		if (actuator_settings_updated) {
@@ -204,6 +223,9 @@ static void actuatorTask(void* parameters)
 			setFailsafe(&actuatorSettings, &mixerSettings);
 			continue;
 		}
+#if defined(LOOP_LATENCY_DIAGNOSTICS)
+		uint32_t gyro_read_time = LatencyTraceOrigin(LATENCY_TRACE_STABILIZATION);
+#endif
 
 		// Check how long since last update
 		thisSysTime = PIOS_Thread_Systime();
@@ -211,8 +233,11 @@ static void actuatorTask(void* parameters)
 			dT = (thisSysTime - lastSysTime) / 1000.0f;
 		lastSysTime = thisSysTime;
 
+		// A fast loop sample that arrives after the switch to manual only
+		// woke this task up
 		FlightStatusGet(&flightStatus);
-		ActuatorDesiredGet(&desired);
+		if (!fastLoop || flightStatus.FlightMode == FLIGHTSTATUS_FLIGHTMODE_MANUAL)
+			ActuatorDesiredGet(&desired);
 		ActuatorCommandGet(&command);
 
 #if defined(MIXERSTATUS_DIAGNOSTICS)
@@ -355,13 +380,19 @@ static void actuatorTask(void* parameters)
 			
 		// Store update time
 		command.UpdateTime = 1000.0f*dT;
-		if(1000.0f*dT > command.MaxUpdateTime)
-			command.MaxUpdateTime = 1000.0f*dT;
+		if(1000.0f*dT > maxUpdateTime)
+			maxUpdateTime = 1000.0f*dT;
+		command.MaxUpdateTime = maxUpdateTime;
 		
-		// Update output object
-		ActuatorCommandSet(&command);
-		// Update in case read only (eg. during servo configuration)
-		ActuatorCommandGet(&command);
+		// Update output object, which the fast loop only does for telemetry
+		// unless the GCS drives the outputs
+		if (!FastLoopEnabled() || ActuatorCommandReadOnly() ||
+		    PIOS_DELAY_DiffuS(publish_timeval) >= FASTLOOP_PUBLISH_PERIOD_US) {
+			publish_timeval = PIOS_DELAY_GetRaw();
+			ActuatorCommandSet(&command);
+			// Update in case read only (eg. during servo configuration)
+			ActuatorCommandGet(&command);
+		}
 
 #if defined(MIXERSTATUS_DIAGNOSTICS)
 		MixerStatusSet(&mixerStatus);
@@ -378,6 +409,9 @@ static void actuatorTask(void* parameters)
 #if defined(PIOS_INCLUDE_HPWM)
 		PIOS_Servo_Update();
 #endif
+#if defined(LOOP_LATENCY_DIAGNOSTICS)
+		LatencyTraceStamp(LATENCY_TRACE_ACTUATOR, gyro_read_time);
+#endif
 
 		if(!success) {
 			command.NumFailedUpdates++;
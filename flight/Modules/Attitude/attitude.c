@@ -73,6 +73,7 @@
 #include "velocityactual.h"
 #include "coordinate_conversions.h"
 #include "WorldMagModel.h"
+#include "latencytrace.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
 
@@ -150,6 +151,9 @@ static const float zeros[3] = {0.0f, 0.0f, 0.0f};
 
 static struct complementary_filter_state complementary_filter_state;
 static struct cfvert cfvert; //!< State information for vertical filter
+#if defined(LOOP_LATENCY_DIAGNOSTICS)
+static uint32_t gyro_read_time; //!< When the gyro sample being processed was read
+#endif
 
 // Private functions
 static void AttitudeTask(void *parameters);
@@ -427,6 +431,9 @@ static int32_t updateAttitudeComplementary(bool first_run, bool secondary, bool
 				return -1;
 			}
 		}
+#if defined(LOOP_LATENCY_DIAGNOSTICS)
+		gyro_read_time = LatencyTraceOrigin(LATENCY_TRACE_SENSORS);
+#endif
 	}
 
 	AccelsGet(&accelsData);
@@ -858,6 +865,9 @@ static int32_t setAttitudeComplementary()
 	AttitudeActualData attitude;
 	quat_copy(cf_q, &attitude.q1);
 	Quaternion2RPY(&attitude.q1,&attitude.Roll);
+#if defined(LOOP_LATENCY_DIAGNOSTICS)
+	LatencyTraceStamp(LATENCY_TRACE_ATTITUDE, gyro_read_time);
+#endif
 	AttitudeActualSet(&attitude);
 
 	return 0;
@@ -995,6 +1005,9 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 	{
 		return -1;
 	}
+#if defined(LOOP_LATENCY_DIAGNOSTICS)
+	gyro_read_time = LatencyTraceOrigin(LATENCY_TRACE_SENSORS);
+#endif
 
 	// Get most recent data
 	GyrosGet(&gyrosData);
@@ -1277,6 +1290,9 @@ static int32_t setAttitudeINSGPS()
 
 	INSGetState(NULL, NULL, &attitude.q1, gyro_bias, NULL);
 	Quaternion2RPY(&attitude.q1,&attitude.Roll);
+#if defined(LOOP_LATENCY_DIAGNOSTICS)
+	LatencyTraceStamp(LATENCY_TRACE_ATTITUDE, gyro_read_time);
+#endif
 	AttitudeActualSet(&attitude);
 
 	if (insSettings.ComputeGyroBias == INSSETTINGS_COMPUTEGYROBIAS_TRUE && 
@@ -46,6 +46,7 @@
 #include "flightstatus.h"
 #include "manualcontrolcommand.h"
 #include "coordinate_conversions.h"
+#include "fastloop.h"
 #include <pios_board_info.h>
 #include "pios_thread.h"
 #include "pios_queue.h"
@@ -373,6 +374,11 @@ static int32_t updateSensors(AccelsData * accelsData, GyrosData * gyrosData)
 
 		
 
+	// Hand the sample straight to stabilization when running the fast loop
+	if (FastLoopEnabled()) {
+		float gyro_rates[3] = { gyrosData->x, gyrosData->y, gyrosData->z };
+		FastLoopSend(FASTLOOP_GYROS, gyro_rates);
+	}
 	GyrosSet(gyrosData);
 	AccelsSet(accelsData);
 
@@ -410,6 +416,11 @@ static int32_t updateSensorsCC3D(AccelsData * accelsData, GyrosData * gyrosData)
 
 	update_trimming(accelsData);
 
+	// Hand the sample straight to stabilization when running the fast loop
+	if (FastLoopEnabled()) {
+		float gyro_rates[3] = { gyrosData->x, gyrosData->y, gyrosData->z };
+		FastLoopSend(FASTLOOP_GYROS, gyro_rates);
+	}
 	GyrosSet(gyrosData);
 	AccelsSet(accelsData);
 
@@ -717,7 +717,9 @@ static void ProcessRadioStream(UAVTalkConnection inConnectionHandle,
 			break;
 
 		default:
-			// all other packets are relayed to the telemetry port
+			// all other packets are relayed to the telemetry port,
+			// including multi-object frames, which the flight side
+			// never puts the objects above in
 			UAVTalkRelayPacket(inConnectionHandle,
 					   outConnectionHandle);
 			break;
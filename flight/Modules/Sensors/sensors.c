@@ -48,6 +48,8 @@
 #include "magnetometer.h"
 #include "magbias.h"
 #include "coordinate_conversions.h"
+#include "latencytrace.h"
+#include "fastloop.h"
 
 // Private constants
 #define STACK_SIZE_BYTES 1000
@@ -97,6 +99,9 @@ static float gyro_temp_bias[3] = {0,0,0};
 static float z_accel_offset = 0;
 static float Rsb[3][3] = {{0}}; //! Rotation matrix that transforms from the body frame to the sensor board frame
 static int8_t rotate = 0;
+#if defined(LOOP_LATENCY_DIAGNOSTICS)
+static uint32_t gyro_read_time;
+#endif
 
 //! Select the algorithm to try and null out the magnetometer bias error
 static enum mag_calibration_algo mag_calibration_algo = MAG_CALIBRATION_PRELEMARI;
@@ -193,6 +198,9 @@ static void SensorsTask(void *parameters)
 			good_runs = 0;
 			continue;
 		}
+#if defined(LOOP_LATENCY_DIAGNOSTICS)
+		gyro_read_time = PIOS_DELAY_GetRaw();
+#endif
 
 		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_ACCEL);
 		if (queue == NULL || PIOS_Queue_Receive(queue, &accels, 0) == false) {
@@ -331,6 +339,15 @@ static void update_gyros(struct pios_sensor_gyro_data *gyros)
 		}
 	}
 
+#if defined(LOOP_LATENCY_DIAGNOSTICS)
+	LatencyTraceStamp(LATENCY_TRACE_SENSORS, gyro_read_time);
+#endif
+
+	// Hand the sample straight to stabilization when running the fast loop
+	if (FastLoopEnabled()) {
+		float gyro_rates[3] = { gyrosData.x, gyrosData.y, gyrosData.z };
+		FastLoopSend(FASTLOOP_GYROS, gyro_rates);
+	}
 	GyrosSet(&gyrosData);
 }
 
@@ -54,6 +54,8 @@
 #include "systemsettings.h"
 
 #include "coordinate_conversions.h"
+#include "latencytrace.h"
+#include "fastloop.h"
 
 // Private constants
 #define STACK_SIZE_BYTES 1540
@@ -179,6 +181,11 @@ static void SensorsTask(void *parameters)
 		
 		sensors_count++;
 
+#if defined(LOOP_LATENCY_DIAGNOSTICS)
+		// Simulated samples are made rather than read, they are ready at once
+		LatencyTraceStamp(LATENCY_TRACE_SENSORS, PIOS_DELAY_GetRaw());
+#endif
+
 		switch(sensor_sim_type) {
 			case CONSTANT:
 				simulateConstant();
@@ -196,6 +203,14 @@ static void SensorsTask(void *parameters)
 				simulateModelCar();
 		}
 
+		// Hand the sample straight to stabilization when running the fast loop
+		if (FastLoopEnabled()) {
+			GyrosData gyrosData;
+			GyrosGet(&gyrosData);
+			float gyro_rates[3] = { gyrosData.x, gyrosData.y, gyrosData.z };
+			FastLoopSend(FASTLOOP_GYROS, gyro_rates);
+		}
+
 		PIOS_Thread_Sleep(2);
 
 	}
@@ -29,6 +29,7 @@
 #include "physical_constants.h"
 #include "openpilot.h"
 #include "pios_thread.h"
+#include "pios_sim.h"
 
 #include "cameradesired.h"
 #include "attitudesimulated.h"
@@ -120,7 +121,9 @@ static void VisualizationTask(void *parameters)
 		uav_data.camera_roll = camera.Roll * 30;
 		uav_data.camera_pitch = camera.Pitch * 45;
 		sendto(s, (struct sockaddr *) &uav_data, sizeof(uav_data), 0, (struct sockaddr *) &server, sizeof(server));
-		usleep(100000);
+		// In lockstep mode the virtual clock alone paces the task
+		if (!PIOS_SIM_IsLockstep())
+			usleep(100000);
 		PIOS_Thread_Sleep(100);
 
 	}
@@ -58,6 +58,8 @@
 
 // Math libraries
 #include "coordinate_conversions.h"
+#include "latencytrace.h"
+#include "fastloop.h"
 #include "pid.h"
 #include "misc_math.h"
 
@@ -132,9 +134,10 @@ int32_t StabilizationStart()
 	// Create object queue
 	queue = PIOS_Queue_Create(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
 
-	// Listen for updates.
+	// Listen for updates, the fast loop gets the gyros straight from sensors
 	//	AttitudeActualConnectQueue(queue);
-	GyrosConnectQueue(queue);
+	if (!FastLoopEnabled())
+		GyrosConnectQueue(queue);
 	
 	// Connect settings callback
 	MWRateSettingsConnectCallback(SettingsUpdatedCb);
@@ -163,6 +166,12 @@ int32_t StabilizationInitialize()
 	RateDesiredInitialize();
 #endif
 
+	// The fast loop is chosen at boot, before the control loop tasks start
+	uint8_t fast_loop;
+	StabilizationSettingsFastLoopGet(&fast_loop);
+	if (fast_loop == STABILIZATIONSETTINGS_FASTLOOP_TRUE && FastLoopEnable() != 0)
+		return -1;
+
 	return 0;
 }
 
@@ -197,6 +206,9 @@ static void stabilizationTask(void* parameters)
 	const uint32_t SYSTEM_IDENT_PERIOD = 75;
 	uint32_t system_ident_timeval = PIOS_DELAY_GetRaw();
 
+	// The fast loop only updates ActuatorDesired for telemetry
+	uint32_t publish_timeval = PIOS_DELAY_GetRaw();
+
 	// Main task loop
 	zero_pids();
 	while(1) {
@@ -206,12 +218,26 @@ static void stabilizationTask(void* parameters)
 		
 		PIOS_WDG_UpdateFlag(PIOS_WDG_STABILIZATION);
 		
-		// Wait until the AttitudeRaw object is updated, if a timeout then go to failsafe
-		if (PIOS_Queue_Receive(queue, &ev, FAILSAFE_TIMEOUT_MS) != true)
+		// Wait until the Gyros object is updated, if a timeout then go to failsafe
+		bool updated;
+		if (FastLoopEnabled()) {
+			float gyro_rates[3];
+			updated = FastLoopReceive(FASTLOOP_GYROS, gyro_rates, FAILSAFE_TIMEOUT_MS);
+			gyrosData.x = gyro_rates[0];
+			gyrosData.y = gyro_rates[1];
+			gyrosData.z = gyro_rates[2];
+		} else {
+			updated = PIOS_Queue_Receive(queue, &ev, FAILSAFE_TIMEOUT_MS);
+		}
+
+		if (updated != true)
 		{
 			AlarmsSet(SYSTEMALARMS_ALARM_STABILIZATION,SYSTEMALARMS_ALARM_WARNING);
 			continue;
 		}
+#if defined(LOOP_LATENCY_DIAGNOSTICS)
+		uint32_t gyro_read_time = LatencyTraceOrigin(LATENCY_TRACE_SENSORS);
+#endif
 		
 
 		calculate_pids();
@@ -222,7 +248,8 @@ static void stabilizationTask(void* parameters)
 		FlightStatusGet(&flightStatus);
 		StabilizationDesiredGet(&stabDesired);
 		AttitudeActualGet(&attitudeActual);
-		GyrosGet(&gyrosData);
+		if (!FastLoopEnabled())
+			GyrosGet(&gyrosData);
 		ActuatorDesiredGet(&actuatorDesired);
 #if defined(RATEDESIRED_DIAGNOSTICS)
 		RateDesiredGet(&rateDesired);
@@ -708,11 +735,28 @@ static void stabilizationTask(void* parameters)
 		actuatorDesired.Throttle = stabDesired.Throttle;
 
 		if(flightStatus.FlightMode != FLIGHTSTATUS_FLIGHTMODE_MANUAL) {
-			ActuatorDesiredSet(&actuatorDesired);
+#if defined(LOOP_LATENCY_DIAGNOSTICS)
+			LatencyTraceStamp(LATENCY_TRACE_STABILIZATION, gyro_read_time);
+#endif
+			if (!FastLoopEnabled()) {
+				ActuatorDesiredSet(&actuatorDesired);
+			} else {
+				FastLoopSend(FASTLOOP_ACTUATOR, &actuatorDesired);
+				if (PIOS_DELAY_DiffuS(publish_timeval) >= FASTLOOP_PUBLISH_PERIOD_US) {
+					publish_timeval = PIOS_DELAY_GetRaw();
+					ActuatorDesiredSet(&actuatorDesired);
+				}
+			}
 		} else {
 			// Force all axes to reinitialize when engaged
 			for(uint8_t i=0; i< MAX_AXES; i++)
 				previous_mode[i] = 255;
+
+			// Manual control sets ActuatorDesired itself and the actuator
+			// waits for that in manual mode, this only wakes it up when it
+			// is still waiting on the fast loop after the switch
+			if (FastLoopEnabled())
+				FastLoopSend(FASTLOOP_ACTUATOR, &actuatorDesired);
 		}
 
 		if(flightStatus.Armed != FLIGHTSTATUS_ARMED_ARMED ||
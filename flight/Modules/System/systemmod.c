@@ -42,7 +42,9 @@
 #include "systemsettings.h"
 #include "taskinfo.h"
 #include "watchdogstatus.h"
+#include "looplatency.h"
 #include "taskmonitor.h"
+#include "latencytrace.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
 
@@ -130,6 +132,9 @@ int32_t SystemModInitialize(void)
 #if defined(WDG_STATS_DIAGNOSTICS)
 	WatchdogStatusInitialize();
 #endif
+#if defined(LOOP_LATENCY_DIAGNOSTICS)
+	LoopLatencyInitialize();
+#endif
 
 	objectPersistenceQueue = PIOS_Queue_Create(1, sizeof(UAVObjEvent));
 	if (objectPersistenceQueue == NULL)
@@ -207,6 +212,11 @@ static void systemTask(void *parameters)
 		TaskMonitorUpdateAll();
 #endif
 
+#if defined(LOOP_LATENCY_DIAGNOSTICS)
+		// Publish the control loop latency since the last update
+		LatencyTraceUpdate();
+#endif
+
 		// Flash the heartbeat LED
 #if defined(PIOS_LED_HEARTBEAT)
 		PIOS_LED_Toggle(PIOS_LED_HEARTBEAT);
@@ -33,6 +33,9 @@
 #include "gcstelemetrystats.h"
 #include "modulesettings.h"
 #include "sessionmanaging.h"
+#include "hwtaulink.h"
+#include "rfm22breceiver.h"
+#include "rfm22bstatus.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
 
@@ -46,7 +49,9 @@
 #define MAX_RETRIES 2
 #define STATS_UPDATE_PERIOD_MS 4000
 #define CONNECTION_TIMEOUT_MS 8000
+#define TX_RESERVE_TIMEOUT_MS 5000
 #define PAUSE_PERIODIC_UPDATE_TIMEOUT 6000
+#define RX_CHUNK_SIZE 32
 // Private types
 
 // Private variables
@@ -63,20 +68,23 @@ static void telemetryTxPriTask(void *parameters);
 
 static struct pios_thread *telemetryTxTaskHandle;
 static struct pios_thread *telemetryRxTaskHandle;
-static uint32_t txErrors;
-static uint32_t txRetries;
 static uint32_t timeOfLastObjectUpdate;
 static UAVTalkConnection uavTalkCon;
 static bool pausePeriodicUpdates;
 static uint32_t pausePeriodicUpdatesTime;
+static uintptr_t reservedPort;
 // Private functions
 static void telemetryTxTask(void *parameters);
 static void telemetryRxTask(void *parameters);
 static int32_t transmitData(uint8_t * data, int32_t length);
+static int32_t reserveData(uint16_t length, uint8_t *spans[2], uint16_t spanLengths[2]);
+static int32_t commitData(uint16_t length);
 static void registerObject(UAVObjHandle obj);
 static void updateObject(UAVObjHandle obj, int32_t eventType);
 static int32_t setUpdatePeriod(UAVObjHandle obj, int32_t updatePeriodMs);
 static void processObjEvent(UAVObjEvent * ev);
+static int32_t sendObjectUpdate(UAVObjHandle obj, uint16_t instId, UAVObjMetadata * metadata);
+static uint32_t processTransactions();
 static void updateTelemetryStats();
 static void gcsTelemetryStatsUpdated();
 static void updateSettings();
@@ -84,6 +92,7 @@ static uintptr_t getComPort();
 static void session_managing_updated(UAVObjEvent * ev);
 static void update_object_instances(uint32_t obj_id, uint32_t inst_id);
 static void check_pause_periodic_updates_timeout();
+static bool routedByModem(UAVObjHandle obj);
 
 /**
  * Initialise the telemetry module
@@ -137,10 +146,9 @@ int32_t TelemetryInitialize(void)
     
 	// Initialise UAVTalk
 	uavTalkCon = UAVTalkInitialize(&transmitData);
+	UAVTalkSetDirectOutputStream(uavTalkCon, &reserveData, &commitData);
     
 	// Create periodic event that will be used to update the telemetry stats
-	txErrors = 0;
-	txRetries = 0;
 	UAVObjEvent ev;
 	memset(&ev, 0, sizeof(UAVObjEvent));
 	EventPeriodicQueueCreate(&ev, priorityQueue, STATS_UPDATE_PERIOD_MS);
@@ -269,8 +277,6 @@ static void processObjEvent(UAVObjEvent * ev)
 	UAVObjMetadata metadata;
 	UAVObjUpdateMode updateMode;
 	FlightTelemetryStatsData flightStats;
-	int32_t retries;
-	int32_t success;
 
 	if (ev->obj == 0) {
 		updateTelemetryStats();
@@ -283,59 +289,30 @@ static void processObjEvent(UAVObjEvent * ev)
 		updateMode = UAVObjGetTelemetryUpdateMode(&metadata);
 
 		// Act on event
-		retries = 0;
-		success = -1;
 		if (ev->event == EV_UPDATED || ev->event == EV_UPDATED_MANUAL || ((ev->event == EV_UPDATED_PERIODIC) && (updateMode != UPDATEMODE_THROTTLED))) {
-			// Send update to GCS (with retries)
+			// Send update to GCS
 			if (pausePeriodicUpdates) {
 				check_pause_periodic_updates_timeout();
 			}
-			while (retries < MAX_RETRIES && success == -1) {
-				if((ev->obj !=FlightTelemetryStatsHandle()) && (ev->event == EV_UPDATED_PERIODIC) && pausePeriodicUpdates) {
-					success = 0;
-				} else {
-					success = UAVTalkSendObject(uavTalkCon, ev->obj, ev->instId, UAVObjGetTelemetryAcked(&metadata), REQ_TIMEOUT_MS);	// call blocks until ack is received or timeout
-				}
-				++retries;
-			}
-			// Update stats
-			txRetries += (retries - 1);
-			if (success == -1) {
-				++txErrors;
+			// Failed sends are counted in the UAVTalk stats
+			if ((ev->obj == FlightTelemetryStatsHandle()) || (ev->event != EV_UPDATED_PERIODIC) || !pausePeriodicUpdates) {
+				sendObjectUpdate(ev->obj, ev->instId, &metadata);
 			}
 		} else if (ev->event == EV_UPDATE_REQ) {
-			// Request object update from GCS (with retries)
-			while (retries < MAX_RETRIES && success == -1) {
-				success = UAVTalkSendObjectRequest(uavTalkCon, ev->obj, ev->instId, REQ_TIMEOUT_MS);	// call blocks until update is received or timeout
-				++retries;
-			}
-			// Update stats
-			txRetries += (retries - 1);
-			if (success == -1) {
-				++txErrors;
-			}
+			// Request object update from GCS, completes when the update is received
+			UAVTalkSendObjectRequestAsync(uavTalkCon, ev->obj, ev->instId, REQ_TIMEOUT_MS, MAX_RETRIES - 1, NULL);
 		} else if (ev->event == EV_UPDATED_PERIODIC && updateMode == UPDATEMODE_THROTTLED) {
 
 			// Get the event mask
 			int32_t eventMask = getEventMask(ev->obj, priorityQueue);
 
 			if (eventMask & EV_UPDATED_THROTTLED_DIRTY) { // If EV_UPDATED_THROTTLED_DIRTY flag is set then send the data like normal.
-				// Send update to GCS (with retries)
+				// Send update to GCS
 				if (pausePeriodicUpdates) {
 					check_pause_periodic_updates_timeout();
 				}
-				while (retries < MAX_RETRIES && success == -1) {
-					if (pausePeriodicUpdates) {
-						success = 0;
-					} else {
-						success = UAVTalkSendObject(uavTalkCon, ev->obj, ev->instId, UAVObjGetTelemetryAcked(&metadata), REQ_TIMEOUT_MS);	// call blocks until ack is received or timeout
-					}
-					++retries;
-				}
-				// Update stats
-				txRetries += (retries - 1);
-				if (success == -1) {
-					++txErrors;
+				if (!pausePeriodicUpdates) {
+					sendObjectUpdate(ev->obj, ev->instId, &metadata);
 				}
 			}
 		}
@@ -351,20 +328,79 @@ static void processObjEvent(UAVObjEvent * ev)
 	}
 }
 
+/**
+ * Send an object update to the GCS. Acked updates don't wait for their ack,
+ * several of them are in flight at once and complete in transactionCompleted.
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t sendObjectUpdate(UAVObjHandle obj, uint16_t instId, UAVObjMetadata * metadata)
+{
+	if (UAVObjGetTelemetryAcked(metadata))
+		return UAVTalkSendObjectAsync(uavTalkCon, obj, instId, REQ_TIMEOUT_MS, MAX_RETRIES - 1, NULL);
+
+	if (routedByModem(obj))
+		return UAVTalkSendObjectUnbatched(uavTalkCon, obj, instId);
+
+	return UAVTalkSendObject(uavTalkCon, obj, instId, 0, 0);
+}
+
+/**
+ * The radio modem decides from the object ID in the frame header whether
+ * it keeps these objects or relays them, so they can't go in a multi-object
+ * frame where it would only see the ID of the batch.
+ */
+static bool routedByModem(UAVObjHandle obj)
+{
+	if (UAVObjIsMetaobject(obj))
+		obj = UAVObjGetLinkedObj(obj);
+
+	switch (UAVObjGetID(obj)) {
+	case HWTAULINK_OBJID:
+	case RFM22BRECEIVER_OBJID:
+	case RFM22BSTATUS_OBJID:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * Retry the transactions that timed out
+ * \return Time to wait for the next event before calling again
+ */
+static uint32_t processTransactions()
+{
+	int32_t nextTimeout = UAVTalkProcessTransactions(uavTalkCon);
+
+	if (nextTimeout < 0)
+		return PIOS_QUEUE_TIMEOUT_MAX;
+
+	return nextTimeout;
+}
+
 /**
  * Telemetry transmit task, regular priority
  */
 static void telemetryTxTask(void *parameters)
 {
 	UAVObjEvent ev;
+	uint32_t timeoutMs = PIOS_QUEUE_TIMEOUT_MAX;
 
 	// Loop forever
 	while (1) {
-		// Wait for queue message
-		if (PIOS_Queue_Receive(queue, &ev, PIOS_QUEUE_TIMEOUT_MAX) == true) {
+		// Wait for queue message, or for a transaction to time out
+		if (PIOS_Queue_Receive(queue, &ev, timeoutMs) == true) {
 			// Process event
 			processObjEvent(&ev);
+			// Process whatever queued up meanwhile, so it can share the
+			// batched frames, then send them
+			while (PIOS_Queue_Receive(queue, &ev, 0) == true) {
+				processObjEvent(&ev);
+			}
+			UAVTalkFlushBatch(uavTalkCon);
 		}
+		timeoutMs = processTransactions();
 	}
 }
 
@@ -375,14 +411,20 @@ static void telemetryTxTask(void *parameters)
 static void telemetryTxPriTask(void *parameters)
 {
 	UAVObjEvent ev;
+	uint32_t timeoutMs = PIOS_QUEUE_TIMEOUT_MAX;
 
 	// Loop forever
 	while (1) {
-		// Wait for queue message
-		if (PIOS_Queue_Receive(priorityQueue, &ev, PIOS_QUEUE_TIMEOUT_MAX) == true) {
+		// Wait for queue message, or for a transaction to time out
+		if (PIOS_Queue_Receive(priorityQueue, &ev, timeoutMs) == true) {
 			// Process event
 			processObjEvent(&ev);
+			while (PIOS_Queue_Receive(priorityQueue, &ev, 0) == true) {
+				processObjEvent(&ev);
+			}
+			UAVTalkFlushBatch(uavTalkCon);
 		}
+		timeoutMs = processTransactions();
 	}
 }
 #endif
@@ -399,14 +441,12 @@ static void telemetryRxTask(void *parameters)
 
 		if (inputPort) {
 			// Block until data are available
-			uint8_t serial_data[1];
+			uint8_t serial_data[RX_CHUNK_SIZE];
 			uint16_t bytes_to_process;
 
 			bytes_to_process = PIOS_COM_ReceiveBuffer(inputPort, serial_data, sizeof(serial_data), 500);
 			if (bytes_to_process > 0) {
-				for (uint8_t i = 0; i < bytes_to_process; i++) {
-					UAVTalkProcessInputStream(uavTalkCon,serial_data[i]);
-				}
+				UAVTalkProcessInputBuffer(uavTalkCon, serial_data, bytes_to_process);
 			}
 		} else {
 			PIOS_Thread_Sleep(5);
@@ -431,6 +471,48 @@ static int32_t transmitData(uint8_t * data, int32_t length)
 	return -1;
 }
 
+/**
+ * Reserve space in the tx buffer of the modem or USB port, for UAVTalk to
+ * write a message into directly.
+ * \param[in] length Length of the message
+ * \param[out] spans The reserved space, in one or two pieces
+ * \param[out] spanLengths Length of each piece
+ * \return -1 on failure, the message has to go through transmitData
+ * \return number of pieces on success
+ */
+static int32_t reserveData(uint16_t length, uint8_t *spans[2], uint16_t spanLengths[2])
+{
+	uintptr_t outputPort = getComPort();
+
+	if (!outputPort)
+		return -1;
+
+	struct pios_com_span reserved[2];
+	int32_t rc = PIOS_COM_ReserveTx(outputPort, length, reserved, TX_RESERVE_TIMEOUT_MS);
+	if (rc <= 0)
+		return -1;
+
+	// The port may change with the settings, commit to the one reserved
+	reservedPort = outputPort;
+	for (int32_t i = 0; i < rc; i++) {
+		spans[i] = reserved[i].buf;
+		spanLengths[i] = reserved[i].len;
+	}
+
+	return rc;
+}
+
+/**
+ * Transmit the message written into the space from reserveData.
+ * \param[in] length Length of the message, 0 to release the space
+ * \return -1 on failure
+ * \return number of bytes transmitted on success
+ */
+static int32_t commitData(uint16_t length)
+{
+	return PIOS_COM_CommitTx(reservedPort, length);
+}
+
 /**
  * Set update period of object (it must be already setup for periodic updates)
  * \param[in] obj The object to update
@@ -490,18 +572,14 @@ static void updateTelemetryStats()
 		flightStats.RxDataRate = (float)utalkStats.rxBytes / ((float)STATS_UPDATE_PERIOD_MS / 1000.0f);
 		flightStats.TxDataRate = (float)utalkStats.txBytes / ((float)STATS_UPDATE_PERIOD_MS / 1000.0f);
 		flightStats.RxFailures += utalkStats.rxErrors;
-		flightStats.TxFailures += txErrors;
-		flightStats.TxRetries += txRetries;
-		txErrors = 0;
-		txRetries = 0;
+		flightStats.TxFailures += utalkStats.txErrors;
+		flightStats.TxRetries += utalkStats.txRetries;
 	} else {
 		flightStats.RxDataRate = 0;
 		flightStats.TxDataRate = 0;
 		flightStats.RxFailures = 0;
 		flightStats.TxFailures = 0;
 		flightStats.TxRetries = 0;
-		txErrors = 0;
-		txRetries = 0;
 	}
 
 	// Check for connection timeout
@@ -544,6 +622,9 @@ static void updateTelemetryStats()
 		AlarmsClear(SYSTEMALARMS_ALARM_TELEMETRY);
 	} else {
 		AlarmsSet(SYSTEMALARMS_ALARM_TELEMETRY, SYSTEMALARMS_ALARM_ERROR);
+		// The next GCS to connect has to ask for batched frames and deltas again
+		UAVTalkSetBatching(uavTalkCon, false);
+		UAVTalkSetDeltaEncoding(uavTalkCon, false);
 	}
 
 	// Update object
@@ -629,6 +710,20 @@ static void session_managing_updated(UAVObjEvent * ev)
 			pausePeriodicUpdatesTime = PIOS_Thread_Systime();
 		} else if (sessionManaging.ObjectOfInterestIndex == 0xFF) {
 			pausePeriodicUpdates = false;
+			// The GCS asks for batched frames and deltas once the session is
+			// set up, answer with whether they are going to be used
+			if (sessionManaging.FrameBatching == SESSIONMANAGING_FRAMEBATCHING_ENABLED &&
+					UAVTalkSetBatching(uavTalkCon, true) != 0) {
+				sessionManaging.FrameBatching = SESSIONMANAGING_FRAMEBATCHING_DISABLED;
+			} else if (sessionManaging.FrameBatching != SESSIONMANAGING_FRAMEBATCHING_ENABLED) {
+				UAVTalkSetBatching(uavTalkCon, false);
+			}
+			if (sessionManaging.DeltaEncoding == SESSIONMANAGING_DELTAENCODING_ENABLED &&
+					UAVTalkSetDeltaEncoding(uavTalkCon, true) != 0) {
+				sessionManaging.DeltaEncoding = SESSIONMANAGING_DELTAENCODING_DISABLED;
+			} else if (sessionManaging.DeltaEncoding != SESSIONMANAGING_DELTAENCODING_ENABLED) {
+				UAVTalkSetDeltaEncoding(uavTalkCon, false);
+			}
 		} else if (sessionManaging.ObjectOfInterestIndex == 0xFE) {
 			pausePeriodicUpdates = true;
 			pausePeriodicUpdatesTime = PIOS_Thread_Systime();
@@ -10,4 +10,9 @@ void PIOS_SIM_GetGyros(float *);
 void PIOS_SIM_GetAttitude(float *);
 void PIOS_SIM_GetPosition(float *);
 
+void PIOS_SIM_SetLockstep(float duration);
+bool PIOS_SIM_IsLockstep(void);
+uint32_t PIOS_SIM_GetTimeuS(void);
+void PIOS_SIM_Idle(void);
+
 #endif /* PIOS_SIM_H */
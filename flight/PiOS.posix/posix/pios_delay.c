@@ -62,6 +62,10 @@ int32_t PIOS_DELAY_Init(void)
 */
 int32_t PIOS_DELAY_WaituS(uint32_t uS)
 {
+	// Code takes no time in lockstep mode, so neither does busy waiting
+	if (PIOS_SIM_IsLockstep())
+		return 0;
+
 	struct timespec wait,rest;
 	wait.tv_sec=0;
 	wait.tv_nsec=1000*uS;
@@ -86,6 +90,10 @@ int32_t PIOS_DELAY_WaituS(uint32_t uS)
 */
 int32_t PIOS_DELAY_WaitmS(uint32_t mS)
 {
+	// Code takes no time in lockstep mode, so neither does busy waiting
+	if (PIOS_SIM_IsLockstep())
+		return 0;
+
 	struct timespec wait,rest;
 	wait.tv_sec=mS/1000;
 	wait.tv_nsec=(mS%1000)*1000000;
@@ -99,14 +107,23 @@ int32_t PIOS_DELAY_WaitmS(uint32_t mS)
 
 uint32_t PIOS_DELAY_GetRaw()
 {
-	uint32_t raw_us = clock();
+	if (PIOS_SIM_IsLockstep())
+		return PIOS_SIM_GetTimeuS();
+
+	// Wall clock rather than clock(), which only counts the CPU time of the
+	// process and so misses all the time spent waiting
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	// Wraps like the hardware counter. Multiply unsigned, a signed time_t
+	// overflows after 35 minutes on 32 bit hosts.
+	uint32_t raw_us = (uint32_t) now.tv_sec * 1000000u + now.tv_nsec / 1000;
 	return raw_us;
 }
 
 uint32_t PIOS_DELAY_DiffuS(uint32_t ref)
 {
-	uint32_t diff_clock = clock() - ref;
-	uint32_t diff_us = diff_clock; // (CLOCKS_PER_SEC / 1000);
+	uint32_t diff_us = PIOS_DELAY_GetRaw() - ref;
 	return diff_us;
 }
 #endif
@@ -3,6 +3,19 @@
 #include "pios_sim_priv.h"
 #include "sim_model.h"
 
+#include <sys/time.h>		/* setitimer */
+
+//! Length of one simulation step, the period of the RTOS tick
+#define SIM_STEP_US (1000000 / CH_FREQUENCY)
+
+//! When set the virtual clock drives the system instead of the wall clock
+static bool lockstep;
+//! Virtual time in us, wraps like the counter behind PIOS_DELAY_GetRaw
+static uint32_t sim_time_us;
+//! Simulated time in us since the start and the time to stop at, 0 for never
+static uint64_t sim_elapsed_us;
+static uint64_t sim_end_us;
+
 struct pios_sim_state pios_sim_state = {
 	.accels = {0, 0, 0},
 	.gyros = {0, 0, 0},
@@ -22,21 +35,104 @@ int PIOS_SIM_Init()
 {
 	if (sim_model_init() != 0)
 		return -1;
+
+	if (lockstep) {
+		// Time now only advances from PIOS_SIM_Idle, stop the wall clock tick
+		struct itimerval stop = { { 0, 0 }, { 0, 0 } };
+		if (setitimer(PORT_TIMER_TYPE, &stop, NULL) != 0)
+			return -1;
+	}
+
 	return 0;
 }
 
 /**
  * Step the model simulation in the external library
+ *
+ * In lockstep mode this also advances the virtual clock one RTOS tick at a
+ * time and lets every task that wakes up run until it blocks again, so it
+ * must only be called from the idle thread.
  * @returns 0 for success, -1 for failure to step external library
  */
 int PIOS_SIM_Step(float dT) 
 {
-	if (sim_model_step(dT, &pios_sim_state) != 0)
-		return -1;
+	if (!lockstep) {
+		if (sim_model_step(dT, &pios_sim_state) != 0)
+			return -1;
+		return 0;
+	}
+
+	uint32_t steps = (uint32_t)(dT * 1e6f / SIM_STEP_US + 0.5f);
+	if (steps == 0)
+		steps = 1;
+
+	for (uint32_t i = 0; i < steps; i++) {
+		if (sim_model_step(SIM_STEP_US * 1e-6f, &pios_sim_state) != 0)
+			return -1;
+
+		sim_time_us += SIM_STEP_US;
+		sim_elapsed_us += SIM_STEP_US;
+		if (sim_end_us != 0 && sim_elapsed_us >= sim_end_us) {
+			printf("\nSimulated %.3f s.  Shutting down\n", sim_elapsed_us * 1e-6);
+			exit(0);
+		}
+
+		// What the timer signal does in wall clock mode, except that the
+		// tasks woken here get to run before the clock moves on
+		CH_IRQ_PROLOGUE();
+		chSysLockFromIsr();
+		chSysTimerHandlerI();
+		chSysUnlockFromIsr();
+		CH_IRQ_EPILOGUE();
+
+		chSysLock();
+		chSchRescheduleS();
+		chSysUnlock();
+	}
 
 	return 0;
 }
 
+/**
+ * Run in lockstep with a virtual clock instead of the wall clock. The clock
+ * only advances when every task is waiting, so each run sees the same times
+ * and the same order of events however fast or loaded the host is, and runs
+ * as fast as the tasks allow. Call before PIOS_SIM_Init.
+ * @param[in] duration simulated seconds after which to exit, 0 to run forever
+ */
+void PIOS_SIM_SetLockstep(float duration)
+{
+	lockstep = true;
+	sim_end_us = (uint64_t)(duration * 1e6f);
+}
+
+/**
+ * @returns true when the virtual clock drives the system
+ */
+bool PIOS_SIM_IsLockstep(void)
+{
+	return lockstep;
+}
+
+/**
+ * Get the virtual time
+ * @returns the virtual time in us, wrapping at 32 bits
+ */
+uint32_t PIOS_SIM_GetTimeuS(void)
+{
+	return sim_time_us;
+}
+
+/**
+ * Called from the idle thread. In lockstep mode all tasks are waiting when
+ * this runs, so move the simulation on to the next tick.
+ */
+void PIOS_SIM_Idle(void)
+{
+	if (lockstep)
+		PIOS_SIM_Step(SIM_STEP_US * 1e-6f);
+}
+
 /**
  * Set the actuator inputs to the model
  * @param[in] actuator pointer to an array of actuators to set
@@ -41,9 +41,11 @@
 static bool debug_fpe=false;
 
 static void Usage(char *cmdName) {
-	printf( "usage: %s [-f]\n"
+	printf( "usage: %s [-f] [-l] [-t seconds]\n"
 		"\n"
-		"\t-f\tEnables floating point exception trapping mode\n",
+		"\t-f\tEnables floating point exception trapping mode\n"
+		"\t-l\tRuns in lockstep with a virtual clock, as fast as possible\n"
+		"\t-t\tExits after the given simulated time, implies -l\n",
 		cmdName);
 
 	exit(1);
@@ -51,12 +53,23 @@ static void Usage(char *cmdName) {
 
 void PIOS_SYS_Args(int argc, char *argv[]) {
 	int opt;
+	bool lockstep = false;
+	float duration = 0;
 
-	while ((opt = getopt(argc, argv, "f")) != -1) {
+	while ((opt = getopt(argc, argv, "flt:")) != -1) {
 		switch (opt) {
 			case 'f':
 				debug_fpe=true;
 				break;
+			case 'l':
+				lockstep = true;
+				break;
+			case 't':
+				lockstep = true;
+				duration = atof(optarg);
+				if (duration <= 0)
+					Usage(argv[0]);
+				break;
 			default:
 				Usage(argv[0]);
 				break;
@@ -66,6 +79,9 @@ void PIOS_SYS_Args(int argc, char *argv[]) {
 	if (optind < argc) {
 		Usage(argv[0]);
 	}
+
+	if (lockstep)
+		PIOS_SIM_SetLockstep(duration);
 }
 
 /**
@@ -97,6 +113,9 @@ void PIOS_SYS_Init(void)
 	int rc = sigaction(SIGINT, &sa_int, NULL);
 	assert(rc == 0);
 
+	rc = PIOS_SIM_Init();
+	assert(rc == 0);
+
 	if (debug_fpe) {
 		struct sigaction sa_fpe = {
 			.sa_sigaction = sigfpe_handler,
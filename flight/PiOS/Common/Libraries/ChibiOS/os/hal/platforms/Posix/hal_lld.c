@@ -31,6 +31,7 @@
 
 #include "ch.h"
 #include "hal.h"
+#include "pios_sim.h"
 
 /*===========================================================================*/
 /* Driver exported variables.                                                */
@@ -87,6 +88,11 @@ void hal_lld_init(void) {
 }
 
 halrtcnt_t hal_lld_get_counter_value(void) {
+  /* Run time statistics follow the virtual clock in lockstep mode, where
+     tasks take no time and only the idle thread sees the clock move. */
+  if (PIOS_SIM_IsLockstep())
+    return PIOS_SIM_GetTimeuS();
+
   struct tms temp;
 
   times(&temp);
@@ -96,6 +102,9 @@ halrtcnt_t hal_lld_get_counter_value(void) {
 
 halclock_t hal_lld_get_counter_frequency(void) {
 
+	if (PIOS_SIM_IsLockstep())
+		return 1000000;
+
 	return sysconf(_SC_CLK_TCK);
 }
 
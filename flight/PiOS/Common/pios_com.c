@@ -64,6 +64,7 @@ struct pios_com_dev {
 
 	t_fifo_buffer rx;
 	t_fifo_buffer tx;
+	uint16_t tx_reserved;
 };
 
 static bool PIOS_COM_validate(struct pios_com_dev * com_dev)
@@ -368,6 +369,116 @@ int32_t PIOS_COM_SendBuffer(uintptr_t com_id, const uint8_t *buffer, uint16_t le
 	return len;
 }
 
+/**
+* Reserves space for a package in the tx buffer of a port, so that it can
+* be written in place instead of copied in by PIOS_COM_SendBuffer. The
+* space is one span, or two when it wraps around the end of the buffer.
+* Other senders are held off until PIOS_COM_CommitTx is called.
+* \param[in] port COM port
+* \param[in] len number of bytes to reserve
+* \param[out] spans the reserved space
+* \param[in] timeout_ms time to wait for the space to become free
+* \return -1 if port not available
+* \return -2 if the space did not become free in time, or never can
+*            caller should send the package with PIOS_COM_SendBuffer
+* \return -3 another thread is already sending
+* \return number of spans on success
+*/
+int32_t PIOS_COM_ReserveTx(uintptr_t com_id, uint16_t len, struct pios_com_span spans[2], uint32_t timeout_ms)
+{
+	struct pios_com_dev * com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev)) {
+		/* Undefined COM port for this board (see pios_board.c) */
+		return -1;
+	}
+
+	PIOS_Assert(com_dev->has_tx);
+
+	if (len > fifoBuf_getSize(&com_dev->tx)) {
+		/* This will never fit, it has to go in fragments */
+		return -2;
+	}
+
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+	if (PIOS_Mutex_Lock(com_dev->sendbuffer_mtx, timeout_ms) != true) {
+		return -3;
+	}
+#endif /* defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS) */
+
+	while (1) {
+		/* Checked on every retry, the device can go down while we wait */
+		if (com_dev->driver->available && !com_dev->driver->available(com_dev->lower_id)) {
+			/* Underlying device is down/unconnected, see PIOS_COM_SendBufferNonBlocking */
+			fifoBuf_clearData(&com_dev->tx);
+		}
+
+		if (len <= fifoBuf_getFree(&com_dev->tx)) {
+			break;
+		}
+
+		/* Make sure the transmitter is running while we wait */
+		if (com_dev->driver->tx_start) {
+			(com_dev->driver->tx_start)(com_dev->lower_id,
+						fifoBuf_getUsed(&com_dev->tx));
+		}
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+		if (timeout_ms == 0 || PIOS_Semaphore_Take(com_dev->tx_sem, timeout_ms) != true) {
+			PIOS_Mutex_Unlock(com_dev->sendbuffer_mtx);
+			return -2;
+		}
+#else
+		if (timeout_ms == 0) {
+			return -2;
+		}
+		PIOS_DELAY_WaitmS(1);
+		timeout_ms--;
+#endif
+	}
+
+	com_dev->tx_reserved = len;
+
+	return fifoBuf_reserveData(&com_dev->tx, len, &spans[0].buf, &spans[0].len, &spans[1].buf, &spans[1].len);
+}
+
+/**
+* Sends the package written into the space from PIOS_COM_ReserveTx
+* \param[in] port COM port
+* \param[in] len number of bytes written, at most as many as reserved, 0 to
+*            give the space back
+* \return -1 if port not available
+* \return number of bytes transmitted on success
+*/
+int32_t PIOS_COM_CommitTx(uintptr_t com_id, uint16_t len)
+{
+	struct pios_com_dev * com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev)) {
+		/* Undefined COM port for this board (see pios_board.c) */
+		return -1;
+	}
+
+	PIOS_Assert(len <= com_dev->tx_reserved);
+	com_dev->tx_reserved = 0;
+
+	/* A device that went down meanwhile acts like an infinite data sink */
+	if (len > 0 &&
+	    (!com_dev->driver->available || com_dev->driver->available(com_dev->lower_id))) {
+		fifoBuf_commitData(&com_dev->tx, len);
+
+		/* More data has been put in the tx buffer, make sure the tx is started */
+		if (com_dev->driver->tx_start) {
+			com_dev->driver->tx_start(com_dev->lower_id,
+						  fifoBuf_getUsed(&com_dev->tx));
+		}
+	}
+
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+	PIOS_Mutex_Unlock(com_dev->sendbuffer_mtx);
+#endif /* PIOS_INCLUDE_FREERTOS */
+	return len;
+}
+
 /**
 * Sends a single character over given port
 * \param[in] port COM port
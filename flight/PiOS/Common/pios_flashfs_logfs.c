@@ -32,9 +32,13 @@
 
 #include <stdbool.h>
 #include <stddef.h>		/* NULL */
+#include <string.h>		/* memmove, memcmp */
 
 #define MIN(x,y) ((x) < (y) ? (x) : (y))
 
+/* Old versions replaced in a batch, waiting to be marked obsolete */
+#define LOGFS_MAX_PENDING_OBSOLETE 32
+
 /*
  * Filesystem state data tracked in RAM
  */
@@ -43,6 +47,13 @@ enum pios_flashfs_logfs_dev_magic {
 	PIOS_FLASHFS_LOGFS_DEV_MAGIC = 0x94938201,
 };
 
+/* Location of an active object, kept sorted by obj_id and obj_inst_id */
+struct logfs_index_entry {
+	uint32_t obj_id;
+	uint16_t obj_inst_id;
+	uint16_t slot_id;
+};
+
 struct logfs_state {
 	enum pios_flashfs_logfs_dev_magic magic;
 	const struct flashfs_logfs_cfg *cfg;
@@ -56,6 +67,21 @@ struct logfs_state {
 	uint16_t num_free_slots;   /* slots in free state */
 	uint16_t num_active_slots; /* slots in active state */
 
+	/* Index of the active slots in the mounted arena, so objects can be
+	 * found without scanning the slot headers in flash.  When it is not
+	 * complete (out of room, or more than one active version of an
+	 * object) objects missing from it still need a scan.
+	 */
+	struct logfs_index_entry *index;
+	uint16_t index_size;       /* entries allocated */
+	uint16_t index_used;       /* entries in use */
+	bool index_complete;       /* every active slot is in the index */
+
+	/* Saves grouped into one transaction by PIOS_FLASHFS_BeginBatch */
+	bool batching;
+	uint16_t num_pending_obsolete;
+	uint16_t pending_obsolete[LOGFS_MAX_PENDING_OBSOLETE];
+
 	/* Underlying flash partition handle */
 	uintptr_t partition_id;
 	uint32_t partition_size;
@@ -398,12 +424,87 @@ static bool logfs_log_is_full(const struct logfs_state *logfs)
 	return (logfs->num_free_slots == 0);
 }
 
+/*
+ * Find the position of an object in the index
+ * true = the object is at *pos
+ * false = the object is not in the index, it belongs at *pos
+ */
+static bool logfs_index_search(const struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id, uint16_t *pos)
+{
+	uint16_t lo = 0;
+	uint16_t hi = logfs->index_used;
+
+	while (lo < hi) {
+		uint16_t mid = lo + (hi - lo) / 2;
+		const struct logfs_index_entry *entry = &logfs->index[mid];
+
+		if (entry->obj_id == obj_id && entry->obj_inst_id == obj_inst_id) {
+			*pos = mid;
+			return true;
+		}
+		if (entry->obj_id < obj_id ||
+			(entry->obj_id == obj_id && entry->obj_inst_id < obj_inst_id)) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	*pos = lo;
+	return false;
+}
+
+static void logfs_index_insert(struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id, uint16_t slot_id)
+{
+	if (!logfs->index) {
+		return;
+	}
+
+	uint16_t pos;
+	if (logfs_index_search(logfs, obj_id, obj_inst_id, &pos)) {
+		/* Another active version, keep the first one like a scan would */
+		logfs->index_complete = false;
+		return;
+	}
+
+	if (logfs->index_used == logfs->index_size) {
+		/* Out of room, this object can only be found by a scan */
+		logfs->index_complete = false;
+		return;
+	}
+
+	memmove(&logfs->index[pos + 1], &logfs->index[pos],
+		(logfs->index_used - pos) * sizeof(logfs->index[0]));
+	logfs->index[pos].obj_id      = obj_id;
+	logfs->index[pos].obj_inst_id = obj_inst_id;
+	logfs->index[pos].slot_id     = slot_id;
+	logfs->index_used++;
+}
+
+static void logfs_index_remove(struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	if (!logfs->index) {
+		return;
+	}
+
+	uint16_t pos;
+	if (!logfs_index_search(logfs, obj_id, obj_inst_id, &pos)) {
+		return;
+	}
+
+	logfs->index_used--;
+	memmove(&logfs->index[pos], &logfs->index[pos + 1],
+		(logfs->index_used - pos) * sizeof(logfs->index[0]));
+}
+
 static int32_t logfs_unmount_log(struct logfs_state *logfs)
 {
 	PIOS_Assert (logfs->mounted);
 
 	logfs->num_active_slots = 0;
 	logfs->num_free_slots   = 0;
+	logfs->index_used       = 0;
+	logfs->index_complete   = false;
 	logfs->mounted          = false;
 
 	return 0;
@@ -416,8 +517,10 @@ static int32_t logfs_mount_log(struct logfs_state *logfs, uint8_t arena_id)
 	logfs->num_active_slots = 0;
 	logfs->num_free_slots   = 0;
 	logfs->active_arena_id  = arena_id;
+	logfs->index_used       = 0;
+	logfs->index_complete   = (logfs->index != NULL);
 
-	/* Scan the log to find out how full it is */
+	/* Scan the log to find out how full it is, and where the objects are */
 	for (uint16_t slot_id = 1;
 	     slot_id < (logfs->cfg->arena_size / logfs->cfg->slot_size);
 	     slot_id++) {
@@ -443,6 +546,7 @@ static int32_t logfs_mount_log(struct logfs_state *logfs, uint8_t arena_id)
 			break;
 		case SLOT_STATE_ACTIVE:
 			logfs->num_active_slots++;
+			logfs_index_insert(logfs, slot_hdr.obj_id, slot_hdr.obj_inst_id, slot_id);
 			break;
 		case SLOT_STATE_RESERVED:
 		case SLOT_STATE_OBSOLETE:
@@ -476,6 +580,9 @@ static void PIOS_FLASHFS_Logfs_free(struct logfs_state *logfs)
 {
 	/* Invalidate the magic */
 	logfs->magic = ~PIOS_FLASHFS_LOGFS_DEV_MAGIC;
+	if (logfs->index) {
+		PIOS_free(logfs->index);
+	}
 	PIOS_free(logfs);
 }
 
@@ -520,6 +627,18 @@ int32_t PIOS_FLASHFS_Logfs_Init(uintptr_t *fs_id, const struct flashfs_logfs_cfg
 	logfs->partition_id   = partition_id; /* underlying partition */
 	logfs->partition_size = partition_size; /* size of underlying partition */
 	logfs->mounted        = false;
+	logfs->batching       = false;
+	logfs->num_pending_obsolete = 0;
+
+	/* Index the slots if there is RAM for it, otherwise always scan */
+	logfs->index          = NULL;
+	logfs->index_size     = 0;
+	if (cfg->index_size > 0) {
+		logfs->index = (struct logfs_index_entry *)PIOS_malloc(cfg->index_size * sizeof(*logfs->index));
+		if (logfs->index) {
+			logfs->index_size = cfg->index_size;
+		}
+	}
 
 	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
 		rc = -1;
@@ -696,33 +815,158 @@ static int16_t logfs_object_find_next (const struct logfs_state *logfs, struct s
 }
 
 /* NOTE: Must be called while holding the flash transaction lock */
-/* OPTIMIZE: could trust that there is at most one active version of every object and terminate the search when we find one */
+static int16_t logfs_object_find (const struct logfs_state *logfs, struct slot_header *slot_hdr, uint16_t *slot_id, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	uint16_t pos;
+	if (logfs->index && logfs_index_search(logfs, obj_id, obj_inst_id, &pos)) {
+		*slot_id = logfs->index[pos].slot_id;
+		uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, *slot_id);
+
+		if (PIOS_FLASH_read_data(logfs->partition_id,
+						slot_addr,
+						(uint8_t *)slot_hdr,
+						sizeof (*slot_hdr)) != 0) {
+			return -2;
+		}
+		if (slot_hdr->state == SLOT_STATE_ACTIVE &&
+			slot_hdr->obj_id      == obj_id &&
+			slot_hdr->obj_inst_id == obj_inst_id) {
+			return 0;
+		}
+
+		/* The index does not match the flash, something is broken */
+		PIOS_DEBUG_Assert(0);
+	} else if (logfs->index_complete) {
+		/* Every active object is in the index, no need to look further */
+		return -1;
+	}
+
+	*slot_id = 0;
+	return logfs_object_find_next (logfs, slot_hdr, slot_id, obj_id, obj_inst_id);
+}
+
+/* NOTE: Must be called while holding the flash transaction lock */
+static int32_t logfs_obsolete_slot (struct logfs_state *logfs, uint16_t slot_id, struct slot_header *slot_hdr)
+{
+	slot_hdr->state = SLOT_STATE_OBSOLETE;
+	uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, slot_id);
+
+	if (PIOS_FLASH_write_data(logfs->partition_id,
+					slot_addr,
+					(uint8_t *)slot_hdr,
+					sizeof(*slot_hdr)) != 0) {
+		return -1;
+	}
+
+	/* Object has been successfully obsoleted and is no longer active */
+	logfs->num_active_slots--;
+	return 0;
+}
+
+/* NOTE: Must be called while holding the flash transaction lock */
+static int32_t logfs_flush_obsolete (struct logfs_state *logfs)
+{
+	/* Only the state at the start of the header changes */
+	enum slot_state state = SLOT_STATE_OBSOLETE;
+
+	while (logfs->num_pending_obsolete > 0) {
+		uint16_t slot_id = logfs->pending_obsolete[logfs->num_pending_obsolete - 1];
+		uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, slot_id);
+
+		if (PIOS_FLASH_write_data(logfs->partition_id,
+						slot_addr,
+						(uint8_t *)&state,
+						sizeof(state)) != 0) {
+			/* More than one version is active now, only a scan finds them all */
+			logfs->index_complete = false;
+			return -1;
+		}
+
+		logfs->num_pending_obsolete--;
+		logfs->num_active_slots--;
+	}
+
+	return 0;
+}
+
+/*
+ * Does the slot already hold this data?
+ * 1 = same data
+ * 0 = different data
+ * -1 = failed to read the slot
+ *
+ * NOTE: Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_slot_data_equals (const struct logfs_state *logfs, uint16_t slot_id, const uint8_t *obj_data, uint16_t obj_size)
+{
+	uint8_t data_block[RAW_COPY_BLOCK_SIZE];
+	uintptr_t addr = logfs_get_addr (logfs, logfs->active_arena_id, slot_id) + sizeof(struct slot_header);
+
+	while (obj_size) {
+		uint16_t blk_size = MIN(obj_size, RAW_COPY_BLOCK_SIZE);
+
+		if (PIOS_FLASH_read_data(logfs->partition_id,
+						addr,
+						data_block,
+						blk_size) != 0) {
+			return -1;
+		}
+		if (memcmp(data_block, obj_data, blk_size) != 0) {
+			return 0;
+		}
+
+		obj_size -= blk_size;
+		obj_data += blk_size;
+		addr += blk_size;
+	}
+
+	return 1;
+}
+
+/* NOTE: Must be called while holding the flash transaction lock */
 static int8_t logfs_delete_object (struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
 {
 	int8_t rc;
+	struct slot_header slot_hdr;
+
+	if (logfs->index_complete) {
+		/* There is at most one active version, and the index knows where */
+		uint16_t slot_id;
+		switch (logfs_object_find (logfs, &slot_hdr, &slot_id, obj_id, obj_inst_id)) {
+		case 0:
+			if (logfs_obsolete_slot (logfs, slot_id, &slot_hdr) != 0) {
+				rc = -2;
+				goto out_exit;
+			}
+			logfs_index_remove(logfs, obj_id, obj_inst_id);
+			rc = 0;
+			break;
+		case -1:
+			/* Object not found */
+			rc = 0;
+			break;
+		default:
+			/* Error occurred during search */
+			rc = -1;
+			break;
+		}
+		goto out_exit;
+	}
 
 	bool more = true;
 	uint16_t curr_slot_id = 0;
 	do {
-		struct slot_header slot_hdr;
 		switch (logfs_object_find_next (logfs, &slot_hdr, &curr_slot_id, obj_id, obj_inst_id)) {
 		case 0:
 			/* Found a matching slot.  Obsolete it. */
-			slot_hdr.state = SLOT_STATE_OBSOLETE;
-			uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, curr_slot_id);
-
-			if (PIOS_FLASH_write_data(logfs->partition_id,
-							slot_addr,
-							(uint8_t *)&slot_hdr,
-							sizeof(slot_hdr)) != 0) {
+			if (logfs_obsolete_slot (logfs, curr_slot_id, &slot_hdr) != 0) {
 				rc = -2;
 				goto out_exit;
 			}
-			/* Object has been successfully obsoleted and is no longer active */
-			logfs->num_active_slots--;
 			break;
 		case -1:
 			/* Search completed, object not found */
+			logfs_index_remove(logfs, obj_id, obj_inst_id);
 			more = false;
 			rc = 0;
 			break;
@@ -832,6 +1076,7 @@ static int8_t logfs_append_to_log (struct logfs_state *logfs, uint32_t obj_id, u
 
 	/* Object has been successfully written to the slot */
 	logfs->num_active_slots++;
+	logfs_index_insert(logfs, obj_id, obj_inst_id, free_slot_id);
 	return 0;
 }
 
@@ -964,9 +1209,9 @@ int32_t PIOS_FLASHFS_ObjLoad(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
 	}
 
 	/* Find the object in the log */
-	uint16_t slot_id = 0;
+	uint16_t slot_id;
 	struct slot_header slot_hdr;
-	if (logfs_object_find_next (logfs, &slot_hdr, &slot_id, obj_id, obj_inst_id) != 0) {
+	if (logfs_object_find (logfs, &slot_hdr, &slot_id, obj_id, obj_inst_id) != 0) {
 		/* Object does not exist in fs */
 		rc = -3;
 		goto out_end_trans;
@@ -1043,6 +1288,192 @@ out_exit:
 	return rc;
 }
 
+/**
+ * @brief Start saving a group of objects in one transaction
+ * The flash stays locked until PIOS_FLASHFS_CommitBatch, so the only other
+ * calls allowed from this thread in the meantime are PIOS_FLASHFS_ObjSaveBatched.
+ * @param[in] fs_id The filesystem to use for this action
+ * @return 0 if success or error code
+ * @retval -1 if fs_id is not a valid filesystem instance
+ * @retval -2 if failed to start transaction
+ */
+int32_t PIOS_FLASHFS_BeginBatch(uintptr_t fs_id)
+{
+	struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+	if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+		return -1;
+	}
+
+	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
+		return -2;
+	}
+
+	PIOS_Assert(!logfs->batching);
+	logfs->batching = true;
+	logfs->num_pending_obsolete = 0;
+
+	return 0;
+}
+
+/**
+ * @brief Saves one object instance as part of a batch
+ * Unlike PIOS_FLASHFS_ObjSave, an object that is already stored with the
+ * same contents is left alone.  When the index knows where the previous
+ * version is, it is marked obsolete together with the others at the end
+ * of the batch, after the new version has been written.
+ * @param[in] fs_id The filesystem to use for this action
+ * @param[in] obj UAVObject ID of the object to save
+ * @param[in] obj_inst_id The instance number of the object being saved
+ * @param[in] obj_data Contents of the object being saved
+ * @param[in] obj_size Size of the object being saved
+ * @return 0 if success or error code
+ * @retval -1 if fs_id is not a valid filesystem instance
+ * @retval -2 if no batch was started
+ * @retval -3 if failure to find or delete any previous versions of the object
+ * @retval -4 if filesystem is entirely full and garbage collection won't help
+ * @retval -5 if garbage collection failed
+ * @retval -6 if filesystem is full even after garbage collection should have freed space
+ * @retval -7 if writing the new object to the filesystem failed
+ */
+int32_t PIOS_FLASHFS_ObjSaveBatched(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t *obj_data, uint16_t obj_size)
+{
+	struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+	if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+		return -1;
+	}
+
+	if (!logfs->batching) {
+		return -2;
+	}
+
+	PIOS_Assert(obj_size <= (logfs->cfg->slot_size - sizeof(struct slot_header)));
+
+	/* Find the current version of the object */
+	uint16_t old_slot_id;
+	struct slot_header old_slot_hdr;
+	int16_t found = logfs_object_find (logfs, &old_slot_hdr, &old_slot_id, obj_id, obj_inst_id);
+	if (found < -1) {
+		return -3;
+	}
+
+	if (found == 0 && old_slot_hdr.obj_size == obj_size) {
+		switch (logfs_slot_data_equals (logfs, old_slot_id, obj_data, obj_size)) {
+		case 1:
+			/* Nothing changed, nothing to write */
+			return 0;
+		case 0:
+			break;
+		default:
+			return -3;
+		}
+	}
+
+	if (logfs_log_is_full(logfs)) {
+		/* Let gc drop the versions waiting to be obsoleted instead of copying them */
+		if (logfs_flush_obsolete(logfs) != 0) {
+			return -3;
+		}
+
+		if (found == 0 && logfs_fs_is_full(logfs)) {
+			/* Only the previous version is left to make room */
+			if (logfs_obsolete_slot (logfs, old_slot_id, &old_slot_hdr) != 0) {
+				return -3;
+			}
+			logfs_index_remove(logfs, obj_id, obj_inst_id);
+			found = -1;
+		}
+
+		if (logfs_fs_is_full(logfs)) {
+			return -4;
+		}
+
+		if (logfs_garbage_collect(logfs) != 0) {
+			return -5;
+		}
+
+		if (logfs_log_is_full(logfs)) {
+			PIOS_DEBUG_Assert(0);
+			return -6;
+		}
+
+		/* The slots moved, look for the previous version again */
+		if (found == 0) {
+			found = logfs_object_find (logfs, &old_slot_hdr, &old_slot_id, obj_id, obj_inst_id);
+			if (found < -1) {
+				return -3;
+			}
+		}
+	}
+
+	bool defer_obsolete = (found == 0 && logfs->index_complete);
+	if (found == 0 && !defer_obsolete) {
+		/* Old versions could be anywhere, delete them all before writing */
+		if (logfs_delete_object (logfs, obj_id, obj_inst_id) != 0) {
+			return -3;
+		}
+	}
+
+	if (defer_obsolete) {
+		/* Make room to remember the previous version */
+		if (logfs->num_pending_obsolete == LOGFS_MAX_PENDING_OBSOLETE &&
+			logfs_flush_obsolete(logfs) != 0) {
+			return -3;
+		}
+
+		/* The index moves on to the new version */
+		logfs_index_remove(logfs, obj_id, obj_inst_id);
+	}
+
+	if (logfs_append_to_log(logfs, obj_id, obj_inst_id, obj_data, obj_size) != 0) {
+		if (defer_obsolete) {
+			logfs_index_insert(logfs, obj_id, obj_inst_id, old_slot_id);
+		}
+		return -7;
+	}
+
+	if (defer_obsolete) {
+		logfs->pending_obsolete[logfs->num_pending_obsolete++] = old_slot_id;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Finish a batch, marking the replaced versions obsolete
+ * @param[in] fs_id The filesystem to use for this action
+ * @return 0 if success or error code
+ * @retval -1 if fs_id is not a valid filesystem instance
+ * @retval -2 if no batch was started
+ * @retval -3 if failed to obsolete the replaced versions
+ */
+int32_t PIOS_FLASHFS_CommitBatch(uintptr_t fs_id)
+{
+	int32_t rc;
+
+	struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+	if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+		return -1;
+	}
+
+	if (!logfs->batching) {
+		return -2;
+	}
+
+	if (logfs_flush_obsolete(logfs) != 0) {
+		rc = -3;
+	} else {
+		rc = 0;
+	}
+
+	logfs->batching = false;
+	PIOS_FLASH_end_transaction(logfs->partition_id);
+
+	return rc;
+}
+
 /**
  * @brief Erases all filesystem arenas and activate the first arena
  * @param[in] fs_id The filesystem to use for this action
@@ -203,7 +203,10 @@ void PIOS_Thread_Scheduler_Resume(void)
 
 #elif defined(PIOS_INCLUDE_CHIBIOS)
 
-#define ST2MS(n) (((((n) - 1UL) * 1000UL) / CH_FREQUENCY) + 1UL)
+#define ST2MS(n) ((((n) * 1000UL) + CH_FREQUENCY - 1UL) / CH_FREQUENCY)
+
+/* MS2ST() from ChibiOS wraps around for 0 ms, which is a valid time stamp */
+#define MS2ST_STAMP(msec) ((msec) == 0 ? (systime_t)0 : MS2ST(msec))
 
 /**
  * Compute size that is at rounded up to the nearest
@@ -347,13 +350,14 @@ void PIOS_Thread_Sleep(uint32_t time_ms)
  */
 void PIOS_Thread_Sleep_Until(uint32_t *previous_ms, uint32_t increment_ms)
 {
-	systime_t future = MS2ST(*previous_ms) + MS2ST(increment_ms);
+	systime_t previous = MS2ST_STAMP(*previous_ms);
+	systime_t future = previous + MS2ST_STAMP(increment_ms);
 	chSysLock();
 	systime_t now = chTimeNow();
 	int mustDelay =
-		now < MS2ST(*previous_ms) ?
-		(now < future && future < MS2ST(*previous_ms)) :
-		(now < future || future < MS2ST(*previous_ms));
+		now < previous ?
+		(now < future && future < previous) :
+		(now < future || future < previous);
 	if (mustDelay)
 		chThdSleepS(future - now);
 	chSysUnlock();
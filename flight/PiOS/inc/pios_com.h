@@ -46,12 +46,20 @@ struct pios_com_driver {
 	bool (*available)(uintptr_t id);
 };
 
+//! Part of the space reserved in a tx buffer, see PIOS_COM_ReserveTx
+struct pios_com_span {
+	uint8_t *buf;
+	uint16_t len;
+};
+
 /* Public Functions */
 extern int32_t PIOS_COM_ChangeBaud(uintptr_t com_id, uint32_t baud);
 extern int32_t PIOS_COM_SendCharNonBlocking(uintptr_t com_id, char c);
 extern int32_t PIOS_COM_SendChar(uintptr_t com_id, char c);
 extern int32_t PIOS_COM_SendBufferNonBlocking(uintptr_t com_id, const uint8_t *buffer, uint16_t len);
 extern int32_t PIOS_COM_SendBuffer(uintptr_t com_id, const uint8_t *buffer, uint16_t len);
+extern int32_t PIOS_COM_ReserveTx(uintptr_t com_id, uint16_t len, struct pios_com_span spans[2], uint32_t timeout_ms);
+extern int32_t PIOS_COM_CommitTx(uintptr_t com_id, uint16_t len);
 extern int32_t PIOS_COM_SendStringNonBlocking(uintptr_t com_id, const char *str);
 extern int32_t PIOS_COM_SendString(uintptr_t com_id, const char *str);
 extern int32_t PIOS_COM_SendFormattedStringNonBlocking(uintptr_t com_id, const char *format, ...);
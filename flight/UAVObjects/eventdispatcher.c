@@ -49,6 +49,9 @@
 
 #define TASK_PRIORITY PIOS_THREAD_PRIO_HIGH
 #define MAX_UPDATE_PERIOD_MS 1000
+#define SCHEDULE_CHUNK 16
+#define SCHEDULE_MAX_CHUNKS 13 /* Enough to index below NOT_SCHEDULED */
+#define NOT_SCHEDULED 0xFFFF
 
 // Private types
 
@@ -69,12 +72,25 @@ struct PeriodicObjectListStruct {
 	EventCallbackInfo evInfo; /** Event callback information */
     uint16_t updatePeriodMs; /** Update period in ms or 0 if no periodic updates are needed */
     int32_t timeToNextUpdateMs; /** Time delay to the next update */
+	uint16_t heapIndex; /** Position in the schedule heap or NOT_SCHEDULED */
+	int32_t lastUpdateMs; /** Time of the last update, used for the jitter */
+	EventPeriodicStats stats; /** Lateness and jitter of this event */
     struct PeriodicObjectListStruct* next; /** Needed by linked list library (utlist.h) */
 };
 typedef struct PeriodicObjectListStruct PeriodicObjectList;
 
 // Private variables
 static PeriodicObjectList* objList;
+/*
+ * Min-heap of the periodic events ordered by the time of their next update,
+ * so each tick only visits the events that are due. It is kept in chunks
+ * that double in size and are allocated as it grows, then kept, as the heap
+ * of the hardware targets cannot free. Chunk n holds SCHEDULE_CHUNK << n
+ * events.
+ */
+static PeriodicObjectList** schedule[SCHEDULE_MAX_CHUNKS];
+static uint16_t scheduleSize;
+#define Scheduled(index) (*scheduleSlot(index))
 static struct pios_queue *queue;
 static struct pios_thread *eventTaskHandle;
 static struct pios_recursive_mutex *mutex;
@@ -86,6 +102,15 @@ static void eventTask();
 static int32_t eventPeriodicCreate(UAVObjEvent* ev, UAVObjEventCallback cb, struct pios_queue *queue, uint16_t periodMs);
 static int32_t eventPeriodicUpdate(UAVObjEvent* ev, UAVObjEventCallback cb, struct pios_queue *queue, uint16_t periodMs);
 static uint16_t randomizePeriod(uint16_t periodMs);
+static PeriodicObjectList* eventPeriodicFind(UAVObjEvent* ev, UAVObjEventCallback cb, struct pios_queue *queue);
+static int32_t eventPeriodicGetStats(UAVObjEvent* ev, UAVObjEventCallback cb, struct pios_queue *queue, EventPeriodicStats* statsOut);
+static void updatePeriodicStats(PeriodicObjectList* objEntry, int32_t timeNow, int32_t lateness);
+static int32_t scheduleInsert(PeriodicObjectList* objEntry);
+static void scheduleRemove(PeriodicObjectList* objEntry);
+static void scheduleSiftUp(uint16_t index);
+static void scheduleSiftDown(uint16_t index);
+static uint16_t scheduleChunk(uint16_t index);
+static PeriodicObjectList** scheduleSlot(uint16_t index);
 
 
 /**
@@ -96,6 +121,7 @@ int32_t EventDispatcherInitialize()
 {
 	// Initialize variables
 	objList = NULL;
+	scheduleSize = 0;
 	memset(&stats, 0, sizeof(EventStats));
 
 	// Create mutex
@@ -203,6 +229,76 @@ int32_t EventPeriodicQueueUpdate(UAVObjEvent* ev, struct pios_queue *queue, uint
 	return eventPeriodicUpdate(ev, 0, queue, periodMs);
 }
 
+/**
+ * Get the lateness and jitter statistics of a periodic event.
+ * \param[in] ev The event
+ * \param[in] cb The callback
+ * \param[out] statsOut The statistics of the event
+ * \return Success (0), failure (-1)
+ */
+int32_t EventPeriodicCallbackGetStats(UAVObjEvent* ev, UAVObjEventCallback cb, EventPeriodicStats* statsOut)
+{
+	return eventPeriodicGetStats(ev, cb, 0, statsOut);
+}
+
+/**
+ * Get the lateness and jitter statistics of a periodic event.
+ * \param[in] ev The event
+ * \param[in] queue The queue
+ * \param[out] statsOut The statistics of the event
+ * \return Success (0), failure (-1)
+ */
+int32_t EventPeriodicQueueGetStats(UAVObjEvent* ev, struct pios_queue *queue, EventPeriodicStats* statsOut)
+{
+	return eventPeriodicGetStats(ev, 0, queue, statsOut);
+}
+
+/**
+ * Find a periodic event, must be called with the mutex held.
+ * \return The entry of the event or NULL if it does not exist
+ */
+static PeriodicObjectList* eventPeriodicFind(UAVObjEvent* ev, UAVObjEventCallback cb, struct pios_queue *queue)
+{
+	PeriodicObjectList* objEntry;
+	LL_FOREACH(objList, objEntry)
+	{
+		if (objEntry->evInfo.cb == cb &&
+			objEntry->evInfo.queue == queue &&
+			objEntry->evInfo.ev.obj == ev->obj &&
+			objEntry->evInfo.ev.instId == ev->instId &&
+			objEntry->evInfo.ev.event == ev->event)
+		{
+			return objEntry;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Get the statistics of a periodic event.
+ * \param[in] ev The event
+ * \param[in] cb The callback or zero if none
+ * \param[in] queue The queue or zero if none
+ * \param[out] statsOut The statistics of the event
+ * \return Success (0), failure (-1)
+ */
+static int32_t eventPeriodicGetStats(UAVObjEvent* ev, UAVObjEventCallback cb, struct pios_queue *queue, EventPeriodicStats* statsOut)
+{
+	PeriodicObjectList* objEntry;
+	int32_t rc = -1;
+
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	objEntry = eventPeriodicFind(ev, cb, queue);
+	if (objEntry != NULL)
+	{
+		memcpy(statsOut, &objEntry->stats, sizeof(EventPeriodicStats));
+		rc = 0;
+	}
+	PIOS_Recursive_Mutex_Unlock(mutex);
+
+	return rc;
+}
+
 /**
  * Dispatch an event through a callback at periodic intervals.
  * \param[in] ev The event to be dispatched
@@ -217,22 +313,18 @@ static int32_t eventPeriodicCreate(UAVObjEvent* ev, UAVObjEventCallback cb, stru
 	// Get lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 	// Check that the object is not already connected
-	LL_FOREACH(objList, objEntry)
+	if (eventPeriodicFind(ev, cb, queue) != NULL)
 	{
-		if (objEntry->evInfo.cb == cb &&
-			objEntry->evInfo.queue == queue &&
-			objEntry->evInfo.ev.obj == ev->obj &&
-			objEntry->evInfo.ev.instId == ev->instId &&
-			objEntry->evInfo.ev.event == ev->event)
-		{
-			// Already registered, do nothing
-			PIOS_Recursive_Mutex_Unlock(mutex);
-			return -1;
-		}
+		// Already registered, do nothing
+		PIOS_Recursive_Mutex_Unlock(mutex);
+		return -1;
 	}
     // Create handle
 	objEntry = (PeriodicObjectList*)PIOS_malloc(sizeof(PeriodicObjectList));
-	if (objEntry == NULL) return -1;
+	if (objEntry == NULL) {
+		PIOS_Recursive_Mutex_Unlock(mutex);
+		return -1;
+	}
 	objEntry->evInfo.ev.obj = ev->obj;
 	objEntry->evInfo.ev.instId = ev->instId;
 	objEntry->evInfo.ev.event = ev->event;
@@ -240,6 +332,15 @@ static int32_t eventPeriodicCreate(UAVObjEvent* ev, UAVObjEventCallback cb, stru
 	objEntry->evInfo.queue = queue;
     objEntry->updatePeriodMs = periodMs;
     objEntry->timeToNextUpdateMs = randomizePeriod(periodMs); // avoid bunching of updates
+	objEntry->heapIndex = NOT_SCHEDULED;
+	memset(&objEntry->stats, 0, sizeof(EventPeriodicStats));
+	// Schedule the first update
+	if (periodMs > 0 && scheduleInsert(objEntry) != 0)
+	{
+		PIOS_free(objEntry);
+		PIOS_Recursive_Mutex_Unlock(mutex);
+		return -1;
+	}
     // Add to list
     LL_APPEND(objList, objEntry);
 	// Release lock
@@ -258,28 +359,29 @@ static int32_t eventPeriodicCreate(UAVObjEvent* ev, UAVObjEventCallback cb, stru
 static int32_t eventPeriodicUpdate(UAVObjEvent* ev, UAVObjEventCallback cb, struct pios_queue *queue, uint16_t periodMs)
 {
 	PeriodicObjectList* objEntry;
+	int32_t rc = 0;
 	// Get lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 	// Find object
-	LL_FOREACH(objList, objEntry)
+	objEntry = eventPeriodicFind(ev, cb, queue);
+	if (objEntry == NULL)
 	{
-		if (objEntry->evInfo.cb == cb &&
-			objEntry->evInfo.queue == queue &&
-			objEntry->evInfo.ev.obj == ev->obj &&
-			objEntry->evInfo.ev.instId == ev->instId &&
-			objEntry->evInfo.ev.event == ev->event)
-		{
-			// Object found, update period
-			objEntry->updatePeriodMs = periodMs;
-			objEntry->timeToNextUpdateMs = randomizePeriod(periodMs); // avoid bunching of updates
-			// Release lock
-			PIOS_Recursive_Mutex_Unlock(mutex);
-			return 0;
-		}
+		// The object was not found
+		PIOS_Recursive_Mutex_Unlock(mutex);
+		return -1;
 	}
-    // If this point is reached the object was not found
+	// Object found, update period
+	objEntry->updatePeriodMs = periodMs;
+	objEntry->timeToNextUpdateMs = randomizePeriod(periodMs); // avoid bunching of updates
+	memset(&objEntry->stats, 0, sizeof(EventPeriodicStats));
+	// Move it in the schedule
+	if (objEntry->heapIndex != NOT_SCHEDULED)
+		scheduleRemove(objEntry);
+	if (periodMs > 0)
+		rc = scheduleInsert(objEntry);
+	// Release lock
 	PIOS_Recursive_Mutex_Unlock(mutex);
-    return -1;
+    return rc;
 }
 
 /**
@@ -333,54 +435,201 @@ static int32_t processPeriodicUpdates()
 {
 	PeriodicObjectList* objEntry;
 	int32_t timeNow;
-    int32_t timeToNextUpdate;
-    int32_t offset;
+	int32_t timeToNextUpdate;
+	int32_t lateness;
 
 	// Get lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
-    // Iterate through each object and update its timer, if zero then transmit object.
-    // Also calculate smallest delay to next update.
-    timeToNextUpdate = PIOS_Thread_Systime() + MAX_UPDATE_PERIOD_MS;
-    LL_FOREACH(objList, objEntry)
-    {
-        // If object is configured for periodic updates
-        if (objEntry->updatePeriodMs > 0)
-        {
-            // Check if time for the next update
-        	timeNow = PIOS_Thread_Systime();
-            if (objEntry->timeToNextUpdateMs <= timeNow)
-            {
-                // Reset timer
-            	offset = ( timeNow - objEntry->timeToNextUpdateMs ) % objEntry->updatePeriodMs;
-            	objEntry->timeToNextUpdateMs = timeNow + objEntry->updatePeriodMs - offset;
-    			// Invoke callback, if one
-    			if ( objEntry->evInfo.cb != 0)
-    			{
-    				objEntry->evInfo.cb(&objEntry->evInfo.ev); // the function is expected to copy the event information
-    			}
-    			// Push event to queue, if one
-    			if ( objEntry->evInfo.queue != 0)
-    			{
-    				if (PIOS_Queue_Send(objEntry->evInfo.queue, &objEntry->evInfo.ev, 0) != true ) // do not block if queue is full
-    				{
-						if (objEntry->evInfo.ev.obj != NULL)
-							stats.lastErrorID = UAVObjGetID(objEntry->evInfo.ev.obj);
-    					++stats.eventErrors;
-    				}
-    			}
-            }
-            // Update minimum delay
-            if (objEntry->timeToNextUpdateMs < timeToNextUpdate)
-            {
-            	timeToNextUpdate = objEntry->timeToNextUpdateMs;
-            }
-        }
-    }
-
-    // Done
-    PIOS_Recursive_Mutex_Unlock(mutex);
-    return timeToNextUpdate;
+	// The events that are due are at the top of the schedule, update them
+	// until the top is an event in the future
+	timeNow = PIOS_Thread_Systime();
+	while (scheduleSize > 0 && Scheduled(0)->timeToNextUpdateMs <= timeNow)
+	{
+		objEntry = Scheduled(0);
+
+		// Reset timer, keeping the phase of the event
+		lateness = timeNow - objEntry->timeToNextUpdateMs;
+		objEntry->timeToNextUpdateMs = timeNow + objEntry->updatePeriodMs - lateness % objEntry->updatePeriodMs;
+		scheduleSiftDown(0);
+
+		updatePeriodicStats(objEntry, timeNow, lateness);
+
+		// Invoke callback, if one
+		if ( objEntry->evInfo.cb != 0)
+		{
+			objEntry->evInfo.cb(&objEntry->evInfo.ev); // the function is expected to copy the event information
+		}
+		// Push event to queue, if one
+		if ( objEntry->evInfo.queue != 0)
+		{
+			if (PIOS_Queue_Send(objEntry->evInfo.queue, &objEntry->evInfo.ev, 0) != true ) // do not block if queue is full
+			{
+				if (objEntry->evInfo.ev.obj != NULL)
+					stats.lastErrorID = UAVObjGetID(objEntry->evInfo.ev.obj);
+				++stats.eventErrors;
+			}
+		}
+	}
+
+	// Calculate the delay to the next update
+	timeToNextUpdate = timeNow + MAX_UPDATE_PERIOD_MS;
+	if (scheduleSize > 0 && Scheduled(0)->timeToNextUpdateMs < timeToNextUpdate)
+	{
+		timeToNextUpdate = Scheduled(0)->timeToNextUpdateMs;
+	}
+
+	// Done
+	PIOS_Recursive_Mutex_Unlock(mutex);
+	return timeToNextUpdate;
+}
+
+/**
+ * Account the lateness and jitter of a periodic update, must be called with
+ * the mutex held.
+ * \param[in] objEntry The event being updated
+ * \param[in] timeNow The time of the update
+ * \param[in] lateness The time since the update was due
+ */
+static void updatePeriodicStats(PeriodicObjectList* objEntry, int32_t timeNow, int32_t lateness)
+{
+	// The first update happens as soon as possible and sets the phase of the
+	// event, it is neither late nor does it end a full period
+	if (objEntry->stats.dispatches > 0)
+	{
+		if (lateness > objEntry->stats.maxLatenessMs)
+			objEntry->stats.maxLatenessMs = lateness > 0xFFFF ? 0xFFFF : lateness;
+
+		if (lateness > 0)
+			++stats.lateDispatches;
+		if ((uint32_t)lateness > stats.maxLatenessMs)
+		{
+			stats.maxLatenessMs = lateness;
+			stats.maxLatenessID = objEntry->evInfo.ev.obj != NULL ? UAVObjGetID(objEntry->evInfo.ev.obj) : 0;
+		}
+	}
+	if (objEntry->stats.dispatches > 1)
+	{
+		int32_t jitter = timeNow - objEntry->lastUpdateMs - objEntry->updatePeriodMs;
+		if (jitter < 0)
+			jitter = -jitter;
+
+		if (jitter > objEntry->stats.maxJitterMs)
+			objEntry->stats.maxJitterMs = jitter > 0xFFFF ? 0xFFFF : jitter;
+		if ((uint32_t)jitter > stats.maxJitterMs)
+			stats.maxJitterMs = jitter;
+	}
+
+	objEntry->lastUpdateMs = timeNow;
+	++objEntry->stats.dispatches;
+	++stats.periodicDispatches;
+}
+
+/**
+ * Add an event to the schedule, must be called with the mutex held.
+ * \return Success (0), failure (-1)
+ */
+static int32_t scheduleInsert(PeriodicObjectList* objEntry)
+{
+	if (scheduleSize == NOT_SCHEDULED)
+		return -1;
+
+	uint16_t chunk = scheduleChunk(scheduleSize);
+	if (schedule[chunk] == NULL)
+	{
+		// Grow the heap
+		schedule[chunk] = (PeriodicObjectList**)PIOS_malloc((SCHEDULE_CHUNK << chunk) * sizeof(PeriodicObjectList*));
+		if (schedule[chunk] == NULL)
+			return -1;
+	}
+
+	objEntry->heapIndex = scheduleSize;
+	Scheduled(scheduleSize) = objEntry;
+	scheduleSize++;
+	scheduleSiftUp(objEntry->heapIndex);
+	return 0;
+}
+
+/**
+ * Remove an event from the schedule, must be called with the mutex held.
+ */
+static void scheduleRemove(PeriodicObjectList* objEntry)
+{
+	uint16_t index = objEntry->heapIndex;
+
+	objEntry->heapIndex = NOT_SCHEDULED;
+	if (--scheduleSize == index)
+		return;
+
+	// Fill the hole with the last event and restore the heap order
+	Scheduled(index) = Scheduled(scheduleSize);
+	Scheduled(index)->heapIndex = index;
+	scheduleSiftUp(index);
+	scheduleSiftDown(Scheduled(index)->heapIndex);
+}
+
+/**
+ * Move an event up the schedule until its parent is due before it.
+ */
+static void scheduleSiftUp(uint16_t index)
+{
+	PeriodicObjectList* objEntry = Scheduled(index);
+
+	while (index > 0)
+	{
+		uint16_t parent = (index - 1) / 2;
+		if (Scheduled(parent)->timeToNextUpdateMs <= objEntry->timeToNextUpdateMs)
+			break;
+		Scheduled(index) = Scheduled(parent);
+		Scheduled(index)->heapIndex = index;
+		index = parent;
+	}
+
+	Scheduled(index) = objEntry;
+	objEntry->heapIndex = index;
+}
+
+/**
+ * Move an event down the schedule until its children are due after it.
+ */
+static void scheduleSiftDown(uint16_t index)
+{
+	PeriodicObjectList* objEntry = Scheduled(index);
+
+	while (1)
+	{
+		uint32_t child = 2 * (uint32_t)index + 1;
+		if (child >= scheduleSize)
+			break;
+		if (child + 1 < scheduleSize &&
+			Scheduled(child + 1)->timeToNextUpdateMs < Scheduled(child)->timeToNextUpdateMs)
+			child++;
+		if (objEntry->timeToNextUpdateMs <= Scheduled(child)->timeToNextUpdateMs)
+			break;
+		Scheduled(index) = Scheduled(child);
+		Scheduled(index)->heapIndex = index;
+		index = child;
+	}
+
+	Scheduled(index) = objEntry;
+	objEntry->heapIndex = index;
+}
+
+/**
+ * Chunk of the schedule that holds an index
+ */
+static uint16_t scheduleChunk(uint16_t index)
+{
+	return 31 - __builtin_clz(index / SCHEDULE_CHUNK + 1);
+}
+
+/**
+ * Slot of the schedule for an index, in an allocated chunk
+ */
+static PeriodicObjectList** scheduleSlot(uint16_t index)
+{
+	uint16_t chunk = scheduleChunk(index);
+	return &schedule[chunk][index - SCHEDULE_CHUNK * ((1 << chunk) - 1)];
 }
 
 /**
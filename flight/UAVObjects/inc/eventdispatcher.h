@@ -41,8 +41,23 @@
 typedef struct {
 	uint32_t lastErrorID;
 	uint32_t eventErrors;
+	uint32_t periodicDispatches; /** Periodic events dispatched */
+	uint32_t lateDispatches; /** Periodic events dispatched after their due time */
+	uint32_t maxLatenessMs; /** Largest delay of a periodic event after its due time */
+	uint32_t maxLatenessID; /** Object of the periodic event with the largest delay */
+	uint32_t maxJitterMs; /** Largest deviation of a periodic interval from its period */
 } EventStats;
 
+/**
+ * Statistics of a single periodic event, since it was created or its period
+ * last updated
+ */
+typedef struct {
+	uint32_t dispatches;
+	uint16_t maxLatenessMs;
+	uint16_t maxJitterMs;
+} EventPeriodicStats;
+
 // Public functions
 int32_t EventDispatcherInitialize();
 void EventGetStats(EventStats* statsOut);
@@ -52,6 +67,8 @@ int32_t EventPeriodicCallbackCreate(UAVObjEvent* ev, UAVObjEventCallback cb, uin
 int32_t EventPeriodicCallbackUpdate(UAVObjEvent* ev, UAVObjEventCallback cb, uint16_t periodMs);
 int32_t EventPeriodicQueueCreate(UAVObjEvent* ev, struct pios_queue *queue, uint16_t periodMs);
 int32_t EventPeriodicQueueUpdate(UAVObjEvent* ev, struct pios_queue *queue, uint16_t periodMs);
+int32_t EventPeriodicCallbackGetStats(UAVObjEvent* ev, UAVObjEventCallback cb, EventPeriodicStats* statsOut);
+int32_t EventPeriodicQueueGetStats(UAVObjEvent* ev, struct pios_queue *queue, EventPeriodicStats* statsOut);
 
 #endif // EVENTDISPATCHER_H
 
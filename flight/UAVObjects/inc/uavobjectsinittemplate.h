@@ -35,6 +35,7 @@
 void UAVObjectsInitializeAll();
 
 #define UAVOBJECTS_LARGEST $(SIZECALCULATION)
+#define UAVOBJECTS_COUNT $(OBJECTCOUNT)
 
 #endif /* UAVOBJECTSINIT_H */
 
@@ -34,6 +34,7 @@
 #include "pios_heap.h"		/* PIOS_malloc_no_dma */
 #include "pios_mutex.h"
 #include "pios_queue.h"
+#include "uavobjectsinit.h"	/* UAVOBJECTS_COUNT */
 
 extern uintptr_t pios_uavo_settings_fs_id;
 
@@ -61,11 +62,14 @@ struct ObjectEventEntry {
 /*
   MetaInstance   == [UAVOBase [UAVObjMetadata]]
   SingleInstance == [UAVOBase [UAVOData [InstanceData]]]
-  MultiInstance  == [UAVOBase [UAVOData [NumInstances [InstanceData0 [next]]]]
-                                                  ____________________/
-                                                  \-->[InstanceData1 [next]]
-                                                  _________...________/
-                                                  \-->[InstanceDataN [next]]
+  MultiInstance  == [UAVOBase [UAVOData [NumInstances [MaxInstances [chunks [InstanceData0]]]]]
+                                                                  \
+                                                                   \-->[chunk0 chunk1 ...]
+                                                                          \
+                                                                           \-->[block0 block1 ... block15]
+                                                                                  \       \
+                                                                                   \       \-->[InstanceData5 ... InstanceData8]
+                                                                                    \-->[InstanceData1 ... InstanceData4]
  */
 
 /*
@@ -116,22 +120,35 @@ struct UAVOSingle {
 	 */
 } __attribute__((packed));
 
-/* Part of a linked list of instances chained off of a multi instance UAVO. */
-struct UAVOMultiInst {
-	struct UAVOMultiInst * next;
-	uint8_t                instance[];
-	/* 
-	 * Additional space will be malloc'd here to hold the
-	 * the data for this instance.
-	 */
-} __attribute__((packed));
+/** number of instances in each block after instance 0 **/
+#define UAVO_INSTANCE_BLOCK 4
+/** number of block pointers in each chunk of the block table **/
+#define UAVO_BLOCK_CHUNK 16
+/** chunks needed to hold UAVOBJ_MAX_INSTANCES instances **/
+#define UAVO_BLOCK_MAX_CHUNKS ((((UAVOBJ_MAX_INSTANCES - 1) / UAVO_INSTANCE_BLOCK) + UAVO_BLOCK_CHUNK - 1) / UAVO_BLOCK_CHUNK)
+
+/*
+ * Chunk of the table of instance blocks of a multi instance UAVO. Each block
+ * holds UAVO_INSTANCE_BLOCK instances, so any instance is reached through
+ * the table in constant time. Chunks and blocks are never moved or freed,
+ * the heap of the hardware targets cannot free.
+ */
+struct UAVOMultiBlockChunk {
+	uint8_t * blocks[UAVO_BLOCK_CHUNK];
+};
 
 /* Augmented type for Multi Instance Data UAVO */
 struct UAVOMulti {
 	struct UAVOData        uavo;
 
 	uint16_t               num_instances;
-	struct UAVOMultiInst   instance0;
+	uint16_t               max_instances;
+
+	/* Instance 1 and up, back to back within each block. The table of
+	 * UAVO_BLOCK_MAX_CHUNKS chunks is allocated with the first block. */
+	struct UAVOMultiBlockChunk ** chunks;
+
+	uint8_t                instance0[];
 	/*
 	 * Additional space will be malloc'd here to hold the
 	 * the data for instance 0.
@@ -148,22 +165,57 @@ struct UAVOMulti {
 
 /** all information about instances are dependant on object type **/
 #define ObjSingleInstanceDataOffset(obj) ((void*)(&(( (struct UAVOSingle*)obj )->instance0)))
-#define InstanceDataOffset(inst) ((void*)&(( (struct UAVOMultiInst*)inst )->instance))
 #define InstanceData(instance) (void*)instance
 
+/*
+ * Index from object ID to object, sorted by ID. Metaobjects are not in the
+ * index, they are found through the ID of their parent.
+ *
+ * The index is kept in chunks that are never moved or freed once allocated,
+ * so a search without the lock always stays within allocated memory, and the
+ * heap of the hardware targets, which cannot free, is not left with the old
+ * copies of a growing array.
+ */
+struct UAVOIndexEntry {
+	uint32_t          id;
+	struct UAVOData * obj;
+};
+
+/** number of entries in each chunk of the index **/
+#define UAVO_INDEX_CHUNK 16
+/** only the generated objects register, the index never holds more **/
+#define UAVO_INDEX_MAX_CHUNKS ((UAVOBJECTS_COUNT + UAVO_INDEX_CHUNK - 1) / UAVO_INDEX_CHUNK)
+
+#if UAVOBJECTS_COUNT > UINT8_MAX
+#error Too many UAVObjects, UAVObjCount() returns a uint8_t
+#endif
+
+#define IndexEntry(pos) (&uavo_index[(pos) / UAVO_INDEX_CHUNK][(pos) % UAVO_INDEX_CHUNK])
+
 // Private functions
 static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 			UAVObjEventType event);
+static int32_t saveObject(UAVObjHandle obj_handle, uint16_t instId, bool batched);
+static int32_t saveObjectLocked(UAVObjHandle obj_handle, uint16_t instId, bool batched);
 static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId);
 static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId);
+static bool growInstances(struct UAVOMulti * uavo_multi, uint16_t min_instances);
+static void * multiInstanceData(struct UAVOMulti * uavo_multi, uint16_t instId);
 static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 			UAVObjEventCallback cb, uint8_t eventMask);
 static int32_t disconnectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 			UAVObjEventCallback cb);
+static bool insertIndex(struct UAVOData * obj);
+static UAVObjHandle lookupIndex(uint32_t id);
 
 // Private variables
 static struct UAVOData * uavo_list;
+static struct UAVOIndexEntry * uavo_index[UAVO_INDEX_MAX_CHUNKS];
+static volatile uint16_t uavo_index_count;
+static volatile uint32_t uavo_index_seq;
 static struct pios_recursive_mutex *mutex;
+// Serializes flash saves, which are done without holding the mutex above
+static struct pios_mutex *save_mutex;
 static const UAVObjMetadata defMetadata = {
 	.flags = (ACCESS_READWRITE << UAVOBJ_ACCESS_SHIFT |
 		ACCESS_READWRITE << UAVOBJ_GCS_ACCESS_SHIFT |
@@ -187,6 +239,9 @@ int32_t UAVObjInitialize()
 {
 	// Initialize variables
 	uavo_list = NULL;
+	// Chunks allocated by a previous initialization are reused
+	uavo_index_count = 0;
+	uavo_index_seq = 0;
 
 	memset(&stats, 0, sizeof(UAVObjStats));
 
@@ -194,6 +249,10 @@ int32_t UAVObjInitialize()
 	mutex = PIOS_Recursive_Mutex_Create();
 	if (mutex == NULL)
 		return -1;
+
+	save_mutex = PIOS_Mutex_Create();
+	if (save_mutex == NULL)
+		return -1;
 	// Done
 	return 0;
 }
@@ -281,10 +340,11 @@ static struct UAVOData * UAVObjAllocMulti(uint32_t num_bytes)
 
 	/* Set up the type-specific part of the UAVO */
 	uavo_multi->num_instances = 1;
+	uavo_multi->max_instances = 1;
+	uavo_multi->chunks        = NULL;
 
 	/* Clear the instance data carried in the UAVO */
-	uavo_multi->instance0.next = NULL;
-	memset (&(uavo_multi->instance0.instance), 0, num_bytes);
+	memset (uavo_multi->instance0, 0, num_bytes);
 
 	/* Give back the generic UAVO part */
 	return (&(uavo_multi->uavo));
@@ -337,6 +397,13 @@ UAVObjHandle UAVObjRegister(uint32_t id,
 	/* Initialize the embedded meta UAVO */
 	UAVObjInitMetaData (&uavo_data->metaObj);
 
+	/* Make the object available to UAVObjGetByID */
+	if (!insertIndex(uavo_data)) {
+		PIOS_free(uavo_data);
+		uavo_data = NULL;
+		goto unlock_exit;
+	}
+
 	/* Add the newly created object to the global list of objects */
 	LL_APPEND(uavo_list, uavo_data);
 
@@ -367,26 +434,27 @@ unlock_exit:
  */
 UAVObjHandle UAVObjGetByID(uint32_t id)
 {
-	UAVObjHandle * found_obj = (UAVObjHandle *) NULL;
+	UAVObjHandle found_obj;
+	uint32_t seq = uavo_index_seq;
 
-	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-
-	// Look for object
-	struct UAVOData * tmp_obj;
-	LL_FOREACH(uavo_list, tmp_obj) {
-		if (tmp_obj->id == id) {
-			found_obj = (UAVObjHandle *)tmp_obj;
-			goto unlock_exit;
-		}
-		if (MetaObjectId(tmp_obj->id) == id) {
-			found_obj = (UAVObjHandle *)&(tmp_obj->metaObj);
-			goto unlock_exit;
-		}
+	/*
+	 * The index is only modified while registering an object, and the
+	 * sequence count is odd while that happens. Search without the lock and
+	 * only retake the search under the lock if the index changed meanwhile,
+	 * rather than spinning on a writer that may have a lower priority.
+	 */
+	if ((seq & 1) == 0) {
+		__sync_synchronize();
+		found_obj = lookupIndex(id);
+		__sync_synchronize();
+		if (seq == uavo_index_seq)
+			return found_obj;
 	}
 
-unlock_exit:
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	found_obj = lookupIndex(id);
 	PIOS_Recursive_Mutex_Unlock(mutex);
+
 	return found_obj;
 }
 
@@ -676,19 +744,33 @@ static uint8_t uavobj_save_trampoline[256] __attribute__((aligned(4)));
 #endif	/* PIOS_INCLUDE_FASTHEAP */
 
 /**
- * Save the data of the specified object to the file system (SD card).
- * If the object contains multiple instances, all of them will be saved.
- * A new file with the name of the object will be created.
- * The object data can be restored using the UAVObjLoad function.
+ * Save the data of the specified object to the file system, on its own or
+ * as part of a batch started with PIOS_FLASHFS_BeginBatch.
  * @param[in] obj The object handle.
  * @param[in] instId The instance ID
- * @param[in] file File to append to
+ * @param[in] batched Whether a batch is in progress
  * @return 0 if success or -1 if failure
  */
-int32_t UAVObjSave(UAVObjHandle obj_handle, uint16_t instId)
+static int32_t saveObject(UAVObjHandle obj_handle, uint16_t instId, bool batched)
 {
 	PIOS_Assert(obj_handle);
 
+	// The save trampoline is shared, one save at a time
+	PIOS_Mutex_Lock(save_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	int32_t rc = saveObjectLocked(obj_handle, instId, batched);
+	PIOS_Mutex_Unlock(save_mutex);
+
+	return rc;
+}
+
+/**
+ * Same as saveObject() with the save mutex held.
+ */
+static int32_t saveObjectLocked(UAVObjHandle obj_handle, uint16_t instId, bool batched)
+{
+	int32_t (*objSave)(uintptr_t, uint32_t, uint16_t, uint8_t *, uint16_t) =
+		batched ? PIOS_FLASHFS_ObjSaveBatched : PIOS_FLASHFS_ObjSave;
+
 	if (UAVObjIsMetaobject(obj_handle)) {
 		if (instId != 0)
 			return -1;
@@ -700,13 +782,13 @@ int32_t UAVObjSave(UAVObjHandle obj_handle, uint16_t instId)
 			MetaDataPtr((struct UAVOMeta *)obj_handle),
 			UAVObjGetNumBytes(obj_handle));
 
-		rc = PIOS_FLASHFS_ObjSave(pios_uavo_settings_fs_id,
+		rc = objSave(pios_uavo_settings_fs_id,
 					UAVObjGetID(obj_handle),
 					instId,
 					uavobj_save_trampoline,
 					UAVObjGetNumBytes(obj_handle));
 #else /* PIOS_INCLUDE_FASTHEAP */
-		rc = PIOS_FLASHFS_ObjSave(pios_uavo_settings_fs_id,
+		rc = objSave(pios_uavo_settings_fs_id,
 					UAVObjGetID(obj_handle),
 					instId,
 					(uint8_t*) MetaDataPtr((struct UAVOMeta *)obj_handle),
@@ -716,13 +798,15 @@ int32_t UAVObjSave(UAVObjHandle obj_handle, uint16_t instId)
 		if (rc != 0)
 			return -1;
 	} else {
-		InstanceHandle instEntry = getInstance( (struct UAVOData *)obj_handle, instId);
+		// Lock only to find the instance and copy it, flash writes are slow
+		PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
-		if (instEntry == NULL)
-			return -1;
+		InstanceHandle instEntry = getInstance( (struct UAVOData *)obj_handle, instId);
 
-		if (InstanceData(instEntry) == NULL)
+		if (instEntry == NULL) {
+			PIOS_Recursive_Mutex_Unlock(mutex);
 			return -1;
+		}
 
 		// Save the object to the filesystem
 		int32_t rc;
@@ -731,13 +815,18 @@ int32_t UAVObjSave(UAVObjHandle obj_handle, uint16_t instId)
 			InstanceData(instEntry),
 			UAVObjGetNumBytes(obj_handle));
 
-		rc = PIOS_FLASHFS_ObjSave(pios_uavo_settings_fs_id,
+		PIOS_Recursive_Mutex_Unlock(mutex);
+
+		rc = objSave(pios_uavo_settings_fs_id,
 					UAVObjGetID(obj_handle),
 					instId,
 					uavobj_save_trampoline,
 					UAVObjGetNumBytes(obj_handle));
 #else /* PIOS_INCLUDE_FASTHEAP */
-		rc = PIOS_FLASHFS_ObjSave(pios_uavo_settings_fs_id,
+		PIOS_Recursive_Mutex_Unlock(mutex);
+
+		// Instances never move once created
+		rc = objSave(pios_uavo_settings_fs_id,
 					UAVObjGetID(obj_handle),
 					instId,
 					InstanceData(instEntry),
@@ -751,6 +840,21 @@ int32_t UAVObjSave(UAVObjHandle obj_handle, uint16_t instId)
 	return 0;
 }
 
+/**
+ * Save the data of the specified object to the file system (SD card).
+ * If the object contains multiple instances, all of them will be saved.
+ * A new file with the name of the object will be created.
+ * The object data can be restored using the UAVObjLoad function.
+ * @param[in] obj The object handle.
+ * @param[in] instId The instance ID
+ * @param[in] file File to append to
+ * @return 0 if success or -1 if failure
+ */
+int32_t UAVObjSave(UAVObjHandle obj_handle, uint16_t instId)
+{
+	return saveObject(obj_handle, instId, false);
+}
+
 #if defined(PIOS_INCLUDE_FASTHEAP)
 /**
  * Trampoline buffer used for loads from the underlying filesystem.
@@ -801,8 +905,11 @@ int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId)
 #endif  /* PIOS_INCLUDE_FASTHEAP */
 
 	} else {
-
+		// Instances never move once created, only lock to find the instance
+		// and copy into it, flash reads are slow
+		PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 		InstanceHandle instEntry = getInstance( (struct UAVOData *)obj_handle, instId);
+		PIOS_Recursive_Mutex_Unlock(mutex);
 
 		if (instEntry == NULL)
 			return -1;
@@ -827,9 +934,10 @@ int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId)
 			return -1;
 
 #if defined(PIOS_INCLUDE_FASTHEAP)
+		PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 		memcpy(InstanceData(instEntry), uavobj_load_trampoline, UAVObjGetNumBytes(obj_handle));
+		PIOS_Recursive_Mutex_Unlock(mutex);
 #endif  /* PIOS_INCLUDE_FASTHEAP */
-
 	}
 
 	sendEvent((struct UAVOBase*)obj_handle, instId, EV_UNPACKED);
@@ -850,34 +958,58 @@ int32_t UAVObjDeleteById(uint32_t obj_id, uint16_t inst_id)
 }
 
 /**
- * Save all settings objects to the SD card.
+ * Save all settings objects to the SD card, in one batch so unchanged
+ * objects are not written again. The object mutex is only held to copy
+ * each instance and to walk the object list, never during flash writes,
+ * so the control loop keeps running during a save.
  * @return 0 if success or -1 if failure
  */
 int32_t UAVObjSaveSettings()
 {
 	struct UAVOData *obj;
 
-	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	// Keep other saves out of the batch
+	PIOS_Mutex_Lock(save_mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
 	int32_t rc = -1;
 
-	// Save all settings objects
-	LL_FOREACH(uavo_list, obj) {
+	if (PIOS_FLASHFS_BeginBatch(pios_uavo_settings_fs_id) != 0) {
+		goto unlock_exit;
+	}
+
+	// Save all settings objects. Objects are never removed, only the links
+	// of the list need the lock.
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	obj = uavo_list;
+	PIOS_Recursive_Mutex_Unlock(mutex);
+
+	while (obj) {
 		// Check if this is a settings object
 		if (UAVObjIsSettings(obj)) {
-			// Save object
-			if (UAVObjSave((UAVObjHandle) obj, 0) ==
-				-1) {
-				goto unlock_exit;
+			// Save every instance of the object
+			uint16_t numInstances = UAVObjGetNumInstances((UAVObjHandle) obj);
+			for (uint16_t instId = 0; instId < numInstances; instId++) {
+				if (saveObjectLocked((UAVObjHandle) obj, instId, true) ==
+					-1) {
+					goto commit_exit;
+				}
 			}
 		}
+
+		PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+		obj = obj->next;
+		PIOS_Recursive_Mutex_Unlock(mutex);
 	}
 
 	rc = 0;
 
+commit_exit:
+	if (PIOS_FLASHFS_CommitBatch(pios_uavo_settings_fs_id) != 0) {
+		rc = -1;
+	}
+
 unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
+	PIOS_Mutex_Unlock(save_mutex);
 	return rc;
 }
 
@@ -1298,6 +1430,65 @@ unlock_exit:
 	return rc;
 }
 
+/**
+ * Get the data of a range of instances of an object in a single call
+ * \param[in] obj The object handle
+ * \param[in] firstInstId The first instance ID of the range
+ * \param[in] numInstances The number of instances in the range
+ * \param[out] dataOut The data of the instances, back to back
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjGetInstanceDataRange(UAVObjHandle obj_handle, uint16_t firstInstId,
+			uint16_t numInstances, void *dataOut)
+{
+	PIOS_Assert(obj_handle);
+
+	// Lock
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	int32_t rc = -1;
+
+	if (numInstances == 0) {
+		goto unlock_exit;
+	}
+
+	if (UAVObjIsMetaobject(obj_handle) || UAVObjIsSingleInstance(obj_handle)) {
+		// Only instance 0
+		if (firstInstId != 0 || numInstances != 1) {
+			goto unlock_exit;
+		}
+		rc = UAVObjGetInstanceData(obj_handle, 0, dataOut);
+	} else {
+		struct UAVOData *obj = (struct UAVOData *) obj_handle;
+
+		// Check the range
+		if ((uint32_t) firstInstId + numInstances > UAVObjGetNumInstances(obj_handle)) {
+			goto unlock_exit;
+		}
+
+		// Instances are contiguous within a block, copy a block at a time
+		struct UAVOMulti *uavo_multi = (struct UAVOMulti *) obj;
+		uint8_t *out = (uint8_t *) dataOut;
+		uint16_t instId = firstInstId;
+		uint16_t lastInstId = firstInstId + numInstances;
+		while (instId < lastInstId) {
+			uint16_t run = (instId == 0) ? 1 :
+				UAVO_INSTANCE_BLOCK - (instId - 1) % UAVO_INSTANCE_BLOCK;
+			if (run > lastInstId - instId)
+				run = lastInstId - instId;
+
+			memcpy(out, multiInstanceData(uavo_multi, instId), run * obj->instance_size);
+			out += run * obj->instance_size;
+			instId += run;
+		}
+		rc = 0;
+	}
+
+unlock_exit:
+	PIOS_Recursive_Mutex_Unlock(mutex);
+	return rc;
+}
+
 /**
  * Set the object metadata
  * \param[in] obj The object handle
@@ -1679,7 +1870,7 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
  */
 static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId)
 {
-	struct UAVOMultiInst *instEntry;
+	struct UAVOMulti *uavo_multi = (struct UAVOMulti *) obj;
 
 	/* Don't allow more than one instance for single instance objects */
 	if (UAVObjIsSingleInstance(&(obj->base))) {
@@ -1697,6 +1888,12 @@ static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId)
 		return NULL;
 	}
 
+	/* Make room for this instance and the ones before it at once */
+	if (instId >= uavo_multi->max_instances) {
+		if (!growInstances(uavo_multi, instId + 1))
+			return NULL;
+	}
+
 	// Create any missing instances (all instance IDs must be sequential)
 	for (uint16_t n = UAVObjGetNumInstances(&(obj->base)); n < instId; ++n) {
 		if (createInstance(obj, n) == NULL) {
@@ -1705,13 +1902,10 @@ static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId)
 	}
 
 	/* Create the actual instance */
-	instEntry = (struct UAVOMultiInst *) PIOS_malloc_no_dma(sizeof(struct UAVOMultiInst)+obj->instance_size);
-	if (!instEntry)
-		return NULL;
-	memset(InstanceDataOffset(instEntry), 0, obj->instance_size);
-	LL_APPEND(( (struct UAVOMulti*)obj )->instance0.next, instEntry);
+	InstanceHandle instEntry = multiInstanceData(uavo_multi, instId);
+	memset(instEntry, 0, obj->instance_size);
 
-	( (struct UAVOMulti*)obj )->num_instances++;
+	uavo_multi->num_instances++;
 
 	// Fire event
 	UAVObjInstanceUpdated((UAVObjHandle) obj, instId);
@@ -1720,7 +1914,66 @@ static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId)
 	if (newUavObjInstanceCB) {
 		newUavObjInstanceCB(obj->id, UAVObjGetNumInstances(obj));
 	}
-	return InstanceDataOffset(instEntry);
+	return instEntry;
+}
+
+/**
+ * Add blocks of instances to a multi instance object until it can hold the
+ * requested number of instances. The existing instances stay in place.
+ * \param[in] uavo_multi The object
+ * \param[in] min_instances The number of instances the object must hold
+ * \return true on success, false if out of memory
+ */
+static bool growInstances(struct UAVOMulti * uavo_multi, uint16_t min_instances)
+{
+	uint16_t instance_size = uavo_multi->uavo.instance_size;
+
+	if (uavo_multi->chunks == NULL) {
+		uavo_multi->chunks = (struct UAVOMultiBlockChunk **) PIOS_malloc_no_dma(
+			UAVO_BLOCK_MAX_CHUNKS * sizeof(*uavo_multi->chunks));
+		if (!uavo_multi->chunks)
+			return false;
+		memset(uavo_multi->chunks, 0, UAVO_BLOCK_MAX_CHUNKS * sizeof(*uavo_multi->chunks));
+	}
+
+	while (uavo_multi->max_instances < min_instances) {
+		uint16_t b = (uavo_multi->max_instances - 1) / UAVO_INSTANCE_BLOCK;
+		PIOS_Assert(b / UAVO_BLOCK_CHUNK < UAVO_BLOCK_MAX_CHUNKS);
+
+		struct UAVOMultiBlockChunk ** chunk = &uavo_multi->chunks[b / UAVO_BLOCK_CHUNK];
+		if (*chunk == NULL) {
+			*chunk = (struct UAVOMultiBlockChunk *) PIOS_malloc_no_dma(sizeof(**chunk));
+			if (!*chunk)
+				return false;
+		}
+
+		uint8_t * block = (uint8_t *) PIOS_malloc_no_dma(UAVO_INSTANCE_BLOCK * instance_size);
+		if (!block)
+			return false;
+
+		(*chunk)->blocks[b % UAVO_BLOCK_CHUNK] = block;
+		uavo_multi->max_instances += UAVO_INSTANCE_BLOCK;
+	}
+
+	return true;
+}
+
+/**
+ * Get the data of an instance that has room in a multi instance object
+ * \param[in] uavo_multi The object
+ * \param[in] instId The instance ID, below max_instances
+ * \return The instance data
+ */
+static void * multiInstanceData(struct UAVOMulti * uavo_multi, uint16_t instId)
+{
+	if (instId == 0)
+		return uavo_multi->instance0;
+
+	uint16_t n = instId - 1;
+	uint16_t b = n / UAVO_INSTANCE_BLOCK;
+	uint8_t * block = uavo_multi->chunks[b / UAVO_BLOCK_CHUNK]->blocks[b % UAVO_BLOCK_CHUNK];
+
+	return &block[(n % UAVO_INSTANCE_BLOCK) * uavo_multi->uavo.instance_size];
 }
 
 /**
@@ -1754,17 +2007,7 @@ static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId)
 		if (instId >= uavo_multi->num_instances)
 			return NULL;
 
-		// Look for specified instance ID
-		uint16_t instance = 0;
-		struct UAVOMultiInst *instEntry;
-		LL_FOREACH(&(uavo_multi->instance0), instEntry) {
-			if (instance++ == instId) {
-				/* Found it */
-				return &(instEntry->instance);
-			}
-		}
-		/* Instance was not found */
-		return NULL;
+		return multiInstanceData(uavo_multi, instId);
 	}
 }
 
@@ -1867,19 +2110,7 @@ int32_t getEventMask(UAVObjHandle obj_handle, struct pios_queue *queue)
  */
 uint8_t UAVObjCount()
 {
-	uint8_t count = 0;
-	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-
-	// Look for object
-	struct UAVOData * tmp_obj;
-	LL_FOREACH(uavo_list, tmp_obj) {
-		++count;
-	}
-
-	// Release lock
-	PIOS_Recursive_Mutex_Unlock(mutex);
-	return count;
+	return uavo_index_count;
 }
 
 /**
@@ -1909,6 +2140,94 @@ uint32_t UAVObjIDByIndex(uint8_t index)
 	return 0;
 }
 
+/**
+ * Insert an object in the ID index, keeping it sorted. Must be called with
+ * the mutex held.
+ * \param[in] obj The object to insert
+ * \return true on success, false if the index could not grow
+ */
+static bool insertIndex(struct UAVOData * obj)
+{
+	uint16_t count = uavo_index_count;
+
+	if (count >= UAVOBJECTS_COUNT)
+		return false;
+
+	if ((count % UAVO_INDEX_CHUNK) == 0) {
+		uint16_t chunk = count / UAVO_INDEX_CHUNK;
+		if (!uavo_index[chunk]) {
+			uavo_index[chunk] = (struct UAVOIndexEntry *) PIOS_malloc_no_dma(UAVO_INDEX_CHUNK * sizeof(struct UAVOIndexEntry));
+			if (!uavo_index[chunk])
+				return false;
+		}
+	}
+
+	uavo_index_seq++;
+	__sync_synchronize();
+
+	uint16_t pos = count;
+	while (pos > 0 && IndexEntry(pos - 1)->id > obj->id) {
+		*IndexEntry(pos) = *IndexEntry(pos - 1);
+		pos--;
+	}
+	IndexEntry(pos)->id = obj->id;
+	IndexEntry(pos)->obj = obj;
+
+	/* The chunk holding the new entry must be visible before the count */
+	__sync_synchronize();
+	uavo_index_count = count + 1;
+
+	__sync_synchronize();
+	uavo_index_seq++;
+
+	return true;
+}
+
+/**
+ * Binary search of the ID index
+ * \param[in] id The object ID
+ * \return The object or NULL if not found
+ */
+static struct UAVOData * searchIndex(uint32_t id)
+{
+	/* Every entry below a count that was read is in an allocated chunk */
+	int32_t low = 0;
+	int32_t high = (int32_t) uavo_index_count - 1;
+
+	while (low <= high) {
+		int32_t mid = (low + high) / 2;
+		const struct UAVOIndexEntry * entry = IndexEntry(mid);
+
+		if (entry->id < id)
+			low = mid + 1;
+		else if (entry->id > id)
+			high = mid - 1;
+		else
+			return entry->obj;
+	}
+
+	return NULL;
+}
+
+/**
+ * Look up an object or a metaobject in the ID index
+ * \param[in] id The object ID
+ * \return The object or NULL if not found
+ */
+static UAVObjHandle lookupIndex(uint32_t id)
+{
+	struct UAVOData * obj = searchIndex(id);
+	if (obj)
+		return (UAVObjHandle) obj;
+
+	/* Metaobjects take the ID following the one of their parent */
+	obj = searchIndex(id - 1);
+	if (obj)
+		return (UAVObjHandle) &(obj->metaObj);
+
+	return NULL;
+}
+
 /**
  * Registers a new UAVO instance created callback
  */
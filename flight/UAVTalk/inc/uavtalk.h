@@ -33,6 +33,8 @@
 
 // Public types
 typedef int32_t (*UAVTalkOutputStream)(uint8_t* data, int32_t length);
+typedef int32_t (*UAVTalkReserveStream)(uint16_t length, uint8_t *spans[2], uint16_t spanLengths[2]);
+typedef int32_t (*UAVTalkCommitStream)(uint16_t length);
 
 //! Tracking statistics for a UAVTalk connection
 typedef struct {
@@ -44,24 +46,37 @@ typedef struct {
     uint32_t txObjects;
     uint32_t txErrors;
     uint32_t rxErrors;
+    uint32_t txRetries;
 } UAVTalkStats;
 
 typedef void* UAVTalkConnection;
 
+//! Completion of an asynchronous transaction, called with the connection locked
+typedef void (*UAVTalkTransactionCallback)(UAVTalkConnection connection, UAVObjHandle obj, uint16_t instId, bool success, uint8_t retries);
+
 typedef enum {UAVTALK_STATE_ERROR=0, UAVTALK_STATE_SYNC, UAVTALK_STATE_TYPE, UAVTALK_STATE_SIZE, UAVTALK_STATE_OBJID, UAVTALK_STATE_INSTID, UAVTALK_STATE_TIMESTAMP, UAVTALK_STATE_DATA, UAVTALK_STATE_CS, UAVTALK_STATE_COMPLETE} UAVTalkRxState;
 
 // Public functions
 UAVTalkConnection UAVTalkInitialize(UAVTalkOutputStream outputStream);
 int32_t UAVTalkSetOutputStream(UAVTalkConnection connection, UAVTalkOutputStream outputStream);
 UAVTalkOutputStream UAVTalkGetOutputStream(UAVTalkConnection connection);
+int32_t UAVTalkSetDirectOutputStream(UAVTalkConnection connectionHandle, UAVTalkReserveStream reserveStream, UAVTalkCommitStream commitStream);
 int32_t UAVTalkSendObject(UAVTalkConnection connection, UAVObjHandle obj, uint16_t instId, uint8_t acked, int32_t timeoutMs);
+int32_t UAVTalkSendObjectUnbatched(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId);
 int32_t UAVTalkSendObjectTimestamped(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId, uint8_t acked, int32_t timeoutMs);
 int32_t UAVTalkSendObjectRequest(UAVTalkConnection connection, UAVObjHandle obj, uint16_t instId, int32_t timeoutMs);
+int32_t UAVTalkSendObjectAsync(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId, int32_t timeoutMs, uint8_t maxRetries, UAVTalkTransactionCallback cb);
+int32_t UAVTalkSendObjectRequestAsync(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId, int32_t timeoutMs, uint8_t maxRetries, UAVTalkTransactionCallback cb);
+int32_t UAVTalkProcessTransactions(UAVTalkConnection connectionHandle);
 int32_t UAVTalkSendAck(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId);
 int32_t UAVTalkSendNack(UAVTalkConnection connectionHandle, uint32_t objId);
+int32_t UAVTalkSetBatching(UAVTalkConnection connectionHandle, bool enabled);
+int32_t UAVTalkFlushBatch(UAVTalkConnection connectionHandle);
+int32_t UAVTalkSetDeltaEncoding(UAVTalkConnection connectionHandle, bool enabled);
 int32_t UAVTalkSendBuf(UAVTalkConnection connectionHandle, uint8_t *buf, uint16_t len);
 UAVTalkRxState UAVTalkProcessInputStream(UAVTalkConnection connection, uint8_t rxbyte);
 UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connection, uint8_t rxbyte);
+int32_t UAVTalkProcessInputBuffer(UAVTalkConnection connectionHandle, uint8_t *buf, uint16_t len);
 UAVTalkRxState UAVTalkRelayInputStream(UAVTalkConnection connectionHandle, uint8_t rxbyte);
 int32_t UAVTalkRelayPacket(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle);
 int32_t UAVTalkReceiveObject(UAVTalkConnection connectionHandle);
@@ -63,6 +63,50 @@ typedef uint8_t uavtalk_checksum;
 #define UAVTALK_MIN_PACKET_LENGTH       UAVTALK_MAX_HEADER_LENGTH + UAVTALK_CHECKSUM_LENGTH
 #define UAVTALK_MAX_PACKET_LENGTH       UAVTALK_MIN_PACKET_LENGTH + UAVTALK_MAX_PAYLOAD_LENGTH
 
+//! Largest payload of a multi-object frame, it must parse like any other frame
+#define UAVTALK_MAX_BATCH_PAYLOAD       (UAVTALK_MAX_PAYLOAD_LENGTH - 1)
+
+//! Granularity of delta frames, each bit of their bitmap covers this many bytes
+#define UAVTALK_DELTA_CHUNK_LENGTH      4
+//! Deltas start with the CRC-16 of the resulting data, which catches a delta
+//! applied to other data than the sender's after a lost frame
+#define UAVTALK_DELTA_CRC_LENGTH        2
+//! Objects smaller than this are always sent in full
+#define UAVTALK_DELTA_MIN_LENGTH        8
+//! Number of deltas sent between two full updates of an object
+#define UAVTALK_DELTA_KEYFRAME_INTERVAL 10
+//! Number of buckets of the delta base index, a power of two
+#define UAVTALK_DELTA_BUCKETS           32
+//! Object ID that marks a delta record in a multi-object frame, the object
+//! ID, instance ID and delta payload follow
+#define UAVTALK_MULTI_DELTA_RECORD      0
+
+//! Number of acked sends and requests that can be outstanding at once
+#define UAVTALK_MAX_TRANSACTIONS        8
+
+//! An acked send or object request that waits for its response
+struct UAVTalkTransaction {
+    UAVObjHandle obj;
+    uint16_t instId;
+    uint8_t type;
+    uint8_t retriesRemaining;
+    uint8_t retries;
+    int32_t timeoutMs;
+    uint32_t deadline;
+    UAVTalkTransactionCallback cb;
+};
+
+//! Last data sent of an object instance, which the next delta is based on.
+//! Entries are kept for the life of the connection, chained per bucket.
+struct UAVTalkDeltaEntry {
+    struct UAVTalkDeltaEntry *next;
+    UAVObjHandle obj;
+    uint16_t instId;
+    bool valid;
+    uint8_t sinceKeyframe;
+    uint8_t data[];
+};
+
 //! State information for the UAVTalk parser
 typedef struct {
     UAVObjHandle obj;
@@ -84,16 +128,27 @@ typedef struct {
 typedef struct {
     uint8_t canari;
     UAVTalkOutputStream outStream;
+    UAVTalkReserveStream reserveStream;
+    UAVTalkCommitStream commitStream;
     struct pios_recursive_mutex *lock;
     struct pios_recursive_mutex *transLock;
     struct pios_semaphore *respSema;
-    UAVObjHandle respObj;
-    uint16_t respInstId;
+    bool respSuccess;
+    struct pios_semaphore *slotSema;
+    struct UAVTalkTransaction transactions[UAVTALK_MAX_TRANSACTIONS];
     UAVTalkStats stats;
     UAVTalkInputProcessor iproc;
     uint8_t *rxBuffer;
     uint32_t txSize;
     uint8_t *txBuffer;
+    bool batching;
+    uint8_t *batchBuffer;
+    uint16_t batchLength;
+    uint16_t batchObjects;
+    uint32_t batchObjectBytes;
+    bool deltaEncoding;
+    struct UAVTalkDeltaEntry **deltaCache;
+    uint8_t *deltaBuffer;
 } UAVTalkConnectionData;
 
 #define UAVTALK_CANARI         0xCA
@@ -108,6 +163,8 @@ typedef struct {
 #define UAVTALK_TYPE_OBJ_ACK   (UAVTALK_TYPE_VER | 0x02)
 #define UAVTALK_TYPE_ACK       (UAVTALK_TYPE_VER | 0x03)
 #define UAVTALK_TYPE_NACK      (UAVTALK_TYPE_VER | 0x04)
+#define UAVTALK_TYPE_OBJ_MULTI (UAVTALK_TYPE_VER | 0x05)
+#define UAVTALK_TYPE_OBJ_DELTA (UAVTALK_TYPE_VER | 0x06)
 #define UAVTALK_TYPE_OBJ_TS       (UAVTALK_TIMESTAMPED | UAVTALK_TYPE_OBJ)
 #define UAVTALK_TYPE_OBJ_ACK_TS   (UAVTALK_TIMESTAMPED | UAVTALK_TYPE_OBJ_ACK)
 
@@ -40,11 +40,27 @@
 
 // Private functions
 static int32_t objectTransaction(UAVTalkConnectionData *connection, UAVObjHandle objectId, uint16_t instId, uint8_t type, int32_t timeout);
+static int32_t startTransaction(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type, int32_t timeoutMs, uint8_t maxRetries, UAVTalkTransactionCallback cb);
+static struct UAVTalkTransaction *findTransactionSlot(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type, UAVTalkTransactionCallback cb);
+static void completeTransaction(UAVTalkConnectionData *connection, struct UAVTalkTransaction *trans, bool success);
+static int32_t expireTransactions(UAVTalkConnectionData *connection);
+static void transactionResponse(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId, bool success, uint8_t retries);
 static int32_t sendObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type);
 static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type);
 static int32_t sendNack(UAVTalkConnectionData *connection, uint32_t objId);
+static int32_t batchSingleObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId);
+static int32_t flushBatch(UAVTalkConnectionData *connection);
+static int32_t sendDeltaObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId);
+static void storeDeltaBase(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, const uint8_t *data);
+static struct UAVTalkDeltaEntry *findDeltaEntry(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId);
+static void clearDeltaCache(UAVTalkConnectionData *connection);
+static uint32_t deltaBucket(UAVObjHandle obj, uint16_t instId);
+static UAVTalkRxState processInputByte(UAVTalkConnectionData *connection, uint8_t rxbyte);
 static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, uint32_t objId, uint16_t instId, uint8_t* data, int32_t length);
-static void updateAck(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId);
+static int32_t receiveMultiObject(UAVTalkConnectionData *connection, uint8_t* data, int32_t length);
+static int32_t receiveDeltaObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t* data, int32_t length);
+static int32_t applyDelta(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, const uint8_t* data, int32_t length, bool *applied);
+static void updateAck(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, bool success);
 
 /**
  * Initialize the UAVTalk library
@@ -62,6 +78,8 @@ UAVTalkConnection UAVTalkInitialize(UAVTalkOutputStream outputStream)
 	connection->iproc.rxPacketLength = 0;
 	connection->iproc.state = UAVTALK_STATE_SYNC;
 	connection->outStream = outputStream;
+	connection->reserveStream = NULL;
+	connection->commitStream = NULL;
 	connection->lock = PIOS_Recursive_Mutex_Create();
 	PIOS_Assert(connection->lock != NULL);
 	connection->transLock = PIOS_Recursive_Mutex_Create();
@@ -71,8 +89,17 @@ UAVTalkConnection UAVTalkInitialize(UAVTalkOutputStream outputStream)
 	if (!connection->rxBuffer) return 0;
 	connection->txBuffer = PIOS_malloc(UAVTALK_MAX_PACKET_LENGTH);
 	if (!connection->txBuffer) return 0;
+	connection->batching = false;
+	connection->batchBuffer = NULL;
+	connection->batchLength = 0;
+	connection->deltaEncoding = false;
+	connection->deltaCache = NULL;
+	connection->deltaBuffer = NULL;
 	connection->respSema = PIOS_Semaphore_Create();
 	PIOS_Semaphore_Take(connection->respSema, 0); // reset to zero
+	connection->slotSema = PIOS_Semaphore_Create();
+	PIOS_Semaphore_Take(connection->slotSema, 0);
+	memset(connection->transactions, 0, sizeof(connection->transactions));
 	UAVTalkResetStats( (UAVTalkConnection) connection );
 	return (UAVTalkConnection) connection;
 }
@@ -103,6 +130,35 @@ int32_t UAVTalkSetOutputStream(UAVTalkConnection connectionHandle, UAVTalkOutput
 
 }
 
+/**
+ * Set an output stream that objects can be written to in place, to save
+ * copying them through txBuffer. Messages it can not take are still sent
+ * through the output stream.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] reserveStream Function pointer that is called to reserve space
+ * for a message, returning the number of spans or a negative error
+ * \param[in] commitStream Function pointer that is called to send the message
+ * written into the space, or to release it when called with 0
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkSetDirectOutputStream(UAVTalkConnection connectionHandle, UAVTalkReserveStream reserveStream, UAVTalkCommitStream commitStream)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	if ((reserveStream == NULL) != (commitStream == NULL)) {
+		return -1;
+	}
+
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+	connection->reserveStream = reserveStream;
+	connection->commitStream = commitStream;
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return 0;
+}
+
 /**
  * Get current output stream
  * \param[in] connection UAVTalkConnection to be used
@@ -115,6 +171,111 @@ UAVTalkOutputStream UAVTalkGetOutputStream(UAVTalkConnection connectionHandle)
 	return connection->outStream;
 }
 
+/**
+ * Enable or disable batching of object updates. While enabled, unacked and
+ * untimestamped updates are collected into multi-object frames, which are
+ * sent when full, before any other message or on UAVTalkFlushBatch(). Only
+ * enable it when the other end has announced it can unpack these frames.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] enabled True to batch object updates
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkSetBatching(UAVTalkConnection connectionHandle, bool enabled)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	// Lock
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+
+	int32_t ret = 0;
+	if (enabled && connection->batchBuffer == NULL) {
+		// Only connections that ever batch pay for the buffer
+		connection->batchBuffer = PIOS_malloc(UAVTALK_MAX_PACKET_LENGTH);
+		if (connection->batchBuffer == NULL)
+			ret = -1;
+	}
+
+	if (ret == 0) {
+		flushBatch(connection);
+		connection->batching = enabled;
+	}
+
+	// Release lock
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return ret;
+}
+
+/**
+ * Send the object updates collected so far, if any.
+ * \param[in] connection UAVTalkConnection to be used
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkFlushBatch(UAVTalkConnection connectionHandle)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	// Lock
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+
+	int32_t ret = flushBatch(connection);
+
+	// Release lock
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return ret;
+}
+
+/**
+ * Enable or disable delta encoding of object updates. While enabled, plain
+ * updates of an object instance carry only the bytes that changed since the
+ * last update sent of it, with a full update every
+ * UAVTALK_DELTA_KEYFRAME_INTERVAL updates for the other end to recover from
+ * lost frames. Only enable it when the other end has announced it can apply
+ * delta frames, it then also accepts them from the other end.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] enabled True to send deltas
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkSetDeltaEncoding(UAVTalkConnection connectionHandle, bool enabled)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	// Lock
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+
+	int32_t ret = 0;
+	if (enabled && connection->deltaBuffer == NULL) {
+		connection->deltaBuffer = PIOS_malloc(UAVTALK_MAX_PAYLOAD_LENGTH);
+		if (connection->deltaBuffer == NULL)
+			ret = -1;
+	}
+	if (enabled && ret == 0 && connection->deltaCache == NULL) {
+		connection->deltaCache = PIOS_malloc(UAVTALK_DELTA_BUCKETS * sizeof(*connection->deltaCache));
+		if (connection->deltaCache == NULL)
+			ret = -1;
+		else
+			memset(connection->deltaCache, 0, UAVTALK_DELTA_BUCKETS * sizeof(*connection->deltaCache));
+	}
+
+	if (ret == 0) {
+		// The other end may not have any of the data, start over from full updates
+		clearDeltaCache(connection);
+		connection->deltaEncoding = enabled;
+	}
+
+	// Release lock
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return ret;
+}
+
 /**
  * Get communication statistics counters
  * \param[in] connection UAVTalkConnection to be used
@@ -209,6 +370,42 @@ int32_t UAVTalkSendObject(UAVTalkConnection connectionHandle, UAVObjHandle obj,
 	}
 }
 
+/**
+ * Send the specified object through the telemetry link as a full update in a
+ * frame of its own, even while batching or delta encoding. For objects that a
+ * relay on the link routes by the ID in the frame header, as the relay
+ * unpacks them itself and can't apply deltas.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object to send
+ * \param[in] instId The instance ID or UAVOBJ_ALL_INSTANCES for all instances.
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkSendObjectUnbatched(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	// Lock
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+
+	// The updates batched so far are flushed ahead of the frame
+	bool batching = connection->batching;
+	bool deltaEncoding = connection->deltaEncoding;
+	connection->batching = false;
+	connection->deltaEncoding = false;
+	int32_t ret = sendObject(connection, obj, instId, UAVTALK_TYPE_OBJ);
+	connection->batching = batching;
+	connection->deltaEncoding = deltaEncoding;
+	if (ret < 0)
+		++connection->stats.txErrors;
+
+	// Release lock
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return ret;
+}
+
 /**
  * Send the specified object through the telemetry link with a timestamp.
  * \param[in] connection UAVTalkConnection to be used
@@ -234,6 +431,66 @@ int32_t UAVTalkSendObjectTimestamped(UAVTalkConnection connectionHandle, UAVObjH
 	}
 }
 
+/**
+ * Send the specified object through the telemetry link and have it acked,
+ * without waiting for the ack. Up to UAVTALK_MAX_TRANSACTIONS sends and
+ * requests can be outstanding, each of them is retried on its own timeout.
+ * Sending an object again before its ack arrived restarts its transaction.
+ * The retries and failures of these transactions are counted in the stats.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object to send
+ * \param[in] instId The instance ID or UAVOBJ_ALL_INSTANCES for all instances.
+ * \param[in] timeoutMs Time to wait for the ack before sending again, and for a free transaction slot
+ * \param[in] maxRetries Number of times the object is sent again before the transaction fails
+ * \param[in] cb Called when the transaction succeeds or fails, can be NULL
+ * \return 0 Success, the object has been sent
+ * \return -1 Failure
+ */
+int32_t UAVTalkSendObjectAsync(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId, int32_t timeoutMs, uint8_t maxRetries, UAVTalkTransactionCallback cb)
+{
+	UAVTalkConnectionData *connection;
+    CHECKCONHANDLE(connectionHandle,connection,return -1);
+	return startTransaction(connection, obj, instId, UAVTALK_TYPE_OBJ_ACK, timeoutMs, maxRetries, cb);
+}
+
+/**
+ * Request an update of the specified object without waiting for it, see
+ * UAVTalkSendObjectAsync.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object to update
+ * \param[in] instId The instance ID or UAVOBJ_ALL_INSTANCES for all instances.
+ * \param[in] timeoutMs Time to wait for the update before requesting again, and for a free transaction slot
+ * \param[in] maxRetries Number of times the object is requested again before the transaction fails
+ * \param[in] cb Called when the transaction succeeds or fails, can be NULL
+ * \return 0 Success, the request has been sent
+ * \return -1 Failure
+ */
+int32_t UAVTalkSendObjectRequestAsync(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId, int32_t timeoutMs, uint8_t maxRetries, UAVTalkTransactionCallback cb)
+{
+	UAVTalkConnectionData *connection;
+    CHECKCONHANDLE(connectionHandle,connection,return -1);
+	return startTransaction(connection, obj, instId, UAVTALK_TYPE_OBJ_REQ, timeoutMs, maxRetries, cb);
+}
+
+/**
+ * Retry or fail the transactions that timed out. Must be called regularly
+ * by the users of the asynchronous transactions.
+ * \param[in] connection UAVTalkConnection to be used
+ * \return Time in ms until the next transaction times out
+ * \return -1 No transaction is outstanding
+ */
+int32_t UAVTalkProcessTransactions(UAVTalkConnection connectionHandle)
+{
+	UAVTalkConnectionData *connection;
+    CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+	int32_t nextTimeout = expireTransactions(connection);
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return nextTimeout;
+}
+
 /**
  * Execute the requested transaction on an object.
  * \param[in] connection UAVTalkConnection to be used
@@ -253,32 +510,38 @@ static int32_t objectTransaction(UAVTalkConnectionData *connection, UAVObjHandle
 	// Send object depending on if a response is needed
 	if (type == UAVTALK_TYPE_OBJ_ACK || type == UAVTALK_TYPE_OBJ_ACK_TS || type == UAVTALK_TYPE_OBJ_REQ)
 	{
-		// Get transaction lock (will block if a transaction is pending)
+		// Get transaction lock (will block if another blocking transaction is pending),
+		// asynchronous transactions keep going meanwhile
 		PIOS_Recursive_Mutex_Lock(connection->transLock, PIOS_MUTEX_TIMEOUT_MAX);
+		PIOS_Semaphore_Take(connection->respSema, 0); // non blocking call to make sure the value is reset to zero (binary sema)
 		// Send object
-		PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
-		connection->respObj = obj;
-		connection->respInstId = instId;
-		sendObject(connection, obj, instId, type);
-		PIOS_Recursive_Mutex_Unlock(connection->lock);
+		if (startTransaction(connection, obj, instId, type, timeoutMs, 0, transactionResponse) < 0)
+		{
+			PIOS_Recursive_Mutex_Unlock(connection->transLock);
+			return -1;
+		}
 		// Wait for response (or timeout)
 		respReceived = PIOS_Semaphore_Take(connection->respSema, timeoutMs);
-		// Check if a response was received
+		PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
 		if (respReceived == false)
 		{
 			// Cancel transaction
-			PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
-			PIOS_Semaphore_Take(connection->respSema, 0); // non blocking call to make sure the value is reset to zero (binary sema)
-			connection->respObj = 0;
-			PIOS_Recursive_Mutex_Unlock(connection->lock);
-			PIOS_Recursive_Mutex_Unlock(connection->transLock);
-			return -1;
+			for (int32_t i = 0; i < UAVTALK_MAX_TRANSACTIONS; i++)
+			{
+				if (connection->transactions[i].obj != NULL && connection->transactions[i].cb == transactionResponse)
+				{
+					connection->transactions[i].obj = NULL;
+					PIOS_Semaphore_Give(connection->slotSema);
+				}
+			}
 		}
 		else
 		{
-			PIOS_Recursive_Mutex_Unlock(connection->transLock);
-			return 0;
+			respReceived = connection->respSuccess;
 		}
+		PIOS_Recursive_Mutex_Unlock(connection->lock);
+		PIOS_Recursive_Mutex_Unlock(connection->transLock);
+		return respReceived ? 0 : -1;
 	}
 	else if (type == UAVTALK_TYPE_OBJ || type == UAVTALK_TYPE_OBJ_TS)
 	{
@@ -293,6 +556,158 @@ static int32_t objectTransaction(UAVTalkConnectionData *connection, UAVObjHandle
 	}
 }
 
+/**
+ * Start an acked transaction, waiting up to timeoutMs for a free slot
+ * when UAVTALK_MAX_TRANSACTIONS transactions are already outstanding.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object
+ * \param[in] instId The instance ID of UAVOBJ_ALL_INSTANCES for all instances.
+ * \param[in] type Transaction type, UAVTALK_TYPE_OBJ_ACK(_TS) or UAVTALK_TYPE_OBJ_REQ
+ * \param[in] timeoutMs Time to wait for the response
+ * \param[in] maxRetries Number of retries before the transaction fails
+ * \param[in] cb Completion callback
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t startTransaction(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type, int32_t timeoutMs, uint8_t maxRetries, UAVTalkTransactionCallback cb)
+{
+	uint32_t start = PIOS_Thread_Systime();
+
+	if (obj == NULL)
+		return -1;
+
+	while (1) {
+		PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+
+		// Transactions that ran out of retries free their slot
+		int32_t nextTimeout = expireTransactions(connection);
+
+		struct UAVTalkTransaction *trans = findTransactionSlot(connection, obj, instId, type, cb);
+		if (trans != NULL) {
+			trans->obj = obj;
+			trans->instId = instId;
+			trans->type = type;
+			trans->retriesRemaining = maxRetries;
+			trans->retries = 0;
+			trans->timeoutMs = timeoutMs;
+			trans->deadline = PIOS_Thread_Systime() + timeoutMs;
+			trans->cb = cb;
+			sendObject(connection, obj, instId, type);
+			PIOS_Recursive_Mutex_Unlock(connection->lock);
+			return 0;
+		}
+
+		PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+		// Wait for a transaction to complete or to time out
+		int32_t remaining = timeoutMs - (int32_t)(PIOS_Thread_Systime() - start);
+		if (remaining <= 0) {
+			if (cb != transactionResponse) {
+				PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+				++connection->stats.txErrors;
+				PIOS_Recursive_Mutex_Unlock(connection->lock);
+			}
+			return -1;
+		}
+		if (nextTimeout >= 0 && nextTimeout < remaining)
+			remaining = nextTimeout;
+		PIOS_Semaphore_Take(connection->slotSema, remaining);
+	}
+}
+
+/**
+ * Find the slot for a new transaction. A transaction of the same object,
+ * instance, type and callback is superseded by the new one.
+ * \return The slot, NULL when all of them are in use
+ */
+static struct UAVTalkTransaction *findTransactionSlot(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type, UAVTalkTransactionCallback cb)
+{
+	struct UAVTalkTransaction *unused = NULL;
+
+	for (int32_t i = 0; i < UAVTALK_MAX_TRANSACTIONS; i++) {
+		struct UAVTalkTransaction *trans = &connection->transactions[i];
+		if (trans->obj == NULL) {
+			if (unused == NULL)
+				unused = trans;
+		} else if (trans->obj == obj && trans->instId == instId && trans->type == type && trans->cb == cb) {
+			return trans;
+		}
+	}
+
+	return unused;
+}
+
+/**
+ * Free the slot of a transaction and report its result.
+ */
+static void completeTransaction(UAVTalkConnectionData *connection, struct UAVTalkTransaction *trans, bool success)
+{
+	UAVObjHandle obj = trans->obj;
+	uint16_t instId = trans->instId;
+	uint8_t retries = trans->retries;
+	UAVTalkTransactionCallback cb = trans->cb;
+
+	trans->obj = NULL;
+	PIOS_Semaphore_Give(connection->slotSema);
+
+	// The blocking calls report their result to their caller instead
+	if (cb != transactionResponse) {
+		connection->stats.txRetries += retries;
+		if (!success)
+			++connection->stats.txErrors;
+	}
+
+	if (cb != NULL)
+		cb((UAVTalkConnection) connection, obj, instId, success, retries);
+}
+
+/**
+ * Send the transactions that timed out again, or fail them once they are
+ * out of retries. Called with the connection locked.
+ * \return Time in ms until the next transaction times out
+ * \return -1 No transaction is outstanding
+ */
+static int32_t expireTransactions(UAVTalkConnectionData *connection)
+{
+	int32_t nextTimeout = -1;
+
+	for (int32_t i = 0; i < UAVTALK_MAX_TRANSACTIONS; i++) {
+		struct UAVTalkTransaction *trans = &connection->transactions[i];
+		if (trans->obj == NULL)
+			continue;
+
+		uint32_t now = PIOS_Thread_Systime();
+		int32_t left = (int32_t)(trans->deadline - now);
+		if (left <= 0) {
+			if (trans->retriesRemaining == 0) {
+				completeTransaction(connection, trans, false);
+				continue;
+			}
+			trans->retriesRemaining--;
+			trans->retries++;
+			trans->deadline = now + trans->timeoutMs;
+			left = trans->timeoutMs;
+			sendObject(connection, trans->obj, trans->instId, trans->type);
+		}
+
+		if (nextTimeout < 0 || left < nextTimeout)
+			nextTimeout = left;
+	}
+
+	return nextTimeout;
+}
+
+/**
+ * Completion of the blocking transactions, wakes up objectTransaction
+ */
+static void transactionResponse(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId, bool success, uint8_t retries)
+{
+	UAVTalkConnectionData *connection = (UAVTalkConnectionData *) connectionHandle;
+
+	connection->respSuccess = success;
+	PIOS_Semaphore_Give(connection->respSema);
+}
+
 /**
  * Process an byte from the telemetry stream.
  * \param[in] connection UAVTalkConnection to be used
@@ -300,10 +715,81 @@ static int32_t objectTransaction(UAVTalkConnectionData *connection, UAVObjHandle
  * \return UAVTalkRxState
  */
 UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connectionHandle, uint8_t rxbyte)
+{
+	UAVTalkConnectionData *connection;
+    CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	return processInputByte(connection, rxbyte);
+}
+
+/**
+ * Process a buffer of the telemetry stream, such as a chunk read from a
+ * COM port, and act on the packets it completes. The payload of a packet
+ * is checked and copied as a block. When the whole payload and its
+ * checksum are in the buffer it is unpacked straight from there into the
+ * object, without going through the receive buffer.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] buf Received bytes
+ * \param[in] len Number of bytes
+ * \return Number of packets received
+ * \return -1 Failure
+ */
+int32_t UAVTalkProcessInputBuffer(UAVTalkConnection connectionHandle, uint8_t *buf, uint16_t len)
 {
 	UAVTalkConnectionData *connection;
     CHECKCONHANDLE(connectionHandle,connection,return -1);
 
+	UAVTalkInputProcessor *iproc = &connection->iproc;
+	uint8_t *payload = connection->rxBuffer;
+	int32_t packets = 0;
+	uint16_t i = 0;
+
+	while (i < len) {
+		if (iproc->state == UAVTALK_STATE_DATA) {
+			uint16_t count = iproc->length - iproc->rxCount;
+
+			if (iproc->rxCount == 0 && len - i > count) {
+				// Payload and checksum are both here, no need to stage it
+				payload = &buf[i];
+			} else {
+				if (count > len - i)
+					count = len - i;
+				memcpy(&connection->rxBuffer[iproc->rxCount], &buf[i], count);
+			}
+
+			iproc->cs = PIOS_CRC_updateCRC(iproc->cs, &buf[i], count);
+			iproc->rxCount += count;
+			iproc->rxPacketLength += count;
+			connection->stats.rxBytes += count;
+			i += count;
+
+			if (iproc->rxCount == iproc->length) {
+				iproc->state = UAVTALK_STATE_CS;
+				iproc->rxCount = 0;
+			}
+			continue;
+		}
+
+		if (processInputByte(connection, buf[i++]) == UAVTALK_STATE_COMPLETE) {
+			PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+			receiveObject(connection, iproc->type, iproc->objId, iproc->instId, payload, iproc->length);
+			PIOS_Recursive_Mutex_Unlock(connection->lock);
+			packets++;
+		}
+		payload = connection->rxBuffer;
+	}
+
+	return packets;
+}
+
+/**
+ * Run the receive state machine on a byte of the telemetry stream.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] rxbyte Received byte
+ * \return UAVTalkRxState
+ */
+static UAVTalkRxState processInputByte(UAVTalkConnectionData *connection, uint8_t rxbyte)
+{
 	UAVTalkInputProcessor *iproc = &connection->iproc;
 	++connection->stats.rxBytes;
 
@@ -390,19 +876,26 @@ UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connectionHandle
 			{
 				iproc->length = 0;
 				iproc->instanceLength = 0;
+				iproc->timestampLength = 0;
 			}
 			else
 			{
 				if (iproc->obj)
 				{
-					iproc->length = UAVObjGetNumBytes(iproc->obj);
 					iproc->instanceLength = (UAVObjIsSingleInstance(iproc->obj) ? 0 : 2);
 					iproc->timestampLength = (iproc->type & UAVTALK_TIMESTAMPED) ? 2 : 0;
+					if (iproc->type == UAVTALK_TYPE_OBJ_DELTA)
+						// Deltas are as long as what changed
+						iproc->length = iproc->packet_size - iproc->rxPacketLength - iproc->instanceLength;
+					else
+						iproc->length = UAVObjGetNumBytes(iproc->obj);
 				}
 				else
 				{
 					// We don't know if it's a multi-instance object, so just assume it's 0.
+					// Multi-object frames also end up here as they carry no object ID.
 					iproc->instanceLength = 0;
+					iproc->timestampLength = 0;
 					iproc->length = iproc->packet_size - iproc->rxPacketLength;
 				}
 			}
@@ -601,6 +1094,8 @@ int32_t UAVTalkRelayPacket(UAVTalkConnection inConnectionHandle, UAVTalkConnecti
     // Lock
     PIOS_Recursive_Mutex_Lock(outConnection->lock, PIOS_MUTEX_TIMEOUT_MAX);
 
+    flushBatch(outConnection);
+
     outConnection->txBuffer[0] = UAVTALK_SYNC_VAL;
     // Setup type
     outConnection->txBuffer[1] = inIproc->type;
@@ -839,6 +1334,8 @@ int32_t UAVTalkSendBuf(UAVTalkConnection connectionHandle, uint8_t *buf, uint16_
 	// Lock
 	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
 
+	flushBatch(connection);
+
 	// Output the buffer
 	int32_t rc = (*connection->outStream)(buf, len);
 
@@ -884,7 +1381,7 @@ static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, ui
 				// Unpack object, if the instance does not exist it will be created!
 				UAVObjUnpack(obj, instId, data);
 				// Check if an ack is pending
-				updateAck(connection, obj, instId);
+				updateAck(connection, obj, instId, true);
 			}
 			else
 			{
@@ -923,14 +1420,29 @@ static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, ui
 				sendObject(connection, obj, instId, UAVTALK_TYPE_OBJ);
 			break;
 		case UAVTALK_TYPE_NACK:
-			// Do nothing on flight side, let it time out.
+			// The other end doesn't know the object, retrying won't help
+			if (obj)
+				updateAck(connection, obj, UAVOBJ_ALL_INSTANCES, false);
 			break;
 		case UAVTALK_TYPE_ACK:
 			// All instances, not allowed for ACK messages
 			if (obj && (instId != UAVOBJ_ALL_INSTANCES))
 			{
 				// Check if an ack is pending
-				updateAck(connection, obj, instId);
+				updateAck(connection, obj, instId, true);
+			}
+			else
+			{
+				ret = -1;
+			}
+			break;
+		case UAVTALK_TYPE_OBJ_MULTI:
+			ret = receiveMultiObject(connection, data, length);
+			break;
+		case UAVTALK_TYPE_OBJ_DELTA:
+			if (obj && (instId != UAVOBJ_ALL_INSTANCES))
+			{
+				ret = receiveDeltaObject(connection, obj, instId, data, length);
 			}
 			else
 			{
@@ -945,17 +1457,169 @@ static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, ui
 }
 
 /**
- * Check if an ack is pending on an object and give response semaphore
+ * Unpack the objects of a multi-object frame. The payload is a sequence of
+ * records, each being the object ID, the instance ID for multi-instance
+ * objects only and the object data. Delta records start with
+ * UAVTALK_MULTI_DELTA_RECORD and carry a delta payload instead of the data.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] data Payload of the frame
+ * \param[in] length Payload length
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t receiveMultiObject(UAVTalkConnectionData *connection, uint8_t* data, int32_t length)
+{
+	int32_t offset = 0;
+
+	while (offset < length) {
+		if (length - offset < 4)
+			return -1;
+		uint32_t objId = data[offset] | (data[offset + 1] << 8) |
+				(data[offset + 2] << 16) | ((uint32_t)data[offset + 3] << 24);
+		offset += 4;
+
+		// A delta record is marked ahead of the object ID
+		bool delta = false;
+		if (objId == UAVTALK_MULTI_DELTA_RECORD) {
+			if (length - offset < 4)
+				return -1;
+			objId = data[offset] | (data[offset + 1] << 8) |
+				(data[offset + 2] << 16) | ((uint32_t)data[offset + 3] << 24);
+			offset += 4;
+			delta = true;
+		}
+
+		// The record length comes from the object, the rest of the
+		// frame can't be parsed past an unknown one
+		UAVObjHandle obj = UAVObjGetByID(objId);
+		if (obj == NULL)
+			return -1;
+
+		uint16_t instId = 0;
+		if (!UAVObjIsSingleInstance(obj)) {
+			if (length - offset < 2)
+				return -1;
+			instId = data[offset] | (data[offset + 1] << 8);
+			offset += 2;
+		}
+
+		if (delta) {
+			// A delta that doesn't apply is skipped like a lost frame
+			bool applied;
+			int32_t deltaLength = applyDelta(connection, obj, instId, &data[offset], length - offset, &applied);
+			if (deltaLength < 0)
+				return -1;
+			offset += deltaLength;
+			continue;
+		}
+
+		int32_t objLength = UAVObjGetNumBytes(obj);
+		if (length - offset < objLength)
+			return -1;
+
+		UAVObjUnpack(obj, instId, &data[offset]);
+		updateAck(connection, obj, instId, true);
+		offset += objLength;
+	}
+
+	return 0;
+}
+
+/**
+ * Apply a delta frame to an object. The payload is the CRC-16 of the resulting
+ * object data, a bitmap with a bit per UAVTALK_DELTA_CHUNK_LENGTH bytes of
+ * the object and the chunks that changed.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object the delta is for
+ * \param[in] instId The instance ID
+ * \param[in] data Payload of the frame
+ * \param[in] length Payload length
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t receiveDeltaObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t* data, int32_t length)
+{
+	bool applied;
+	if (applyDelta(connection, obj, instId, data, length, &applied) != length || !applied)
+		return -1;
+
+	return 0;
+}
+
+/**
+ * Apply a delta payload to an object, when the result matches its CRC.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object the delta is for
+ * \param[in] instId The instance ID
+ * \param[in] data The delta payload
+ * \param[in] length Bytes available from data onwards
+ * \param[out] applied Whether the object was updated
+ * \return The length of the delta payload, -1 if it is malformed
+ */
+static int32_t applyDelta(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, const uint8_t* data, int32_t length, bool *applied)
+{
+	uint8_t *current = connection->deltaBuffer;
+
+	*applied = false;
+
+	// Deltas are only expected once they have been agreed on
+	if (current == NULL)
+		return -1;
+
+	int32_t objLength = UAVObjGetNumBytes(obj);
+	int32_t numChunks = (objLength + UAVTALK_DELTA_CHUNK_LENGTH - 1) / UAVTALK_DELTA_CHUNK_LENGTH;
+	int32_t bitmapLength = (numChunks + 7) / 8;
+	if (length < UAVTALK_DELTA_CRC_LENGTH + bitmapLength)
+		return -1;
+
+	if (UAVObjPack(obj, instId, current) < 0)
+		return -1;
+
+	const uint8_t *bitmap = &data[UAVTALK_DELTA_CRC_LENGTH];
+	int32_t offset = UAVTALK_DELTA_CRC_LENGTH + bitmapLength;
+	for (int32_t chunk = 0; chunk < numChunks; chunk++) {
+		if (!(bitmap[chunk / 8] & (1 << (chunk % 8))))
+			continue;
+
+		int32_t objOffset = chunk * UAVTALK_DELTA_CHUNK_LENGTH;
+		int32_t chunkLength = objLength - objOffset;
+		if (chunkLength > UAVTALK_DELTA_CHUNK_LENGTH)
+			chunkLength = UAVTALK_DELTA_CHUNK_LENGTH;
+		if (offset + chunkLength > length)
+			return -1;
+
+		memcpy(&current[objOffset], &data[offset], chunkLength);
+		offset += chunkLength;
+	}
+
+	// A lost frame leaves the data the delta applies to different from the
+	// sender's, ignore deltas until the next full update
+	uint16_t crc = data[0] | (data[1] << 8);
+	if (PIOS_CRC16_updateCRC(0, current, objLength) == crc) {
+		UAVObjUnpack(obj, instId, current);
+		updateAck(connection, obj, instId, true);
+		*applied = true;
+	}
+
+	return offset;
+}
+
+/**
+ * Complete the transactions pending on an object
  * \param[in] connection UAVTalkConnection to be used
  * \param[in] obj Object
  * \param[in] instId The instance ID of UAVOBJ_ALL_INSTANCES for all instances.
+ * \param[in] success Whether the response was an ack or the object, rather than a nack
  */
-static void updateAck(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId)
+static void updateAck(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, bool success)
 {
-	if (connection->respObj == obj && (connection->respInstId == instId || connection->respInstId == UAVOBJ_ALL_INSTANCES))
+	for (int32_t i = 0; i < UAVTALK_MAX_TRANSACTIONS; i++)
 	{
-		PIOS_Semaphore_Give(connection->respSema);
-		connection->respObj = 0;
+		struct UAVTalkTransaction *trans = &connection->transactions[i];
+		if (trans->obj == obj && (trans->instId == instId || trans->instId == UAVOBJ_ALL_INSTANCES || instId == UAVOBJ_ALL_INSTANCES))
+		{
+			completeTransaction(connection, trans, success);
+		}
 	}
 }
 
@@ -1036,38 +1700,30 @@ static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle
 
 	if (!connection->outStream) return -1;
 
-	// Setup type and object id fields
-	objId = UAVObjGetID(obj);
-	connection->txBuffer[0] = UAVTALK_SYNC_VAL;  // sync byte
-	connection->txBuffer[1] = type;
-	// data length inserted here below
-	connection->txBuffer[4] = (uint8_t)(objId & 0xFF);
-	connection->txBuffer[5] = (uint8_t)((objId >> 8) & 0xFF);
-	connection->txBuffer[6] = (uint8_t)((objId >> 16) & 0xFF);
-	connection->txBuffer[7] = (uint8_t)((objId >> 24) & 0xFF);
-	
-	// Setup instance ID if one is required
-	if (UAVObjIsSingleInstance(obj))
+	// Send plain updates as deltas when the other end has what they apply to
+	if (type == UAVTALK_TYPE_OBJ && connection->deltaEncoding &&
+			sendDeltaObject(connection, obj, instId) == 0)
 	{
-		dataOffset = 8;
+		return 0;
 	}
-	else
+
+	// Collect plain updates into a multi-object frame when batching, unless
+	// the object is too large to ever share one
+	if (type == UAVTALK_TYPE_OBJ && connection->batching &&
+			4 + 2 + UAVObjGetNumBytes(obj) <= UAVTALK_MAX_BATCH_PAYLOAD)
 	{
-		connection->txBuffer[8] = (uint8_t)(instId & 0xFF);
-		connection->txBuffer[9] = (uint8_t)((instId >> 8) & 0xFF);
-		dataOffset = 10;
+		return batchSingleObject(connection, obj, instId);
 	}
 
-	// Add timestamp when the transaction type is appropriate
+	// Everything else has to follow the updates batched before it
+	flushBatch(connection);
+
+	// Determine the header and data length
+	dataOffset = UAVObjIsSingleInstance(obj) ? 8 : 10;
 	if (type & UAVTALK_TIMESTAMPED)
 	{
-		uint32_t time = PIOS_Thread_Systime();
-		connection->txBuffer[dataOffset] = (uint8_t)(time & 0xFF);
-		connection->txBuffer[dataOffset + 1] = (uint8_t)((time >> 8) & 0xFF);
 		dataOffset += 2;
 	}
-	
-	// Determine data length
 	if (type == UAVTALK_TYPE_OBJ_REQ || type == UAVTALK_TYPE_ACK)
 	{
 		length = 0;
@@ -1082,25 +1738,77 @@ static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle
 	{
 		return -1;
 	}
+
+	uint16_t tx_msg_len = dataOffset+length+UAVTALK_CHECKSUM_LENGTH;
+
+	// Build the message in place in the output buffer when it is in one
+	// piece, otherwise in txBuffer to be copied out
+	uint8_t *spans[2];
+	uint16_t spanLengths[2];
+	int32_t numSpans = 0;
+	if (connection->reserveStream)
+	{
+		numSpans = (*connection->reserveStream)(tx_msg_len, spans, spanLengths);
+	}
+	uint8_t *buf = (numSpans == 1) ? spans[0] : connection->txBuffer;
+
+	// Setup type and object id fields
+	objId = UAVObjGetID(obj);
+	buf[0] = UAVTALK_SYNC_VAL;  // sync byte
+	buf[1] = type;
+	buf[2] = (uint8_t)((dataOffset+length) & 0xFF);
+	buf[3] = (uint8_t)(((dataOffset+length) >> 8) & 0xFF);
+	buf[4] = (uint8_t)(objId & 0xFF);
+	buf[5] = (uint8_t)((objId >> 8) & 0xFF);
+	buf[6] = (uint8_t)((objId >> 16) & 0xFF);
+	buf[7] = (uint8_t)((objId >> 24) & 0xFF);
+	
+	// Setup instance ID if one is required
+	if (!UAVObjIsSingleInstance(obj))
+	{
+		buf[8] = (uint8_t)(instId & 0xFF);
+		buf[9] = (uint8_t)((instId >> 8) & 0xFF);
+	}
+
+	// Add timestamp when the transaction type is appropriate
+	if (type & UAVTALK_TIMESTAMPED)
+	{
+		uint32_t time = PIOS_Thread_Systime();
+		buf[dataOffset - 2] = (uint8_t)(time & 0xFF);
+		buf[dataOffset - 1] = (uint8_t)((time >> 8) & 0xFF);
+	}
 	
 	// Copy data (if any)
 	if (length > 0)
 	{
-		if ( UAVObjPack(obj, instId, &connection->txBuffer[dataOffset]) < 0 )
+		if ( UAVObjPack(obj, instId, &buf[dataOffset]) < 0 )
 		{
+			if (numSpans > 0)
+			{
+				(*connection->commitStream)(0);
+			}
 			return -1;
 		}
+		storeDeltaBase(connection, obj, instId, &buf[dataOffset]);
 	}
 	
-	// Store the packet length
-	connection->txBuffer[2] = (uint8_t)((dataOffset+length) & 0xFF);
-	connection->txBuffer[3] = (uint8_t)(((dataOffset+length) >> 8) & 0xFF);
-	
 	// Calculate checksum
-	connection->txBuffer[dataOffset+length] = PIOS_CRC_updateCRC(0, connection->txBuffer, dataOffset+length);
+	buf[dataOffset+length] = PIOS_CRC_updateCRC(0, buf, dataOffset+length);
 
-	uint16_t tx_msg_len = dataOffset+length+UAVTALK_CHECKSUM_LENGTH;
-	int32_t rc = (*connection->outStream)(connection->txBuffer, tx_msg_len);
+	int32_t rc;
+	if (numSpans > 0)
+	{
+		if (numSpans == 2)
+		{
+			memcpy(spans[0], buf, spanLengths[0]);
+			memcpy(spans[1], &buf[spanLengths[0]], spanLengths[1]);
+		}
+		rc = (*connection->commitStream)(tx_msg_len);
+	}
+	else
+	{
+		rc = (*connection->outStream)(buf, tx_msg_len);
+	}
 
 	if (rc == tx_msg_len) {
 		// Update stats
@@ -1126,6 +1834,8 @@ static int32_t sendNack(UAVTalkConnectionData *connection, uint32_t objId)
 
 	if (!connection->outStream) return -1;
 
+	flushBatch(connection);
+
 	connection->txBuffer[0] = UAVTALK_SYNC_VAL;  // sync byte
 	connection->txBuffer[1] = UAVTALK_TYPE_NACK;
 	// data length inserted here below
@@ -1155,6 +1865,325 @@ static int32_t sendNack(UAVTalkConnectionData *connection, uint32_t objId)
 	return 0;
 }
 
+/**
+ * Append an object update to the multi-object frame being collected, sending
+ * the frame first if the update doesn't fit anymore.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object handle to send
+ * \param[in] instId The instance ID (can NOT be UAVOBJ_ALL_INSTANCES)
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t batchSingleObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId)
+{
+	uint32_t objId = UAVObjGetID(obj);
+	int32_t length = UAVObjGetNumBytes(obj);
+	int32_t dataOffset = UAVObjIsSingleInstance(obj) ? 4 : 6;
+
+	if (connection->batchLength + dataOffset + length > UAVTALK_MIN_HEADER_LENGTH + UAVTALK_MAX_BATCH_PAYLOAD)
+	{
+		flushBatch(connection);
+	}
+
+	// The header is filled in when the frame is sent
+	if (connection->batchLength == 0)
+	{
+		connection->batchLength = UAVTALK_MIN_HEADER_LENGTH;
+	}
+
+	uint8_t *record = &connection->batchBuffer[connection->batchLength];
+	record[0] = (uint8_t)(objId & 0xFF);
+	record[1] = (uint8_t)((objId >> 8) & 0xFF);
+	record[2] = (uint8_t)((objId >> 16) & 0xFF);
+	record[3] = (uint8_t)((objId >> 24) & 0xFF);
+	if (dataOffset > 4)
+	{
+		record[4] = (uint8_t)(instId & 0xFF);
+		record[5] = (uint8_t)((instId >> 8) & 0xFF);
+	}
+
+	if (UAVObjPack(obj, instId, &record[dataOffset]) < 0)
+	{
+		return -1;
+	}
+	storeDeltaBase(connection, obj, instId, &record[dataOffset]);
+
+	connection->batchLength += dataOffset + length;
+	++connection->batchObjects;
+	connection->batchObjectBytes += length;
+
+	return 0;
+}
+
+/**
+ * Send the multi-object frame being collected, if it holds any object.
+ * The object ID of the header is unused and zero, so relays that don't know
+ * the frame type pass it on as an unknown object.
+ * \param[in] connection UAVTalkConnection to be used
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t flushBatch(UAVTalkConnectionData *connection)
+{
+	uint16_t packetLength = connection->batchLength;
+	uint8_t *buf = connection->batchBuffer;
+
+	if (packetLength == 0) return 0;
+
+	connection->batchLength = 0;
+	uint16_t objects = connection->batchObjects;
+	uint32_t objectBytes = connection->batchObjectBytes;
+	connection->batchObjects = 0;
+	connection->batchObjectBytes = 0;
+
+	if (!connection->outStream) return -1;
+
+	buf[0] = UAVTALK_SYNC_VAL;  // sync byte
+	buf[1] = UAVTALK_TYPE_OBJ_MULTI;
+	buf[2] = (uint8_t)(packetLength & 0xFF);
+	buf[3] = (uint8_t)((packetLength >> 8) & 0xFF);
+	memset(&buf[4], 0, 4);
+
+	// Calculate checksum
+	buf[packetLength] = PIOS_CRC_updateCRC(0, buf, packetLength);
+
+	uint16_t tx_msg_len = packetLength + UAVTALK_CHECKSUM_LENGTH;
+	int32_t rc = (*connection->outStream)(buf, tx_msg_len);
+
+	if (rc != tx_msg_len) {
+		return -1;
+	}
+
+	// Update stats
+	connection->stats.txObjects += objects;
+	connection->stats.txBytes += tx_msg_len;
+	connection->stats.txObjectBytes += objectBytes;
+
+	return 0;
+}
+
+/**
+ * Send an object update as the chunks that changed since the last update sent
+ * of the object instance. While batching, the delta joins the batch as a
+ * delta record.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object handle to send
+ * \param[in] instId The instance ID (can NOT be UAVOBJ_ALL_INSTANCES)
+ * \return 0 if the delta was sent
+ * \return -1 if the object has to be sent in full instead
+ */
+static int32_t sendDeltaObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId)
+{
+	int32_t length = UAVObjGetNumBytes(obj);
+	if (length < UAVTALK_DELTA_MIN_LENGTH || length >= UAVTALK_MAX_PAYLOAD_LENGTH)
+	{
+		return -1;
+	}
+
+	struct UAVTalkDeltaEntry *entry = findDeltaEntry(connection, obj, instId);
+	if (entry == NULL)
+	{
+		// The full update sent instead fills it in
+		entry = PIOS_malloc(sizeof(*entry) + length);
+		if (entry == NULL)
+		{
+			return -1;
+		}
+		entry->obj = obj;
+		entry->instId = instId;
+		entry->valid = false;
+
+		struct UAVTalkDeltaEntry **bucket = &connection->deltaCache[deltaBucket(obj, instId)];
+		entry->next = *bucket;
+		*bucket = entry;
+		return -1;
+	}
+
+	// A full update now and then lets the other end recover from lost frames
+	if (!entry->valid || entry->sinceKeyframe >= UAVTALK_DELTA_KEYFRAME_INTERVAL)
+	{
+		return -1;
+	}
+
+	uint8_t *current = connection->deltaBuffer;
+	if (UAVObjPack(obj, instId, current) < 0)
+	{
+		return -1;
+	}
+
+	// The delta is built in place, behind a delta record of the batch or
+	// behind the header of its own frame. A record takes the marker, the
+	// object ID, the instance ID and at most the object length.
+	int32_t instLength = UAVObjIsSingleInstance(obj) ? 0 : 2;
+	bool batched = connection->batching &&
+		4 + 4 + instLength + length <= UAVTALK_MAX_BATCH_PAYLOAD;
+	uint8_t *header;
+	int32_t dataOffset;
+	if (batched)
+	{
+		if (connection->batchLength + 4 + 4 + instLength + length > UAVTALK_MIN_HEADER_LENGTH + UAVTALK_MAX_BATCH_PAYLOAD)
+		{
+			flushBatch(connection);
+		}
+		uint16_t recordOffset = connection->batchLength > 0 ? connection->batchLength : UAVTALK_MIN_HEADER_LENGTH;
+		header = &connection->batchBuffer[recordOffset];
+		dataOffset = 4 + 4 + instLength;
+	}
+	else
+	{
+		header = connection->txBuffer;
+		dataOffset = 8 + instLength;
+	}
+
+	int32_t numChunks = (length + UAVTALK_DELTA_CHUNK_LENGTH - 1) / UAVTALK_DELTA_CHUNK_LENGTH;
+	int32_t bitmapLength = (numChunks + 7) / 8;
+	uint8_t *delta = &header[dataOffset];
+	int32_t deltaLength = UAVTALK_DELTA_CRC_LENGTH + bitmapLength;
+
+	memset(&delta[UAVTALK_DELTA_CRC_LENGTH], 0, bitmapLength);
+	for (int32_t chunk = 0; chunk < numChunks; chunk++)
+	{
+		int32_t offset = chunk * UAVTALK_DELTA_CHUNK_LENGTH;
+		int32_t chunkLength = length - offset;
+		if (chunkLength > UAVTALK_DELTA_CHUNK_LENGTH)
+			chunkLength = UAVTALK_DELTA_CHUNK_LENGTH;
+
+		if (memcmp(&current[offset], &entry->data[offset], chunkLength) == 0)
+			continue;
+
+		// Not worth it when most of the object changed
+		if (deltaLength + chunkLength >= length)
+		{
+			return -1;
+		}
+
+		delta[UAVTALK_DELTA_CRC_LENGTH + chunk / 8] |= 1 << (chunk % 8);
+		memcpy(&delta[deltaLength], &current[offset], chunkLength);
+		deltaLength += chunkLength;
+	}
+	uint16_t crc = PIOS_CRC16_updateCRC(0, current, length);
+	delta[0] = (uint8_t)(crc & 0xFF);
+	delta[1] = (uint8_t)((crc >> 8) & 0xFF);
+
+	memcpy(entry->data, current, length);
+	entry->sinceKeyframe++;
+
+	uint32_t objId = UAVObjGetID(obj);
+	uint8_t *ids = &header[dataOffset - 4 - instLength];
+	ids[0] = (uint8_t)(objId & 0xFF);
+	ids[1] = (uint8_t)((objId >> 8) & 0xFF);
+	ids[2] = (uint8_t)((objId >> 16) & 0xFF);
+	ids[3] = (uint8_t)((objId >> 24) & 0xFF);
+	if (instLength > 0)
+	{
+		ids[4] = (uint8_t)(instId & 0xFF);
+		ids[5] = (uint8_t)((instId >> 8) & 0xFF);
+	}
+
+	if (batched)
+	{
+		header[0] = (uint8_t)(UAVTALK_MULTI_DELTA_RECORD & 0xFF);
+		header[1] = (uint8_t)((UAVTALK_MULTI_DELTA_RECORD >> 8) & 0xFF);
+		header[2] = (uint8_t)((UAVTALK_MULTI_DELTA_RECORD >> 16) & 0xFF);
+		header[3] = (uint8_t)((UAVTALK_MULTI_DELTA_RECORD >> 24) & 0xFF);
+
+		connection->batchLength = (header - connection->batchBuffer) + dataOffset + deltaLength;
+		++connection->batchObjects;
+		connection->batchObjectBytes += deltaLength;
+		return 0;
+	}
+
+	// Everything batched before goes first
+	flushBatch(connection);
+
+	header[0] = UAVTALK_SYNC_VAL;  // sync byte
+	header[1] = UAVTALK_TYPE_OBJ_DELTA;
+	header[2] = (uint8_t)((dataOffset + deltaLength) & 0xFF);
+	header[3] = (uint8_t)(((dataOffset + deltaLength) >> 8) & 0xFF);
+
+	// Calculate checksum
+	header[dataOffset + deltaLength] = PIOS_CRC_updateCRC(0, header, dataOffset + deltaLength);
+
+	uint16_t tx_msg_len = dataOffset + deltaLength + UAVTALK_CHECKSUM_LENGTH;
+	int32_t rc = (*connection->outStream)(header, tx_msg_len);
+
+	if (rc == tx_msg_len) {
+		// Update stats
+		++connection->stats.txObjects;
+		connection->stats.txBytes += tx_msg_len;
+		connection->stats.txObjectBytes += deltaLength;
+	}
+
+	return 0;
+}
+
+/**
+ * Remember the data of a full update sent, as the base of the next deltas.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object handle sent
+ * \param[in] instId The instance ID sent
+ * \param[in] data The packed object data sent
+ */
+static void storeDeltaBase(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, const uint8_t *data)
+{
+	if (!connection->deltaEncoding)
+		return;
+
+	struct UAVTalkDeltaEntry *entry = findDeltaEntry(connection, obj, instId);
+	if (entry != NULL)
+	{
+		memcpy(entry->data, data, UAVObjGetNumBytes(obj));
+		entry->valid = true;
+		entry->sinceKeyframe = 0;
+	}
+}
+
+/**
+ * Bucket of the delta base index an object instance is in.
+ */
+static uint32_t deltaBucket(UAVObjHandle obj, uint16_t instId)
+{
+	return ((uintptr_t)obj / sizeof(void *) + instId) & (UAVTALK_DELTA_BUCKETS - 1);
+}
+
+/**
+ * Find the delta base of an object instance.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object handle
+ * \param[in] instId The instance ID
+ * \return The entry or NULL if there is none yet
+ */
+static struct UAVTalkDeltaEntry *findDeltaEntry(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId)
+{
+	struct UAVTalkDeltaEntry *entry;
+
+	for (entry = connection->deltaCache[deltaBucket(obj, instId)]; entry != NULL; entry = entry->next)
+	{
+		if (entry->obj == obj && entry->instId == instId)
+			return entry;
+	}
+
+	return NULL;
+}
+
+/**
+ * Drop all delta bases, the next update of every object is sent in full.
+ * The entries are kept for when delta encoding starts again.
+ * \param[in] connection UAVTalkConnection to be used
+ */
+static void clearDeltaCache(UAVTalkConnectionData *connection)
+{
+	if (connection->deltaCache == NULL)
+		return;
+
+	for (uint32_t i = 0; i < UAVTALK_DELTA_BUCKETS; i++)
+	{
+		struct UAVTalkDeltaEntry *entry;
+		for (entry = connection->deltaCache[i]; entry != NULL; entry = entry->next)
+			entry->valid = false;
+	}
+}
+
 /**
  * @}
  * @}
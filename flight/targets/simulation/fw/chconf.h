@@ -529,7 +529,9 @@ halrtcnt_t hal_lld_get_counter_value(void);
 #if !defined(IDLE_LOOP_HOOK) || defined(__DOXYGEN__)
 #define IDLE_LOOP_HOOK() {                                                  \
   extern void vApplicationIdleHook(void);                                   \
+  extern void PIOS_SIM_Idle(void);                                          \
   vApplicationIdleHook();                                                   \
+  PIOS_SIM_Idle();                                                          \
 }
 #endif
 
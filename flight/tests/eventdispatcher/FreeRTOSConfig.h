@@ -0,0 +1 @@
+#define configMINIMAL_STACK_SIZE 128
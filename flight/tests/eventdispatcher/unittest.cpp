@@ -0,0 +1,243 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdint.h>		/* uint*_t */
+#include <string.h>		/* memset */
+#include <time.h>		/* clock_gettime */
+
+extern "C" {
+
+#include "openpilot.h"
+#include "pios_queue.h"
+#include "unittest_init.h"
+
+}
+
+#define NUM_EVENTS 5000
+
+static const uint16_t periods[] = { 10, 20, 50, 100, 250, 1000 };
+
+static struct pios_queue telemetry_queue;
+
+static uint32_t dispatches[NUM_EVENTS];
+static uint32_t last_dispatch[NUM_EVENTS];
+static uint32_t bad_intervals;
+
+static uint16_t period_of(uint16_t event)
+{
+  return periods[event % (sizeof(periods) / sizeof(periods[0]))];
+}
+
+static void record_dispatch(struct pios_queue *queuep, const void *itemp)
+{
+  const UAVObjEvent *ev = (const UAVObjEvent *) itemp;
+
+  ASSERT_EQ(&telemetry_queue, queuep);
+  ASSERT_LT(ev->instId, NUM_EVENTS);
+
+  // The first interval after the first dispatch sets the phase of the event
+  uint32_t now = ut_get_clock();
+  if (dispatches[ev->instId] > 1 && now - last_dispatch[ev->instId] != period_of(ev->instId))
+    bad_intervals++;
+
+  dispatches[ev->instId]++;
+  last_dispatch[ev->instId] = now;
+}
+
+static UAVObjEvent make_event(uint16_t instId)
+{
+  UAVObjEvent ev;
+  ev.obj = (UAVObjHandle)(uintptr_t) 0x1000;
+  ev.instId = instId;
+  ev.event = EV_UPDATED_PERIODIC;
+  return ev;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class EventDispatcherTest : public testing::Test {
+protected:
+  virtual void SetUp() {
+    ASSERT_EQ(0, EventDispatcherInitialize());
+    memset(dispatches, 0, sizeof(dispatches));
+    memset(last_dispatch, 0, sizeof(last_dispatch));
+    bad_intervals = 0;
+    ut_queue_send_hook = record_dispatch;
+
+    // Start away from 0, like a board that has been running for a while
+    ut_advance_clock(12345);
+  }
+
+  virtual void TearDown() {
+    ut_queue_send_hook = NULL;
+  }
+
+  void CreateEvents(uint16_t count) {
+    for (uint16_t i = 0; i < count; i++) {
+      UAVObjEvent ev = make_event(i);
+      ASSERT_EQ(0, EventPeriodicQueueCreate(&ev, &telemetry_queue, period_of(i)));
+    }
+  }
+};
+
+TEST_F(EventDispatcherTest, DuplicateEvent) {
+  UAVObjEvent ev = make_event(0);
+  EXPECT_EQ(0, EventPeriodicQueueCreate(&ev, &telemetry_queue, 10));
+  EXPECT_EQ(-1, EventPeriodicQueueCreate(&ev, &telemetry_queue, 20));
+
+  UAVObjEvent other = make_event(1);
+  EXPECT_EQ(-1, EventPeriodicQueueUpdate(&other, &telemetry_queue, 20));
+}
+
+TEST_F(EventDispatcherTest, PeriodsAreKept) {
+  CreateEvents(NUM_EVENTS);
+
+  ut_run_event_task(10000);
+
+  // Every event runs at its own period, from a random phase
+  for (uint16_t i = 0; i < NUM_EVENTS; i++) {
+    uint32_t expected = 10000 / period_of(i);
+    EXPECT_GE(dispatches[i], expected - 1) << "event " << i;
+    EXPECT_LE(dispatches[i], expected + 1) << "event " << i;
+  }
+  EXPECT_EQ(0u, bad_intervals);
+
+  EventStats stats;
+  EventGetStats(&stats);
+  EXPECT_EQ(0u, stats.eventErrors);
+  EXPECT_EQ(0u, stats.lateDispatches);
+  EXPECT_EQ(0u, stats.maxLatenessMs);
+  EXPECT_EQ(0u, stats.maxJitterMs);
+
+  uint32_t total = 0;
+  for (uint16_t i = 0; i < NUM_EVENTS; i++)
+    total += dispatches[i];
+  EXPECT_EQ(total, stats.periodicDispatches);
+
+  EventPeriodicStats evStats;
+  UAVObjEvent ev = make_event(7);
+  EXPECT_EQ(0, EventPeriodicQueueGetStats(&ev, &telemetry_queue, &evStats));
+  EXPECT_EQ(dispatches[7], evStats.dispatches);
+  EXPECT_EQ(0, evStats.maxLatenessMs);
+  EXPECT_EQ(0, evStats.maxJitterMs);
+}
+
+TEST_F(EventDispatcherTest, UpdatePeriod) {
+  CreateEvents(2);
+
+  // Stop event 0 and slow down event 1
+  UAVObjEvent ev0 = make_event(0);
+  UAVObjEvent ev1 = make_event(1);
+  EXPECT_EQ(0, EventPeriodicQueueUpdate(&ev0, &telemetry_queue, 0));
+  EXPECT_EQ(0, EventPeriodicQueueUpdate(&ev1, &telemetry_queue, 100));
+
+  ut_run_event_task(1000);
+
+  EXPECT_EQ(0u, dispatches[0]);
+  EXPECT_GE(dispatches[1], 9u);
+  EXPECT_LE(dispatches[1], 11u);
+
+  // And restart event 0
+  EXPECT_EQ(0, EventPeriodicQueueUpdate(&ev0, &telemetry_queue, 10));
+  ut_run_event_task(1000);
+  EXPECT_GE(dispatches[0], 99u);
+  EXPECT_LE(dispatches[0], 101u);
+}
+
+static uint32_t slow_calls;
+
+static void slow_callback(UAVObjEvent *)
+{
+  // Hog the event task for 35 ms every tenth call
+  if (++slow_calls % 10 == 0)
+    ut_advance_clock(35);
+}
+
+TEST_F(EventDispatcherTest, LatenessAndJitter) {
+  slow_calls = 0;
+  CreateEvents(100);
+
+  UAVObjEvent slow = make_event(NUM_EVENTS - 1);
+  ASSERT_EQ(0, EventPeriodicCallbackCreate(&slow, slow_callback, 50));
+
+  ut_run_event_task(5000);
+
+  EventStats stats;
+  EventGetStats(&stats);
+  EXPECT_GT(stats.lateDispatches, 0u);
+  EXPECT_GT(stats.maxLatenessMs, 0u);
+  EXPECT_LE(stats.maxLatenessMs, 35u);
+  EXPECT_EQ(0x1000u, stats.maxLatenessID);
+  EXPECT_GT(stats.maxJitterMs, 0u);
+
+  // The slow callback finishes before its next period, it is always on time
+  EventPeriodicStats evStats;
+  EXPECT_EQ(0, EventPeriodicCallbackGetStats(&slow, slow_callback, &evStats));
+  EXPECT_GE(evStats.dispatches, 99u);
+  EXPECT_EQ(0, evStats.maxLatenessMs);
+
+  // While the fast events are held back by it
+  UAVObjEvent fast = make_event(0);
+  EXPECT_EQ(0, EventPeriodicQueueGetStats(&fast, &telemetry_queue, &evStats));
+  EXPECT_GT(evStats.maxLatenessMs, 0);
+  EXPECT_GT(evStats.maxJitterMs, 0);
+
+  EventClearStats();
+  EventGetStats(&stats);
+  EXPECT_EQ(0u, stats.periodicDispatches);
+  EXPECT_EQ(0u, stats.maxLatenessMs);
+}
+
+TEST_F(EventDispatcherTest, Throughput) {
+  CreateEvents(NUM_EVENTS);
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  ut_run_event_task(60000);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  EventStats stats;
+  EventGetStats(&stats);
+
+  double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  printf("%d periodic events: %u dispatches in %.3f s, %.0f dispatches/sec\n",
+         NUM_EVENTS, stats.periodicDispatches, seconds, stats.periodicDispatches / seconds);
+}
+
+/**
+ * @}
+ * @}
+ */
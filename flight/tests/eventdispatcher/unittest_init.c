@@ -0,0 +1,140 @@
+/**
+ ******************************************************************************
+ * @file       unittest_init.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Simulated clock, task and queues for the event dispatcher
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "openpilot.h"
+#include "pios_mutex.h"
+#include "pios_queue.h"
+#include "unittest_init.h"
+
+#include <setjmp.h>
+
+/*
+ * The event task runs on the thread of the test. The queue of the dispatcher
+ * never receives anything: waiting on it advances the simulated clock by the
+ * requested delay, and leaves the task once the end of the run is reached.
+ */
+static uint32_t systime;
+static uint32_t run_until;
+static jmp_buf task_exit;
+static void (*event_task)(void *);
+
+static struct pios_thread event_thread;
+static struct pios_queue dispatcher_queue;
+static struct pios_recursive_mutex recursive_mutex;
+
+void (*ut_queue_send_hook)(struct pios_queue *queuep, const void *itemp);
+
+void ut_advance_clock(uint32_t ms)
+{
+	systime += ms;
+}
+
+uint32_t ut_get_clock(void)
+{
+	return systime;
+}
+
+void ut_run_event_task(uint32_t duration_ms)
+{
+	run_until = systime + duration_ms;
+
+	if (setjmp(task_exit) == 0)
+		event_task(NULL);
+}
+
+uint32_t PIOS_Thread_Systime(void)
+{
+	return systime;
+}
+
+struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, size_t stack_bytes, void *argp, enum pios_thread_prio_e prio)
+{
+	event_task = fp;
+	return &event_thread;
+}
+
+int32_t TaskMonitorAdd(uint32_t task, struct pios_thread *handlep)
+{
+	return 0;
+}
+
+struct pios_queue *PIOS_Queue_Create(size_t queue_length, size_t item_size)
+{
+	return &dispatcher_queue;
+}
+
+bool PIOS_Queue_Receive(struct pios_queue *queuep, void *itemp, uint32_t timeout_ms)
+{
+	if (systime + timeout_ms >= run_until) {
+		systime = run_until;
+		longjmp(task_exit, 1);
+	}
+
+	systime += timeout_ms;
+	return false;
+}
+
+bool PIOS_Queue_Send(struct pios_queue *queuep, const void *itemp, uint32_t timeout_ms)
+{
+	if (ut_queue_send_hook)
+		ut_queue_send_hook(queuep, itemp);
+	return true;
+}
+
+struct pios_recursive_mutex *PIOS_Recursive_Mutex_Create(void)
+{
+	return &recursive_mutex;
+}
+
+bool PIOS_Recursive_Mutex_Lock(struct pios_recursive_mutex *mtx, uint32_t timeout_ms)
+{
+	return true;
+}
+
+bool PIOS_Recursive_Mutex_Unlock(struct pios_recursive_mutex *mtx)
+{
+	return true;
+}
+
+void * PIOS_malloc(size_t size)
+{
+	return malloc(size);
+}
+
+void PIOS_free(void * buf)
+{
+	free(buf);
+}
+
+uint32_t UAVObjGetID(UAVObjHandle obj_handle)
+{
+	return (uint32_t)(uintptr_t) obj_handle;
+}
+
+/**
+ * @}
+ * @}
+ */
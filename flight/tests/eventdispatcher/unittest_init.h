@@ -0,0 +1,9 @@
+#include <stdint.h>
+
+struct pios_queue;
+
+extern void (*ut_queue_send_hook)(struct pios_queue *queuep, const void *itemp);
+
+void ut_advance_clock(uint32_t ms);
+uint32_t ut_get_clock(void);
+void ut_run_event_task(uint32_t duration_ms);
@@ -0,0 +1,37 @@
+/**
+ ******************************************************************************
+ * @file       insgps16.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief The 16 state INSGPS filter, with its API prefixed by insgps16_
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#define INSGPS_WRAP_PREFIX insgps16_
+#include "insgps_wrap.h"
+
+#include "insgps16state.c"
+
+const struct insgps_filter insgps16_filter = INSGPS_WRAP_FILTER;
+
+/**
+ * @}
+ * @}
+ */
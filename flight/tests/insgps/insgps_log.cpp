@@ -0,0 +1,643 @@
+/**
+ ******************************************************************************
+ * @file       insgps_log.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Reads and writes the objects the INSGPS replay needs from GCS logs
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "insgps_log.h"
+
+#include <stdio.h>		/* fopen */
+#include <stdlib.h>		/* strtoul */
+#include <string.h>		/* memcpy */
+#include <string>
+#include <algorithm>		/* stable_sort */
+#include <sys/stat.h>		/* stat, mkdir */
+
+extern "C" {
+
+#include "pios_crc.h"		/* PIOS_CRC_updateCRC */
+
+}
+
+/* UAVTalk framing, see flight/UAVTalk/inc/uavtalk_priv.h */
+#define UAVTALK_SYNC_VAL        0x3C
+#define UAVTALK_TYPE_MASK       0x78
+#define UAVTALK_TYPE_VER        0x20
+#define UAVTALK_TIMESTAMPED     0x80
+#define UAVTALK_TYPE_OBJ        (UAVTALK_TYPE_VER | 0x00)
+#define UAVTALK_TYPE_OBJ_ACK    (UAVTALK_TYPE_VER | 0x02)
+#define UAVTALK_TYPE_OBJ_MULTI  (UAVTALK_TYPE_VER | 0x05)
+#define UAVTALK_TYPE_OBJ_DELTA  (UAVTALK_TYPE_VER | 0x06)
+#define UAVTALK_HEADER_LENGTH   8
+#define UAVTALK_MAX_PACKET      1024
+#define UAVTALK_DELTA_CHUNK_LENGTH 4
+#define UAVTALK_DELTA_CRC_LENGTH 2
+
+/* The log record, see ground/gcs/src/plugins/logging/logfile.cpp */
+#define TLL_RECORD_HEADER       (sizeof(uint32_t) + sizeof(int64_t))
+#define TLL_MAX_RECORD          (1024 * 1024)
+#define TLL_INDEX_FOOTER        (sizeof(int64_t) + sizeof(uint32_t) + 8)
+static const char tll_index_magic[8] = { 'T', 'L', 'L', 'I', 'N', 'D', 'E', 'X' };
+
+/* Field types, numbered as the UAVObject generator numbers them */
+enum uavo_type {
+  UAVO_INT8, UAVO_INT16, UAVO_INT32, UAVO_UINT8, UAVO_UINT16, UAVO_UINT32, UAVO_FLOAT, UAVO_ENUM
+};
+
+static const uint8_t uavo_type_size[] = { 1, 2, 4, 1, 2, 4, 4, 1 };
+static const char *uavo_type_name[] = {
+  "int8", "int16", "int32", "uint8", "uint16", "uint32", "float32", "uint8"
+};
+
+struct uavo_field {
+  const char *name;
+  enum uavo_type type;
+  uint8_t elements;
+  const char *options;		/* enum options, or element names */
+};
+
+struct uavo_def {
+  const char *name;
+  bool settings;
+  const struct uavo_field *fields;	/* in the order of the XML definition */
+  uint8_t num_fields;
+  uint16_t size;
+};
+
+static const struct uavo_field gyros_fields[] = {
+  { "x", UAVO_FLOAT, 1, NULL }, { "y", UAVO_FLOAT, 1, NULL }, { "z", UAVO_FLOAT, 1, NULL },
+  { "temperature", UAVO_FLOAT, 1, NULL },
+};
+
+static const struct uavo_field accels_fields[] = {
+  { "x", UAVO_FLOAT, 1, NULL }, { "y", UAVO_FLOAT, 1, NULL }, { "z", UAVO_FLOAT, 1, NULL },
+  { "temperature", UAVO_FLOAT, 1, NULL },
+};
+
+static const struct uavo_field magnetometer_fields[] = {
+  { "x", UAVO_FLOAT, 1, NULL }, { "y", UAVO_FLOAT, 1, NULL }, { "z", UAVO_FLOAT, 1, NULL },
+};
+
+static const struct uavo_field baro_altitude_fields[] = {
+  { "Altitude", UAVO_FLOAT, 1, NULL }, { "Temperature", UAVO_FLOAT, 1, NULL },
+  { "Pressure", UAVO_FLOAT, 1, NULL },
+};
+
+static const struct uavo_field gps_position_fields[] = {
+  { "Status", UAVO_ENUM, 1, "NoGPS,NoFix,Fix2D,Fix3D,Diff3D" },
+  { "Latitude", UAVO_INT32, 1, NULL }, { "Longitude", UAVO_INT32, 1, NULL },
+  { "Altitude", UAVO_FLOAT, 1, NULL }, { "GeoidSeparation", UAVO_FLOAT, 1, NULL },
+  { "Heading", UAVO_FLOAT, 1, NULL }, { "Groundspeed", UAVO_FLOAT, 1, NULL },
+  { "Satellites", UAVO_INT8, 1, NULL }, { "Accuracy", UAVO_FLOAT, 1, NULL },
+  { "PDOP", UAVO_FLOAT, 1, NULL }, { "HDOP", UAVO_FLOAT, 1, NULL }, { "VDOP", UAVO_FLOAT, 1, NULL },
+};
+
+static const struct uavo_field gps_velocity_fields[] = {
+  { "North", UAVO_FLOAT, 1, NULL }, { "East", UAVO_FLOAT, 1, NULL },
+  { "Down", UAVO_FLOAT, 1, NULL }, { "Accuracy", UAVO_FLOAT, 1, NULL },
+};
+
+static const struct uavo_field home_location_fields[] = {
+  { "Set", UAVO_ENUM, 1, "FALSE,TRUE" },
+  { "Latitude", UAVO_INT32, 1, NULL }, { "Longitude", UAVO_INT32, 1, NULL },
+  { "Altitude", UAVO_FLOAT, 1, NULL }, { "Be", UAVO_FLOAT, 3, NULL },
+  { "GroundTemperature", UAVO_INT16, 1, NULL }, { "SeaLevelPressure", UAVO_UINT16, 1, NULL },
+};
+
+static const struct uavo_field ground_truth_fields[] = {
+  { "AccelerationXYZ", UAVO_FLOAT, 3, NULL }, { "PositionNED", UAVO_FLOAT, 3, NULL },
+  { "VelocityNED", UAVO_FLOAT, 3, NULL }, { "RPY", UAVO_FLOAT, 3, NULL },
+  { "AngularRates", UAVO_FLOAT, 3, NULL }, { "TrueAirspeed", UAVO_FLOAT, 1, NULL },
+  { "CalibratedAirspeed", UAVO_FLOAT, 1, NULL }, { "AngleOfAttack", UAVO_FLOAT, 1, NULL },
+  { "AngleOfSlip", UAVO_FLOAT, 1, NULL },
+};
+
+static const struct uavo_field attitude_simulated_fields[] = {
+  { "q1", UAVO_FLOAT, 1, NULL }, { "q2", UAVO_FLOAT, 1, NULL },
+  { "q3", UAVO_FLOAT, 1, NULL }, { "q4", UAVO_FLOAT, 1, NULL },
+  { "Roll", UAVO_FLOAT, 1, NULL }, { "Pitch", UAVO_FLOAT, 1, NULL }, { "Yaw", UAVO_FLOAT, 1, NULL },
+  { "Velocity", UAVO_FLOAT, 3, "North,East,Down" }, { "Position", UAVO_FLOAT, 3, "North,East,Down" },
+};
+
+#define UAVO_DEF(name, settings, fields, data) \
+  { name, settings, fields, sizeof(fields) / sizeof(fields[0]), sizeof(data) }
+
+/* In the order of enum log_object */
+static const struct uavo_def uavo_defs[LOG_NUM_OBJECTS] = {
+  UAVO_DEF("Gyros", false, gyros_fields, struct log_gyros),
+  UAVO_DEF("Accels", false, accels_fields, struct log_accels),
+  UAVO_DEF("Magnetometer", false, magnetometer_fields, struct log_magnetometer),
+  UAVO_DEF("BaroAltitude", false, baro_altitude_fields, struct log_baro_altitude),
+  UAVO_DEF("GPSPosition", false, gps_position_fields, struct log_gps_position),
+  UAVO_DEF("GPSVelocity", false, gps_velocity_fields, struct log_gps_velocity),
+  UAVO_DEF("HomeLocation", true, home_location_fields, struct log_home_location),
+  UAVO_DEF("GroundTruth", false, ground_truth_fields, struct log_ground_truth),
+  UAVO_DEF("AttitudeSimulated", false, attitude_simulated_fields,
+                                      struct log_attitude_simulated),
+};
+
+/* Fields in the packed order: stably sorted by element size, largest first */
+static std::vector<const struct uavo_field *> packed_fields(enum log_object obj)
+{
+  const struct uavo_def *def = &uavo_defs[obj];
+  std::vector<const struct uavo_field *> fields;
+
+  for (uint8_t i = 0; i < def->num_fields; i++)
+    fields.push_back(&def->fields[i]);
+  std::stable_sort(fields.begin(), fields.end(),
+                   [](const struct uavo_field *a, const struct uavo_field *b) {
+                     return uavo_type_size[a->type] > uavo_type_size[b->type];
+                   });
+  return fields;
+}
+
+/* Shift-Add-XOR hash, as ground/uavobjgenerator/uavobjectparser.cpp */
+static uint32_t update_hash(uint32_t value, uint32_t hash)
+{
+  return hash ^ ((hash << 5) + (hash >> 2) + value);
+}
+
+static uint32_t update_hash(const char *value, uint32_t hash)
+{
+  for (; *value; value++)
+    hash = update_hash((uint8_t)*value, hash);
+  return hash;
+}
+
+static uint32_t calculate_id(enum log_object obj)
+{
+  const struct uavo_def *def = &uavo_defs[obj];
+
+  uint32_t hash = update_hash(def->name, 0);
+  hash = update_hash(def->settings ? 1 : 0, hash);
+  hash = update_hash(1, hash);	/* all of them are single instance */
+  for (const struct uavo_field *field : packed_fields(obj)) {
+    hash = update_hash(field->name, hash);
+    hash = update_hash(field->elements, hash);
+    hash = update_hash(field->type, hash);
+    if (field->type == UAVO_ENUM) {
+      std::string options(field->options);
+      size_t start = 0, end;
+      do {
+        end = options.find(',', start);
+        hash = update_hash(options.substr(start, end - start).c_str(), hash);
+        start = end + 1;
+      } while (end != std::string::npos);
+    }
+  }
+  return hash & 0xFFFFFFFE;
+}
+
+uint32_t InsgpsLog::objectId(enum log_object obj)
+{
+  static uint32_t ids[LOG_NUM_OBJECTS];
+
+  if (ids[obj] == 0)
+    ids[obj] = calculate_id(obj);
+  return ids[obj];
+}
+
+uint16_t InsgpsLog::objectSize(enum log_object obj)
+{
+  return uavo_defs[obj].size;
+}
+
+static int find_object(uint32_t obj_id)
+{
+  for (int obj = 0; obj < LOG_NUM_OBJECTS; obj++)
+    if (InsgpsLog::objectId((enum log_object)obj) == obj_id)
+      return obj;
+  return -1;
+}
+
+static uint16_t get_u16(const uint8_t *buf)
+{
+  return buf[0] | (buf[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t *buf)
+{
+  return buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+static bool read_file(const std::string &path, std::vector<uint8_t> &contents)
+{
+  FILE *f = fopen(path.c_str(), "rb");
+  if (f == NULL)
+    return false;
+
+  uint8_t buf[4096];
+  size_t n;
+  contents.clear();
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+    contents.insert(contents.end(), buf, buf + n);
+  fclose(f);
+  return true;
+}
+
+static bool write_file(const std::string &path, const std::vector<uint8_t> &contents)
+{
+  FILE *f = fopen(path.c_str(), "wb");
+  if (f == NULL)
+    return false;
+
+  bool ok = fwrite(contents.data(), 1, contents.size(), f) == contents.size();
+  return fclose(f) == 0 && ok;
+}
+
+void InsgpsLog::append(uint32_t timestamp, enum log_object obj, const void *data)
+{
+  const uint8_t *bytes = (const uint8_t *)data;
+  struct log_update update;
+
+  update.timestamp = timestamp;
+  update.obj = obj;
+  update.data.assign(bytes, bytes + objectSize(obj));
+  updates.push_back(update);
+
+  last[obj] = update.data;
+}
+
+/**
+ * Reads a .tll log, or a directory the log was exported to as columns
+ */
+bool InsgpsLog::read(const char *path)
+{
+  struct stat st;
+
+  if (stat(path, &st) != 0)
+    return false;
+  return S_ISDIR(st.st_mode) ? readColumns(path) : readTll(path);
+}
+
+/**
+ * Reads the UAVTalk frames of a .tll log, frames may span log records
+ */
+bool InsgpsLog::readTll(const char *file)
+{
+  std::vector<uint8_t> log;
+  if (!read_file(file, log))
+    return false;
+
+  updates.clear();
+  pending.clear();
+  for (int obj = 0; obj < LOG_NUM_OBJECTS; obj++)
+    last[obj].clear();
+  last_timestamp = 0;
+
+  /* Skip the header, it ends on a line with ## within the first lines */
+  size_t pos = 0, line = 0, lines = 0;
+  for (size_t i = 0; i < log.size() && lines < 13; i++) {
+    if (log[i] != '\n')
+      continue;
+    if (i - line == 2 && log[line] == '#' && log[line + 1] == '#') {
+      pos = i + 1;
+      break;
+    }
+    line = i + 1;
+    lines++;
+  }
+
+  /* The index the GCS appends to the log isn't UAVTalk */
+  size_t end = log.size();
+  if (end - pos >= TLL_INDEX_FOOTER &&
+      memcmp(&log[end - sizeof(tll_index_magic)], tll_index_magic, sizeof(tll_index_magic)) == 0) {
+    int64_t index_pos;
+    memcpy(&index_pos, &log[end - TLL_INDEX_FOOTER], sizeof(index_pos));
+    if (index_pos >= (int64_t)pos && index_pos < (int64_t)end)
+      end = index_pos;
+  }
+
+  while (end - pos >= TLL_RECORD_HEADER) {
+    uint32_t timestamp;
+    int64_t size;
+    memcpy(&timestamp, &log[pos], sizeof(timestamp));
+    memcpy(&size, &log[pos + sizeof(timestamp)], sizeof(size));
+
+    /* Resynchronize on anything that doesn't look like a record */
+    if (size < 1 || size > TLL_MAX_RECORD || (size_t)size > end - pos - TLL_RECORD_HEADER) {
+      pos++;
+      continue;
+    }
+
+    parseFrames(&log[pos + TLL_RECORD_HEADER], size, timestamp);
+    pos += TLL_RECORD_HEADER + size;
+  }
+
+  return !updates.empty();
+}
+
+/**
+ * Extracts the updates of the known objects from the frames in @p buf
+ */
+void InsgpsLog::parseFrames(const uint8_t *buf, uint32_t length, uint32_t timestamp)
+{
+  pending.insert(pending.end(), buf, buf + length);
+
+  size_t pos = 0;
+  while (pending.size() - pos >= UAVTALK_HEADER_LENGTH) {
+    const uint8_t *frame = &pending[pos];
+    uint8_t type = frame[1];
+    uint16_t size = get_u16(&frame[2]);
+
+    if (frame[0] != UAVTALK_SYNC_VAL || (type & UAVTALK_TYPE_MASK) != UAVTALK_TYPE_VER ||
+        size < UAVTALK_HEADER_LENGTH || size > UAVTALK_MAX_PACKET) {
+      pos++;
+      continue;
+    }
+    if (pending.size() - pos < (size_t)size + 1)
+      break;
+    if (PIOS_CRC_updateCRC(0, frame, size) != frame[size]) {
+      pos++;
+      continue;
+    }
+    pos += size + 1;
+
+    int obj = find_object(get_u32(&frame[4]));
+    uint32_t header = UAVTALK_HEADER_LENGTH;
+
+    /* Timestamped frames carry the 16 bit ms time of the flight controller,
+     * which is closer to when the sensors were read than the log time */
+    uint32_t frame_time = timestamp;
+    if ((type & UAVTALK_TIMESTAMPED) && obj >= 0 && size >= header + 2) {
+      uint16_t ts = get_u16(&frame[header]);
+      frame_time = (last_timestamp & ~0xFFFFu) | ts;
+      if (frame_time + 0x8000 < last_timestamp)
+        frame_time += 0x10000;
+      else if (frame_time > last_timestamp + 0x8000 && frame_time >= 0x10000)
+        frame_time -= 0x10000;
+      header += 2;
+    }
+
+    const uint8_t *data = &frame[header];
+    uint32_t data_length = size - header;
+
+    switch (type & ~UAVTALK_TIMESTAMPED) {
+    case UAVTALK_TYPE_OBJ:
+    case UAVTALK_TYPE_OBJ_ACK:
+      if (obj >= 0 && data_length == objectSize((enum log_object)obj))
+        append(frame_time, (enum log_object)obj, data);
+      break;
+    case UAVTALK_TYPE_OBJ_MULTI:
+      /* Records of object ID and data, the rest of the frame can't be
+       * parsed past an object this doesn't know */
+      for (uint32_t offset = 0; data_length - offset >= 4;) {
+        int multi_obj = find_object(get_u32(&data[offset]));
+        if (multi_obj < 0 ||
+            data_length - offset - 4 < objectSize((enum log_object)multi_obj))
+          break;
+        append(frame_time, (enum log_object)multi_obj, &data[offset + 4]);
+        offset += 4 + objectSize((enum log_object)multi_obj);
+      }
+      break;
+    case UAVTALK_TYPE_OBJ_DELTA:
+      {
+        /* CRC-16 of the result, a bitmap of the changed chunks, the chunks */
+        if (obj < 0 || last[obj].empty())
+          break;
+        std::vector<uint8_t> current = last[obj];
+        uint32_t num_chunks = (current.size() + UAVTALK_DELTA_CHUNK_LENGTH - 1) / UAVTALK_DELTA_CHUNK_LENGTH;
+        uint32_t offset = UAVTALK_DELTA_CRC_LENGTH + (num_chunks + 7) / 8;
+        if (data_length < offset)
+          break;
+        for (uint32_t chunk = 0; chunk < num_chunks && offset <= data_length; chunk++) {
+          if (!(data[UAVTALK_DELTA_CRC_LENGTH + chunk / 8] & (1 << (chunk % 8))))
+            continue;
+          uint32_t chunk_offset = chunk * UAVTALK_DELTA_CHUNK_LENGTH;
+          uint32_t chunk_length = std::min<uint32_t>(UAVTALK_DELTA_CHUNK_LENGTH, current.size() - chunk_offset);
+          if (offset + chunk_length > data_length) {
+            offset = data_length + 1;
+            break;
+          }
+          memcpy(&current[chunk_offset], &data[offset], chunk_length);
+          offset += chunk_length;
+        }
+        if (offset == data_length &&
+            PIOS_CRC16_updateCRC(0, current.data(), current.size()) == (data[0] | (data[1] << 8)))
+          append(frame_time, (enum log_object)obj, current.data());
+      }
+      break;
+    }
+
+    if (obj >= 0)
+      last_timestamp = frame_time;
+  }
+
+  pending.erase(pending.begin(), pending.begin() + pos);
+}
+
+/**
+ * Reads the column files LogColumnExport wrote for the known objects. The
+ * updates of different objects are merged by timestamp.
+ */
+bool InsgpsLog::readColumns(const char *dir)
+{
+  std::string base = std::string(dir) + "/";
+  std::vector<uint8_t> schema;
+  if (!read_file(base + "schema.json", schema))
+    return false;
+  std::string json(schema.begin(), schema.end());
+
+  updates.clear();
+  for (int i = 0; i < LOG_NUM_OBJECTS; i++) {
+    enum log_object obj = (enum log_object)i;
+    const char *name = uavo_defs[obj].name;
+
+    /* The keys of an object are sorted, its rows come after its file */
+    size_t at = json.find("\"file\": \"" + std::string(name) + ".col\"");
+    if (at == std::string::npos)
+      continue;
+    at = json.find("\"rows\":", at);
+    if (at == std::string::npos)
+      return false;
+    uint32_t rows = strtoul(json.c_str() + at + strlen("\"rows\":"), NULL, 10);
+
+    std::vector<uint8_t> col;
+    if (!read_file(base + name + ".col", col))
+      return false;
+
+    /* A timestamp column, then a column per field element, each 8 aligned */
+    std::vector<uint8_t> row_data(rows * objectSize(obj));
+    std::vector<uint32_t> timestamps(rows);
+    size_t pos = 0;
+    if ((size_t)rows * sizeof(uint32_t) > col.size())
+      return false;
+    memcpy(timestamps.data(), col.data(), rows * sizeof(uint32_t));
+    pos += rows * sizeof(uint32_t);
+
+    uint32_t data_offset = 0;
+    for (const struct uavo_field *field : packed_fields(obj)) {
+      uint32_t size = uavo_type_size[field->type];
+      for (uint8_t n = 0; n < field->elements; n++) {
+        pos = (pos + 7) & ~(size_t)7;
+        if (pos + (size_t)rows * size > col.size())
+          return false;
+        for (uint32_t r = 0; r < rows; r++)
+          memcpy(&row_data[r * objectSize(obj) + data_offset], &col[pos + r * size], size);
+        pos += rows * size;
+        data_offset += size;
+      }
+    }
+
+    for (uint32_t r = 0; r < rows; r++) {
+      struct log_update update;
+      update.timestamp = timestamps[r];
+      update.obj = obj;
+      update.data.assign(&row_data[r * objectSize(obj)], &row_data[(r + 1) * objectSize(obj)]);
+      updates.push_back(update);
+    }
+  }
+
+  /* Stable, so updates of an object stay in order and objects updated in
+   * the same ms come in the order of enum log_object */
+  std::stable_sort(updates.begin(), updates.end(),
+                   [](const struct log_update &a, const struct log_update &b) {
+                     return a.timestamp < b.timestamp;
+                   });
+
+  return !updates.empty();
+}
+
+void InsgpsLog::appendFrame(std::vector<uint8_t> &out, const struct log_update &update) const
+{
+  uint32_t obj_id = objectId(update.obj);
+  uint16_t size = UAVTALK_HEADER_LENGTH + update.data.size();
+  uint8_t header[UAVTALK_HEADER_LENGTH] = {
+    UAVTALK_SYNC_VAL, UAVTALK_TYPE_OBJ, (uint8_t)size, (uint8_t)(size >> 8),
+    (uint8_t)obj_id, (uint8_t)(obj_id >> 8), (uint8_t)(obj_id >> 16), (uint8_t)(obj_id >> 24),
+  };
+
+  size_t start = out.size();
+  out.insert(out.end(), header, header + sizeof(header));
+  out.insert(out.end(), update.data.begin(), update.data.end());
+  out.push_back(PIOS_CRC_updateCRC(0, &out[start], size));
+}
+
+/**
+ * Writes the updates as a .tll log, a record with one frame per update
+ */
+bool InsgpsLog::writeTll(const char *file) const
+{
+  static const char header[] = "Tau Labs git hash:\ninsgps-test\n0\n##\n";
+  std::vector<uint8_t> log(header, header + strlen(header));
+  std::vector<uint8_t> frame;
+
+  for (const struct log_update &update : updates) {
+    frame.clear();
+    appendFrame(frame, update);
+
+    int64_t size = frame.size();
+    const uint8_t *ts = (const uint8_t *)&update.timestamp;
+    log.insert(log.end(), ts, ts + sizeof(update.timestamp));
+    log.insert(log.end(), (const uint8_t *)&size, (const uint8_t *)&size + sizeof(size));
+    log.insert(log.end(), frame.begin(), frame.end());
+  }
+
+  return write_file(file, log);
+}
+
+/**
+ * Writes the updates as LogColumnExport does: a column file per object and
+ * schema.json to describe them
+ */
+bool InsgpsLog::writeColumns(const char *dir) const
+{
+  std::string base = std::string(dir) + "/";
+  mkdir(dir, 0777);
+
+  std::string objects;
+  for (int i = 0; i < LOG_NUM_OBJECTS; i++) {
+    enum log_object obj = (enum log_object)i;
+    const char *name = uavo_defs[obj].name;
+
+    std::vector<const struct log_update *> rows;
+    for (const struct log_update &update : updates)
+      if (update.obj == obj)
+        rows.push_back(&update);
+    if (rows.empty())
+      continue;
+
+    std::vector<uint8_t> col;
+    std::string columns;
+    char buf[256];
+
+    snprintf(buf, sizeof(buf), "                {\n                    \"name\": \"timestamp\",\n"
+             "                    \"offset\": 0,\n                    \"size\": 4,\n"
+             "                    \"type\": \"uint32\",\n                    \"units\": \"ms\"\n"
+             "                }");
+    columns += buf;
+    for (const struct log_update *update : rows) {
+      const uint8_t *ts = (const uint8_t *)&update->timestamp;
+      col.insert(col.end(), ts, ts + sizeof(update->timestamp));
+    }
+
+    uint32_t data_offset = 0;
+    for (const struct uavo_field *field : packed_fields(obj)) {
+      uint32_t size = uavo_type_size[field->type];
+      for (uint8_t n = 0; n < field->elements; n++) {
+        col.resize((col.size() + 7) & ~(size_t)7);
+
+        std::string column_name = field->name;
+        if (field->elements > 1) {
+          std::string element = std::to_string(n);
+          if (field->options != NULL) {
+            std::string names(field->options);
+            size_t start = 0;
+            for (uint8_t k = 0; k < n; k++)
+              start = names.find(',', start) + 1;
+            element = names.substr(start, names.find(',', start) - start);
+          }
+          column_name += "." + element;
+        }
+        snprintf(buf, sizeof(buf), ",\n                {\n                    \"name\": \"%s\",\n"
+                 "                    \"offset\": %zu,\n                    \"size\": %u,\n"
+                 "                    \"type\": \"%s\"\n                }",
+                 column_name.c_str(), col.size(), size, uavo_type_name[field->type]);
+        columns += buf;
+
+        for (const struct log_update *update : rows)
+          col.insert(col.end(), &update->data[data_offset], &update->data[data_offset + size]);
+        data_offset += size;
+      }
+    }
+
+    if (!write_file(base + name + ".col", col))
+      return false;
+
+    snprintf(buf, sizeof(buf), "            \"file\": \"%s.col\",\n            \"id\": \"0x%08x\",\n"
+             "            \"name\": \"%s\",\n            \"rows\": %zu,\n            \"size\": %zu\n",
+             name, objectId(obj), name, rows.size(), col.size());
+    if (!objects.empty())
+      objects += ",\n";
+    objects += "        {\n            \"columns\": [\n" + columns + "\n            ],\n" + buf + "        }";
+  }
+
+  std::string json = "{\n    \"alignment\": 8,\n    \"byteOrder\": \"little\",\n"
+                     "    \"log\": \"insgps-test.tll\",\n    \"objects\": [\n" + objects + "\n    ]\n}\n";
+  return write_file(base + "schema.json", std::vector<uint8_t>(json.begin(), json.end()));
+}
+
+/**
+ * @}
+ * @}
+ */
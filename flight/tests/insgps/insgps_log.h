@@ -0,0 +1,141 @@
+/**
+ ******************************************************************************
+ * @file       insgps_log.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Reads and writes the objects the INSGPS replay needs from GCS logs
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef INSGPS_LOG_H
+#define INSGPS_LOG_H
+
+#include <stdint.h>
+#include <vector>
+
+/* The objects the replay uses, in their packed layout: fields sorted by
+ * element size as the UAVObject generator does. Only the objects with bytes
+ * at the end need packing, the others are all floats. */
+struct log_gyros {
+  float x, y, z, temperature;
+};
+
+struct log_accels {
+  float x, y, z, temperature;
+};
+
+struct log_magnetometer {
+  float x, y, z;
+};
+
+struct log_baro_altitude {
+  float Altitude, Temperature, Pressure;
+};
+
+struct __attribute__((packed)) log_gps_position {
+  int32_t Latitude, Longitude;
+  float Altitude, GeoidSeparation, Heading, Groundspeed;
+  float Accuracy, PDOP, HDOP, VDOP;
+  uint8_t Status;
+  int8_t Satellites;
+};
+
+#define LOG_GPS_STATUS_FIX3D  3
+
+struct log_gps_velocity {
+  float North, East, Down, Accuracy;
+};
+
+struct __attribute__((packed)) log_home_location {
+  int32_t Latitude, Longitude;
+  float Altitude;
+  float Be[3];
+  int16_t GroundTemperature;
+  uint16_t SeaLevelPressure;
+  uint8_t Set;
+};
+
+struct log_ground_truth {
+  float AccelerationXYZ[3], PositionNED[3], VelocityNED[3], RPY[3], AngularRates[3];
+  float TrueAirspeed, CalibratedAirspeed, AngleOfAttack, AngleOfSlip;
+};
+
+struct log_attitude_simulated {
+  float q1, q2, q3, q4;
+  float Roll, Pitch, Yaw;
+  float Velocity[3], Position[3];
+};
+
+enum log_object {
+  LOG_GYROS,
+  LOG_ACCELS,
+  LOG_MAGNETOMETER,
+  LOG_BARO_ALTITUDE,
+  LOG_GPS_POSITION,
+  LOG_GPS_VELOCITY,
+  LOG_HOME_LOCATION,
+  LOG_GROUND_TRUTH,
+  LOG_ATTITUDE_SIMULATED,
+  LOG_NUM_OBJECTS
+};
+
+//! One update of an object, in the order it was logged
+struct log_update {
+  uint32_t timestamp;		/* ms */
+  enum log_object obj;
+  std::vector<uint8_t> data;	/* packed */
+};
+
+/**
+ * A GCS log reduced to the objects the INSGPS uses. It reads a .tll log of
+ * UAVTalk frames or a directory of column files exported from one, other
+ * objects are skipped.
+ */
+class InsgpsLog {
+public:
+  bool read(const char *path);
+  bool readTll(const char *file);
+  bool readColumns(const char *dir);
+
+  bool writeTll(const char *file) const;
+  bool writeColumns(const char *dir) const;
+
+  void append(uint32_t timestamp, enum log_object obj, const void *data);
+
+  static uint32_t objectId(enum log_object obj);
+  static uint16_t objectSize(enum log_object obj);
+
+  std::vector<struct log_update> updates;
+
+private:
+  void parseFrames(const uint8_t *buf, uint32_t length, uint32_t timestamp);
+  void appendFrame(std::vector<uint8_t> &out, const struct log_update &update) const;
+
+  std::vector<uint8_t> pending;		/* part of a frame split across records */
+  std::vector<uint8_t> last[LOG_NUM_OBJECTS];	/* what deltas apply to */
+  uint32_t last_timestamp;
+};
+
+#endif /* INSGPS_LOG_H */
+
+/**
+ * @}
+ * @}
+ */
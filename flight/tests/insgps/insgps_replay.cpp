@@ -0,0 +1,375 @@
+/**
+ ******************************************************************************
+ * @file       insgps_replay.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Replays a log through an INSGPS filter as the attitude module runs it
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "insgps_replay.h"
+
+#include <stdio.h>		/* printf */
+#include <string.h>		/* memset */
+#include <math.h>		/* atan2f */
+#include <time.h>		/* clock_gettime */
+
+extern "C" {
+
+#include "insgps.h"		/* sensor flags */
+#include "coordinate_conversions.h"	/* RPY2Quaternion */
+#include "physical_constants.h"	/* DEG2RAD */
+
+}
+
+/* Count the allocations made while the filter runs, it is expected to make none */
+static bool count_allocations;
+static uint32_t allocations;
+
+extern "C" {
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size)
+{
+  if (count_allocations)
+    allocations++;
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+  if (count_allocations)
+    allocations++;
+  return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+  if (count_allocations)
+    allocations++;
+  return __libc_realloc(ptr, size);
+}
+
+}
+
+/* The defaults of INSSettings */
+static const float accel_var[3] = { 0.003f, 0.003f, 0.003f };
+static const float gyro_var[3] = { 1e-5f, 1e-5f, 1e-4f };
+static const float mag_var[3] = { 10.0f, 10.0f, 100.0f };
+static const float gps_var[3] = { 0.001f, 0.01f, 0.5f };	/* pos, vel, vertpos */
+static const float baro_var = 0.01f;
+
+#define WARMUP_MS      10000	/* biases are held at zero meanwhile */
+#define INDOOR_POS_MS  100	/* period of the fake position indoors */
+
+static double now_us()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* Transforms a GPS position into the NED frame of the home location */
+static void get_ned(const struct log_gps_position *gps, const struct log_home_location *home, float ned[3])
+{
+  float lat = home->Latitude / 10.0e6f * (float)DEG2RAD;
+  float T[3] = { home->Altitude + 6.378137E6f, cosf(lat) * (home->Altitude + 6.378137E6f), -1.0f };
+  float dL[3] = { (gps->Latitude - home->Latitude) / 10.0e6f * (float)DEG2RAD,
+                  (gps->Longitude - home->Longitude) / 10.0e6f * (float)DEG2RAD,
+                  gps->Altitude - home->Altitude };
+
+  for (int i = 0; i < 3; i++)
+    ned[i] = T[i] * dL[i];
+}
+
+/* Compares the state of the filter to the true one */
+static void add_truth(const struct insgps_filter *filter, const float true_pos[3], const float true_vel[3],
+                      const float true_q[4], struct replay_stats *stats)
+{
+  float pos[3], vel[3], q[4], gyro_bias[3], accel_bias[3];
+  filter->get_state(pos, vel, q, gyro_bias, accel_bias);
+
+  float pos_error = 0, vel_error = 0, dot = 0;
+  for (int i = 0; i < 3; i++) {
+    pos_error += (pos[i] - true_pos[i]) * (pos[i] - true_pos[i]);
+    vel_error += (vel[i] - true_vel[i]) * (vel[i] - true_vel[i]);
+  }
+  for (int i = 0; i < 4; i++)
+    dot += q[i] * true_q[i];
+  pos_error = sqrtf(pos_error);
+  vel_error = sqrtf(vel_error);
+  float att_error = 2 * acosf(fminf(fabsf(dot), 1.0f)) * (float)RAD2DEG;
+
+  stats->truth_samples++;
+  stats->pos_sq_error += pos_error * pos_error;
+  stats->vel_sq_error += vel_error * vel_error;
+  stats->att_sq_error += att_error * att_error;
+  stats->pos_max_error = fmaxf(stats->pos_max_error, pos_error);
+  stats->vel_max_error = fmaxf(stats->vel_max_error, vel_error);
+  stats->att_max_error = fmaxf(stats->att_max_error, att_error);
+}
+
+/**
+ * Runs the filter through the log as the attitude module would have in flight:
+ * initialized from the first mag, baro and (outdoors) GPS fix, stepped on each
+ * accel update and corrected with whatever sensors updated since the last step.
+ * Logs without a HomeLocation take the first good fix as home and the first
+ * mag reading as the field there.
+ * @return false if the log never allowed the filter to initialize
+ */
+bool insgps_replay(const struct insgps_filter *filter, const InsgpsLog &log, struct replay_stats *stats)
+{
+  struct log_gyros gyros;
+  struct log_accels accels;
+  struct log_magnetometer mag;
+  struct log_baro_altitude baro;
+  struct log_gps_position gps;
+  struct log_gps_velocity gps_vel;
+  struct log_home_location home;
+
+  memset(&gyros, 0, sizeof(gyros));
+  memset(&mag, 0, sizeof(mag));
+  memset(&baro, 0, sizeof(baro));
+  memset(&gps, 0, sizeof(gps));
+  memset(&gps_vel, 0, sizeof(gps_vel));
+  memset(&home, 0, sizeof(home));
+  memset(stats, 0, sizeof(*stats));
+  stats->num_states = filter->get_num_states();
+
+  bool outdoor = false;
+  for (const struct log_update &update : log.updates)
+    outdoor |= update.obj == LOG_GPS_POSITION;
+
+  bool mag_updated = false, baro_updated = false, gps_updated = false, gps_vel_updated = false;
+  bool initialized = false;
+  uint32_t init_time = 0, last_time = 0, indoor_pos_time = 0;
+  float baro_offset = 0;
+  float ned[3] = { 0, 0, 0 }, vel[3] = { 0, 0, 0 };
+  const float zeros[3] = { 0, 0, 0 };
+
+  allocations = 0;
+
+  for (const struct log_update &update : log.updates) {
+    const uint8_t *data = update.data.data();
+
+    switch (update.obj) {
+    case LOG_GYROS:
+      memcpy(&gyros, data, sizeof(gyros));
+      continue;
+    case LOG_MAGNETOMETER:
+      memcpy(&mag, data, sizeof(mag));
+      /* Discard mag with NAN, normally from bad calibration */
+      mag_updated = mag.x == mag.x && mag.y == mag.y && mag.z == mag.z;
+      continue;
+    case LOG_BARO_ALTITUDE:
+      memcpy(&baro, data, sizeof(baro));
+      baro_updated = true;
+      continue;
+    case LOG_GPS_POSITION:
+      memcpy(&gps, data, sizeof(gps));
+      gps_updated = true;
+      if (!home.Set && gps.Status >= LOG_GPS_STATUS_FIX3D && gps.Satellites >= 7 && gps.PDOP < 3.5f) {
+        home.Latitude = gps.Latitude;
+        home.Longitude = gps.Longitude;
+        home.Altitude = gps.Altitude;
+        home.Set = 1;
+      }
+      continue;
+    case LOG_GPS_VELOCITY:
+      memcpy(&gps_vel, data, sizeof(gps_vel));
+      gps_vel_updated = true;
+      continue;
+    case LOG_HOME_LOCATION:
+      memcpy(&home, data, sizeof(home));
+      continue;
+    case LOG_GROUND_TRUTH:
+      if (initialized) {
+        struct log_ground_truth truth;
+        memcpy(&truth, data, sizeof(truth));
+        float q[4];
+        RPY2Quaternion(truth.RPY, q);
+        add_truth(filter, truth.PositionNED, truth.VelocityNED, q, stats);
+      }
+      continue;
+    case LOG_ATTITUDE_SIMULATED:
+      if (initialized) {
+        struct log_attitude_simulated truth;
+        memcpy(&truth, data, sizeof(truth));
+        add_truth(filter, truth.Position, truth.Velocity, &truth.q1, stats);
+      }
+      continue;
+    case LOG_ACCELS:
+      memcpy(&accels, data, sizeof(accels));
+      break;
+    case LOG_NUM_OBJECTS:
+      continue;
+    }
+
+    /* A new accel sample steps the filter */
+    if (!initialized) {
+      bool gps_init_usable = gps_updated && gps.Satellites >= 7 && gps.PDOP <= 3.5f && home.Set;
+      if (!mag_updated || !baro_updated || (outdoor && !gps_init_usable))
+        continue;
+
+      count_allocations = true;
+      filter->init();
+      filter->set_mag_var(mag_var);
+      filter->set_accel_var(accel_var);
+      filter->set_gyro_var(gyro_var);
+      filter->set_baro_var(baro_var);
+      filter->set_pos_vel_var(gps_var[0], gps_var[1], gps_var[2]);
+      filter->set_gyro_bias(zeros);
+      filter->set_accel_bias(zeros);
+
+      float rpy[3], q[4];
+      rpy[0] = atan2f(-accels.y, -accels.z) * (float)RAD2DEG;
+      rpy[1] = atan2f(accels.x, -accels.z) * (float)RAD2DEG;
+      rpy[2] = atan2f(-mag.y, mag.x) * (float)RAD2DEG;
+      RPY2Quaternion(rpy, q);
+
+      float Be[3];
+      memcpy(Be, home.Be, sizeof(Be));
+      if (Be[0] == 0 && Be[1] == 0 && Be[2] == 0) {
+        if (outdoor) {
+          /* Rotate the mag reading into the earth frame */
+          float Rbe[3][3];
+          Quaternion2R(q, Rbe);
+          for (int i = 0; i < 3; i++)
+            Be[i] = Rbe[0][i] * mag.x + Rbe[1][i] * mag.y + Rbe[2][i] * mag.z;
+        } else {
+          /* Reasonable default, as indoors */
+          Be[0] = 100;
+          Be[1] = 0;
+          Be[2] = 500;
+        }
+      }
+      filter->set_mag_north(Be);
+
+      baro_offset = -baro.Altitude;
+      if (outdoor)
+        get_ned(&gps, &home, ned);
+      else
+        ned[0] = ned[1] = ned[2] = 0;
+      filter->set_state(ned, zeros, q, zeros, zeros);
+      count_allocations = false;
+
+      initialized = true;
+      init_time = last_time = indoor_pos_time = update.timestamp;
+      continue;
+    }
+
+    bool warmup = update.timestamp - init_time < WARMUP_MS;
+
+    gps_updated &= gps.Satellites >= 6 && gps.PDOP <= 4.0f && home.Set;
+
+    float dT = (update.timestamp - last_time) / 1000.0f;
+    last_time = update.timestamp;
+    if (dT > 0.01f)
+      dT = 0.01f;
+    else if (dT <= 0.001f)
+      dT = 0.001f;
+
+    float gyro[3] = { gyros.x * (float)DEG2RAD, gyros.y * (float)DEG2RAD, gyros.z * (float)DEG2RAD };
+    uint16_t sensors = 0;
+
+    if (warmup) {
+      filter->set_gyro_bias(zeros);
+      filter->set_accel_bias(zeros);
+    }
+
+    count_allocations = true;
+    double start = now_us();
+
+    filter->state_prediction(gyro, &accels.x, dT);
+    filter->covariance_prediction(dT);
+
+    double predicted = now_us();
+    stats->predict_us += predicted - start;
+    stats->predictions++;
+
+    if (mag_updated) {
+      sensors |= MAG_SENSORS;
+      mag_updated = false;
+    }
+    if (baro_updated) {
+      sensors |= BARO_SENSOR;
+      baro_updated = false;
+    }
+    if (gps_updated) {
+      sensors |= HORIZ_POS_SENSORS;
+      get_ned(&gps, &home, ned);
+      gps_updated = false;
+    }
+    if (gps_vel_updated) {
+      sensors |= HORIZ_VEL_SENSORS | VERT_VEL_SENSORS;
+      vel[0] = gps_vel.North;
+      vel[1] = gps_vel.East;
+      vel[2] = gps_vel.Down;
+      gps_vel_updated = false;
+    }
+    if (!outdoor && update.timestamp - indoor_pos_time > INDOOR_POS_MS) {
+      sensors |= HORIZ_VEL_SENSORS | HORIZ_POS_SENSORS;
+      indoor_pos_time = update.timestamp;
+      vel[0] = vel[1] = vel[2] = 0;
+      ned[0] = ned[1] = 0;
+      ned[2] = -(baro.Altitude + baro_offset);
+    }
+
+    if (sensors) {
+      predicted = now_us();
+      filter->correction(&mag.x, ned, vel, baro.Altitude + baro_offset, sensors);
+      stats->correct_us += now_us() - predicted;
+      stats->corrections++;
+    }
+    count_allocations = false;
+  }
+
+  stats->allocations = allocations;
+
+  if (initialized) {
+    float gyro_bias[3], accel_bias[3];
+    filter->get_state(stats->pos, stats->vel, stats->q, gyro_bias, accel_bias);
+  }
+  return initialized;
+}
+
+void insgps_print_stats(const struct replay_stats *stats)
+{
+  printf("%u states: predict %.2f us/step (%u), correct %.2f us/step (%u), %u allocations\n",
+         stats->num_states,
+         stats->predictions ? stats->predict_us / stats->predictions : 0, stats->predictions,
+         stats->corrections ? stats->correct_us / stats->corrections : 0, stats->corrections,
+         stats->allocations);
+  if (stats->truth_samples > 0)
+    printf("%u states: error rms/max pos %.3f/%.3f m, vel %.3f/%.3f m/s, att %.2f/%.2f deg (%u)\n",
+           stats->num_states,
+           sqrt(stats->pos_sq_error / stats->truth_samples), stats->pos_max_error,
+           sqrt(stats->vel_sq_error / stats->truth_samples), stats->vel_max_error,
+           sqrt(stats->att_sq_error / stats->truth_samples), stats->att_max_error,
+           stats->truth_samples);
+}
+
+/**
+ * @}
+ * @}
+ */
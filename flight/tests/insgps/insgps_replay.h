@@ -0,0 +1,72 @@
+/**
+ ******************************************************************************
+ * @file       insgps_replay.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Replays a log through an INSGPS filter as the attitude module runs it
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef INSGPS_REPLAY_H
+#define INSGPS_REPLAY_H
+
+#include <stdint.h>
+
+#include "insgps_log.h"
+
+extern "C" {
+
+#include "insgps_variants.h"
+
+}
+
+//! What a replay measured
+struct replay_stats {
+  uint16_t num_states;
+
+  uint32_t predictions;
+  uint32_t corrections;
+  double predict_us;		/* total wall time of the predictions */
+  double correct_us;
+  uint32_t allocations;		/* made by the filter while replaying */
+
+  /* Errors against GroundTruth or AttitudeSimulated, when the log has them */
+  uint32_t truth_samples;
+  double pos_sq_error;
+  double vel_sq_error;
+  double att_sq_error;
+  float pos_max_error;		/* m */
+  float vel_max_error;		/* m/s */
+  float att_max_error;		/* deg */
+
+  float pos[3];			/* final state */
+  float vel[3];
+  float q[4];
+};
+
+bool insgps_replay(const struct insgps_filter *filter, const InsgpsLog &log, struct replay_stats *stats);
+void insgps_print_stats(const struct replay_stats *stats);
+
+#endif /* INSGPS_REPLAY_H */
+
+/**
+ * @}
+ * @}
+ */
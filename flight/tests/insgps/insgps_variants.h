@@ -0,0 +1,64 @@
+/**
+ ******************************************************************************
+ * @file       insgps_variants.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief The INSGPS filters, so one test can run all of them
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef INSGPS_VARIANTS_H
+#define INSGPS_VARIANTS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//! The part of the INSGPS API the attitude module drives the filter through
+struct insgps_filter {
+	void (*init)(void);
+	void (*state_prediction)(const float gyro_data[3], const float accel_data[3], float dT);
+	void (*covariance_prediction)(float dT);
+	void (*correction)(const float mag_data[3], const float Pos[3], const float Vel[3],
+			   float BaroAlt, uint16_t SensorsUsed);
+	void (*get_state)(float *pos, float *vel, float *attitude, float *gyro_bias, float *accel_bias);
+	void (*set_state)(const float pos[3], const float vel[3], const float q[4],
+			  const float gyro_bias[3], const float accel_bias[3]);
+	void (*set_pos_vel_var)(float PosVar, float VelVar, float VertPosVar);
+	void (*set_armed)(bool armed);
+	void (*set_gyro_bias)(const float gyro_bias[3]);
+	void (*set_accel_bias)(const float accel_bias[3]);
+	void (*set_accel_var)(const float accel_var[3]);
+	void (*set_gyro_var)(const float gyro_var[3]);
+	void (*set_mag_north)(const float B[3]);
+	void (*set_mag_var)(const float scaled_mag_var[3]);
+	void (*set_baro_var)(float baro_var);
+	uint16_t (*get_num_states)(void);
+};
+
+extern const struct insgps_filter insgps13_filter;
+extern const struct insgps_filter insgps14_filter;
+extern const struct insgps_filter insgps16_filter;
+
+#endif /* INSGPS_VARIANTS_H */
+
+/**
+ * @}
+ * @}
+ */
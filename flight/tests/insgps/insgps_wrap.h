@@ -0,0 +1,81 @@
+/**
+ ******************************************************************************
+ * @file       insgps_wrap.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Renames the API of the INSGPS filter included next
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * Every filter implements the same API, so they can't be linked together. A
+ * wrapper defines INSGPS_WRAP_PREFIX, includes this and then the filter, which
+ * prefixes the names of the filter and fills INSGPS_WRAP_FILTER with them.
+ */
+
+#include "insgps_variants.h"
+
+#define INSGPS_WRAP_CAT2(a, b) a ## b
+#define INSGPS_WRAP_CAT(a, b) INSGPS_WRAP_CAT2(a, b)
+#define INSGPS_WRAP(name) INSGPS_WRAP_CAT(INSGPS_WRAP_PREFIX, name)
+
+#define INSGPSInit INSGPS_WRAP(INSGPSInit)
+#define INSStatePrediction INSGPS_WRAP(INSStatePrediction)
+#define INSCovariancePrediction INSGPS_WRAP(INSCovariancePrediction)
+#define INSCorrection INSGPS_WRAP(INSCorrection)
+#define INSGetState INSGPS_WRAP(INSGetState)
+#define INSSetArmed INSGPS_WRAP(INSSetArmed)
+#define INSResetP INSGPS_WRAP(INSResetP)
+#define INSSetState INSGPS_WRAP(INSSetState)
+#define INSSetPosVelVar INSGPS_WRAP(INSSetPosVelVar)
+#define INSSetGyroBias INSGPS_WRAP(INSSetGyroBias)
+#define INSSetAccelBias INSGPS_WRAP(INSSetAccelBias)
+#define INSSetAccelVar INSGPS_WRAP(INSSetAccelVar)
+#define INSSetGyroVar INSGPS_WRAP(INSSetGyroVar)
+#define INSSetMagNorth INSGPS_WRAP(INSSetMagNorth)
+#define INSSetMagVar INSGPS_WRAP(INSSetMagVar)
+#define INSSetBaroVar INSGPS_WRAP(INSSetBaroVar)
+#define INSPosVelReset INSGPS_WRAP(INSPosVelReset)
+#define INSGetVariance INSGPS_WRAP(INSGetVariance)
+#define ins_get_num_states INSGPS_WRAP(ins_get_num_states)
+
+#define INSGPS_WRAP_FILTER { \
+	.init = INSGPSInit, \
+	.state_prediction = INSStatePrediction, \
+	.covariance_prediction = INSCovariancePrediction, \
+	.correction = INSCorrection, \
+	.get_state = INSGetState, \
+	.set_state = INSSetState, \
+	.set_pos_vel_var = INSSetPosVelVar, \
+	.set_armed = INSSetArmed, \
+	.set_gyro_bias = INSSetGyroBias, \
+	.set_accel_bias = INSSetAccelBias, \
+	.set_accel_var = INSSetAccelVar, \
+	.set_gyro_var = INSSetGyroVar, \
+	.set_mag_north = INSSetMagNorth, \
+	.set_mag_var = INSSetMagVar, \
+	.set_baro_var = INSSetBaroVar, \
+	.get_num_states = ins_get_num_states, \
+}
+
+/**
+ * @}
+ * @}
+ */
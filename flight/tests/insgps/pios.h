@@ -0,0 +1,4 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "pios_crc.h"
@@ -0,0 +1,461 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test, benchmark and log replay of the INSGPS filters
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* getenv */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
+#include <ftw.h>		/* nftw */
+
+extern "C" {
+
+#include "insgps.h"		/* sensor flags */
+#include "insgps_variants.h"	/* the 13, 14 and 16 state filters */
+
+}
+
+#include "insgps_log.h"
+#include "insgps_replay.h"
+
+#include <math.h>		/* fabs() */
+
+#define GYRO_RATE   500		/* Hz, the rate of the state prediction */
+#define MAG_RATE    50
+#define BARO_RATE   50
+#define GPS_RATE    5
+
+#define YAW_RATE    0.2f	/* rad/s */
+#define SPEED       5.0f	/* m/s */
+#define RADIUS      (SPEED / YAW_RATE)
+#define GRAVITY     9.81f
+#define DEG2RAD     ((float)M_PI / 180.0f)
+#define RAD2DEG     (180.0f / (float)M_PI)
+
+#define HOME_LAT    470000000	/* deg * 10e6 */
+#define HOME_LON    80000000
+#define HOME_ALT    500.0f	/* m */
+#define MGAUSS      1000.0f	/* per unit of Be, to log the field in mGa */
+
+static const struct insgps_filter *filters[] = {
+  &insgps13_filter,
+  &insgps14_filter,
+  &insgps16_filter,
+};
+#define NUM_FILTERS (sizeof(filters) / sizeof(filters[0]))
+
+/* One sample of the sensors, as the attitude module feeds them to the filter */
+struct ins_sample {
+  float gyro[3];
+  float accel[3];
+  float mag[3];
+  float pos[3];
+  float vel[3];
+  float baro;
+  uint16_t sensors;
+};
+
+// To use a test fixture, derive a class from testing::Test.
+class InsgpsTest : public testing::Test {
+protected:
+  virtual void SetUp() {
+  }
+
+  virtual void TearDown() {
+  }
+
+  /* Starts @p filter at the beginning of the flight */
+  void start(const struct insgps_filter *filter) {
+    noise_seed = 1;
+
+    filter->init();
+
+    const float mag_var[3] = { 0.005f, 0.005f, 0.005f };
+    const float accel_var[3] = { 0.01f, 0.01f, 0.01f };
+    const float gyro_var[3] = { 1e-5f, 1e-5f, 1e-5f };
+    filter->set_mag_var(mag_var);
+    filter->set_accel_var(accel_var);
+    filter->set_gyro_var(gyro_var);
+    filter->set_baro_var(0.1f);
+    filter->set_pos_vel_var(1.0f, 0.1f, 4.0f);
+    filter->set_mag_north(Be);
+
+    const float zeros[3] = { 0, 0, 0 };
+    const float q[4] = { 1, 0, 0, 0 };
+    filter->set_state(zeros, zeros, q, zeros, zeros);
+  }
+
+  /* Deterministic noise so every run feeds the filter the same data */
+  float noise(float amplitude) {
+    noise_seed = noise_seed * 1103515245 + 12345;
+    return amplitude * ((float)((noise_seed >> 16) & 0x7fff) / 16384.0f - 1.0f);
+  }
+
+  /* Level flight around a circle, nose along the track */
+  void sample(uint32_t step, struct ins_sample *s) {
+    float t = (float)step / GYRO_RATE;
+    float yaw = YAW_RATE * t;
+    float c = cosf(yaw);
+    float sn = sinf(yaw);
+
+    s->gyro[0] = noise(0.01f);
+    s->gyro[1] = noise(0.01f);
+    s->gyro[2] = YAW_RATE + noise(0.01f);
+
+    /* Centripetal acceleration points to the right wing */
+    s->accel[0] = noise(0.1f);
+    s->accel[1] = SPEED * YAW_RATE + noise(0.1f);
+    s->accel[2] = -GRAVITY + noise(0.1f);
+
+    s->mag[0] = c * Be[0] + sn * Be[1] + noise(0.01f);
+    s->mag[1] = -sn * Be[0] + c * Be[1] + noise(0.01f);
+    s->mag[2] = Be[2] + noise(0.01f);
+
+    s->pos[0] = RADIUS * sn + noise(0.5f);
+    s->pos[1] = RADIUS * (1 - c) + noise(0.5f);
+    s->pos[2] = noise(1.0f);
+
+    s->vel[0] = SPEED * c + noise(0.05f);
+    s->vel[1] = SPEED * sn + noise(0.05f);
+    s->vel[2] = noise(0.1f);
+
+    s->baro = noise(0.2f);
+
+    s->sensors = 0;
+    if (step % (GYRO_RATE / MAG_RATE) == 0)
+      s->sensors |= MAG_SENSORS;
+    if (step % (GYRO_RATE / BARO_RATE) == 0)
+      s->sensors |= BARO_SENSOR;
+    if (step % (GYRO_RATE / GPS_RATE) == 0)
+      s->sensors |= POS_SENSORS | HORIZ_VEL_SENSORS | VERT_VEL_SENSORS;
+  }
+
+  /* Runs the filter through the first steps of the flight */
+  void fly(const struct insgps_filter *filter, uint32_t steps) {
+    struct ins_sample s;
+
+    start(filter);
+    for (uint32_t step = 0; step < steps; step++) {
+      sample(step, &s);
+      filter->state_prediction(s.gyro, s.accel, 1.0f / GYRO_RATE);
+      filter->covariance_prediction(1.0f / GYRO_RATE);
+      if (s.sensors)
+        filter->correction(s.mag, s.pos, s.vel, s.baro, s.sensors);
+    }
+  }
+
+  /* Logs the flight as the simulator would: the sensors in their units, GPS
+   * positions around the home location and the true state */
+  void record(InsgpsLog *log, uint32_t steps) {
+    struct ins_sample s;
+    noise_seed = 1;
+
+    float lat = HOME_LAT / 10.0e6f * DEG2RAD;
+    float T[2] = { HOME_ALT + 6.378137E6f, cosf(lat) * (HOME_ALT + 6.378137E6f) };
+
+    struct log_home_location home;
+    memset(&home, 0, sizeof(home));
+    home.Latitude = HOME_LAT;
+    home.Longitude = HOME_LON;
+    home.Altitude = HOME_ALT;
+    for (int i = 0; i < 3; i++)
+      home.Be[i] = Be[i] * MGAUSS;
+    home.Set = 1;
+
+    for (uint32_t step = 0; step < steps; step++) {
+      uint32_t timestamp = step * 1000 / GYRO_RATE;
+      sample(step, &s);
+
+      struct log_gyros gyros = { s.gyro[0] * RAD2DEG, s.gyro[1] * RAD2DEG, s.gyro[2] * RAD2DEG, 25 };
+      log->append(timestamp, LOG_GYROS, &gyros);
+
+      struct log_accels accels = { s.accel[0], s.accel[1], s.accel[2], 25 };
+      log->append(timestamp, LOG_ACCELS, &accels);
+
+      if (s.sensors & MAG_SENSORS) {
+        struct log_magnetometer mag = { s.mag[0] * MGAUSS, s.mag[1] * MGAUSS, s.mag[2] * MGAUSS };
+        log->append(timestamp, LOG_MAGNETOMETER, &mag);
+      }
+
+      if (s.sensors & BARO_SENSOR) {
+        struct log_baro_altitude baro = { HOME_ALT + s.baro, 25, 95 };
+        log->append(timestamp, LOG_BARO_ALTITUDE, &baro);
+      }
+
+      if (s.sensors & POS_SENSORS) {
+        struct log_gps_position gps;
+        memset(&gps, 0, sizeof(gps));
+        gps.Latitude = HOME_LAT + lrintf(s.pos[0] / T[0] * RAD2DEG * 10.0e6f);
+        gps.Longitude = HOME_LON + lrintf(s.pos[1] / T[1] * RAD2DEG * 10.0e6f);
+        gps.Altitude = HOME_ALT - s.pos[2];
+        gps.Groundspeed = SPEED;
+        gps.Accuracy = 1.5f;
+        gps.PDOP = 1.5f;
+        gps.HDOP = 1.0f;
+        gps.VDOP = 1.2f;
+        gps.Status = LOG_GPS_STATUS_FIX3D;
+        gps.Satellites = 9;
+        log->append(timestamp, LOG_GPS_POSITION, &gps);
+
+        struct log_gps_velocity gps_vel = { s.vel[0], s.vel[1], s.vel[2], 0.3f };
+        log->append(timestamp, LOG_GPS_VELOCITY, &gps_vel);
+      }
+
+      /* Objects of the same ms are logged in the order of enum log_object,
+       * as they are read back from columns */
+      if (step == 0)
+        log->append(timestamp, LOG_HOME_LOCATION, &home);
+
+      if (s.sensors & MAG_SENSORS) {
+        float t = (float)step / GYRO_RATE;
+        float yaw = YAW_RATE * t;
+
+        struct log_ground_truth truth;
+        memset(&truth, 0, sizeof(truth));
+        truth.PositionNED[0] = RADIUS * sinf(yaw);
+        truth.PositionNED[1] = RADIUS * (1 - cosf(yaw));
+        truth.VelocityNED[0] = SPEED * cosf(yaw);
+        truth.VelocityNED[1] = SPEED * sinf(yaw);
+        truth.RPY[2] = yaw * RAD2DEG;
+        truth.AngularRates[2] = YAW_RATE * RAD2DEG;
+        truth.TrueAirspeed = SPEED;
+        truth.CalibratedAirspeed = SPEED;
+        log->append(timestamp, LOG_GROUND_TRUTH, &truth);
+      }
+    }
+  }
+
+  static double now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+  }
+
+  static int remove_entry(const char *path, const struct stat *, int, struct FTW *) {
+    return remove(path);
+  }
+
+  static void remove_tree(const char *path) {
+    nftw(path, remove_entry, 8, FTW_DEPTH | FTW_PHYS);
+  }
+
+  static const float Be[3];
+  uint32_t noise_seed;
+};
+
+const float InsgpsTest::Be[3] = { 0.4f, 0.05f, 0.9f };
+
+TEST_F(InsgpsTest, TracksCircle) {
+  const uint32_t steps = 60 * GYRO_RATE;
+
+  for (uint32_t n = 0; n < NUM_FILTERS; n++) {
+    fly(filters[n], steps);
+
+    float pos[3], vel[3], q[4], gyro_bias[3], accel_bias[3];
+    filters[n]->get_state(pos, vel, q, gyro_bias, accel_bias);
+
+    float t = (float)steps / GYRO_RATE;
+    float yaw = YAW_RATE * t;
+    EXPECT_NEAR(RADIUS * sinf(yaw), pos[0], 1.0f);
+    EXPECT_NEAR(RADIUS * (1 - cosf(yaw)), pos[1], 1.0f);
+    EXPECT_NEAR(SPEED * cosf(yaw), vel[0], 0.5f);
+    EXPECT_NEAR(SPEED * sinf(yaw), vel[1], 0.5f);
+
+    /* Level, heading along the track */
+    EXPECT_NEAR(fabsf(cosf(yaw / 2)), fabsf(q[0]), 0.02f);
+    EXPECT_NEAR(0, q[1], 0.02f);
+    EXPECT_NEAR(0, q[2], 0.02f);
+    EXPECT_NEAR(fabsf(sinf(yaw / 2)), fabsf(q[3]), 0.02f);
+  }
+}
+
+TEST_F(InsgpsTest, MatchesDenseUpdate) {
+  /* Final states of this flight recorded when SerialUpdate still multiplied
+   * through all of H, the sparse update must not change the result */
+  const struct {
+    uint16_t num_states;
+    float pos[3];
+    float vel[3];
+    float q[4];
+  } dense[] = {
+    { 13, { -13.404201f, 3.915280f, -0.040132f }, { 4.263821f, -2.658967f, -0.017675f },
+      { 0.960159f, 0.000379f, -0.000192f, -0.279456f } },
+    { 14, { -13.494443f, 3.967910f, -0.000834f }, { 4.223342f, -2.663546f, 0.000591f },
+      { 0.960083f, 0.000011f, -0.000049f, -0.279714f } },
+    { 16, { -13.495823f, 3.964015f, -0.000963f }, { 4.221731f, -2.665272f, 0.000535f },
+      { 0.960075f, 0.000006f, -0.000034f, -0.279742f } },
+  };
+  ASSERT_EQ(NUM_FILTERS, sizeof(dense) / sizeof(dense[0]));
+
+  const uint32_t steps = 60 * GYRO_RATE;
+
+  for (uint32_t n = 0; n < NUM_FILTERS; n++) {
+    fly(filters[n], steps);
+
+    float pos[3], vel[3], q[4], gyro_bias[3], accel_bias[3];
+    filters[n]->get_state(pos, vel, q, gyro_bias, accel_bias);
+
+    EXPECT_EQ(dense[n].num_states, filters[n]->get_num_states());
+    for (uint32_t i = 0; i < 3; i++) {
+      EXPECT_NEAR(dense[n].pos[i], pos[i], 1e-4f);
+      EXPECT_NEAR(dense[n].vel[i], vel[i], 1e-4f);
+    }
+    for (uint32_t i = 0; i < 4; i++)
+      EXPECT_NEAR(dense[n].q[i], q[i], 1e-5f);
+  }
+}
+
+TEST_F(InsgpsTest, StepTime) {
+  struct ins_sample s;
+  const uint32_t steps = 20 * GYRO_RATE;
+
+  for (uint32_t n = 0; n < NUM_FILTERS; n++) {
+    const struct insgps_filter *filter = filters[n];
+    double predict_us = 0, correct_us = 0;
+    uint32_t corrections = 0;
+
+    start(filter);
+    for (uint32_t step = 0; step < steps; step++) {
+      sample(step, &s);
+
+      double begin = now_us();
+      filter->state_prediction(s.gyro, s.accel, 1.0f / GYRO_RATE);
+      filter->covariance_prediction(1.0f / GYRO_RATE);
+      double predicted = now_us();
+      predict_us += predicted - begin;
+
+      if (s.sensors) {
+        filter->correction(s.mag, s.pos, s.vel, s.baro, s.sensors);
+        correct_us += now_us() - predicted;
+        corrections++;
+      }
+    }
+
+    fprintf(stdout, "%u states: predict %.2f us/step, correct %.2f us/step\n",
+            filter->get_num_states(), predict_us / steps, correct_us / corrections);
+  }
+}
+
+TEST_F(InsgpsTest, ObjectIds) {
+  /* As the UAVObject generator hashes the definitions of the objects */
+  EXPECT_EQ(0x04228af6u, InsgpsLog::objectId(LOG_GYROS));
+  EXPECT_EQ(0xdd9d5fc0u, InsgpsLog::objectId(LOG_ACCELS));
+  EXPECT_EQ(0x813b55deu, InsgpsLog::objectId(LOG_MAGNETOMETER));
+  EXPECT_EQ(0x99622e6au, InsgpsLog::objectId(LOG_BARO_ALTITUDE));
+  EXPECT_EQ(0x5c1d1898u, InsgpsLog::objectId(LOG_GPS_POSITION));
+  EXPECT_EQ(0xe358d69cu, InsgpsLog::objectId(LOG_GPS_VELOCITY));
+  EXPECT_EQ(0xca32b032u, InsgpsLog::objectId(LOG_HOME_LOCATION));
+  EXPECT_EQ(0xf178dca8u, InsgpsLog::objectId(LOG_GROUND_TRUTH));
+  EXPECT_EQ(0x9266ce74u, InsgpsLog::objectId(LOG_ATTITUDE_SIMULATED));
+
+  EXPECT_EQ(16, InsgpsLog::objectSize(LOG_GYROS));
+  EXPECT_EQ(42, InsgpsLog::objectSize(LOG_GPS_POSITION));
+  EXPECT_EQ(29, InsgpsLog::objectSize(LOG_HOME_LOCATION));
+  EXPECT_EQ(76, InsgpsLog::objectSize(LOG_GROUND_TRUTH));
+  EXPECT_EQ(52, InsgpsLog::objectSize(LOG_ATTITUDE_SIMULATED));
+}
+
+TEST_F(InsgpsTest, LogFormats) {
+  InsgpsLog log;
+  record(&log, 10 * GYRO_RATE);
+
+  char dir[] = "/tmp/insgps_XXXXXX";
+  ASSERT_TRUE(mkdtemp(dir) != NULL);
+  std::string tll = std::string(dir) + "/flight.tll";
+  std::string columns = std::string(dir) + "/flight";
+
+  ASSERT_TRUE(log.writeTll(tll.c_str()));
+  ASSERT_TRUE(log.writeColumns(columns.c_str()));
+
+  InsgpsLog from_tll, from_columns;
+  EXPECT_TRUE(from_tll.read(tll.c_str()));
+  EXPECT_TRUE(from_columns.read(columns.c_str()));
+  remove_tree(dir);
+
+  ASSERT_EQ(log.updates.size(), from_tll.updates.size());
+  ASSERT_EQ(log.updates.size(), from_columns.updates.size());
+  for (uint32_t i = 0; i < log.updates.size(); i++) {
+    EXPECT_EQ(log.updates[i].timestamp, from_tll.updates[i].timestamp);
+    EXPECT_EQ(log.updates[i].obj, from_tll.updates[i].obj);
+    EXPECT_TRUE(log.updates[i].data == from_tll.updates[i].data);
+    EXPECT_EQ(log.updates[i].timestamp, from_columns.updates[i].timestamp);
+    EXPECT_EQ(log.updates[i].obj, from_columns.updates[i].obj);
+    EXPECT_TRUE(log.updates[i].data == from_columns.updates[i].data);
+  }
+}
+
+TEST_F(InsgpsTest, ReplaySimulatedFlight) {
+  InsgpsLog log;
+  record(&log, 60 * GYRO_RATE);
+
+  for (uint32_t n = 0; n < NUM_FILTERS; n++) {
+    struct replay_stats stats;
+    ASSERT_TRUE(insgps_replay(filters[n], log, &stats));
+    insgps_print_stats(&stats);
+
+    EXPECT_EQ(60 * GYRO_RATE - 2, (int32_t)stats.predictions);
+    EXPECT_EQ(0, (int32_t)stats.allocations);
+    ASSERT_GT(stats.truth_samples, 0u);
+    /* The attitude starts off by the roll of the turn, as it is
+     * initialized from the accels */
+    EXPECT_LT(sqrt(stats.pos_sq_error / stats.truth_samples), 0.5);
+    EXPECT_LT(sqrt(stats.vel_sq_error / stats.truth_samples), 0.3);
+    EXPECT_LT(sqrt(stats.att_sq_error / stats.truth_samples), 4.0);
+  }
+}
+
+TEST_F(InsgpsTest, ReplayLog) {
+  /* Replays a flight log, a .tll or a directory exported as columns, given
+   * in INSGPS_LOG. Run with --gtest_filter=*ReplayLog to benchmark on it. */
+  const char *path = getenv("INSGPS_LOG");
+  if (path == NULL)
+    return;
+
+  InsgpsLog log;
+  ASSERT_TRUE(log.read(path)) << "No INSGPS data in " << path;
+  fprintf(stdout, "%s: %u updates\n", path, (uint32_t)log.updates.size());
+
+  for (uint32_t n = 0; n < NUM_FILTERS; n++) {
+    struct replay_stats stats;
+    EXPECT_TRUE(insgps_replay(filters[n], log, &stats));
+    insgps_print_stats(&stats);
+    EXPECT_EQ(0, (int32_t)stats.allocations);
+  }
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -12,6 +12,12 @@ enum flash_posix_magic {
 	FLASH_POSIX_MAGIC = 0x321dabc1,
 };
 
+uint32_t pios_flash_posix_reads;
+uint32_t pios_flash_posix_read_bytes;
+uint32_t pios_flash_posix_writes;
+uint32_t pios_flash_posix_erases;
+uint32_t pios_flash_posix_transactions;
+
 struct flash_posix_dev {
 	enum flash_posix_magic magic;
 	const struct pios_flash_posix_cfg * cfg;
@@ -81,6 +87,8 @@ static int32_t PIOS_Flash_Posix_StartTransaction(uintptr_t chip_id)
 
 	flash_dev->transaction_in_progress = true;
 
+	pios_flash_posix_transactions++;
+
 	return 0;
 }
 
@@ -116,6 +124,8 @@ static int32_t PIOS_Flash_Posix_EraseSector(uintptr_t chip_id, uint32_t chip_sec
 
 	assert (s == flash_dev->cfg->size_of_sector);
 
+	pios_flash_posix_erases++;
+
 	return 0;
 }
 
@@ -137,6 +147,8 @@ static int32_t PIOS_Flash_Posix_WriteData(uintptr_t chip_id, uint32_t chip_offse
 
 	assert (s == len);
 
+	pios_flash_posix_writes++;
+
 	return 0;
 }
 
@@ -158,6 +170,9 @@ static int32_t PIOS_Flash_Posix_ReadData(uintptr_t chip_id, uint32_t chip_offset
 
 	assert (s == len);
 
+	pios_flash_posix_reads++;
+	pios_flash_posix_read_bytes += len;
+
 	return 0;
 }
 
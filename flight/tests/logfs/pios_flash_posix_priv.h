@@ -8,4 +8,11 @@ struct pios_flash_posix_cfg {
 int32_t PIOS_Flash_Posix_Init(uintptr_t * chip_id, const struct pios_flash_posix_cfg * cfg);
 void PIOS_Flash_Posix_Destroy(uintptr_t chip_id);
 
+/* Operations so far, to see how much flash a filesystem operation touches */
+extern uint32_t pios_flash_posix_reads;
+extern uint32_t pios_flash_posix_read_bytes;
+extern uint32_t pios_flash_posix_writes;
+extern uint32_t pios_flash_posix_erases;
+extern uint32_t pios_flash_posix_transactions;
+
 extern const struct pios_flash_driver pios_posix_flash_driver;
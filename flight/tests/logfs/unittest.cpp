@@ -37,6 +37,7 @@
 #include <stdlib.h>		/* abort */
 #include <string.h>		/* memset */
 #include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock */
 
 extern "C" {
 
@@ -56,6 +57,8 @@ extern struct pios_flash_posix_cfg flash_config;
 
 extern struct flashfs_logfs_cfg flashfs_config_settings;
 extern struct flashfs_logfs_cfg flashfs_config_waypoints;
+extern struct flashfs_logfs_cfg flashfs_config_settings_noindex;
+extern struct flashfs_logfs_cfg flashfs_config_settings_smallindex;
 
 #include "pios_flashfs.h"	/* PIOS_FLASHFS_* */
 
@@ -425,3 +428,325 @@ TEST_F(LogfsTestCookedMultiPart, WriteLarge) {
   memset(obj4_check, 0, sizeof(obj4_check));
   EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id_b, OBJ4_ID, 0, obj4_check, sizeof(obj4_check)));
 }
+
+/* A settings partition as it looks after a while: many objects, a few of
+ * them multi-instance, some saved many times */
+#define NUM_SETTINGS 120
+#define NELEMENTS(x) (sizeof(x) / sizeof(*(x)))
+#define SETTINGS_ID(n) (0x5e770000 + (n) * 0x1b3)
+#define SETTINGS_INST(n) ((n) % 10 == 0 ? 1 : 0)
+#define SETTINGS_SIZE(n) (8 + ((n) * 37) % 200)
+
+class LogfsTestIndex : public LogfsTestRaw {
+protected:
+  virtual void SetUp() {
+    LogfsTestRaw::SetUp();
+
+    EXPECT_EQ(0, PIOS_Flash_Posix_Init(&pios_posix_flash_id, &flash_config));
+  }
+
+  virtual void TearDown() {
+    PIOS_Flash_Posix_Destroy(pios_posix_flash_id);
+  }
+
+  void fill(uint32_t n, uint8_t seed, uint8_t *data) {
+    for (uint32_t i = 0; i < SETTINGS_SIZE(n); i++) {
+      data[i] = seed + n + i;
+    }
+  }
+
+  void saveAll(uintptr_t fs_id, uint8_t seed) {
+    uint8_t data[256];
+    for (uint32_t n = 0; n < NUM_SETTINGS; n++) {
+      for (uint16_t inst = 0; inst <= SETTINGS_INST(n); inst++) {
+        fill(n, seed + inst, data);
+        EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, SETTINGS_ID(n), inst, data, SETTINGS_SIZE(n)));
+      }
+    }
+  }
+
+  /* Saves every object as UAVObjSaveSettings() does */
+  void saveAllBatched(uintptr_t fs_id, uint8_t seed) {
+    uint8_t data[256];
+    EXPECT_EQ(0, PIOS_FLASHFS_BeginBatch(fs_id));
+    for (uint32_t n = 0; n < NUM_SETTINGS; n++) {
+      for (uint16_t inst = 0; inst <= SETTINGS_INST(n); inst++) {
+        fill(n, seed + inst, data);
+        EXPECT_EQ(0, PIOS_FLASHFS_ObjSaveBatched(fs_id, SETTINGS_ID(n), inst, data, SETTINGS_SIZE(n)));
+      }
+    }
+    EXPECT_EQ(0, PIOS_FLASHFS_CommitBatch(fs_id));
+  }
+
+  void resetCounters() {
+    pios_flash_posix_reads = 0;
+    pios_flash_posix_read_bytes = 0;
+    pios_flash_posix_writes = 0;
+    pios_flash_posix_erases = 0;
+    pios_flash_posix_transactions = 0;
+  }
+
+  /* Loads every object as UAVObjLoadSettings() would at boot, including
+   * the ones that were never saved */
+  void loadAll(uintptr_t fs_id, uint8_t seed) {
+    uint8_t data[256];
+    uint8_t expected[256];
+    for (uint32_t n = 0; n < NUM_SETTINGS; n++) {
+      for (uint16_t inst = 0; inst <= SETTINGS_INST(n); inst++) {
+        fill(n, seed + inst, expected);
+        EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, SETTINGS_ID(n), inst, data, SETTINGS_SIZE(n)));
+        EXPECT_EQ(0, memcmp(expected, data, SETTINGS_SIZE(n)));
+      }
+      EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, SETTINGS_ID(n) + 1, 0, data, 0));
+    }
+  }
+};
+
+TEST_F(LogfsTestIndex, SameContentsWithAndWithoutIndex) {
+  uintptr_t fs_id;
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+  saveAll(fs_id, 0x10);
+  saveAll(fs_id, 0x20);
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, SETTINGS_ID(3), 0));
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+
+  const struct flashfs_logfs_cfg *cfgs[] = {
+    &flashfs_config_settings_noindex,
+    &flashfs_config_settings_smallindex,
+    &flashfs_config_settings,
+  };
+  for (uint32_t c = 0; c < NELEMENTS(cfgs); c++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, cfgs[c], FLASH_PARTITION_LABEL_SETTINGS));
+
+    uint8_t data[256];
+    uint8_t expected[256];
+    for (uint32_t n = 0; n < NUM_SETTINGS; n++) {
+      int32_t rc = PIOS_FLASHFS_ObjLoad(fs_id, SETTINGS_ID(n), 0, data, SETTINGS_SIZE(n));
+      if (n == 3) {
+        EXPECT_EQ(-3, rc);
+      } else {
+        fill(n, 0x20, expected);
+        EXPECT_EQ(0, rc);
+        EXPECT_EQ(0, memcmp(expected, data, SETTINGS_SIZE(n)));
+      }
+    }
+
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+  }
+}
+
+TEST_F(LogfsTestIndex, SmallIndexSaveDeleteGarbageCollect) {
+  uintptr_t fs_id;
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings_smallindex, FLASH_PARTITION_LABEL_SETTINGS));
+
+  /* Enough rounds to garbage collect several times with most objects
+   * only found by scanning */
+  for (uint8_t round = 0; round < 8; round++) {
+    saveAll(fs_id, round);
+    loadAll(fs_id, round);
+  }
+
+  uint8_t data[256];
+  for (uint32_t n = 0; n < NUM_SETTINGS; n += 2) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, SETTINGS_ID(n), 0));
+    EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, SETTINGS_ID(n), 0, data, SETTINGS_SIZE(n)));
+  }
+
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+}
+
+TEST_F(LogfsTestIndex, FullIndexSaveDeleteGarbageCollect) {
+  uintptr_t fs_id;
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+
+  for (uint8_t round = 0; round < 8; round++) {
+    saveAll(fs_id, round);
+    loadAll(fs_id, round);
+  }
+
+  /* A deleted object is gone, also after the index is rebuilt */
+  uint8_t data[256];
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, SETTINGS_ID(5), 0));
+  EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, SETTINGS_ID(5), 0, data, SETTINGS_SIZE(5)));
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+  EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, SETTINGS_ID(5), 0, data, SETTINGS_SIZE(5)));
+  uint8_t expected[256];
+  fill(6, 7, expected);
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, SETTINGS_ID(6), 0, data, SETTINGS_SIZE(6)));
+  EXPECT_EQ(0, memcmp(expected, data, SETTINGS_SIZE(6)));
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+}
+
+TEST_F(LogfsTestIndex, MountLoadAllTime) {
+  uintptr_t fs_id;
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+  saveAll(fs_id, 0x10);
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+
+  const struct flashfs_logfs_cfg *cfgs[] = {
+    &flashfs_config_settings_noindex,
+    &flashfs_config_settings,
+  };
+  uint32_t reads[NELEMENTS(cfgs)];
+  for (uint32_t c = 0; c < NELEMENTS(cfgs); c++) {
+    pios_flash_posix_reads = 0;
+    pios_flash_posix_read_bytes = 0;
+
+    clock_t start = clock();
+    EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, cfgs[c], FLASH_PARTITION_LABEL_SETTINGS));
+    loadAll(fs_id, 0x10);
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+
+    /* On a 20 MHz SPI flash every read also sends a command and address */
+    double spiMs = (pios_flash_posix_reads * 4 + pios_flash_posix_read_bytes) * 8 / 20e6 * 1e3;
+    fprintf(stdout, "%s: %u reads, %u bytes, %.2f ms here, ~%.1f ms on SPI flash\n",
+            cfgs[c]->index_size ? "indexed" : "scanning",
+            pios_flash_posix_reads, pios_flash_posix_read_bytes, seconds * 1e3, spiMs);
+    reads[c] = pios_flash_posix_reads;
+  }
+
+  EXPECT_LT(reads[1] * 10, reads[0]);
+}
+
+TEST_F(LogfsTestIndex, BatchNotStarted) {
+  uintptr_t fs_id;
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+  EXPECT_EQ(-2, PIOS_FLASHFS_ObjSaveBatched(fs_id, OBJ1_ID, 0, obj1, sizeof(obj1)));
+  EXPECT_EQ(-2, PIOS_FLASHFS_CommitBatch(fs_id));
+  EXPECT_EQ(-1, PIOS_FLASHFS_BeginBatch(fs_id + 1));
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+}
+
+TEST_F(LogfsTestIndex, BatchSaveLoad) {
+  const struct flashfs_logfs_cfg *cfgs[] = {
+    &flashfs_config_settings_noindex,
+    &flashfs_config_settings_smallindex,
+    &flashfs_config_settings,
+  };
+  for (uint32_t c = 0; c < NELEMENTS(cfgs); c++) {
+    uintptr_t fs_id;
+    EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, cfgs[c], FLASH_PARTITION_LABEL_SETTINGS));
+    EXPECT_EQ(0, PIOS_FLASHFS_Format(fs_id));
+
+    /* Every round replaces all objects, enough to garbage collect in
+     * the middle of several batches */
+    for (uint8_t round = 0; round < 8; round++) {
+      saveAllBatched(fs_id, round);
+      loadAll(fs_id, round);
+    }
+
+    /* Only one version of each object is left behind */
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+    EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, cfgs[c], FLASH_PARTITION_LABEL_SETTINGS));
+    loadAll(fs_id, 7);
+    for (uint32_t n = 0; n < NUM_SETTINGS; n++) {
+      EXPECT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, SETTINGS_ID(n), 0));
+    }
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+
+    EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, cfgs[c], FLASH_PARTITION_LABEL_SETTINGS));
+    uint8_t data[256];
+    for (uint32_t n = 0; n < NUM_SETTINGS; n++) {
+      EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, SETTINGS_ID(n), 0, data, SETTINGS_SIZE(n)));
+    }
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+  }
+}
+
+TEST_F(LogfsTestIndex, BatchSkipsUnchanged) {
+  uintptr_t fs_id;
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+  saveAllBatched(fs_id, 0x10);
+
+  resetCounters();
+  saveAllBatched(fs_id, 0x10);
+  EXPECT_EQ(0, (int32_t)pios_flash_posix_writes);
+  EXPECT_EQ(1, (int32_t)pios_flash_posix_transactions);
+
+  loadAll(fs_id, 0x10);
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+}
+
+TEST_F(LogfsTestIndex, BatchFillsFilesystem) {
+  uintptr_t fs_id;
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+
+  /* Fill all but one slot with objects */
+  uint32_t num_slots = (flashfs_config_settings.arena_size / flashfs_config_settings.slot_size) - 1;
+  EXPECT_EQ(0, PIOS_FLASHFS_BeginBatch(fs_id));
+  for (uint32_t i = 0; i < num_slots - 1; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSaveBatched(fs_id, OBJ1_ID, i, obj1, sizeof(obj1)));
+  }
+  EXPECT_EQ(0, PIOS_FLASHFS_CommitBatch(fs_id));
+
+  /* Replacing them fills the log, the previous versions make room */
+  EXPECT_EQ(0, PIOS_FLASHFS_BeginBatch(fs_id));
+  for (uint32_t i = 0; i < num_slots - 1; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSaveBatched(fs_id, OBJ1_ID, i, obj1_alt, sizeof(obj1_alt)));
+  }
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSaveBatched(fs_id, OBJ2_ID, 0, obj2, sizeof(obj2)));
+  EXPECT_EQ(-4, PIOS_FLASHFS_ObjSaveBatched(fs_id, OBJ3_ID, 0, obj3, sizeof(obj3)));
+  EXPECT_EQ(0, PIOS_FLASHFS_CommitBatch(fs_id));
+
+  unsigned char obj1_check[OBJ1_SIZE];
+  for (uint32_t i = 0; i < num_slots - 1; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, i, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
+  }
+  unsigned char obj2_check[OBJ2_SIZE];
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj2_check, sizeof(obj2_check)));
+  EXPECT_EQ(0, memcmp(obj2, obj2_check, sizeof(obj2)));
+
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+}
+
+TEST_F(LogfsTestIndex, SaveAllTime) {
+  uintptr_t fs_id;
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+  saveAll(fs_id, 0x10);
+
+  /* After a setup wizard: a few objects changed, the rest saved again as is */
+  uint8_t data[256];
+  uint32_t writes[2];
+  uint32_t erases[2];
+  for (uint32_t batched = 0; batched < 2; batched++) {
+    resetCounters();
+    clock_t start = clock();
+    if (batched) {
+      EXPECT_EQ(0, PIOS_FLASHFS_BeginBatch(fs_id));
+    }
+    for (uint32_t round = 0; round < 10; round++) {
+      for (uint32_t n = 0; n < NUM_SETTINGS; n++) {
+        fill(n, (n % 10 == round) ? 0x20 + round : 0x10, data);
+        if (batched) {
+          EXPECT_EQ(0, PIOS_FLASHFS_ObjSaveBatched(fs_id, SETTINGS_ID(n), 0, data, SETTINGS_SIZE(n)));
+        } else {
+          EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, SETTINGS_ID(n), 0, data, SETTINGS_SIZE(n)));
+        }
+      }
+      if (batched) {
+        EXPECT_EQ(0, PIOS_FLASHFS_CommitBatch(fs_id));
+        if (round < 9) {
+          EXPECT_EQ(0, PIOS_FLASHFS_BeginBatch(fs_id));
+        }
+      }
+    }
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    fprintf(stdout, "%s: %u transactions, %u reads, %u writes, %u erases, %.2f ms\n",
+            batched ? "batched" : "one by one", pios_flash_posix_transactions,
+            pios_flash_posix_reads, pios_flash_posix_writes, pios_flash_posix_erases,
+            seconds * 1e3);
+    writes[batched] = pios_flash_posix_writes;
+    erases[batched] = pios_flash_posix_erases;
+  }
+
+  EXPECT_LT(writes[1] * 4, writes[0]);
+  EXPECT_LT(erases[1], erases[0]);
+
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+}
+
@@ -11,6 +11,20 @@ const struct flashfs_logfs_cfg flashfs_config_settings = {
 	.fs_magic      = 0x89abceef,
 	.arena_size    = 0x00010000, /* 256 * slot size */
 	.slot_size     = 0x00000100, /* 256 bytes */
+	.index_size    = 255,        /* every slot */
+};
+
+const struct flashfs_logfs_cfg flashfs_config_settings_noindex = {
+	.fs_magic      = 0x89abceef,
+	.arena_size    = 0x00010000, /* 256 * slot size */
+	.slot_size     = 0x00000100, /* 256 bytes */
+};
+
+const struct flashfs_logfs_cfg flashfs_config_settings_smallindex = {
+	.fs_magic      = 0x89abceef,
+	.arena_size    = 0x00010000, /* 256 * slot size */
+	.slot_size     = 0x00000100, /* 256 bytes */
+	.index_size    = 16,
 };
 
 const struct flashfs_logfs_cfg flashfs_config_waypoints = {
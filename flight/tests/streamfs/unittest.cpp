@@ -437,6 +437,60 @@ TEST_F(StreamfsComTest, ComWrite) {
   EXPECT_EQ(0, PIOS_STREAMFS_Close(fs_id));
 }
 
+TEST_F(StreamfsComTest, ComReserveTooLong) {
+  struct pios_com_span spans[2];
+  EXPECT_EQ(-2, PIOS_COM_ReserveTx(com_id, BUF_LEN + 1, spans, 0));
+}
+
+TEST_F(StreamfsComTest, ComReserveCancel) {
+  struct pios_com_span spans[2];
+
+  /* Nothing drains the buffer while closed, giving back the space keeps it free */
+  for (int32_t i = 0; i < 10; i++) {
+    EXPECT_EQ(1, PIOS_COM_ReserveTx(com_id, 40, spans, 0));
+    EXPECT_EQ(40, spans[0].len);
+    EXPECT_EQ(0, PIOS_COM_CommitTx(com_id, 0));
+  }
+
+  EXPECT_EQ(1, PIOS_COM_ReserveTx(com_id, 40, spans, 0));
+  EXPECT_EQ(40, PIOS_COM_CommitTx(com_id, 40));
+  EXPECT_EQ(-2, PIOS_COM_ReserveTx(com_id, 40, spans, 0));
+}
+
+TEST_F(StreamfsComTest, ComReserveWrite) {
+  EXPECT_EQ(0, PIOS_STREAMFS_OpenWrite(fs_id));
+  int32_t total_write = 0;
+  int32_t wrapped = 0;
+  while(total_write < DATA_LEN) {
+    /* Odd sized messages, so the space wraps around the buffer end */
+    uint16_t len = (DATA_LEN - total_write < 37) ? DATA_LEN - total_write : 37;
+    struct pios_com_span spans[2];
+    int32_t num_spans = PIOS_COM_ReserveTx(com_id, len, spans, 0);
+    ASSERT_TRUE(num_spans == 1 || num_spans == 2);
+
+    memcpy(spans[0].buf, &data2[total_write], spans[0].len);
+    if (num_spans == 2) {
+      EXPECT_EQ(len, spans[0].len + spans[1].len);
+      memcpy(spans[1].buf, &data2[total_write + spans[0].len], spans[1].len);
+      wrapped++;
+    } else {
+      EXPECT_EQ(len, spans[0].len);
+    }
+
+    EXPECT_EQ(len, PIOS_COM_CommitTx(com_id, len));
+    total_write += len;
+  }
+  EXPECT_EQ(0, PIOS_STREAMFS_Close(fs_id));
+  EXPECT_GT(wrapped, 0);
+
+  int32_t file_id = PIOS_STREAMFS_MaxFileId(fs_id);
+  uint8_t data_read[DATA_LEN];
+  EXPECT_EQ(0, PIOS_STREAMFS_OpenRead(fs_id,file_id));
+  EXPECT_EQ(DATA_LEN, PIOS_STREAMFS_Testing_Read(fs_id, data_read, DATA_LEN));
+  CompareArray(data2, data_read, DATA_LEN);
+  EXPECT_EQ(0, PIOS_STREAMFS_Close(fs_id));
+}
+
 TEST_F(StreamfsComTest, ComReadClosed) {
   uint8_t data_read[DATA_LEN];
   EXPECT_EQ(0, PIOS_COM_ReceiveBuffer(com_id, data_read, (uint16_t) DATA_LEN, 0));
@@ -0,0 +1,13 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PIOS_Assert(x) if (!(x)) { while (1) ; }
+
+#define PIOS_DEBUG_Assert(x) PIOS_Assert(x)
+
+#include "utlist.h"
+#include "uavobjectmanager.h"
+#include "eventdispatcher.h"
+#include "pios_flashfs.h"
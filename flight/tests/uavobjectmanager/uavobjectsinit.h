@@ -0,0 +1,2 @@
+/* The test registers its own objects, there are no more of them than this */
+#define UAVOBJECTS_COUNT 130
@@ -0,0 +1,214 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdint.h>		/* uint*_t */
+#include <string.h>		/* memset */
+#include <time.h>		/* clock_gettime */
+
+extern "C" {
+
+#include "openpilot.h"
+#include "uavobjectsinit.h"
+
+}
+
+#define NUM_OBJECTS UAVOBJECTS_COUNT
+#define OBJ_SIZE 16
+#define NUM_LOOKUPS 1000000
+
+// To use a test fixture, derive a class from testing::Test.
+class UAVObjManagerTest : public testing::Test {
+protected:
+  virtual void SetUp() {
+    ASSERT_EQ(0, UAVObjInitialize());
+
+    // Object IDs are hashes, spread them over the whole range. The low bit
+    // is left clear as the following ID is taken by the metaobject.
+    uint32_t id = 0x12345678;
+    for (uint32_t i = 0; i < NUM_OBJECTS; i++) {
+      id = id * 1664525 + 1013904223;
+      ids[i] = id & ~1;
+      handles[i] = UAVObjRegister(ids[i], (i % 4) != 0, (i % 3) == 0, OBJ_SIZE, NULL);
+      ASSERT_TRUE(handles[i] != NULL);
+    }
+  }
+
+  uint32_t ids[NUM_OBJECTS];
+  UAVObjHandle handles[NUM_OBJECTS];
+};
+
+TEST_F(UAVObjManagerTest, Count) {
+  EXPECT_EQ(NUM_OBJECTS, UAVObjCount());
+}
+
+TEST_F(UAVObjManagerTest, FindObjects) {
+  for (uint32_t i = 0; i < NUM_OBJECTS; i++) {
+    EXPECT_EQ(handles[i], UAVObjGetByID(ids[i]));
+    EXPECT_EQ(ids[i], UAVObjGetID(handles[i]));
+  }
+}
+
+TEST_F(UAVObjManagerTest, FindMetaobjects) {
+  for (uint32_t i = 0; i < NUM_OBJECTS; i++) {
+    UAVObjHandle meta = UAVObjGetByID(ids[i] + 1);
+    ASSERT_TRUE(meta != NULL);
+    EXPECT_TRUE(UAVObjIsMetaobject(meta));
+    EXPECT_EQ(ids[i] + 1, UAVObjGetID(meta));
+    EXPECT_EQ(handles[i], UAVObjGetLinkedObj(meta));
+  }
+}
+
+TEST_F(UAVObjManagerTest, UnknownID) {
+  EXPECT_TRUE(UAVObjGetByID(0) == NULL);
+  EXPECT_TRUE(UAVObjGetByID(0xFFFFFFFF) == NULL);
+  EXPECT_TRUE(UAVObjGetByID(0x12345678) == NULL);
+}
+
+TEST_F(UAVObjManagerTest, DuplicateRegistration) {
+  EXPECT_TRUE(UAVObjRegister(ids[0], true, false, OBJ_SIZE, NULL) == NULL);
+  EXPECT_EQ(NUM_OBJECTS, UAVObjCount());
+  EXPECT_EQ(handles[0], UAVObjGetByID(ids[0]));
+}
+
+TEST_F(UAVObjManagerTest, IndexFull) {
+  ASSERT_EQ(UAVOBJECTS_COUNT, UAVObjCount());
+  EXPECT_TRUE(UAVObjRegister(0x0badcafe, true, false, OBJ_SIZE, NULL) == NULL);
+  EXPECT_EQ(UAVOBJECTS_COUNT, UAVObjCount());
+  EXPECT_TRUE(UAVObjGetByID(0x0badcafe) == NULL);
+}
+
+TEST_F(UAVObjManagerTest, CreateInstances) {
+  UAVObjHandle obj = handles[0];
+  uint8_t data[OBJ_SIZE];
+
+  ASSERT_FALSE(UAVObjIsSingleInstance(obj));
+  EXPECT_EQ(1, UAVObjGetNumInstances(obj));
+
+  // Unpacking an instance creates it and all the ones before it
+  memset(data, 0xA5, sizeof(data));
+  EXPECT_EQ(0, UAVObjUnpack(obj, 49, data));
+  EXPECT_EQ(50, UAVObjGetNumInstances(obj));
+
+  uint8_t out[OBJ_SIZE];
+  EXPECT_EQ(0, UAVObjGetInstanceData(obj, 49, out));
+  EXPECT_EQ(0, memcmp(data, out, OBJ_SIZE));
+
+  memset(data, 0, sizeof(data));
+  EXPECT_EQ(0, UAVObjGetInstanceData(obj, 48, out));
+  EXPECT_EQ(0, memcmp(data, out, OBJ_SIZE));
+
+  EXPECT_EQ(-1, UAVObjGetInstanceData(obj, 50, out));
+}
+
+TEST_F(UAVObjManagerTest, InstanceDataRange) {
+  UAVObjHandle obj = handles[0];
+  uint8_t data[OBJ_SIZE];
+
+  // Fill each instance with its own ID, growing the instance array
+  for (uint16_t inst = 0; inst < 100; inst++) {
+    memset(data, inst, sizeof(data));
+    EXPECT_EQ(0, UAVObjUnpack(obj, inst, data));
+  }
+  EXPECT_EQ(100, UAVObjGetNumInstances(obj));
+
+  uint8_t range[40 * OBJ_SIZE];
+  EXPECT_EQ(0, UAVObjGetInstanceDataRange(obj, 30, 40, range));
+  for (uint16_t n = 0; n < 40; n++) {
+    memset(data, 30 + n, sizeof(data));
+    EXPECT_EQ(0, memcmp(data, &range[n * OBJ_SIZE], OBJ_SIZE));
+  }
+
+  // The range must exist completely
+  EXPECT_EQ(-1, UAVObjGetInstanceDataRange(obj, 70, 40, range));
+  EXPECT_EQ(-1, UAVObjGetInstanceDataRange(obj, 0, 0, range));
+
+  // Single instance objects only have instance 0
+  EXPECT_TRUE(UAVObjIsSingleInstance(handles[1]));
+  EXPECT_EQ(0, UAVObjGetInstanceDataRange(handles[1], 0, 1, range));
+  EXPECT_EQ(-1, UAVObjGetInstanceDataRange(handles[1], 0, 2, range));
+}
+
+TEST_F(UAVObjManagerTest, MaxInstances) {
+  UAVObjHandle obj = handles[0];
+  uint8_t data[OBJ_SIZE];
+
+  // Every instance up to the limit is reachable and keeps its own data
+  for (uint16_t inst = 0; inst < UAVOBJ_MAX_INSTANCES; inst++) {
+    memset(data, inst & 0xFF, sizeof(data));
+    data[0] = inst >> 8;
+    ASSERT_EQ(0, UAVObjUnpack(obj, inst, data));
+  }
+  EXPECT_EQ(UAVOBJ_MAX_INSTANCES, UAVObjGetNumInstances(obj));
+  EXPECT_EQ(-1, UAVObjUnpack(obj, UAVOBJ_MAX_INSTANCES, data));
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  uint8_t out[OBJ_SIZE];
+  for (uint16_t inst = 0; inst < UAVOBJ_MAX_INSTANCES; inst++) {
+    ASSERT_EQ(0, UAVObjGetInstanceData(obj, inst, out));
+    EXPECT_EQ(inst >> 8, out[0]);
+    EXPECT_EQ(inst & 0xFF, out[OBJ_SIZE - 1]);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  printf("%d instances read in %.1f us\n", UAVOBJ_MAX_INSTANCES, seconds * 1e6);
+}
+
+TEST_F(UAVObjManagerTest, LookupRate) {
+  struct timespec start, end;
+  uint32_t found = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t i = 0; i < NUM_LOOKUPS; i++) {
+    // Alternate between objects and metaobjects, like the telemetry stream
+    uint32_t id = ids[i % NUM_OBJECTS] + (i & 1);
+    if (UAVObjGetByID(id) != NULL)
+      found++;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  EXPECT_EQ((uint32_t) NUM_LOOKUPS, found);
+
+  double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  printf("%d objects: %.0f lookups/sec\n", NUM_OBJECTS, NUM_LOOKUPS / seconds);
+}
+
+/**
+ * @}
+ * @}
+ */
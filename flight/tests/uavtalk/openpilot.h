@@ -0,0 +1,19 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PIOS_INCLUDE_FREERTOS
+
+#define PIOS_Assert(x) if (!(x)) { while (1) ; }
+
+#define PIOS_DEBUG_Assert(x) PIOS_Assert(x)
+
+#include "utlist.h"
+#include "pios.h"
+#include "pios_heap.h"
+#include "pios_thread.h"
+#include "uavobjectmanager.h"
+#include "eventdispatcher.h"
+#include "pios_flashfs.h"
+#include "uavtalk.h"
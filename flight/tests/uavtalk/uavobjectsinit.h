@@ -0,0 +1,4 @@
+/* The test registers its own objects, none is larger than this */
+#define UAVOBJECTS_LARGEST 255
+/* and there are no more of them than this */
+#define UAVOBJECTS_COUNT 32
@@ -0,0 +1,1014 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdint.h>		/* uint*_t */
+#include <string.h>		/* memset */
+#include <time.h>		/* clock */
+#include <vector>
+#include <deque>
+#include <algorithm>
+
+extern "C" {
+
+#include "openpilot.h"
+
+extern uint32_t fakeSystime;
+
+}
+
+/* Same values as uavtalk_priv.h, which can't be included from C++ */
+#define TYPE_OBJ       0x20
+#define TYPE_NACK      0x24
+#define TYPE_OBJ_MULTI 0x25
+#define TYPE_OBJ_DELTA 0x26
+#define DELTA_KEYFRAME_INTERVAL 10
+#define MAX_TRANSACTIONS 8
+
+#define LINK_BAUD 57600
+#define NUM_ROUNDS 100
+
+/* Sizes of a typical set of periodically sent telemetry objects */
+static const uint16_t telemetrySizes[] = { 40, 28, 12, 16, 36, 24, 20, 12, 48, 8, 30, 16, 64, 6 };
+#define NUM_OBJECTS (sizeof(telemetrySizes) / sizeof(telemetrySizes[0]))
+#define MULTI_INSTANCES 3
+#define LARGE_SIZE 250
+#define REQ_TIMEOUT_MS 250
+#define LINK_LATENCY_MS 40
+#define RX_STREAM_BYTES (4 * 1024 * 1024)
+
+/* Everything sent ends up on the simulated link */
+static std::vector<uint8_t> linkBytes;
+static uint32_t linkWrites;
+
+static int32_t linkWrite(uint8_t *data, int32_t length)
+{
+  linkBytes.insert(linkBytes.end(), data, data + length);
+  linkWrites++;
+  return length;
+}
+
+/* Acks and objects sent back by the receiving end */
+static std::vector<uint8_t> backBytes;
+
+static int32_t backWrite(uint8_t *data, int32_t length)
+{
+  backBytes.insert(backBytes.end(), data, data + length);
+  return length;
+}
+
+/* A port tx buffer that messages are written into in place, drained onto
+ * the link on every commit */
+#define RING_LEN 128
+static uint8_t ring[RING_LEN];
+static uint16_t ringWr;
+static uint16_t ringReserved;
+static uint32_t ringCommits;
+
+static int32_t ringReserve(uint16_t length, uint8_t *spans[2], uint16_t spanLengths[2])
+{
+  if (length > RING_LEN)
+    return -1;
+
+  ringReserved = length;
+  spans[0] = &ring[ringWr];
+  if (ringWr + length <= RING_LEN) {
+    spanLengths[0] = length;
+    return 1;
+  }
+  spanLengths[0] = RING_LEN - ringWr;
+  spans[1] = &ring[0];
+  spanLengths[1] = length - spanLengths[0];
+  return 2;
+}
+
+static int32_t ringCommit(uint16_t length)
+{
+  EXPECT_LE(length, ringReserved);
+  for (uint16_t i = 0; i < length; i++) {
+    linkBytes.push_back(ring[ringWr]);
+    ringWr = (ringWr + 1) % RING_LEN;
+  }
+  ringReserved = 0;
+  if (length > 0)
+    ringCommits++;
+  return length;
+}
+
+/* Completed transactions, in order */
+struct Completion {
+  UAVObjHandle obj;
+  bool success;
+  uint8_t retries;
+};
+static std::vector<Completion> completions;
+
+static void recordCompletion(UAVTalkConnection, UAVObjHandle obj, uint16_t, bool success, uint8_t retries)
+{
+  Completion completion;
+  completion.obj = obj;
+  completion.success = success;
+  completion.retries = retries;
+  completions.push_back(completion);
+}
+
+/* A radio link with latency, each frame arrives once it is through the
+ * serial port and the air */
+struct Delivery {
+  uint32_t time;
+  std::vector<uint8_t> bytes;
+};
+static std::deque<Delivery> upLink;
+static std::deque<Delivery> downLink;
+static uint32_t upLinkFree;
+static uint32_t downLinkFree;
+
+static void transmit(std::deque<Delivery> &queue, uint32_t &linkFree, uint8_t *data, int32_t length)
+{
+  uint32_t start = fakeSystime > linkFree ? fakeSystime : linkFree;
+  linkFree = start + (length * 10 * 1000 + LINK_BAUD - 1) / LINK_BAUD;
+  Delivery delivery;
+  delivery.time = linkFree + LINK_LATENCY_MS;
+  delivery.bytes.assign(data, data + length);
+  queue.push_back(delivery);
+}
+
+static int32_t upLinkWrite(uint8_t *data, int32_t length)
+{
+  transmit(upLink, upLinkFree, data, length);
+  return length;
+}
+
+static int32_t downLinkWrite(uint8_t *data, int32_t length)
+{
+  transmit(downLink, downLinkFree, data, length);
+  return length;
+}
+
+static void deliver(std::deque<Delivery> &queue, UAVTalkConnection connection)
+{
+  while (!queue.empty() && queue.front().time <= fakeSystime) {
+    for (uint32_t i = 0; i < queue.front().bytes.size(); i++)
+      UAVTalkProcessInputStream(connection, queue.front().bytes[i]);
+    queue.pop_front();
+  }
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class UAVTalkLink : public testing::Test {
+protected:
+  virtual void SetUp() {
+    ASSERT_EQ(0, UAVObjInitialize());
+
+    uint32_t id = 0x12345678;
+    for (uint32_t i = 0; i < NUM_OBJECTS; i++) {
+      id = id * 1664525 + 1013904223;
+      objects[i] = UAVObjRegister(id & ~1, true, false, telemetrySizes[i], NULL);
+      ASSERT_TRUE(objects[i] != NULL);
+    }
+
+    multi = UAVObjRegister(0x0badcafe, false, false, 10, NULL);
+    ASSERT_TRUE(multi != NULL);
+    for (uint16_t n = 1; n < MULTI_INSTANCES; n++)
+      ASSERT_EQ(n, UAVObjCreateInstance(multi, NULL));
+
+    large = UAVObjRegister(0x1eadbeee, true, false, LARGE_SIZE, NULL);
+    ASSERT_TRUE(large != NULL);
+
+    tx = UAVTalkInitialize(linkWrite);
+    ASSERT_TRUE(tx != NULL);
+    rx = UAVTalkInitialize(backWrite);
+    ASSERT_TRUE(rx != NULL);
+
+    linkBytes.clear();
+    linkWrites = 0;
+    backBytes.clear();
+    completions.clear();
+  }
+
+  /* Fills the object with a pattern that depends on the seed */
+  void fill(UAVObjHandle obj, uint16_t instId, uint8_t seed) {
+    uint8_t data[LARGE_SIZE];
+    for (uint32_t i = 0; i < UAVObjGetNumBytes(obj); i++)
+      data[i] = seed + i;
+    ASSERT_EQ(0, UAVObjSetInstanceData(obj, instId, data));
+  }
+
+  bool matches(UAVObjHandle obj, uint16_t instId, uint8_t seed) {
+    uint8_t data[LARGE_SIZE];
+    EXPECT_EQ(0, UAVObjGetInstanceData(obj, instId, data));
+    for (uint32_t i = 0; i < UAVObjGetNumBytes(obj); i++)
+      if (data[i] != (uint8_t)(seed + i))
+        return false;
+    return true;
+  }
+
+  void sendAll() {
+    for (uint32_t i = 0; i < NUM_OBJECTS; i++)
+      ASSERT_EQ(0, UAVTalkSendObject(tx, objects[i], 0, 0, 0));
+    ASSERT_EQ(0, UAVTalkSendObject(tx, multi, UAVOBJ_ALL_INSTANCES, 0, 0));
+  }
+
+  /* Feeds the link to the receiving end, returns the number of frames */
+  uint32_t receive() {
+    uint32_t frames = 0;
+    for (uint32_t i = 0; i < linkBytes.size(); i++)
+      if (UAVTalkProcessInputStream(rx, linkBytes[i]) == UAVTALK_STATE_COMPLETE)
+        frames++;
+    return frames;
+  }
+
+  /* Offsets of the frames on the link */
+  std::vector<uint32_t> frames() {
+    std::vector<uint32_t> starts;
+    for (uint32_t offset = 0; offset + 4 <= linkBytes.size();
+         offset += linkBytes[offset + 2] + (linkBytes[offset + 3] << 8) + 1)
+      starts.push_back(offset);
+    return starts;
+  }
+
+  /* Lets the receiving end answer what is on the link */
+  void answer() {
+    receive();
+    linkBytes.clear();
+    for (uint32_t i = 0; i < backBytes.size(); i++)
+      UAVTalkProcessInputStream(tx, backBytes[i]);
+    backBytes.clear();
+  }
+
+  /* Time it takes to send all objects acked over the radio link, with up
+   * to window of them waiting for their ack */
+  uint32_t uploadTime(uint32_t window) {
+    UAVTalkSetOutputStream(tx, upLinkWrite);
+    UAVTalkSetOutputStream(rx, downLinkWrite);
+    upLink.clear();
+    downLink.clear();
+    upLinkFree = downLinkFree = fakeSystime;
+    completions.clear();
+
+    uint32_t start = fakeSystime;
+    uint32_t sent = 0;
+    while (completions.size() < NUM_OBJECTS) {
+      while (sent < NUM_OBJECTS && sent - completions.size() < window)
+        EXPECT_EQ(0, UAVTalkSendObjectAsync(tx, objects[sent++], 0, REQ_TIMEOUT_MS, 1, recordCompletion));
+      fakeSystime++;
+      deliver(upLink, rx);
+      deliver(downLink, tx);
+      UAVTalkProcessTransactions(tx);
+    }
+
+    for (uint32_t i = 0; i < completions.size(); i++) {
+      EXPECT_TRUE(completions[i].success);
+      EXPECT_EQ(0, completions[i].retries);
+    }
+    return fakeSystime - start;
+  }
+
+  /* Changes a few bytes of an object, as a periodic update would */
+  void touch(UAVObjHandle obj, uint16_t instId, uint32_t offset, uint8_t value) {
+    uint8_t data[LARGE_SIZE];
+    ASSERT_EQ(0, UAVObjGetInstanceData(obj, instId, data));
+    data[offset] = value;
+    ASSERT_EQ(0, UAVObjSetInstanceData(obj, instId, data));
+  }
+
+  UAVObjHandle objects[NUM_OBJECTS];
+  UAVObjHandle multi;
+  UAVObjHandle large;
+  UAVTalkConnection tx;
+  UAVTalkConnection rx;
+};
+
+TEST_F(UAVTalkLink, BatchRoundTrip) {
+  for (uint32_t i = 0; i < NUM_OBJECTS; i++)
+    fill(objects[i], 0, i);
+  for (uint16_t n = 0; n < MULTI_INSTANCES; n++)
+    fill(multi, n, 100 + n);
+
+  ASSERT_EQ(0, UAVTalkSetBatching(tx, true));
+  sendAll();
+  ASSERT_EQ(0, UAVTalkFlushBatch(tx));
+
+  // Nothing but multi-object frames, and fewer of them than objects
+  EXPECT_EQ(TYPE_OBJ_MULTI, linkBytes[1]);
+  EXPECT_LT(linkWrites, NUM_OBJECTS);
+
+  // Overwrite the objects, receiving has to restore them
+  for (uint32_t i = 0; i < NUM_OBJECTS; i++)
+    fill(objects[i], 0, 0xAA);
+  for (uint16_t n = 0; n < MULTI_INSTANCES; n++)
+    fill(multi, n, 0xAA);
+
+  EXPECT_EQ(linkWrites, receive());
+
+  for (uint32_t i = 0; i < NUM_OBJECTS; i++)
+    EXPECT_TRUE(matches(objects[i], 0, i)) << "object " << i;
+  for (uint16_t n = 0; n < MULTI_INSTANCES; n++)
+    EXPECT_TRUE(matches(multi, n, 100 + n)) << "instance " << n;
+
+  UAVTalkStats txStats, rxStats;
+  UAVTalkGetStats(tx, &txStats);
+  UAVTalkGetStats(rx, &rxStats);
+  EXPECT_EQ(NUM_OBJECTS + MULTI_INSTANCES, txStats.txObjects);
+  EXPECT_EQ(linkBytes.size(), txStats.txBytes);
+  EXPECT_EQ(0, (int32_t)rxStats.rxErrors);
+}
+
+TEST_F(UAVTalkLink, OtherMessagesFollowTheBatch) {
+  ASSERT_EQ(0, UAVTalkSetBatching(tx, true));
+  ASSERT_EQ(0, UAVTalkSendObject(tx, objects[0], 0, 0, 0));
+  EXPECT_EQ(0, (int32_t)linkBytes.size());
+
+  // The NACK must not overtake the update sent before it
+  ASSERT_EQ(0, UAVTalkSendNack(tx, 0x12345678));
+  ASSERT_EQ(2, (int32_t)linkWrites);
+  EXPECT_EQ(TYPE_OBJ_MULTI, linkBytes[1]);
+  uint32_t nack = linkBytes[2] + (linkBytes[3] << 8) + 1;
+  ASSERT_LT(nack, linkBytes.size());
+  EXPECT_EQ(TYPE_NACK, linkBytes[nack + 1]);
+
+  // Nothing is left to flush
+  ASSERT_EQ(0, UAVTalkFlushBatch(tx));
+  EXPECT_EQ(2, (int32_t)linkWrites);
+}
+
+TEST_F(UAVTalkLink, LargeObjectsAreSentAlone) {
+  fill(large, 0, 7);
+  ASSERT_EQ(0, UAVTalkSetBatching(tx, true));
+  ASSERT_EQ(0, UAVTalkSendObject(tx, objects[0], 0, 0, 0));
+  ASSERT_EQ(0, UAVTalkSendObject(tx, large, 0, 0, 0));
+
+  // The pending update goes first, then the large object in a plain frame
+  ASSERT_EQ(2, (int32_t)linkWrites);
+  uint32_t second = linkBytes[2] + (linkBytes[3] << 8) + 1;
+  ASSERT_LT(second, linkBytes.size());
+  EXPECT_EQ(TYPE_OBJ, linkBytes[second + 1]);
+
+  fill(large, 0, 0);
+  EXPECT_EQ(2, (int32_t)receive());
+  EXPECT_TRUE(matches(large, 0, 7));
+}
+
+TEST_F(UAVTalkLink, DisablingBatchingFlushes) {
+  ASSERT_EQ(0, UAVTalkSetBatching(tx, true));
+  ASSERT_EQ(0, UAVTalkSendObject(tx, objects[0], 0, 0, 0));
+  ASSERT_EQ(0, UAVTalkSetBatching(tx, false));
+  EXPECT_EQ(1, (int32_t)linkWrites);
+
+  // Back to one plain frame per object
+  ASSERT_EQ(0, UAVTalkSendObject(tx, objects[1], 0, 0, 0));
+  EXPECT_EQ(2, (int32_t)linkWrites);
+  uint32_t second = linkBytes[2] + (linkBytes[3] << 8) + 1;
+  ASSERT_LT(second, linkBytes.size());
+  EXPECT_EQ(TYPE_OBJ, linkBytes[second + 1]);
+}
+
+TEST_F(UAVTalkLink, UnbatchedObjectsKeepTheirFrame) {
+  fill(objects[1], 0, 3);
+  ASSERT_EQ(0, UAVTalkSetBatching(tx, true));
+  ASSERT_EQ(0, UAVTalkSendObject(tx, objects[0], 0, 0, 0));
+  ASSERT_EQ(0, UAVTalkSendObjectUnbatched(tx, objects[1], 0));
+
+  // The pending update goes first, then a plain frame a relay can route
+  ASSERT_EQ(2, (int32_t)linkWrites);
+  EXPECT_EQ(TYPE_OBJ_MULTI, linkBytes[1]);
+  uint32_t second = linkBytes[2] + (linkBytes[3] << 8) + 1;
+  ASSERT_LT(second, linkBytes.size());
+  EXPECT_EQ(TYPE_OBJ, linkBytes[second + 1]);
+
+  // Batching carries on afterwards
+  ASSERT_EQ(0, UAVTalkSendObject(tx, objects[2], 0, 0, 0));
+  EXPECT_EQ(2, (int32_t)linkWrites);
+  ASSERT_EQ(0, UAVTalkFlushBatch(tx));
+  EXPECT_EQ(3, (int32_t)linkWrites);
+
+  fill(objects[1], 0, 0);
+  EXPECT_EQ(3, (int32_t)receive());
+  EXPECT_TRUE(matches(objects[1], 0, 3));
+}
+
+TEST_F(UAVTalkLink, UnbatchedObjectsAreSentInFull) {
+  // A relay decoding the routed objects itself never enables deltas
+  ASSERT_EQ(0, UAVTalkSetDeltaEncoding(tx, true));
+  ASSERT_EQ(0, UAVTalkSetBatching(tx, true));
+
+  fill(objects[0], 0, 3);
+  ASSERT_EQ(0, UAVTalkSendObjectUnbatched(tx, objects[0], 0));
+  touch(objects[0], 0, 1, 0xEE);
+  ASSERT_EQ(0, UAVTalkSendObjectUnbatched(tx, objects[0], 0));
+
+  std::vector<uint32_t> starts = frames();
+  ASSERT_EQ(2, (int32_t)starts.size());
+  EXPECT_EQ(TYPE_OBJ, linkBytes[starts[0] + 1]);
+  EXPECT_EQ(TYPE_OBJ, linkBytes[starts[1] + 1]);
+
+  fill(objects[0], 0, 0);
+  EXPECT_EQ(2, (int32_t)receive());
+  uint8_t data[LARGE_SIZE];
+  ASSERT_EQ(0, UAVObjGetInstanceData(objects[0], 0, data));
+  EXPECT_EQ(0xEE, data[1]);
+  EXPECT_EQ(3, data[0]);
+
+  UAVTalkStats rxStats;
+  UAVTalkGetStats(rx, &rxStats);
+  EXPECT_EQ(0, (int32_t)rxStats.rxErrors);
+}
+
+TEST_F(UAVTalkLink, BatchBandwidth) {
+  // Unbatched, one frame per object update
+  for (uint32_t round = 0; round < NUM_ROUNDS; round++)
+    sendAll();
+  uint32_t plainBytes = linkBytes.size();
+  uint32_t plainWrites = linkWrites;
+
+  linkBytes.clear();
+  linkWrites = 0;
+
+  // Batched, each round is flushed like the telemetry task does once its
+  // queue runs empty
+  ASSERT_EQ(0, UAVTalkSetBatching(tx, true));
+  for (uint32_t round = 0; round < NUM_ROUNDS; round++) {
+    sendAll();
+    ASSERT_EQ(0, UAVTalkFlushBatch(tx));
+  }
+  uint32_t batchedBytes = linkBytes.size();
+  uint32_t batchedWrites = linkWrites;
+
+  // A serial link spends 10 bits on every byte
+  float plainMs = plainBytes * 10 * 1000.0f / LINK_BAUD / NUM_ROUNDS;
+  float batchedMs = batchedBytes * 10 * 1000.0f / LINK_BAUD / NUM_ROUNDS;
+  fprintf(stdout, "unbatched: %u bytes in %u frames, %.2f ms per round at %d baud\n",
+          plainBytes, plainWrites, (double)plainMs, LINK_BAUD);
+  fprintf(stdout, "batched:   %u bytes in %u frames, %.2f ms per round at %d baud (%.1f%% less)\n",
+          batchedBytes, batchedWrites, (double)batchedMs, LINK_BAUD,
+          100.0 * (plainBytes - batchedBytes) / plainBytes);
+
+  EXPECT_LT(batchedBytes, plainBytes);
+  EXPECT_LT(batchedWrites * 4, plainWrites);
+
+  // All of it still decodes
+  EXPECT_EQ(batchedWrites, receive());
+  UAVTalkStats rxStats;
+  UAVTalkGetStats(rx, &rxStats);
+  EXPECT_EQ(0, (int32_t)rxStats.rxErrors);
+}
+
+TEST_F(UAVTalkLink, DeltaRoundTrip) {
+  ASSERT_EQ(0, UAVTalkSetDeltaEncoding(tx, true));
+  ASSERT_EQ(0, UAVTalkSetDeltaEncoding(rx, true));
+
+  for (uint32_t i = 0; i < NUM_OBJECTS; i++)
+    fill(objects[i], 0, i);
+  for (uint16_t n = 0; n < MULTI_INSTANCES; n++)
+    fill(multi, n, 100 + n);
+  sendAll();
+  uint32_t fullFrames = frames().size();
+
+  // Change a byte in the middle of every object and send them again
+  for (uint32_t i = 0; i < NUM_OBJECTS; i++)
+    touch(objects[i], 0, telemetrySizes[i] / 2, 0xEE);
+  for (uint16_t n = 0; n < MULTI_INSTANCES; n++)
+    touch(multi, n, 5, 0xEE);
+  sendAll();
+
+  // Only the objects too small for deltas are sent in full again
+  std::vector<uint32_t> starts = frames();
+  ASSERT_EQ(2 * fullFrames, starts.size());
+  for (uint32_t f = 0; f < fullFrames; f++) {
+    uint32_t full = starts[f], second = starts[fullFrames + f];
+    EXPECT_EQ(TYPE_OBJ, linkBytes[full + 1]);
+    if (linkBytes[full + 2] - 8 >= 8) {
+      EXPECT_EQ(TYPE_OBJ_DELTA, linkBytes[second + 1]) << "frame " << f;
+      EXPECT_LT(linkBytes[second + 2], linkBytes[full + 2]);
+    } else {
+      EXPECT_EQ(TYPE_OBJ, linkBytes[second + 1]) << "frame " << f;
+    }
+  }
+
+  // The full updates restore the first state, the deltas then apply to it
+  for (uint32_t i = 0; i < NUM_OBJECTS; i++)
+    fill(objects[i], 0, 0xAA);
+  for (uint16_t n = 0; n < MULTI_INSTANCES; n++)
+    fill(multi, n, 0xAA);
+  EXPECT_EQ(starts.size(), receive());
+
+  uint8_t data[LARGE_SIZE];
+  for (uint32_t i = 0; i < NUM_OBJECTS; i++) {
+    ASSERT_EQ(0, UAVObjGetInstanceData(objects[i], 0, data));
+    for (uint32_t b = 0; b < telemetrySizes[i]; b++)
+      EXPECT_EQ(b == telemetrySizes[i] / 2U ? 0xEE : (uint8_t)(i + b), data[b]) << "object " << i;
+  }
+  for (uint16_t n = 0; n < MULTI_INSTANCES; n++) {
+    ASSERT_EQ(0, UAVObjGetInstanceData(multi, n, data));
+    EXPECT_EQ(0xEE, data[5]);
+    EXPECT_EQ((uint8_t)(100 + n + 6), data[6]);
+  }
+}
+
+TEST_F(UAVTalkLink, DeltaKeyframes) {
+  ASSERT_EQ(0, UAVTalkSetDeltaEncoding(tx, true));
+
+  for (uint32_t update = 0; update < 2 * (DELTA_KEYFRAME_INTERVAL + 1); update++) {
+    touch(objects[0], 0, 0, update);
+    ASSERT_EQ(0, UAVTalkSendObject(tx, objects[0], 0, 0, 0));
+  }
+
+  std::vector<uint32_t> starts = frames();
+  ASSERT_EQ(2 * (DELTA_KEYFRAME_INTERVAL + 1), (int32_t)starts.size());
+  for (uint32_t f = 0; f < starts.size(); f++) {
+    uint8_t expected = (f % (DELTA_KEYFRAME_INTERVAL + 1) == 0) ? TYPE_OBJ : TYPE_OBJ_DELTA;
+    EXPECT_EQ(expected, linkBytes[starts[f] + 1]) << "frame " << f;
+  }
+
+  // Deltas are only sent when smaller than the object
+  linkBytes.clear();
+  ASSERT_EQ(0, UAVTalkSetDeltaEncoding(tx, true));
+  ASSERT_EQ(0, UAVTalkSendObject(tx, objects[0], 0, 0, 0));
+  fill(objects[0], 0, 0x55);
+  ASSERT_EQ(0, UAVTalkSendObject(tx, objects[0], 0, 0, 0));
+  starts = frames();
+  ASSERT_EQ(2, (int32_t)starts.size());
+  EXPECT_EQ(TYPE_OBJ, linkBytes[starts[1] + 1]);
+}
+
+TEST_F(UAVTalkLink, DeltaLostFrame) {
+  ASSERT_EQ(0, UAVTalkSetDeltaEncoding(tx, true));
+  ASSERT_EQ(0, UAVTalkSetDeltaEncoding(rx, true));
+
+  // A full update, two deltas, then deltas up to the next full update
+  fill(objects[0], 0, 0);
+  for (uint32_t update = 0; update < DELTA_KEYFRAME_INTERVAL + 2; update++) {
+    touch(objects[0], 0, 4 * (update % 4), update);
+    ASSERT_EQ(0, UAVTalkSendObject(tx, objects[0], 0, 0, 0));
+  }
+  uint8_t last[LARGE_SIZE];
+  ASSERT_EQ(0, UAVObjGetInstanceData(objects[0], 0, last));
+
+  std::vector<uint32_t> starts = frames();
+  ASSERT_EQ(DELTA_KEYFRAME_INTERVAL + 2U, starts.size());
+  ASSERT_EQ(TYPE_OBJ, linkBytes[starts[DELTA_KEYFRAME_INTERVAL + 1] + 1]);
+
+  // The first delta is lost, none of the following ones may be applied
+  fill(objects[0], 0, 0xAA);
+  std::vector<uint8_t> sent = linkBytes;
+  for (uint32_t f = 0; f < starts.size(); f++) {
+    if (f == 1)
+      continue;
+    uint32_t end = (f + 1 < starts.size()) ? starts[f + 1] : sent.size();
+    for (uint32_t b = starts[f]; b < end; b++)
+      UAVTalkProcessInputStream(rx, sent[b]);
+
+    uint8_t data[LARGE_SIZE];
+    ASSERT_EQ(0, UAVObjGetInstanceData(objects[0], 0, data));
+    if (f == 0) {
+      EXPECT_EQ(0, data[0]);
+      EXPECT_EQ(1, data[1]);
+    } else if (f <= DELTA_KEYFRAME_INTERVAL) {
+      // Still the data of the full update
+      EXPECT_EQ(0, data[0]) << "frame " << f;
+      EXPECT_EQ(1, data[1]) << "frame " << f;
+      EXPECT_EQ(4, data[4]) << "frame " << f;
+    } else {
+      // Recovered at the next full update
+      EXPECT_EQ(0, memcmp(last, data, telemetrySizes[0]));
+    }
+  }
+}
+
+TEST_F(UAVTalkLink, DeltaWrongBase) {
+  ASSERT_EQ(0, UAVTalkSetDeltaEncoding(tx, true));
+  ASSERT_EQ(0, UAVTalkSetDeltaEncoding(rx, true));
+
+  // A full update, then a delta changing the first chunk
+  fill(objects[0], 0, 0);
+  ASSERT_EQ(0, UAVTalkSendObject(tx, objects[0], 0, 0, 0));
+  touch(objects[0], 0, 0, 0xEE);
+  ASSERT_EQ(0, UAVTalkSendObject(tx, objects[0], 0, 0, 0));
+  ASSERT_EQ(TYPE_OBJ_DELTA, linkBytes[frames()[1] + 1]);
+  uint8_t sent[LARGE_SIZE];
+  ASSERT_EQ(0, UAVObjGetInstanceData(objects[0], 0, sent));
+
+  // The receiver holds other data than the delta was made against, two
+  // bytes chosen so that an 8 bit CRC of the result still matches
+  uint8_t other[LARGE_SIZE];
+  memcpy(other, sent, telemetrySizes[0]);
+  uint8_t sentCrc8 = PIOS_CRC_updateCRC(0, sent, telemetrySizes[0]);
+  other[20] = sent[20] + 1;
+  for (other[21] = 0; other[21] < 0xFF; other[21]++)
+    if (PIOS_CRC_updateCRC(0, other, telemetrySizes[0]) == sentCrc8)
+      break;
+  ASSERT_EQ(sentCrc8, PIOS_CRC_updateCRC(0, other, telemetrySizes[0]));
+
+  fill(objects[0], 0, 0);
+  std::vector<uint32_t> starts = frames();
+  for (uint32_t b = 0; b < starts[1]; b++)
+    UAVTalkProcessInputStream(rx, linkBytes[b]);
+  touch(objects[0], 0, 20, other[20]);
+  touch(objects[0], 0, 21, other[21]);
+  for (uint32_t b = starts[1]; b < linkBytes.size(); b++)
+    UAVTalkProcessInputStream(rx, linkBytes[b]);
+
+  uint8_t data[LARGE_SIZE];
+  ASSERT_EQ(0, UAVObjGetInstanceData(objects[0], 0, data));
+  EXPECT_EQ(0, data[0]);
+  EXPECT_EQ(other[20], data[20]);
+  EXPECT_EQ(other[21], data[21]);
+}
+
+TEST_F(UAVTalkLink, DeltasJoinTheBatch) {
+  ASSERT_EQ(0, UAVTalkSetBatching(tx, true));
+  ASSERT_EQ(0, UAVTalkSetDeltaEncoding(tx, true));
+  ASSERT_EQ(0, UAVTalkSetDeltaEncoding(rx, true));
+
+  for (uint32_t i = 0; i < NUM_OBJECTS; i++)
+    fill(objects[i], 0, i);
+  for (uint16_t n = 0; n < MULTI_INSTANCES; n++)
+    fill(multi, n, 100 + n);
+  sendAll();
+  ASSERT_EQ(0, UAVTalkFlushBatch(tx));
+  uint32_t fullBytes = linkBytes.size();
+
+  for (uint32_t i = 0; i < NUM_OBJECTS; i++)
+    touch(objects[i], 0, telemetrySizes[i] / 2, 0xEE);
+  for (uint16_t n = 0; n < MULTI_INSTANCES; n++)
+    touch(multi, n, 5, 0xEE);
+  sendAll();
+  ASSERT_EQ(0, UAVTalkFlushBatch(tx));
+
+  // Nothing but multi-object frames, the second round smaller than the first
+  std::vector<uint32_t> starts = frames();
+  for (uint32_t f = 0; f < starts.size(); f++)
+    EXPECT_EQ(TYPE_OBJ_MULTI, linkBytes[starts[f] + 1]) << "frame " << f;
+  EXPECT_LT(linkBytes.size() - fullBytes, fullBytes);
+
+  for (uint32_t i = 0; i < NUM_OBJECTS; i++)
+    fill(objects[i], 0, 0xAA);
+  for (uint16_t n = 0; n < MULTI_INSTANCES; n++)
+    fill(multi, n, 0xAA);
+  EXPECT_EQ(starts.size(), receive());
+
+  uint8_t data[LARGE_SIZE];
+  for (uint32_t i = 0; i < NUM_OBJECTS; i++) {
+    ASSERT_EQ(0, UAVObjGetInstanceData(objects[i], 0, data));
+    for (uint32_t b = 0; b < telemetrySizes[i]; b++)
+      EXPECT_EQ(b == telemetrySizes[i] / 2U ? 0xEE : (uint8_t)(i + b), data[b]) << "object " << i;
+  }
+  for (uint16_t n = 0; n < MULTI_INSTANCES; n++) {
+    ASSERT_EQ(0, UAVObjGetInstanceData(multi, n, data));
+    EXPECT_EQ(0xEE, data[5]);
+    EXPECT_EQ((uint8_t)(100 + n + 6), data[6]);
+  }
+
+  UAVTalkStats rxStats;
+  UAVTalkGetStats(rx, &rxStats);
+  EXPECT_EQ(0, (int32_t)rxStats.rxErrors);
+}
+
+TEST_F(UAVTalkLink, DeltaRestartSendsFullUpdates) {
+  ASSERT_EQ(0, UAVTalkSetDeltaEncoding(tx, true));
+  touch(objects[0], 0, 0, 1);
+  ASSERT_EQ(0, UAVTalkSendObject(tx, objects[0], 0, 0, 0));
+
+  // Each time the link comes back the other end has to get a full update
+  for (uint32_t restart = 0; restart < 3; restart++) {
+    ASSERT_EQ(0, UAVTalkSetDeltaEncoding(tx, false));
+    ASSERT_EQ(0, UAVTalkSetDeltaEncoding(tx, true));
+    touch(objects[0], 0, 0, 2 + restart);
+    ASSERT_EQ(0, UAVTalkSendObject(tx, objects[0], 0, 0, 0));
+    touch(objects[0], 0, 4, 2 + restart);
+    ASSERT_EQ(0, UAVTalkSendObject(tx, objects[0], 0, 0, 0));
+  }
+
+  std::vector<uint32_t> starts = frames();
+  ASSERT_EQ(7, (int32_t)starts.size());
+  for (uint32_t f = 1; f < starts.size(); f++)
+    EXPECT_EQ((f % 2) ? TYPE_OBJ : TYPE_OBJ_DELTA, linkBytes[starts[f] + 1]) << "frame " << f;
+}
+
+TEST_F(UAVTalkLink, DeltaBandwidth) {
+  // A few values of every object change between two updates
+  for (uint32_t round = 0; round < NUM_ROUNDS; round++) {
+    for (uint32_t i = 0; i < NUM_OBJECTS; i++) {
+      touch(objects[i], 0, (round * 4) % telemetrySizes[i], round);
+      touch(objects[i], 0, telemetrySizes[i] - 1, round);
+    }
+    sendAll();
+  }
+  uint32_t plainBytes = linkBytes.size();
+
+  linkBytes.clear();
+  ASSERT_EQ(0, UAVTalkSetDeltaEncoding(tx, true));
+  for (uint32_t round = 0; round < NUM_ROUNDS; round++) {
+    for (uint32_t i = 0; i < NUM_OBJECTS; i++) {
+      touch(objects[i], 0, (round * 4) % telemetrySizes[i], round);
+      touch(objects[i], 0, telemetrySizes[i] - 1, round);
+    }
+    sendAll();
+  }
+  uint32_t deltaBytes = linkBytes.size();
+
+  float plainMs = plainBytes * 10 * 1000.0f / LINK_BAUD / NUM_ROUNDS;
+  float deltaMs = deltaBytes * 10 * 1000.0f / LINK_BAUD / NUM_ROUNDS;
+  fprintf(stdout, "full:  %u bytes, %.2f ms per round at %d baud\n",
+          plainBytes, (double)plainMs, LINK_BAUD);
+  fprintf(stdout, "delta: %u bytes, %.2f ms per round at %d baud (%.1f%% less)\n",
+          deltaBytes, (double)deltaMs, LINK_BAUD,
+          100.0 * (plainBytes - deltaBytes) / plainBytes);
+
+  EXPECT_LT(deltaBytes * 3, plainBytes * 2);
+}
+
+TEST_F(UAVTalkLink, TransactionsArePipelined) {
+  for (uint32_t i = 0; i < MAX_TRANSACTIONS; i++)
+    ASSERT_EQ(0, UAVTalkSendObjectAsync(tx, objects[i], 0, REQ_TIMEOUT_MS, 1, recordCompletion));
+
+  // All of them went out before any ack came back
+  EXPECT_EQ(MAX_TRANSACTIONS, (int32_t)frames().size());
+  EXPECT_EQ(0, (int32_t)completions.size());
+  EXPECT_EQ(REQ_TIMEOUT_MS, UAVTalkProcessTransactions(tx));
+
+  answer();
+  ASSERT_EQ(MAX_TRANSACTIONS, (int32_t)completions.size());
+  for (uint32_t i = 0; i < MAX_TRANSACTIONS; i++) {
+    EXPECT_EQ(objects[i], completions[i].obj);
+    EXPECT_TRUE(completions[i].success);
+    EXPECT_EQ(0, completions[i].retries);
+  }
+  EXPECT_EQ(-1, UAVTalkProcessTransactions(tx));
+}
+
+TEST_F(UAVTalkLink, TransactionRetries) {
+  ASSERT_EQ(0, UAVTalkSendObjectAsync(tx, objects[0], 0, REQ_TIMEOUT_MS, 2, recordCompletion));
+
+  // Each timeout sends the object again, until the retries run out
+  for (uint32_t retry = 1; retry <= 2; retry++) {
+    fakeSystime += REQ_TIMEOUT_MS;
+    EXPECT_EQ(REQ_TIMEOUT_MS, UAVTalkProcessTransactions(tx));
+    EXPECT_EQ(retry + 1, frames().size());
+  }
+  EXPECT_EQ(0, (int32_t)completions.size());
+
+  fakeSystime += REQ_TIMEOUT_MS;
+  EXPECT_EQ(-1, UAVTalkProcessTransactions(tx));
+  ASSERT_EQ(1, (int32_t)completions.size());
+  EXPECT_FALSE(completions[0].success);
+  EXPECT_EQ(2, completions[0].retries);
+
+  // Counted in the stats as well
+  UAVTalkStats txStats;
+  UAVTalkGetStats(tx, &txStats);
+  EXPECT_EQ(2, (int32_t)txStats.txRetries);
+  EXPECT_EQ(1, (int32_t)txStats.txErrors);
+
+  // Late acks are ignored
+  answer();
+  EXPECT_EQ(1, (int32_t)completions.size());
+}
+
+TEST_F(UAVTalkLink, ResendingRestartsTheTransaction) {
+  ASSERT_EQ(0, UAVTalkSendObjectAsync(tx, objects[0], 0, REQ_TIMEOUT_MS, 1, recordCompletion));
+  fakeSystime += REQ_TIMEOUT_MS / 2;
+  ASSERT_EQ(0, UAVTalkSendObjectAsync(tx, objects[0], 0, REQ_TIMEOUT_MS, 1, recordCompletion));
+  EXPECT_EQ(REQ_TIMEOUT_MS, UAVTalkProcessTransactions(tx));
+
+  answer();
+  ASSERT_EQ(1, (int32_t)completions.size());
+  EXPECT_TRUE(completions[0].success);
+}
+
+TEST_F(UAVTalkLink, RequestCompletesWithTheObject) {
+  fill(objects[2], 0, 0x42);
+  ASSERT_EQ(0, UAVTalkSendObjectRequestAsync(tx, objects[2], 0, REQ_TIMEOUT_MS, 1, recordCompletion));
+
+  answer();
+  ASSERT_EQ(1, (int32_t)completions.size());
+  EXPECT_EQ(objects[2], completions[0].obj);
+  EXPECT_TRUE(completions[0].success);
+}
+
+TEST_F(UAVTalkLink, NackFailsTheTransaction) {
+  ASSERT_EQ(0, UAVTalkSendObjectAsync(tx, objects[3], 0, REQ_TIMEOUT_MS, 2, recordCompletion));
+  ASSERT_EQ(0, UAVTalkSendObjectAsync(tx, objects[4], 0, REQ_TIMEOUT_MS, 2, recordCompletion));
+
+  uint32_t objId = UAVObjGetID(objects[3]);
+  uint8_t nack[9] = { 0x3C, TYPE_NACK, 8, 0,
+                      (uint8_t)objId, (uint8_t)(objId >> 8), (uint8_t)(objId >> 16), (uint8_t)(objId >> 24) };
+  nack[8] = PIOS_CRC_updateCRC(0, nack, 8);
+  for (uint32_t i = 0; i < sizeof(nack); i++)
+    UAVTalkProcessInputStream(tx, nack[i]);
+
+  // Failed at once, without waiting for the retries
+  ASSERT_EQ(1, (int32_t)completions.size());
+  EXPECT_EQ(objects[3], completions[0].obj);
+  EXPECT_FALSE(completions[0].success);
+  EXPECT_EQ(0, completions[0].retries);
+  EXPECT_EQ(REQ_TIMEOUT_MS, UAVTalkProcessTransactions(tx));
+}
+
+TEST_F(UAVTalkLink, FullWindowWaitsForASlot) {
+  for (uint32_t i = 0; i < MAX_TRANSACTIONS; i++)
+    ASSERT_EQ(0, UAVTalkSendObjectAsync(tx, objects[i], 0, REQ_TIMEOUT_MS, 0, recordCompletion));
+
+  // No slot frees up in time
+  EXPECT_EQ(-1, UAVTalkSendObjectAsync(tx, objects[MAX_TRANSACTIONS], 0, REQ_TIMEOUT_MS / 2, 0, recordCompletion));
+  EXPECT_EQ(0, (int32_t)completions.size());
+
+  // The outstanding transactions time out while waiting
+  EXPECT_EQ(0, UAVTalkSendObjectAsync(tx, objects[MAX_TRANSACTIONS], 0, REQ_TIMEOUT_MS, 0, recordCompletion));
+  EXPECT_EQ(MAX_TRANSACTIONS, (int32_t)completions.size());
+
+  answer();
+  ASSERT_EQ(MAX_TRANSACTIONS + 1, (int32_t)completions.size());
+  EXPECT_EQ(objects[MAX_TRANSACTIONS], completions[MAX_TRANSACTIONS].obj);
+  EXPECT_TRUE(completions[MAX_TRANSACTIONS].success);
+}
+
+TEST_F(UAVTalkLink, BlockingSendNextToPipelined) {
+  ASSERT_EQ(0, UAVTalkSendObjectAsync(tx, objects[0], 0, REQ_TIMEOUT_MS * 4, 0, recordCompletion));
+
+  // Nothing answers in this test, the blocking send times out on its own
+  EXPECT_EQ(-1, UAVTalkSendObject(tx, objects[1], 0, 1, REQ_TIMEOUT_MS));
+  EXPECT_EQ(REQ_TIMEOUT_MS * 3, UAVTalkProcessTransactions(tx));
+
+  answer();
+  ASSERT_EQ(1, (int32_t)completions.size());
+  EXPECT_EQ(objects[0], completions[0].obj);
+  EXPECT_TRUE(completions[0].success);
+}
+
+TEST_F(UAVTalkLink, PipelinedThroughput) {
+  uint32_t stopAndWaitMs = uploadTime(1);
+  uint32_t pipelinedMs = uploadTime(MAX_TRANSACTIONS);
+
+  fprintf(stdout, "stop-and-wait: %u acked objects in %u ms at %d baud with %d ms latency\n",
+          (uint32_t)NUM_OBJECTS, stopAndWaitMs, LINK_BAUD, LINK_LATENCY_MS);
+  fprintf(stdout, "pipelined:     %u acked objects in %u ms (%.1fx faster)\n",
+          (uint32_t)NUM_OBJECTS, pipelinedMs, (double)stopAndWaitMs / pipelinedMs);
+
+  EXPECT_LT(pipelinedMs * 3, stopAndWaitMs);
+}
+
+TEST_F(UAVTalkLink, DirectOutputMatchesOutputStream) {
+  for (uint32_t i = 0; i < NUM_OBJECTS; i++)
+    fill(objects[i], 0, i);
+  for (uint16_t n = 0; n < MULTI_INSTANCES; n++)
+    fill(multi, n, 0x40 + n);
+  sendAll();
+  ASSERT_EQ(0, UAVTalkSendAck(tx, objects[0], 0));
+  std::vector<uint8_t> copied = linkBytes;
+  linkBytes.clear();
+  linkWrites = 0;
+
+  // Twice round, so the messages start everywhere in the ring
+  ASSERT_EQ(0, UAVTalkSetDirectOutputStream(tx, ringReserve, ringCommit));
+  ringWr = 0;
+  ringCommits = 0;
+  for (uint32_t round = 0; round < 2; round++) {
+    sendAll();
+    ASSERT_EQ(0, UAVTalkSendAck(tx, objects[0], 0));
+  }
+  ASSERT_EQ(2 * copied.size(), linkBytes.size());
+  EXPECT_TRUE(std::equal(copied.begin(), copied.end(), linkBytes.begin()));
+  EXPECT_TRUE(std::equal(copied.begin(), copied.end(), linkBytes.begin() + copied.size()));
+  EXPECT_EQ(0, (int32_t)linkWrites);
+  EXPECT_EQ(2 * (NUM_OBJECTS + MULTI_INSTANCES + 1), ringCommits);
+
+  UAVTalkStats stats;
+  UAVTalkGetStats(tx, &stats);
+  EXPECT_EQ(3 * copied.size(), stats.txBytes);
+
+  // Messages the port can not take still go through the output stream
+  linkBytes.clear();
+  ASSERT_EQ(0, UAVTalkSendObject(tx, large, 0, 0, 0));
+  EXPECT_EQ(1, (int32_t)linkWrites);
+  EXPECT_EQ(8 + LARGE_SIZE + 1, (int32_t)linkBytes.size());
+
+  UAVTalkSetDirectOutputStream(tx, NULL, NULL);
+}
+
+TEST_F(UAVTalkLink, BufferMatchesByteStream) {
+  for (uint32_t i = 0; i < NUM_OBJECTS; i++)
+    fill(objects[i], 0, i);
+  for (uint16_t n = 0; n < MULTI_INSTANCES; n++)
+    fill(multi, n, 0x40 + n);
+  fill(large, 0, 0x80);
+  sendAll();
+  ASSERT_EQ(0, UAVTalkSendObject(tx, large, 0, 0, 0));
+  uint32_t numFrames = frames().size();
+
+  // Chunks that split payloads, checksums and headers in every way
+  static const uint16_t chunkSizes[] = { 1, 3, 7, 32, 255, 0xffff };
+  for (uint32_t c = 0; c < sizeof(chunkSizes) / sizeof(chunkSizes[0]); c++) {
+    for (uint32_t i = 0; i < NUM_OBJECTS; i++)
+      fill(objects[i], 0, 0xff);
+    for (uint16_t n = 0; n < MULTI_INSTANCES; n++)
+      fill(multi, n, 0xff);
+    fill(large, 0, 0xff);
+
+    UAVTalkConnection bufRx = UAVTalkInitialize(NULL);
+    ASSERT_TRUE(bufRx != NULL);
+    uint32_t received = 0;
+    for (uint32_t offset = 0; offset < linkBytes.size(); offset += chunkSizes[c]) {
+      uint16_t len = linkBytes.size() - offset < chunkSizes[c] ? linkBytes.size() - offset : chunkSizes[c];
+      received += UAVTalkProcessInputBuffer(bufRx, &linkBytes[offset], len);
+    }
+    EXPECT_EQ(numFrames, received);
+
+    for (uint32_t i = 0; i < NUM_OBJECTS; i++)
+      EXPECT_TRUE(matches(objects[i], 0, i));
+    for (uint16_t n = 0; n < MULTI_INSTANCES; n++)
+      EXPECT_TRUE(matches(multi, n, 0x40 + n));
+    EXPECT_TRUE(matches(large, 0, 0x80));
+
+    UAVTalkStats stats;
+    UAVTalkGetStats(bufRx, &stats);
+    EXPECT_EQ(linkBytes.size(), stats.rxBytes);
+    EXPECT_EQ(numFrames, stats.rxObjects);
+    EXPECT_EQ(0, (int32_t)stats.rxErrors);
+  }
+}
+
+TEST_F(UAVTalkLink, BufferDropsCorruptPayload) {
+  fill(objects[0], 0, 0x10);
+  ASSERT_EQ(0, UAVTalkSendObject(tx, objects[0], 0, 0, 0));
+  fill(objects[1], 0, 0x20);
+  ASSERT_EQ(0, UAVTalkSendObject(tx, objects[1], 0, 0, 0));
+  fill(objects[0], 0, 0xff);
+  fill(objects[1], 0, 0xff);
+
+  // Corrupt the payload of the first frame
+  linkBytes[10] ^= 0x55;
+  EXPECT_EQ(1, UAVTalkProcessInputBuffer(rx, &linkBytes[0], linkBytes.size()));
+
+  // The object is left alone, the frame after it still goes through
+  EXPECT_TRUE(matches(objects[0], 0, 0xff));
+  EXPECT_TRUE(matches(objects[1], 0, 0x20));
+  UAVTalkStats stats;
+  UAVTalkGetStats(rx, &stats);
+  EXPECT_EQ(1, (int32_t)stats.rxErrors);
+}
+
+TEST_F(UAVTalkLink, BufferThroughput) {
+  // A stream of the typical telemetry objects, as the rx task would read it
+  sendAll();
+  std::vector<uint8_t> round = linkBytes;
+  linkBytes.clear();
+  while (linkBytes.size() < RX_STREAM_BYTES)
+    linkBytes.insert(linkBytes.end(), round.begin(), round.end());
+  uint32_t numFrames = frames().size();
+
+  clock_t start = clock();
+  EXPECT_EQ(numFrames, receive());
+  double byteSeconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  // Chunks as large as the telemetry rx task reads
+  UAVTalkConnection bufRx = UAVTalkInitialize(NULL);
+  ASSERT_TRUE(bufRx != NULL);
+  uint32_t received = 0;
+  start = clock();
+  for (uint32_t offset = 0; offset < linkBytes.size(); offset += 32) {
+    uint16_t len = linkBytes.size() - offset < 32 ? linkBytes.size() - offset : 32;
+    received += UAVTalkProcessInputBuffer(bufRx, &linkBytes[offset], len);
+  }
+  double bufferSeconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+  EXPECT_EQ(numFrames, received);
+
+  fprintf(stdout, "byte stream: %.1f MB/s\n", linkBytes.size() / byteSeconds / 1e6);
+  fprintf(stdout, "32 byte chunks: %.1f MB/s (%.1fx)\n", linkBytes.size() / bufferSeconds / 1e6,
+          byteSeconds / bufferSeconds);
+
+  EXPECT_LT(bufferSeconds, byteSeconds);
+}
@@ -459,7 +459,7 @@ void Simulator::updateUAVOs(Output2Hardware out){
     groundTruthData.AngleOfSlip=out.angleOfSlip;
 
     groundTruthData.PositionNED[0]=out.dstN-initN;
-    groundTruthData.PositionNED[1]=out.dstE-initD;
+    groundTruthData.PositionNED[1]=out.dstE-initE;
     groundTruthData.PositionNED[2]=out.dstD-initD;
 
     groundTruthData.VelocityNED[0]=out.velNorth;
@@ -471,8 +471,8 @@ void Simulator::updateUAVOs(Output2Hardware out){
     groundTruthData.AccelerationXYZ[2]=out.accZ;
 
     groundTruthData.RPY[0]=out.roll;
-    groundTruthData.RPY[0]=out.pitch;
-    groundTruthData.RPY[0]=out.heading;
+    groundTruthData.RPY[1]=out.pitch;
+    groundTruthData.RPY[2]=out.heading;
 
     groundTruthData.AngularRates[0]=out.rollRate;
     groundTruthData.AngularRates[1]=out.pitchRate;
@@ -28,11 +28,13 @@
 #include <QMessageBox>
 #include <QTextStream>
 #include <QtGlobal>
+#include <QEventLoop>
 
 #include <coreplugin/coreconstants.h>
 #include "utils/coordinateconversions.h"
 #include "uavobjects/uavobjectsinit.h"
 #include "uavobjectmanager.h"
+#include "uavtalk/logbatchdecoder.h"
 
 // autogenerated version info string. MUST GO BEFORE coreconstants.h INCLUDE
 #include "../../../../../build/ground/gcs/gcsversioninfo.h"
@@ -53,12 +55,9 @@ KmlExport::KmlExport(QString inputLogFileName, QString outputKmlFileName) :
     logFile.setFileName(inputLogFileName);
 
     // Create new UAVObject manager and initialize it with all UAVObjects
-    UAVObjectManager *kmlUAVObjectManager = new UAVObjectManager;
+    kmlUAVObjectManager = new UAVObjectManager;
     UAVObjectsInitialize(kmlUAVObjectManager);
 
-    // Connect new UAVO manager to a UAVTalk instance
-    kmlTalk = new UAVTalk(&logFile, kmlUAVObjectManager);
-
     // Get the UAVObjects
     airspeedActual = AirspeedActual::GetInstance(kmlUAVObjectManager);
     attitudeActual = AttitudeActual::GetInstance(kmlUAVObjectManager);
@@ -118,16 +117,28 @@ bool KmlExport::exportToKML()
         return false;
     }
 
-    // Parses logfile and generates KML document
-    ret = preparseLogFile();
-    if (!ret) {
-        qDebug () << "Logfile preparsing failed";
+    // The header has been checked, the decoder maps the file by itself
+    stopExport();
+
+    // Decode the whole log on a worker thread. The UAVObject updates reach the
+    // slots connected in the constructor on that thread, and generate the KML.
+    LogBatchDecoder decoder(logFile.fileName(), kmlUAVObjectManager);
+    QEventLoop loop;
+    connect(&decoder, SIGNAL(finished()), &loop, SLOT(quit()));
+    decoder.start();
+    loop.exec(QEventLoop::ExcludeUserInputEvents);
+    decoder.wait();
+
+    //Check if any packets were successfully read
+    if (!decoder.getSuccess() || decoder.getPacketCount() == 0) {
+        QMessageBox msgBox;
+        msgBox.setText("Empty logfile.");
+        msgBox.setInformativeText("No log data can be found.");
+        msgBox.exec();
+
         return false;
     }
 
-    // Call parser.
-    parseLogFile();
-
     // Add track to <Document>
     document->add_feature(trackFolder);
 
@@ -261,70 +272,6 @@ bool KmlExport::open()
 }
 
 
-/**
- * @brief KmlExport::preparseLogFile Ensures that the logfile has data to export
- * @return Returns true if the logfile has data, false otherwise
- */
-bool KmlExport::preparseLogFile()
-{
-    //Read all log timestamps into array
-    timestampBuffer.clear(); //Save beginning of log for later use
-    timestampPos.clear();
-    quint64 logFileStartIdx = logFile.pos();
-    quint32 lastTimeStamp = 0;
-
-    while (!logFile.atEnd()){
-        qint64 dataSize;
-
-        //Get time stamp position
-        timestampPos.append(logFile.pos());
-
-        //Read timestamp and logfile packet size
-        logFile.read((char *) &lastTimeStamp, sizeof(lastTimeStamp));
-        logFile.read((char *) &dataSize, sizeof(dataSize));
-
-        //Check if dataSize sync bytes are correct.
-        //TODO: LIKELY AS NOT, THIS WILL FAIL TO RESYNC BECAUSE THERE IS TOO LITTLE INFORMATION IN THE STRING OF SIX 0x00
-        if ((dataSize & 0xFFFFFFFFFFFF0000)!=0){
-            qDebug() << "Wrong sync byte. At file location 0x"  << QString("%1").arg(logFile.pos(),0,16) << "Got 0x" << QString("%1").arg(dataSize & 0xFFFFFFFFFFFF0000,0,16) << ", but expected 0x""00"".";
-            logFile.seek(timestampPos.last()+1);
-            timestampPos.pop_back();
-            continue;
-        }
-
-        //Check if timestamps are sequential.
-        if (!timestampBuffer.isEmpty() && lastTimeStamp < timestampBuffer.last()){
-            QMessageBox msgBox;
-            msgBox.setText("Corrupted file.");
-            msgBox.setInformativeText("Timestamps are not sequential. Playback may have unexpected behavior"); //<--TODO: add hyperlink to webpage with better description.
-            msgBox.exec();
-
-            qDebug() << "Timestamp: " << timestampBuffer.last() << " " << lastTimeStamp;
-        }
-
-        timestampBuffer.append(lastTimeStamp);
-
-        logFile.seek(timestampPos.last()+sizeof(lastTimeStamp)+sizeof(dataSize)+dataSize);
-    }
-
-    //Check if any timestamps were successfully read
-    if (timestampBuffer.size() == 0){
-        QMessageBox msgBox;
-        msgBox.setText("Empty logfile.");
-        msgBox.setInformativeText("No log data can be found.");
-        msgBox.exec();
-
-        stopExport();
-        return false;
-    }
-
-    //Reset to log beginning, including the timestamp.
-    logFile.seek(logFileStartIdx);
-
-    return true;
-}
-
-
 /**
  * @brief KmlExport::stopExport Called to stop the export. Currently only closes
  * the logfile
@@ -337,53 +284,6 @@ bool KmlExport::stopExport()
 }
 
 
-/**
- * @brief KmlExport::parseLogFile Parses logfile and exports results to KML file
- */
-void KmlExport::parseLogFile()
-{
-    qint64 packetSize;
-    quint32 timeStampIdx;
-
-    //Read packets
-    while (!logFile.atEnd())
-    {
-        if(logFile.bytesAvailable() < 4) {
-            break;
-        }
-
-        //Read timestamp and logfile packet size
-        logFile.read((char *) &timeStamp, sizeof(timeStamp));
-        logFile.read((char *) &packetSize, sizeof(packetSize));
-
-        if (packetSize<1 || packetSize>(1024*1024)) {
-            qDebug() << "Error: Logfile corrupted! Unlikely packet size: " << packetSize << "\n";
-            QMessageBox::critical(new QWidget(),"Corrupted file", "Incorrect packet size. Stopping export. Data up to this point will be saved.");
-
-            break;
-        }
-
-        if(logFile.bytesAvailable() < packetSize) {
-            break;
-        }
-
-        // Read the data packet from the file.
-        QByteArray dataBuffer;
-        dataBuffer.append(logFile.read(packetSize));
-
-        // Parse the packet. This operation passes the data to the kmlTalk object, which internally parses the data
-        // and then emits objectUpdated(UAVObject *) signals. These signals are connected to in the KmlExport constructor.
-        for (int i=0; i < dataBuffer.size(); i++) {
-            kmlTalk->processInputByte(dataBuffer[i]);
-        }
-
-        timeStampIdx++;
-    }
-
-    stopExport();
-}
-
-
 /**
  * @brief KmlExport::createCustomBalloonStyle Creates a custom balloon stye, using an arrow as an icon.
  * @return Returns the custom balloon style.
@@ -773,11 +673,12 @@ kmlbase::Color32 KmlExport::mapVelocity2Color(double velocity, quint8 alpha)
  * @brief KmlExport::positionActualUpdated Triggers on PositionActual UAVO
  * update. Converts position to latitude-longitude-altitude and then
  * creates new placemarks.
- * @param obj Unused
+ * @param obj PositionActual
  */
 void KmlExport::positionActualUpdated(UAVObject *obj)
 {
-    Q_UNUSED(obj);
+    // Time the packet was logged
+    timeStamp = obj->getTimestamp();
 
     // Only export positional data if the home location has been set.
     if (homeLocationData.Set == HomeLocation::SET_FALSE)
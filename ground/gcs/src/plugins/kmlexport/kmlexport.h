@@ -74,7 +74,6 @@ public:
     bool open();
     void setFileName(QString name) { logFile.setFileName(name); }
 
-    bool preparseLogFile();
     bool stopExport();
     bool exportToKML();
 
@@ -92,10 +91,7 @@ protected:
     QFile logFile;
 
 private:
-    QList<quint32> timestampBuffer;
-    QList<quint32> timestampPos;
-
-    UAVTalk *kmlTalk;
+    UAVObjectManager *kmlUAVObjectManager;
 
     AirspeedActual *airspeedActual;
     AttitudeActual *attitudeActual;
@@ -120,7 +116,6 @@ private:
     QVector<CoordinatesPtr> wallAxes;
     static QString dateTimeFormat;
 
-    void parseLogFile();
     StylePtr createGroundTrackStyle();
     StyleMapPtr createWallAxesStyle();
     StyleMapPtr createCustomBalloonStyle();
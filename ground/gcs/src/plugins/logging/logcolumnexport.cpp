@@ -0,0 +1,296 @@
+/**
+ ******************************************************************************
+ *
+ * @file       logcolumnexport.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @see        The GNU Public License (GPL) Version 3
+ * @brief      Exports a GCS log as one column file per UAVObject
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup   Logging
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "logcolumnexport.h"
+#include <QDebug>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QMap>
+#include <QJsonDocument>
+#include <QtEndian>
+#include "uavobjects/uavobjectsinit.h"
+#include "uavdataobject.h"
+#include "uavtalk/logbatchdecoder.h"
+
+LogColumnExport::LogColumnExport(const QString &logFileName, const QString &outputDir, QObject *parent) :
+    QObject(parent),
+    logFileName(logFileName),
+    outputDir(outputDir)
+{
+    // Decode into a private set of objects, so the export neither disturbs nor
+    // is disturbed by the objects of a connected board
+    objMngr = new UAVObjectManager;
+    UAVObjectsInitialize(objMngr);
+
+    // The decoder emits the updates from its own thread, capture them there
+    foreach (QVector<UAVDataObject*> list, objMngr->getDataObjectsVector()) {
+        foreach (UAVDataObject *obj, list)
+            connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(objectUpdated(UAVObject*)), Qt::DirectConnection);
+    }
+    connect(objMngr, SIGNAL(newInstance(UAVObject*)), this, SLOT(newInstance(UAVObject*)), Qt::DirectConnection);
+}
+
+LogColumnExport::~LogColumnExport()
+{
+    clearRows();
+    delete objMngr;
+}
+
+/**
+ * @brief LogColumnExport::exportColumns Decodes the log and writes the column
+ * files and schema.json to the output directory.
+ * @return true on success, otherwise see @ref getErrorString
+ */
+bool LogColumnExport::exportColumns()
+{
+    if (!outputDir.exists() && !outputDir.mkpath(".")) {
+        errorString = tr("Unable to create %0").arg(outputDir.path());
+        return false;
+    }
+
+    clearRows();
+
+    LogBatchDecoder decoder(logFileName, objMngr);
+    QEventLoop loop;
+    connect(&decoder, SIGNAL(finished()), &loop, SLOT(quit()));
+    decoder.start();
+    loop.exec(QEventLoop::ExcludeUserInputEvents);
+    decoder.wait();
+
+    if (!decoder.getSuccess() || decoder.getPacketCount() == 0) {
+        errorString = tr("No log data can be found in %0").arg(logFileName);
+        clearRows();
+        return false;
+    }
+
+    // Write the objects sorted by name, so the schema is easy to browse
+    QMap<QString, quint32> byName;
+    foreach (quint32 objId, objects.keys())
+        if (objects[objId].rowCount > 0)
+            byName.insert(objects[objId].obj->getName(), objId);
+
+    QJsonArray schemaObjects;
+    foreach (quint32 objId, byName.values()) {
+        QJsonObject objSchema;
+        if (!writeColumns(objects[objId], objSchema)) {
+            clearRows();
+            return false;
+        }
+        schemaObjects.append(objSchema);
+    }
+    clearRows();
+
+    QJsonObject schema;
+    schema["log"] = QFileInfo(logFileName).fileName();
+    schema["byteOrder"] = QString("little");
+    schema["alignment"] = 8;
+    schema["objects"] = schemaObjects;
+
+    QFile schemaFile(outputDir.filePath("schema.json"));
+    if (!schemaFile.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+            schemaFile.write(QJsonDocument(schema).toJson()) < 0) {
+        errorString = tr("Unable to write %0").arg(schemaFile.fileName());
+        return false;
+    }
+
+    qDebug() << "Exported" << schemaObjects.size() << "objects from" << decoder.getPacketCount()
+             << "packets to" << outputDir.path();
+    return true;
+}
+
+/**
+ * Instances created while decoding are new objects, follow their updates too
+ */
+void LogColumnExport::newInstance(UAVObject *obj)
+{
+    connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(objectUpdated(UAVObject*)), Qt::DirectConnection);
+}
+
+/**
+ * Appends the object to the row file of its type: timestamp, instance and the
+ * packed object data, which is already little endian
+ */
+void LogColumnExport::objectUpdated(UAVObject *obj)
+{
+    QHash<quint32, ObjectRows>::iterator it = objects.find(obj->getObjID());
+    if (it == objects.end()) {
+        ObjectRows rows;
+        rows.file = new QFile(outputDir.filePath(obj->getName() + ".rows"));
+        rows.obj = obj;
+        rows.rowCount = 0;
+        rows.rowSize = ROW_HEADER_SIZE + obj->getNumBytes();
+        if (!rows.file->open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+            qDebug() << "Unable to open" << rows.file->fileName();
+            delete rows.file;
+            return;
+        }
+        it = objects.insert(obj->getObjID(), rows);
+    }
+
+    ObjectRows &rows = it.value();
+    rowBuffer.resize(rows.rowSize);
+    uchar *row = reinterpret_cast<uchar *>(rowBuffer.data());
+    qToLittleEndian<quint32>(obj->getTimestamp(), row);
+    qToLittleEndian<quint16>(obj->getInstID(), row + sizeof(quint32));
+    obj->pack(row + ROW_HEADER_SIZE);
+
+    if (rows.file->write(rowBuffer) == rowBuffer.size())
+        rows.rowCount++;
+}
+
+/**
+ * Transposes the rows of one object into its column file and describes the
+ * columns in @p schema
+ */
+bool LogColumnExport::writeColumns(ObjectRows &rows, QJsonObject &schema)
+{
+    UAVObject *obj = rows.obj;
+
+    rows.file->flush();
+    uchar *rowData = rows.file->map(0, (qint64)rows.rowCount * rows.rowSize);
+    if (rowData == NULL) {
+        errorString = tr("Unable to map %0").arg(rows.file->fileName());
+        return false;
+    }
+
+    QFile out(outputDir.filePath(obj->getName() + ".col"));
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        errorString = tr("Unable to write %0").arg(out.fileName());
+        rows.file->unmap(rowData);
+        return false;
+    }
+
+    QJsonArray columns;
+    QJsonObject column;
+
+    column["name"] = QString("timestamp");
+    column["type"] = QString("uint32");
+    column["units"] = QString("ms");
+    appendColumn(out, rowData, rows, 0, sizeof(quint32), column, columns);
+
+    if (!obj->isSingleInstance()) {
+        column = QJsonObject();
+        column["name"] = QString("instance");
+        column["type"] = QString("uint16");
+        appendColumn(out, rowData, rows, sizeof(quint32), sizeof(quint16), column, columns);
+    }
+
+    static const char *typeNames[] = { "int8", "int16", "int32", "uint8", "uint16",
+                                       "uint32", "float32", "uint8", "bitfield", "string" };
+
+    quint32 fieldOffset = ROW_HEADER_SIZE;
+    foreach (UAVObjectField *field, obj->getFields()) {
+        UAVObjectField::FieldType type = field->getType();
+
+        column = QJsonObject();
+        column["type"] = QString(typeNames[type]);
+        if (!field->getUnits().isEmpty())
+            column["units"] = field->getUnits();
+        if (type == UAVObjectField::ENUM)
+            column["options"] = QJsonArray::fromStringList(field->getOptions());
+
+        if (type == UAVObjectField::BITFIELD || type == UAVObjectField::STRING) {
+            // Packed bits and characters only make sense as a whole
+            column["name"] = field->getName();
+            column["elements"] = (int)field->getNumElements();
+            appendColumn(out, rowData, rows, fieldOffset, field->getNumBytes(), column, columns);
+        } else {
+            quint32 numElements = field->getNumElements();
+            quint32 elementSize = field->getNumBytes() / numElements;
+            QStringList elementNames = field->getElementNames();
+            for (quint32 n = 0; n < numElements; ++n) {
+                if (numElements == 1)
+                    column["name"] = field->getName();
+                else
+                    column["name"] = field->getName() + "." + elementNames.value(n, QString::number(n));
+                appendColumn(out, rowData, rows, fieldOffset + n * elementSize, elementSize, column, columns);
+            }
+        }
+        fieldOffset += field->getNumBytes();
+    }
+
+    rows.file->unmap(rowData);
+
+    schema["name"] = obj->getName();
+    schema["id"] = QString("0x%0").arg(obj->getObjID(), 8, 16, QChar('0'));
+    schema["rows"] = (int)rows.rowCount;
+    schema["file"] = QFileInfo(out.fileName()).fileName();
+    schema["size"] = (double)out.size();
+    schema["columns"] = columns;
+
+    if (out.error() != QFile::NoError) {
+        errorString = tr("Unable to write %0").arg(out.fileName());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Gathers the @p size bytes at @p rowOffset of every row into one column,
+ * aligned to 8 bytes in @p out
+ */
+void LogColumnExport::appendColumn(QFile &out, const uchar *rowData, const ObjectRows &rows,
+                                   quint32 rowOffset, quint32 size, QJsonObject column, QJsonArray &columns)
+{
+    qint64 padding = (8 - out.pos() % 8) % 8;
+    if (padding > 0)
+        out.write(QByteArray(padding, 0));
+
+    column["offset"] = (double)out.pos();
+    column["size"] = (int)size;
+
+    QByteArray data(rows.rowCount * size, Qt::Uninitialized);
+    char *dst = data.data();
+    const uchar *src = rowData + rowOffset;
+    for (quint32 i = 0; i < rows.rowCount; ++i) {
+        memcpy(dst, src, size);
+        dst += size;
+        src += rows.rowSize;
+    }
+    out.write(data);
+
+    columns.append(column);
+}
+
+/**
+ * Closes and removes the staged rows
+ */
+void LogColumnExport::clearRows()
+{
+    foreach (ObjectRows rows, objects) {
+        rows.file->remove();
+        delete rows.file;
+    }
+    objects.clear();
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,95 @@
+/**
+ ******************************************************************************
+ *
+ * @file       logcolumnexport.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @see        The GNU Public License (GPL) Version 3
+ * @brief      Exports a GCS log as one column file per UAVObject
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup   Logging
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef LOGCOLUMNEXPORT_H
+#define LOGCOLUMNEXPORT_H
+
+#include <QObject>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include "uavobjectmanager.h"
+
+/**
+ * Exports a GCS log (.tll) to a directory of column files, one per UAVObject
+ * type that appears in the log.
+ *
+ * Each <ObjectName>.col file holds the columns of that object back to back:
+ * a uint32 timestamp column (ms since the start of the log), a uint16 instance
+ * column for multi-instance objects, then one column per field element. Every
+ * column starts on an 8 byte boundary and holds one little endian value per
+ * row, so a reader can memory map the file and use each column in place.
+ * The columns, their types and offsets are described in schema.json.
+ */
+class LogColumnExport : public QObject
+{
+    Q_OBJECT
+
+public:
+    LogColumnExport(const QString &logFileName, const QString &outputDir, QObject *parent = 0);
+    ~LogColumnExport();
+
+    bool exportColumns();
+    QString getErrorString() { return errorString; }
+
+private slots:
+    void newInstance(UAVObject *obj);
+    void objectUpdated(UAVObject *obj);
+
+private:
+    //! Row-major staging of the updates of one object type
+    struct ObjectRows {
+        QFile *file;
+        UAVObject *obj;
+        quint32 rowCount;
+        quint32 rowSize;
+    };
+
+    static const quint32 ROW_HEADER_SIZE = sizeof(quint32) + sizeof(quint16);
+
+    bool writeColumns(ObjectRows &rows, QJsonObject &schema);
+    void appendColumn(QFile &out, const uchar *rowData, const ObjectRows &rows,
+                      quint32 rowOffset, quint32 size, QJsonObject column, QJsonArray &columns);
+    void clearRows();
+
+    QString logFileName;
+    QDir outputDir;
+    QString errorString;
+    UAVObjectManager *objMngr;
+    QHash<quint32, ObjectRows> objects;
+    QByteArray rowBuffer;
+};
+
+#endif // LOGCOLUMNEXPORT_H
+
+/**
+ * @}
+ * @}
+ */
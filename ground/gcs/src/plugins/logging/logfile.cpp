@@ -29,6 +29,7 @@
 #include <QDebug>
 #include <QtGlobal>
 #include <QTextStream>
+#include <string.h>
  #include <QMessageBox>
 
 // autogenerated version info string. MUST GO BEFORE coreconstants.h INCLUDE
@@ -36,9 +37,16 @@
 
 #include <coreplugin/coreconstants.h>
 
+const char LogFile::INDEX_MAGIC[8] = {'T', 'L', 'L', 'I', 'N', 'D', 'E', 'X'};
+
 LogFile::LogFile(QObject *parent) :
     QIODevice(parent),
-    timestampBufferIdx(0)
+    indexChunkSize(INDEX_CHUNK_SIZE),
+    dataStart(0),
+    dataEnd(0),
+    nextRecordPos(0),
+    firstTimestamp(0),
+    replayEpoch(0)
 {
     connect(&timer, SIGNAL(timeout()), this, SLOT(timerFired()));
 }
@@ -84,6 +92,9 @@ bool LogFile::open(OpenMode mode) {
         QTextStream out(&file);
 
         out << "Tau Labs git hash:\n" <<  gitHash << "\n" << uavoHash << "\n##\n";
+
+        index.clear();
+        indexChunkSize = INDEX_CHUNK_SIZE;
     }
     else if(mode == QIODevice::ReadOnly)
     {
@@ -144,6 +155,8 @@ void LogFile::close()
 
     if (timer.isActive())
         timer.stop();
+    if (file.isOpen() && file.isWritable())
+        writeIndex();
     file.close();
     QIODevice::close();
 }
@@ -154,6 +167,8 @@ qint64 LogFile::writeData(const char * data, qint64 dataSize) {
 
     quint32 timeStamp = myTime.elapsed();
 
+    addIndexEntry(timeStamp, file.pos());
+
     file.write((char *) &timeStamp,sizeof(timeStamp));
     file.write((char *) &dataSize, sizeof(dataSize));
 
@@ -181,57 +196,43 @@ void LogFile::timerFired()
 {
     qint64 dataSize;
 
-    if(file.bytesAvailable() > 4)
-    {
-
-        int time;
-        time = myTime.elapsed();
-
-        //Read packets
-        while ((lastPlayTime + ((time - lastPlayTimeOffset)* playbackSpeed) > (lastTimeStamp-firstTimestamp)))
-        {
-            lastPlayTime += ((time - lastPlayTimeOffset)* playbackSpeed);
-            if(file.bytesAvailable() < 4) {
-                stopReplay();
-                return;
-            }
-
-            file.seek(lastTimeStampPos+sizeof(lastTimeStamp));
+    int time;
+    time = myTime.elapsed();
 
-            file.read((char *) &dataSize, sizeof(dataSize));
+    //Read packets
+    while ((lastPlayTime + ((time - lastPlayTimeOffset)* playbackSpeed) > (lastTimeStamp-firstTimestamp)))
+    {
+        lastPlayTime += ((time - lastPlayTimeOffset)* playbackSpeed);
 
-            if (dataSize<1 || dataSize>(1024*1024)) {
-                qDebug() << "Error: Logfile corrupted! Unlikely packet size: " << dataSize << "\n";
-                stopReplay();
-                return;
-            }
-            if(file.bytesAvailable() < dataSize) {
-                stopReplay();
-                return;
-            }
+        file.seek(nextRecordPos+sizeof(lastTimeStamp));
 
-            mutex.lock();
-            dataBuffer.append(file.read(dataSize));
-            mutex.unlock();
-            emit readyRead();
+        file.read((char *) &dataSize, sizeof(dataSize));
 
-            if(file.bytesAvailable() < 4) {
-                stopReplay();
-                return;
-            }
+        if (dataSize<1 || dataSize>(1024*1024)) {
+            qDebug() << "Error: Logfile corrupted! Unlikely packet size: " << dataSize << "\n";
+            stopReplay();
+            return;
+        }
 
-            lastTimeStampPos = timestampPos[timestampBufferIdx];
-            lastTimeStamp = timestampBuffer[timestampBufferIdx];
-            timestampBufferIdx++;
+        mutex.lock();
+        dataBuffer.append(file.read(dataSize));
+        mutex.unlock();
 
-            lastPlayTimeOffset = time;
-            time = myTime.elapsed();
+        // Stamp the objects with the time they were logged, not the
+        // time they are replayed, so the replay speed doesn't matter
+        emit receiveTimestamp(replayEpoch + lastTimeStamp);
+        emit readyRead();
 
+        // Move on to the next packet, which also reads its timestamp
+        nextRecordPos += sizeof(lastTimeStamp) + sizeof(dataSize) + dataSize;
+        if (!findRecord(nextRecordPos, lastTimeStamp, dataSize)) {
+            stopReplay();
+            return;
         }
-    } else {
-        stopReplay();
-    }
 
+        lastPlayTimeOffset = time;
+        time = myTime.elapsed();
+    }
 }
 
 bool LogFile::startReplay() {
@@ -241,49 +242,20 @@ bool LogFile::startReplay() {
     lastPlayTime = 0;
     playbackSpeed = 1;
 
-    //Read all log timestamps into array
-    timestampBuffer.clear(); //Save beginning of log for later use
-    timestampPos.clear();
-    quint64 logFileStartIdx = file.pos();
-    timestampBufferIdx = 0;
-    lastTimeStamp = 0;
-
-    while (!file.atEnd()){
-        qint64 dataSize;
-
-        //Get time stamp position
-        timestampPos.append(file.pos());
-
-        //Read timestamp and logfile packet size
-        file.read((char *) &lastTimeStamp, sizeof(lastTimeStamp));
-        file.read((char *) &dataSize, sizeof(dataSize));
-
-        //Check if dataSize sync bytes are correct.
-        //TODO: LIKELY AS NOT, THIS WILL FAIL TO RESYNC BECAUSE THERE IS TOO LITTLE INFORMATION IN THE STRING OF SIX 0x00
-        if ((dataSize & 0xFFFFFFFFFFFF0000)!=0){
-            qDebug() << "Wrong sync byte. At file location 0x"  << QString("%1").arg(file.pos(),0,16) << "Got 0x" << QString("%1").arg(dataSize & 0xFFFFFFFFFFFF0000,0,16) << ", but expected 0x""00"".";
-            file.seek(timestampPos.last()+1);
-            timestampPos.pop_back();
-            continue;
-        }
-
-        //Check if timestamps are sequential.
-        if (!timestampBuffer.isEmpty() && lastTimeStamp < timestampBuffer.last()){
-            QMessageBox msgBox;
-            msgBox.setText("Corrupted file.");
-            msgBox.setInformativeText("Timestamps are not sequential. Playback may have unexpected behavior"); //<--TODO: add hyperlink to webpage with better description.
-            msgBox.exec();
-
-            qDebug() << "Timestamp: " << timestampBuffer.last() << " " << lastTimeStamp;
-        }
-
-        timestampBuffer.append(lastTimeStamp);
+    // Packets start right after the header, which open() has skipped
+    dataStart = file.pos();
+    dataEnd = file.size();
 
-        file.seek(timestampPos.last()+sizeof(lastTimeStamp)+sizeof(dataSize)+dataSize);
+    // Use the index stored in the log or next to it, and only scan the whole
+    // file if neither exists
+    if (!loadIndex() && !loadSidecarIndex()) {
+        buildIndex();
+        if (!index.isEmpty())
+            writeSidecarIndex();
     }
 
     //Check if any timestamps were successfully read
-    if (timestampBuffer.size() == 0){
+    if (index.isEmpty()){
         QMessageBox msgBox;
         msgBox.setText("Empty logfile.");
         msgBox.setInformativeText("No log data can be found.");
@@ -294,11 +266,11 @@ bool LogFile::startReplay() {
     }
 
     //Reset to log beginning.
-    file.seek(logFileStartIdx+sizeof(lastTimeStamp));
-    lastTimeStampPos = timestampPos[0];
-    lastTimeStamp = timestampBuffer[0];
-    firstTimestamp = timestampBuffer[0];
-    timestampBufferIdx = 1;
+    qint64 dataSize;
+    nextRecordPos = index[0].offset;
+    findRecord(nextRecordPos, lastTimeStamp, dataSize);
+    firstTimestamp = lastTimeStamp;
+    replayEpoch = UAVObject::currentTimestamp() - firstTimestamp;
 
     timer.setInterval(10);
     timer.start();
@@ -329,17 +301,258 @@ void LogFile::resumeReplay()
  */
 void LogFile::setReplayTime(double val)
 {
-    quint32 tmpIdx=0;
-    while(timestampBuffer[tmpIdx++] <= val*1000 && tmpIdx <= timestampBufferIdx){
+    if (index.isEmpty())
+        return;
+
+    quint32 target = val*1000;
+
+    // Binary search for the last chunk starting at or before the target...
+    int low = 0;
+    int high = index.size();
+    while (high - low > 1) {
+        int middle = (low + high) / 2;
+        if (index[middle].timestamp <= target)
+            low = middle;
+        else
+            high = middle;
     }
 
-    lastTimeStampPos=timestampPos[tmpIdx];
-    lastTimeStamp=timestampBuffer[tmpIdx];
-    timestampBufferIdx=tmpIdx;
+    // ...and walk its packet headers to the first packet at the target
+    qint64 pos = index[low].offset;
+    quint32 timestamp;
+    qint64 dataSize;
+    while (findRecord(pos, timestamp, dataSize) && timestamp < target)
+        pos += sizeof(timestamp) + sizeof(dataSize) + dataSize;
+
+    if (!findRecord(pos, timestamp, dataSize))
+        return;
+
+    nextRecordPos = pos;
+    lastTimeStamp = timestamp;
 
     lastPlayTimeOffset = myTime.elapsed();
-    lastPlayTime=lastTimeStamp;
+    lastPlayTime = lastTimeStamp - firstTimestamp;
 
     qDebug() << "Replaying at: " << lastTimeStamp << ", but requestion at" << val*1000;
 }
 
+/**
+ * @brief LogFile::findRecord Finds the first packet at or after a file offset,
+ * skipping over bytes that do not look like a packet header
+ * @param pos Offset to start from, moved to the packet found
+ * @param timestamp Timestamp of the packet found
+ * @param dataSize Size of the packet found
+ * @return true if a packet was found before the end of the packet data
+ */
+bool LogFile::findRecord(qint64 &pos, quint32 &timestamp, qint64 &dataSize)
+{
+    const qint64 headerSize = sizeof(timestamp) + sizeof(dataSize);
+
+    while (dataEnd - pos >= headerSize) {
+        // Stop if the file was closed while replaying
+        if (!file.seek(pos) ||
+                file.read((char *) &timestamp, sizeof(timestamp)) != sizeof(timestamp) ||
+                file.read((char *) &dataSize, sizeof(dataSize)) != sizeof(dataSize))
+            return false;
+
+        //Check if dataSize sync bytes are correct.
+        //TODO: LIKELY AS NOT, THIS WILL FAIL TO RESYNC BECAUSE THERE IS TOO LITTLE INFORMATION IN THE STRING OF SIX 0x00
+        if ((dataSize & 0xFFFFFFFFFFFF0000) == 0 && dataSize > 0 && dataEnd - pos - headerSize >= dataSize)
+            return true;
+
+        qDebug() << "Wrong sync byte. At file location 0x"  << QString("%1").arg(pos,0,16) << "Got 0x" << QString("%1").arg(dataSize & 0xFFFFFFFFFFFF0000,0,16) << ", but expected 0x""00"".";
+        pos++;
+    }
+
+    return false;
+}
+
+/**
+ * @brief LogFile::addIndexEntry Indexes a packet if it starts a new chunk. When
+ * the index is full every other entry is dropped and the chunks get twice as large.
+ */
+void LogFile::addIndexEntry(quint32 timestamp, qint64 offset)
+{
+    if (!index.isEmpty() && offset - index.last().offset < indexChunkSize)
+        return;
+
+    if (index.size() >= MAX_INDEX_ENTRIES) {
+        for (int i = 0; i < index.size() / 2; i++)
+            index[i] = index[2 * i];
+        index.resize(index.size() / 2);
+        indexChunkSize *= 2;
+
+        if (offset - index.last().offset < indexChunkSize)
+            return;
+    }
+
+    IndexEntry entry = {timestamp, offset};
+    index.append(entry);
+}
+
+/**
+ * @brief LogFile::loadIndex Reads the index stored at the end of the log
+ * @return true if the log has a valid index
+ */
+bool LogFile::loadIndex()
+{
+    index.clear();
+
+    // Footer: offset of the index packet, number of entries, magic
+    qint64 recordPos;
+    quint32 count;
+    char magic[sizeof(INDEX_MAGIC)];
+    const qint64 footerSize = sizeof(recordPos) + sizeof(count) + sizeof(magic);
+    const qint64 entrySize = sizeof(quint32) + sizeof(qint64);
+
+    if (file.size() - dataStart < footerSize)
+        return false;
+
+    file.seek(file.size() - footerSize);
+    file.read((char *) &recordPos, sizeof(recordPos));
+    file.read((char *) &count, sizeof(count));
+    file.read(magic, sizeof(magic));
+
+    if (memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0)
+        return false;
+
+    // The index is the payload of the last packet
+    const qint64 headerSize = sizeof(quint32) + sizeof(qint64);
+    if (count == 0 || count > MAX_INDEX_ENTRIES || recordPos < dataStart ||
+            recordPos + headerSize + count * entrySize + footerSize != file.size())
+        return false;
+
+    file.seek(recordPos + headerSize);
+    index.resize(count);
+    for (quint32 i = 0; i < count; i++) {
+        file.read((char *) &index[i].timestamp, sizeof(index[i].timestamp));
+        file.read((char *) &index[i].offset, sizeof(index[i].offset));
+    }
+
+    dataEnd = recordPos;
+    return true;
+}
+
+/**
+ * @brief LogFile::loadSidecarIndex Reads the index built for a log without one
+ * @return true if a sidecar index exists and matches the log
+ */
+bool LogFile::loadSidecarIndex()
+{
+    index.clear();
+
+    QFile sidecar(file.fileName() + ".idx");
+    if (!sidecar.open(QIODevice::ReadOnly))
+        return false;
+
+    char magic[sizeof(INDEX_MAGIC)];
+    qint64 logSize;
+    quint32 count;
+
+    sidecar.read(magic, sizeof(magic));
+    sidecar.read((char *) &logSize, sizeof(logSize));
+    sidecar.read((char *) &count, sizeof(count));
+
+    // A log that changed since the index was built is scanned again
+    const qint64 entrySize = sizeof(quint32) + sizeof(qint64);
+    if (memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0 || logSize != file.size() ||
+            sidecar.bytesAvailable() != count * entrySize)
+        return false;
+
+    index.resize(count);
+    for (quint32 i = 0; i < count; i++) {
+        sidecar.read((char *) &index[i].timestamp, sizeof(index[i].timestamp));
+        sidecar.read((char *) &index[i].offset, sizeof(index[i].offset));
+    }
+
+    return !index.isEmpty() && index[0].offset >= dataStart;
+}
+
+/**
+ * @brief LogFile::buildIndex Scans all packet headers of a log without an index
+ */
+void LogFile::buildIndex()
+{
+    index.clear();
+    indexChunkSize = INDEX_CHUNK_SIZE;
+
+    qint64 pos = dataStart;
+    quint32 timestamp;
+    quint32 previousTimestamp = 0;
+    qint64 dataSize;
+    bool warned = false;
+
+    while (findRecord(pos, timestamp, dataSize)) {
+        //Check if timestamps are sequential.
+        if (!index.isEmpty() && timestamp < previousTimestamp){
+            qDebug() << "Timestamp: " << previousTimestamp << " " << timestamp;
+
+            if (!warned) {
+                QMessageBox msgBox;
+                msgBox.setText("Corrupted file.");
+                msgBox.setInformativeText("Timestamps are not sequential. Playback may have unexpected behavior"); //<--TODO: add hyperlink to webpage with better description.
+                msgBox.exec();
+                warned = true;
+            }
+        }
+
+        addIndexEntry(timestamp, pos);
+        previousTimestamp = timestamp;
+
+        pos += sizeof(timestamp) + sizeof(dataSize) + dataSize;
+    }
+}
+
+/**
+ * @brief LogFile::writeSidecarIndex Saves the index of a log without one next
+ * to it, so the log is only scanned once. Failure is harmless.
+ */
+void LogFile::writeSidecarIndex()
+{
+    QFile sidecar(file.fileName() + ".idx");
+    if (!sidecar.open(QIODevice::WriteOnly))
+        return;
+
+    qint64 logSize = file.size();
+    quint32 count = index.size();
+
+    sidecar.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    sidecar.write((char *) &logSize, sizeof(logSize));
+    sidecar.write((char *) &count, sizeof(count));
+    foreach (const IndexEntry &entry, index) {
+        sidecar.write((char *) &entry.timestamp, sizeof(entry.timestamp));
+        sidecar.write((char *) &entry.offset, sizeof(entry.offset));
+    }
+}
+
+/**
+ * @brief LogFile::writeIndex Appends the index to a log being recorded. The
+ * index is written as one more packet, so older GCS versions still replay the
+ * log and hand the index to UAVTalk, which discards it as noise. A fixed size
+ * footer at the end of the file points back at it.
+ */
+void LogFile::writeIndex()
+{
+    if (index.isEmpty())
+        return;
+
+    quint32 timeStamp = myTime.elapsed();
+    qint64 recordPos = file.pos();
+    quint32 count = index.size();
+    qint64 dataSize = count * (sizeof(quint32) + sizeof(qint64)) +
+            sizeof(recordPos) + sizeof(count) + sizeof(INDEX_MAGIC);
+
+    file.write((char *) &timeStamp, sizeof(timeStamp));
+    file.write((char *) &dataSize, sizeof(dataSize));
+
+    foreach (const IndexEntry &entry, index) {
+        file.write((char *) &entry.timestamp, sizeof(entry.timestamp));
+        file.write((char *) &entry.offset, sizeof(entry.offset));
+    }
+
+    file.write((char *) &recordPos, sizeof(recordPos));
+    file.write((char *) &count, sizeof(count));
+    file.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+
+    index.clear();
+}
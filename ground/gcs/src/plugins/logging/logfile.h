@@ -34,6 +34,7 @@
 #include <QMutexLocker>
 #include <QDebug>
 #include <QBuffer>
+#include <QVector>
 #include "uavobjectmanager.h"
 #include <math.h>
 
@@ -53,6 +54,14 @@ public:
     bool startReplay();
     bool stopReplay();
 
+    /**
+     * Index entry pointing at the packet that starts a chunk of the log
+     */
+    struct IndexEntry {
+        quint32 timestamp;
+        qint64 offset;
+    };
+
 public slots:
     void setReplaySpeed(double val) { playbackSpeed = val; qDebug() << "New playback speed: " << playbackSpeed; }
     void setReplayTime(double val);
@@ -64,6 +73,7 @@ protected slots:
 
 signals:
     void readReady();
+    void receiveTimestamp(qint64 timestamp);
     void replayStarted();
     void replayFinished();
 
@@ -72,7 +82,7 @@ protected:
     QTimer timer;
     QTime myTime;
     QFile file;
-    quint32 lastTimeStamp;
+    quint32 lastTimeStamp; // Timestamp of the next packet to replay
     quint32 lastPlayTime;
     QMutex mutex;
 
@@ -81,11 +91,27 @@ protected:
     double playbackSpeed;
 
 private:
-    QList<quint32> timestampBuffer;
-    QList<quint32> timestampPos;
-    quint32 timestampBufferIdx;
-    quint32 lastTimeStampPos;
+    // Packets are indexed in chunks of at least this many bytes
+    static const qint64 INDEX_CHUNK_SIZE = 256 * 1024;
+    // Keeps the index record small enough to pass as a packet in older GCSs
+    static const int MAX_INDEX_ENTRIES = 4096;
+    static const char INDEX_MAGIC[8];
+
+    bool findRecord(qint64 &pos, quint32 &timestamp, qint64 &dataSize);
+    void addIndexEntry(quint32 timestamp, qint64 offset);
+    bool loadIndex();
+    bool loadSidecarIndex();
+    void buildIndex();
+    void writeSidecarIndex();
+    void writeIndex();
+
+    QVector<IndexEntry> index;
+    qint64 indexChunkSize; // Current chunk size, doubled when the index is thinned
+    qint64 dataStart;      // Offset of the first packet, after the header
+    qint64 dataEnd;        // Offset just past the last packet
+    qint64 nextRecordPos;  // Offset of the next packet to replay
     quint32 firstTimestamp;
+    qint64 replayEpoch; // Replayed log time 0 in UAVObject::currentTimestamp() time
 };
 
 #endif // LOGFILE_H
@@ -10,7 +10,8 @@ HEADERS += loggingplugin.h \
     logginggadget.h \
     logginggadgetfactory.h \
     loggingdevice.h \
-    flightlogdownload.h
+    flightlogdownload.h \
+    logcolumnexport.h
 #    logginggadgetconfiguration.h
 #   logginggadgetoptionspage.h
 
@@ -20,9 +21,12 @@ SOURCES += loggingplugin.cpp \
     logginggadget.cpp \
     logginggadgetfactory.cpp \
     loggingdevice.cpp \
-    flightlogdownload.cpp
+    flightlogdownload.cpp \
+    logcolumnexport.cpp
 #    logginggadgetconfiguration.cpp \
 #    logginggadgetoptionspage.cpp
+SOURCES += $$UAVOBJECT_SYNTHETICS/uavobjectsinit.cpp
+
 OTHER_FILES += LoggingGadget.pluginspec \
     LoggingGadget.json
 FORMS += logging.ui \
@@ -32,6 +32,7 @@
 #include "loggingdevice.h"
 #include "logginggadgetfactory.h"
 #include "flightlogdownload.h"
+#include "logcolumnexport.h"
 
 #include <QDebug>
 #include <QtPlugin>
@@ -39,6 +40,8 @@
 #include <QStringList>
 #include <QDir>
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QMessageBox>
 #include <QList>
 #include <QErrorMessage>
 #include <QWriteLocker>
@@ -365,6 +368,15 @@ bool LoggingPlugin::initialize(const QStringList& args, QString *errMsg)
     ac->addAction(cmdDownload, "Logging");
     connect(cmdDownload->action(), SIGNAL(triggered(bool)), this, SLOT(downloadLog()));
 
+    // Command to export a log to column files
+    cmdExportColumns = am->registerAction(new QAction(this),
+                                            "LoggingPlugin.ExportColumns",
+                                            QList<int>() <<
+                                            Core::Constants::C_GLOBAL_ID);
+    cmdExportColumns->action()->setText("Export logfile to columns...");
+    ac->addAction(cmdExportColumns, "Logging");
+    connect(cmdExportColumns->action(), SIGNAL(triggered(bool)), this, SLOT(exportColumns()));
+
 
     mf = new LoggingGadgetFactory(this);
     addAutoReleasedObject(mf);
@@ -382,6 +394,27 @@ void LoggingPlugin::downloadLog()
     download.exec();
 }
 
+/**
+ * Exports a log to a directory of column files, one per UAVObject, for
+ * offline analysis
+ */
+void LoggingPlugin::exportColumns()
+{
+    QString inputFileName = QFileDialog::getOpenFileName(NULL, tr("Open file"), QDir::homePath(),
+                                                         tr("Tau Labs Log (*.tll)"));
+    if (inputFileName.isEmpty())
+        return;
+
+    QString outputDir = QFileDialog::getExistingDirectory(NULL, tr("Export columns to"),
+                                                          QFileInfo(inputFileName).absolutePath());
+    if (outputDir.isEmpty())
+        return;
+
+    LogColumnExport columnExport(inputFileName, outputDir);
+    if (!columnExport.exportColumns())
+        QMessageBox::critical(NULL, tr("Export failed"), columnExport.getErrorString());
+}
+
 /**
   * The action that is triggered by the menu item which opens the
   * file and begins logging if successful
@@ -144,6 +144,7 @@ protected:
 
 private slots:
     void downloadLog();
+    void exportColumns();
     void toggleLogging();
     void startLogging(QString file);
     void stopLogging();
@@ -155,6 +156,7 @@ private:
     LoggingGadgetFactory *mf;
     Core::Command* cmdLogging;
     Core::Command* cmdDownload;
+    Core::Command* cmdExportColumns;
 
 };
 #endif /* LoggingPLUGIN_H_ */
@@ -41,8 +41,12 @@
  * @param p_uavFieldName The plotted UAVO field name
  */
 Plot2dData::Plot2dData(QString p_uavObject, QString p_uavFieldName):
-    yDataHistory(0),
-    dataUpdated(false)
+    dataUpdated(false),
+    mathWindowHead(0),
+    mathWindowCount(0),
+    mathResyncCount(0),
+    mathMean(0),
+    mathM2(0)
 {
     uavObjectName = p_uavObject;
 
@@ -59,15 +63,8 @@ Plot2dData::Plot2dData(QString p_uavObject, QString p_uavFieldName):
         haveSubField = false;
     }
 
-    xData = new QVector<double>();
-    yData = new QVector<double>();
-    yDataHistory = new QVector<double>();
-
     scalePower = 0;
     meanSamples = 1;
-    meanSum = 0.0f;
-    correctionSum = 0.0f;
-    correctionCount = 0;
     yMinimum = 0;
     yMaximum = 120;
 
@@ -98,17 +95,12 @@ Plot3dData::Plot3dData(QString p_uavObject, QString p_uavFieldName):
         haveSubField = false;
     }
 
-    xData = new QVector<double>();
-    yData = new QVector<double>();
     zData = new QVector<double>();
     zDataHistory = new QVector<double>();
     timeDataHistory = new QVector<double>();
 
     scalePower = 0;
     meanSamples = 1;
-    meanSum = 0.0f;
-    correctionSum = 0.0f;
-    correctionCount = 0;
     xMinimum = 0;
     xMaximum = 16;
     yMinimum = 0;
@@ -120,21 +112,11 @@ Plot3dData::Plot3dData(QString p_uavObject, QString p_uavFieldName):
 
 Plot2dData::~Plot2dData()
 {
-    if (xData != NULL)
-        delete xData;
-    if (yData != NULL)
-        delete yData;
-    if (yDataHistory != NULL)
-        delete yDataHistory;
 }
 
 
 Plot3dData::~Plot3dData()
 {
-    if (xData != NULL)
-        delete xData;
-    if (yData != NULL)
-        delete yData;
     if (zData != NULL)
         delete zData;
     if (zDataHistory != NULL)
@@ -155,13 +137,89 @@ Plot3dData::~Plot3dData()
 double PlotData::valueAsDouble(UAVObject* obj, UAVObjectField* field, bool haveSubField, QString uavSubFieldName)
 {
     Q_UNUSED(obj);
-    QVariant value;
+    double value = 0;
+    quint32 index = 0;
+
+    if(haveSubField)
+        index = field->getElementNames().indexOf(uavSubFieldName);
+
+    // Enums are plotted by their numeric value
+    field->getDoubles(&value, index, 1);
+    return value;
+}
+
+
+/**
+ * @brief Plot2dData::applyMathFunction Runs a value through the scope math function
+ * @param value Newest value of the plotted field
+ * @return The boxcar average or standard deviation of the last meanSamples
+ * values, or the value itself if no math function is selected
+ */
+double Plot2dData::applyMathFunction(double value)
+{
+    if (mathFunction != "Boxcar average" && mathFunction != "Standard deviation")
+        return value;
+
+    int windowSize = qMax((int)meanSamples, 1);
+    if (mathWindow.size() != windowSize)
+        resetMathWindow(windowSize);
+
+    // Welford's update of the running mean and squared deviations. Once the
+    // window is full the oldest value is replaced in the same step.
+    if (mathWindowCount == windowSize) {
+        double oldest = mathWindow.at(mathWindowHead);
+        double oldMean = mathMean;
+
+        mathWindow[mathWindowHead] = value;
+        mathWindowHead = (mathWindowHead + 1) % windowSize;
+
+        mathMean += (value - oldest) / windowSize;
+        mathM2 += (value - oldest) * (value - mathMean + oldest - oldMean);
+    } else {
+        mathWindow[(mathWindowHead + mathWindowCount) % windowSize] = value;
+        mathWindowCount++;
+
+        double delta = value - mathMean;
+        mathMean += delta / mathWindowCount;
+        mathM2 += delta * (value - mathMean);
+    }
 
-    if(haveSubField){
-        int indexOfSubField = field->getElementNames().indexOf(QRegExp(uavSubFieldName, Qt::CaseSensitive, QRegExp::FixedString));
-        value = field->getValue(indexOfSubField);
-    }else
-        value = field->getValue();
+    // make sure to recompute the sums every meanSamples steps to prevent them
+    // from running away due to floating point rounding errors
+    if (++mathResyncCount >= windowSize) {
+        double sum = 0;
+        for (int i = 0; i < mathWindowCount; i++)
+            sum += mathWindow.at(i);
+        mathMean = sum / mathWindowCount;
 
-    return value.toDouble();
+        mathM2 = 0;
+        for (int i = 0; i < mathWindowCount; i++)
+            mathM2 += (mathWindow.at(i) - mathMean) * (mathWindow.at(i) - mathMean);
+
+        mathResyncCount = 0;
+    }
+
+    if (mathFunction == "Standard deviation") {
+        //Sample standard deviation, with Bessel's correction
+        if (windowSize < 2)
+            return 0;
+        return sqrt(qMax(mathM2, 0.0) / (windowSize - 1));
+    }
+
+    return mathMean;
+}
+
+
+/**
+ * @brief Plot2dData::resetMathWindow Discards the math history and resizes its window
+ * @param size Number of values in the window
+ */
+void Plot2dData::resetMathWindow(int size)
+{
+    mathWindow.fill(0, size);
+    mathWindowHead = 0;
+    mathWindowCount = 0;
+    mathResyncCount = 0;
+    mathMean = 0;
+    mathM2 = 0;
 }
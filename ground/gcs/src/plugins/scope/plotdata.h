@@ -74,9 +74,6 @@ public:
     int getMeanSamples(){return meanSamples;}
     QString getMathFunction(){return mathFunction;}
 
-    QVector<double>* getXData(){return xData;}
-    QVector<double>* getYData(){return yData;}
-
     virtual bool append(UAVObject* obj) = 0;
     virtual void removeStaleData() = 0;
     virtual void setUpdatedFlagToTrue() = 0;
@@ -87,9 +84,6 @@ public:
     QwtScaleWidget *rightAxis;
 
 protected:
-    QVector<double>* xData;    //Data vector for plots
-    QVector<double>* yData;    //Used vector for plots
-
     double m_xWindowSize;
     double xMinimum;
     double xMaximum;
@@ -104,10 +98,6 @@ protected:
     int scalePower; //This is the power to which each value must be raised
     unsigned int meanSamples;
     QString mathFunction;
-    double meanSum;
-
-    double correctionSum;
-    int correctionCount;
 
 private:
 
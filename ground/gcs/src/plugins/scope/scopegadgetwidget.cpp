@@ -62,7 +62,9 @@ QTimer *ScopeGadgetWidget::replotTimer=0;
 ScopeGadgetWidget::ScopeGadgetWidget(QWidget *parent) : QwtPlot(parent),
     m_refreshInterval(50), // Arbitrary 50ms refresh timer
     m_scope(0),
-    m_xWindowSize(60) // This is an arbitrary 1 minute window
+    m_xWindowSize(60), // This is an arbitrary 1 minute window
+    m_latestTimestamp(0),
+    m_latestArrival(0)
 {
     m_grid = new QwtPlotGrid;
 
@@ -295,6 +297,9 @@ void ScopeGadgetWidget::showCurve(const QVariant & itemInfo, bool on, int index)
  */
 void ScopeGadgetWidget::uavObjectReceived(UAVObject* obj)
 {
+    m_latestTimestamp = obj->getTimestamp();
+    m_latestArrival = UAVObject::currentTimestamp();
+
     foreach(PlotData* plotdData, m_dataSources.values()) {
         bool ret = plotdData->append(obj);
         if (ret)
@@ -304,6 +309,23 @@ void ScopeGadgetWidget::uavObjectReceived(UAVObject* obj)
 
 
 
+/**
+ * @brief ScopeGadgetWidget::getPlotTime Time shown at the right edge of time
+ * series plots. It follows the timestamps of the received objects, which run
+ * faster than the clock when a log is replayed faster than real time.
+ * @return Seconds since the epoch, in the time base of UAVObject::getTimestamp()
+ */
+double ScopeGadgetWidget::getPlotTime()
+{
+    qint64 now = UAVObject::currentTimestamp();
+
+    if (m_latestArrival == 0)
+        return now / 1000.0;
+
+    return (m_latestTimestamp + (now - m_latestArrival)) / 1000.0;
+}
+
+
 /**
  * @brief ScopeGadgetWidget::replotNewData
  */
@@ -91,6 +91,7 @@ public:
     void deleteLegend();
     void clearPlotWidget();
     void startTimer(int);
+    double getPlotTime();
     QwtPlotGrid *m_grid;
     QwtLegend *m_legend;
 
@@ -118,6 +119,10 @@ private:
     static QTimer *replotTimer;
     QList<QString> m_connectedUAVObjects;
 
+    // Timestamp of the newest object update, and the time it was handled
+    qint64 m_latestTimestamp;
+    qint64 m_latestArrival;
+
 };
 
 
@@ -0,0 +1,398 @@
+/**
+ ******************************************************************************
+ *
+ * @file       circularseriesdata.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief The scope Gadget, graphically plots the states of UAVObjects
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "scopes2d/circularseriesdata.h"
+
+
+/**
+ * @brief CircularSeriesData::CircularSeriesData Constructor
+ * @param p_indexAsX TRUE if samples are plotted against their index in the buffer
+ */
+CircularSeriesData::CircularSeriesData(bool p_indexAsX):
+    mask(0),
+    head(0),
+    count(0),
+    firstIndex(0),
+    indexAsX(p_indexAsX),
+    viewMin(0),
+    viewMax(0),
+    viewPixels(0),
+    viewDecimated(false),
+    viewDirty(true)
+{
+    grow(64);
+    clear();
+}
+
+
+/**
+ * @brief CircularSeriesData::size Number of samples shown to the curve
+ */
+size_t CircularSeriesData::size() const
+{
+    updateView();
+
+    if (viewDecimated)
+        return view.size();
+
+    return count;
+}
+
+
+/**
+ * @brief CircularSeriesData::sample Returns the i-th sample shown to the curve
+ */
+QPointF CircularSeriesData::sample(size_t i) const
+{
+    updateView();
+
+    if (viewDecimated)
+        return view.at(i);
+
+    return rawSample(i);
+}
+
+
+/**
+ * @brief CircularSeriesData::rawSample Returns the i-th oldest sample
+ */
+QPointF CircularSeriesData::rawSample(int i) const
+{
+    const QPointF &point = buffer.at((head + i) & mask);
+
+    if (indexAsX)
+        return QPointF(i, point.y());
+
+    return point;
+}
+
+
+/**
+ * @brief CircularSeriesData::boundingRect Bounding rectangle of all samples. The
+ * result is cached until the buffer is modified.
+ */
+QRectF CircularSeriesData::boundingRect() const
+{
+    if (count == 0)
+        return QRectF(1.0, 1.0, -2.0, -2.0);
+
+    // The decimated view keeps the extremes, so the raw samples give the same
+    // rectangle no matter the resolution
+    if (d_boundingRect.width() < 0.0) {
+        QPointF point = rawSample(0);
+        double minX = point.x(), maxX = point.x();
+        double minY = point.y(), maxY = point.y();
+
+        for (int i = 1; i < count; i++) {
+            point = rawSample(i);
+            minX = qMin(minX, point.x());
+            maxX = qMax(maxX, point.x());
+            minY = qMin(minY, point.y());
+            maxY = qMax(maxY, point.y());
+        }
+
+        d_boundingRect.setCoords(minX, minY, maxX, maxY);
+    }
+
+    return d_boundingRect;
+}
+
+
+/**
+ * @brief CircularSeriesData::append Adds a sample after the newest one, growing
+ * the buffer when it is full. Once the buffer holds MAX_CAPACITY samples the
+ * oldest one is dropped instead.
+ */
+void CircularSeriesData::append(const QPointF &point)
+{
+    if (count == buffer.size()) {
+        if (buffer.size() < MAX_CAPACITY)
+            grow(buffer.size() * 2);
+        else
+            removeFirst();
+    }
+
+    qint64 index = firstIndex + count;
+    buffer[(head + count) & mask] = point;
+    count++;
+
+    // Fold the sample into the newest bucket of every level, starting a new
+    // bucket when the sample crosses a bucket boundary
+    for (int l = 0; l < LOD_LEVELS; l++) {
+        Level &level = levels[l];
+        qint64 bucketNumber = index >> (LOD_SHIFT * (l + 1));
+
+        if (level.head == level.buckets.size()) {
+            Bucket bucket = {index, index, point.y(), point.y()};
+            level.buckets.append(bucket);
+            level.firstBucket = bucketNumber;
+        } else if (level.firstBucket + (level.buckets.size() - level.head) <= bucketNumber) {
+            Bucket bucket = {index, index, point.y(), point.y()};
+            level.buckets.append(bucket);
+        } else {
+            Bucket &bucket = level.buckets.last();
+            if (point.y() < bucket.minValue) {
+                bucket.minValue = point.y();
+                bucket.minIndex = index;
+            }
+            if (point.y() > bucket.maxValue) {
+                bucket.maxValue = point.y();
+                bucket.maxIndex = index;
+            }
+        }
+    }
+
+    invalidate();
+}
+
+
+/**
+ * @brief CircularSeriesData::removeFirst Drops the oldest sample
+ */
+void CircularSeriesData::removeFirst()
+{
+    if (count == 0)
+        return;
+
+    head = (head + 1) & mask;
+    count--;
+    firstIndex++;
+
+    // Drop the buckets that no longer hold any sample. A partially evicted
+    // bucket is kept, updateView() rebuilds it from the remaining samples.
+    for (int l = 0; l < LOD_LEVELS; l++) {
+        Level &level = levels[l];
+        qint64 bucketSize = Q_INT64_C(1) << (LOD_SHIFT * (l + 1));
+
+        while (level.head < level.buckets.size() && (level.firstBucket + 1) * bucketSize <= firstIndex) {
+            level.head++;
+            level.firstBucket++;
+        }
+
+        // Compact once the dropped buckets make up half of the storage
+        if (level.head > 32 && level.head * 2 > level.buckets.size()) {
+            level.buckets.remove(0, level.head);
+            level.head = 0;
+        }
+    }
+
+    invalidate();
+}
+
+
+/**
+ * @brief CircularSeriesData::clear Drops all samples, keeping the allocated storage
+ */
+void CircularSeriesData::clear()
+{
+    head = 0;
+    count = 0;
+    firstIndex = 0;
+
+    for (int l = 0; l < LOD_LEVELS; l++) {
+        levels[l].buckets.resize(0);
+        levels[l].head = 0;
+        levels[l].firstBucket = 0;
+    }
+
+    invalidate();
+}
+
+
+/**
+ * @brief CircularSeriesData::reserve Makes room for at least capacity samples,
+ * up to MAX_CAPACITY, so that fixed size windows never reallocate while plotting.
+ */
+void CircularSeriesData::reserve(int capacity)
+{
+    capacity = qMin(capacity, (int)MAX_CAPACITY);
+    if (capacity > buffer.size())
+        grow(capacity);
+}
+
+
+/**
+ * @brief CircularSeriesData::setResolution Sets the part of the curve that is
+ * visible and how many pixels wide it is drawn. A width of 0 disables decimation.
+ * @return TRUE if the resolution changed and the curve needs to be redrawn
+ */
+bool CircularSeriesData::setResolution(double xMin, double xMax, int pixels)
+{
+    if (xMin == viewMin && xMax == viewMax && pixels == viewPixels)
+        return false;
+
+    viewMin = xMin;
+    viewMax = xMax;
+    viewPixels = pixels;
+    viewDirty = true;
+
+    return true;
+}
+
+
+/**
+ * @brief CircularSeriesData::grow Reallocates the storage to the next power of
+ * two holding capacity samples and unwraps the contents to the start of it.
+ */
+void CircularSeriesData::grow(int capacity)
+{
+    int size = 1;
+    while (size < capacity)
+        size <<= 1;
+
+    QVector<QPointF> newBuffer(size);
+    for (int i = 0; i < count; i++)
+        newBuffer[i] = buffer.at((head + i) & mask);
+
+    buffer = newBuffer;
+    mask = size - 1;
+    head = 0;
+}
+
+
+/**
+ * @brief CircularSeriesData::invalidate Marks the cached bounding rectangle and
+ * decimated view as stale
+ */
+void CircularSeriesData::invalidate()
+{
+    d_boundingRect = QRectF(0.0, 0.0, -1.0, -1.0);
+    viewDirty = true;
+}
+
+
+/**
+ * @brief CircularSeriesData::lowerBound Index of the first sample whose x is not
+ * less than x, or count if there is none. Samples are appended in x order.
+ */
+int CircularSeriesData::lowerBound(double x) const
+{
+    int low = 0;
+    int high = count;
+
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (rawSample(middle).x() < x)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return low;
+}
+
+
+/**
+ * @brief CircularSeriesData::scanBucket Extremes of the samples between the
+ * absolute sample numbers from and to, both included
+ */
+CircularSeriesData::Bucket CircularSeriesData::scanBucket(qint64 from, qint64 to) const
+{
+    double value = rawSample((int)(from - firstIndex)).y();
+    Bucket bucket = {from, from, value, value};
+
+    for (qint64 index = from + 1; index <= to; index++) {
+        value = rawSample((int)(index - firstIndex)).y();
+        if (value < bucket.minValue) {
+            bucket.minValue = value;
+            bucket.minIndex = index;
+        }
+        if (value > bucket.maxValue) {
+            bucket.maxValue = value;
+            bucket.maxIndex = index;
+        }
+    }
+
+    return bucket;
+}
+
+
+/**
+ * @brief CircularSeriesData::updateView Rebuilds the decimated samples for the
+ * visible range from the finest pyramid level that gives at most one bucket,
+ * so two points, per pixel. Cost is proportional to the width, not the sample
+ * count.
+ */
+void CircularSeriesData::updateView() const
+{
+    if (!viewDirty)
+        return;
+
+    viewDirty = false;
+    viewDecimated = false;
+    view.resize(0);
+
+    if (viewPixels <= 0 || count == 0)
+        return;
+
+    // Include one sample on either side so the curve runs off the edges
+    int first = qMax(lowerBound(viewMin) - 1, 0);
+    int last = qMin(lowerBound(viewMax), count - 1);
+    qint64 visible = last - first + 1;
+
+    if (visible <= 2 * viewPixels)
+        return;
+
+    int l = 0;
+    while (l < LOD_LEVELS - 1 &&
+           ((firstIndex + last) >> (LOD_SHIFT * (l + 1))) - ((firstIndex + first) >> (LOD_SHIFT * (l + 1))) + 1 > viewPixels)
+        l++;
+
+    const Level &level = levels[l];
+    int shift = LOD_SHIFT * (l + 1);
+    qint64 firstBucket = (firstIndex + first) >> shift;
+    qint64 lastBucket = (firstIndex + last) >> shift;
+
+    view.reserve(2 * (lastBucket - firstBucket + 1) + 2);
+    view.append(rawSample(first));
+
+    for (qint64 b = firstBucket; b <= lastBucket; b++) {
+        Bucket bucket;
+
+        // The edge buckets may also cover evicted samples or samples out of
+        // view, so they are rebuilt from the samples in range
+        if (b == firstBucket || b == lastBucket)
+            bucket = scanBucket(qMax(b << shift, firstIndex + first), qMin(((b + 1) << shift) - 1, firstIndex + last));
+        else
+            bucket = level.buckets.at(level.head + (int)(b - level.firstBucket));
+
+        QPointF minPoint(rawSample((int)(bucket.minIndex - firstIndex)).x(), bucket.minValue);
+        QPointF maxPoint(rawSample((int)(bucket.maxIndex - firstIndex)).x(), bucket.maxValue);
+
+        // Keep the two extremes in the order they were sampled
+        if (bucket.minIndex <= bucket.maxIndex) {
+            view.append(minPoint);
+            view.append(maxPoint);
+        } else {
+            view.append(maxPoint);
+            view.append(minPoint);
+        }
+    }
+
+    view.append(rawSample(last));
+    viewDecimated = true;
+}
@@ -0,0 +1,128 @@
+/**
+ ******************************************************************************
+ *
+ * @file       circularseriesdata.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief The scope Gadget, graphically plots the states of UAVObjects
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef CIRCULARSERIESDATA_H
+#define CIRCULARSERIESDATA_H
+
+#include "qwt/src/qwt_series_data.h"
+
+#include <QPointF>
+#include <QVector>
+
+
+/**
+ * @brief The CircularSeriesData class Ring buffer of curve samples. Appending
+ * and dropping the oldest sample are both O(1), so scrolling plots no longer
+ * shift their whole history on every update. The buffer is handed to the
+ * QwtPlotCurve once and is read in place when the curve is replotted.
+ *
+ * The buffer also keeps a min/max pyramid of its samples. When the visible
+ * part of the curve holds many more samples than there are pixels, Qwt is only
+ * shown the minimum and maximum of each group of samples, about two points
+ * per pixel, instead of every sample.
+ */
+class CircularSeriesData : public QwtSeriesData<QPointF>
+{
+public:
+    CircularSeriesData(bool indexAsX = false);
+
+    //Samples as seen by the curve, possibly decimated
+    virtual size_t size() const;
+    virtual QPointF sample(size_t i) const;
+    virtual QRectF boundingRect() const;
+
+    void append(const QPointF &point);
+    void removeFirst();
+    void clear();
+    void reserve(int capacity);
+
+    bool setResolution(double xMin, double xMax, int pixels);
+
+    //Raw samples, never decimated
+    int sampleCount() const {return count;}
+    QPointF rawSample(int i) const;
+    const QPointF &first() const {return buffer.at(head);}
+    const QPointF &last() const {return buffer.at((head + count - 1) & mask);}
+
+private:
+    /**
+     * @brief The Bucket struct Extremes of a group of consecutive samples,
+     * identified by their absolute sample number.
+     */
+    struct Bucket {
+        qint64 minIndex;
+        qint64 maxIndex;
+        double minValue;
+        double maxValue;
+    };
+
+    /**
+     * @brief The Level struct One level of the pyramid. Buckets are appended at
+     * the back and dropped from the front as samples are evicted.
+     */
+    struct Level {
+        QVector<Bucket> buckets;
+        int head;            //Index of the oldest live bucket
+        qint64 firstBucket;  //Bucket number of buckets[head]
+    };
+
+    enum {
+        LOD_SHIFT = 2,          //Each level groups 2^LOD_SHIFT times more samples
+        LOD_LEVELS = 10,        //Coarsest level groups 2^20 samples per bucket
+        MAX_CAPACITY = 1 << 20  //Oldest samples are dropped beyond this
+    };
+
+    void grow(int capacity);
+    void invalidate();
+    void updateView() const;
+    int lowerBound(double x) const;
+    Bucket scanBucket(qint64 from, qint64 to) const;
+
+    QVector<QPointF> buffer; //Storage, always a power of two in size
+    int mask;                //buffer.size() - 1
+    int head;                //Index of the oldest sample
+    int count;               //Number of valid samples
+    qint64 firstIndex;       //Absolute sample number of the oldest sample
+
+    //When set, samples are plotted against their position in the buffer
+    //instead of their stored x value, as used by the sequential plots
+    bool indexAsX;
+
+    Level levels[LOD_LEVELS];
+
+    //Visible x range and width in pixels, as given by setResolution()
+    double viewMin;
+    double viewMax;
+    int viewPixels;
+
+    //Decimated samples handed to the curve, rebuilt lazily after a change
+    mutable QVector<QPointF> view;
+    mutable bool viewDecimated;
+    mutable bool viewDirty;
+};
+
+#endif // CIRCULARSERIESDATA_H
@@ -91,11 +91,6 @@ void HistogramData::plotNewData(PlotData* plot2dData, ScopeConfig *scopeConfig,
  */
 bool HistogramData::append(UAVObject* obj)
 {
-
-    //Empty histogram data set
-    xData->clear();
-    yData->clear();
-
     if (uavObjectName == obj->getName()) {
 
         //Get the field of interest
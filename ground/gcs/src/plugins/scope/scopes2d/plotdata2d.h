@@ -46,13 +46,24 @@ public:
     Plot2dData(QString uavObject, QString uavField);
     ~Plot2dData();
 
-    QVector<double>* yDataHistory; //Used for scatterplots
-
     virtual void setUpdatedFlagToTrue(){dataUpdated = true;}
     virtual bool readAndResetUpdatedFlag(){bool tmp = dataUpdated; dataUpdated = false; return tmp;}
 
+protected:
+    double applyMathFunction(double value);
+
 private:
+    void resetMathWindow(int size);
+
     bool dataUpdated;
+
+    //Sliding window of the last meanSamples values, used by the scope math
+    QVector<double> mathWindow;
+    int mathWindowHead;  //Index of the oldest value
+    int mathWindowCount; //Number of valid values
+    int mathResyncCount; //Values since the running sums were last recomputed
+    double mathMean;     //Running mean of the window
+    double mathM2;       //Running sum of squared deviations from the mean
 };
 
 #endif // PLOTDATA2D_H
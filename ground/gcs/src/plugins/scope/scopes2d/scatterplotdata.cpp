@@ -49,13 +49,15 @@ void TimeSeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeCon
     Q_UNUSED(scopeConfig);
     Q_UNUSED(scopeGadgetWidget);
 
-    //Plot new data
-    if (readAndResetUpdatedFlag() == true)
-        curve->setSamples(*xData, *yData);
+    double toTime = scopeGadgetWidget->getPlotTime();
 
-    QDateTime NOW = QDateTime::currentDateTime();
-    double toTime = NOW.toTime_t();
-    toTime += NOW.time().msec() / 1000.0;
+    //Decimate the curve to the visible window
+    bool rescaled = seriesData->setResolution(toTime - m_xWindowSize, toTime, scopeGadgetWidget->canvas()->width());
+
+    //Plot new data. The curve reads the samples in place, so it only needs
+    //to be told that they changed.
+    if (readAndResetUpdatedFlag() == true || rescaled)
+        curve->itemChanged();
 
     scopeGadgetWidget->setAxisScale(QwtPlot::xBottom, toTime - m_xWindowSize, toTime);
 }
@@ -71,9 +73,14 @@ void SeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeConfig,
     Q_UNUSED(scopeConfig);
     Q_UNUSED(scopeGadgetWidget);
 
-    //Plot new data
-    if (readAndResetUpdatedFlag() == true)
-        curve->setSamples(*xData, *yData);
+    //Decimate the curve to the visible part of the x axis, which may be zoomed
+    const QwtScaleDiv &xScale = scopeGadgetWidget->axisScaleDiv(QwtPlot::xBottom);
+    bool rescaled = seriesData->setResolution(xScale.lowerBound(), xScale.upperBound(), scopeGadgetWidget->canvas()->width());
+
+    //Plot new data. The curve reads the samples in place, so it only needs
+    //to be told that they changed.
+    if (readAndResetUpdatedFlag() == true || rescaled)
+        curve->itemChanged();
 }
 
 
@@ -94,48 +101,12 @@ bool SeriesPlotData::append(UAVObject* obj)
             double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
 
             //Perform scope math, if necessary
-            if (mathFunction  == "Boxcar average" || mathFunction  == "Standard deviation"){
-                //Put the new value at the front
-                yDataHistory->append( currentValue );
-
-                // calculate average value
-                meanSum += currentValue;
-                if(yDataHistory->size() > (int)meanSamples) {
-                    meanSum -= yDataHistory->first();
-                    yDataHistory->pop_front();
-                }
-
-                // make sure to correct the sum every meanSamples steps to prevent it
-                // from running away due to floating point rounding errors
-                correctionSum+=currentValue;
-                if (++correctionCount >= (int)meanSamples) {
-                    meanSum = correctionSum;
-                    correctionSum = 0.0f;
-                    correctionCount = 0;
-                }
-
-                double boxcarAvg=meanSum/yDataHistory->size();
-
-                if ( mathFunction  == "Standard deviation" ){
-                    //Calculate square of sample standard deviation, with Bessel's correction
-                    double stdSum=0;
-                    for (int i=0; i < yDataHistory->size(); i++){
-                        stdSum+= pow(yDataHistory->at(i)- boxcarAvg,2)/(meanSamples-1);
-                    }
-                    yData->append(sqrt(stdSum));
-                }
-                else  {
-                    yData->append(boxcarAvg);
-                }
-            }
-            else{
-                yData->append( currentValue );
-            }
-
-            if (yData->size() > getXWindowSize()) { //If new data overflows the window, remove old data...
-                yData->pop_front();
-            } else //...otherwise, add a new y point at position xData
-                xData->insert(xData->size(), xData->size());
+            seriesData->append(QPointF(0, applyMathFunction(currentValue)));
+
+            //If new data overflows the window, remove old data. The x
+            //coordinate is the position in the buffer, so the rest shifts left
+            if (seriesData->sampleCount() > getXWindowSize())
+                seriesData->removeFirst();
 
             return true;
         }
@@ -157,49 +128,17 @@ bool TimeSeriesPlotData::append(UAVObject* obj)
         UAVObjectField* field =  obj->getField(uavFieldName);
 
         if (field) {
-            QDateTime NOW = QDateTime::currentDateTime(); //THINK ABOUT REIMPLEMENTING THIS TO SHOW UAVO TIME, NOT SYSTEM TIME
             double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
 
             //Perform scope math, if necessary
-            if (mathFunction  == "Boxcar average" || mathFunction  == "Standard deviation"){
-                //Put the new value at the back
-                yDataHistory->append( currentValue );
-
-                // calculate average value
-                meanSum += currentValue;
-                if(yDataHistory->size() > (int)meanSamples) {
-                    meanSum -= yDataHistory->first();
-                    yDataHistory->pop_front();
-                }
-                // make sure to correct the sum every meanSamples steps to prevent it
-                // from running away due to floating point rounding errors
-                correctionSum+=currentValue;
-                if (++correctionCount >= (int)meanSamples) {
-                    meanSum = correctionSum;
-                    correctionSum = 0.0f;
-                    correctionCount = 0;
-                }
-
-                double boxcarAvg=meanSum/yDataHistory->size();
-
-                if ( mathFunction  == "Standard deviation" ){
-                    //Calculate square of sample standard deviation, with Bessel's correction
-                    double stdSum=0;
-                    for (int i=0; i < yDataHistory->size(); i++){
-                        stdSum+= pow(yDataHistory->at(i)- boxcarAvg,2)/(meanSamples-1);
-                    }
-                    yData->append(sqrt(stdSum));
-                }
-                else  {
-                    yData->append(boxcarAvg);
-                }
-            }
-            else{
-                yData->append( currentValue );
-            }
-
-            double valueX = NOW.toTime_t() + NOW.time().msec() / 1000.0;
-            xData->append(valueX);
+            double valueX = obj->getTimestamp() / 1000.0;
+
+            //Time went backwards, as when a log replay is rewound. Start
+            //over, the buffer is searched and evicted in time order.
+            if (seriesData->sampleCount() > 0 && valueX < seriesData->last().x())
+                seriesData->clear();
+
+            seriesData->append(QPointF(valueX, applyMathFunction(currentValue)));
 
             //Remove stale data
             removeStaleData();
@@ -221,15 +160,14 @@ void TimeSeriesPlotData::removeStaleData()
     double oldestValue;
 
     while (1) {
-        if (xData->size() == 0)
+        if (seriesData->sampleCount() == 0)
             break;
 
-        newestValue = xData->last();
-        oldestValue = xData->first();
+        newestValue = seriesData->last().x();
+        oldestValue = seriesData->first().x();
 
         if (newestValue - oldestValue > getXWindowSize()) {
-            yData->pop_front();
-            xData->pop_front();
+            seriesData->removeFirst();
         } else
             break;
     }
@@ -245,6 +183,17 @@ void TimeSeriesPlotData::removeStaleDataTimeout()
 }
 
 
+/**
+ * @brief ScatterplotData::setCurve Attaches the sample buffer to the curve, which
+ * takes ownership of it
+ */
+void ScatterplotData::setCurve(QwtPlotCurve *val)
+{
+    curve = val;
+    curve->setData(seriesData);
+}
+
+
 /**
  * @brief ScatterplotData::clearPlots Clear all plot data
  */
@@ -29,6 +29,7 @@
 #define SCATTERPLOTDATA_H
 
 #include "scopes2d/plotdata2d.h"
+#include "scopes2d/circularseriesdata.h"
 #include "uavobject.h"
 #include "qwt/src/qwt_plot_curve.h"
 
@@ -44,16 +45,17 @@ class ScatterplotData : public Plot2dData
 {
     Q_OBJECT
 public:
-    ScatterplotData(QString uavObject, QString uavField):
-        Plot2dData(uavObject, uavField){curve = 0;}
-    ~ScatterplotData(){}
+    ScatterplotData(QString uavObject, QString uavField, bool indexAsX = false):
+        Plot2dData(uavObject, uavField){curve = 0; seriesData = new CircularSeriesData(indexAsX);}
+    ~ScatterplotData(){if (curve == 0) delete seriesData;}
 
     virtual void clearPlots(PlotData *);
 
-    void setCurve(QwtPlotCurve *val){curve = val;}
+    void setCurve(QwtPlotCurve *val);
 
 protected:
     QwtPlotCurve* curve;
+    CircularSeriesData* seriesData; //Owned by the curve once it is set
 };
 
 
@@ -67,7 +69,7 @@ class SeriesPlotData : public ScatterplotData
     Q_OBJECT
 public:
     SeriesPlotData(QString uavObject, QString uavField)
-            : ScatterplotData(uavObject, uavField) {}
+            : ScatterplotData(uavObject, uavField, true) {}
     ~SeriesPlotData() {}
 
     /*!
@@ -292,7 +292,6 @@ void Scatterplot2dScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetW
         //Create the curve plot
         QwtPlotCurve* plotCurve = new QwtPlotCurve(curveNameScaledMath);
         plotCurve->setPen(QPen(QBrush(QColor(color), Qt::SolidPattern), (qreal)1, Qt::SolidLine, Qt::SquareCap, Qt::BevelJoin));
-        plotCurve->setSamples(*(scatterplotData->getXData()), *(scatterplotData->getYData()));
         plotCurve->attach(scopeGadgetWidget);
         scatterplotData->setCurve(plotCurve);
 
@@ -418,7 +417,7 @@ void Scatterplot2dScopeConfig::configureAxes(ScopeGadgetWidget *scopeGadgetWidge
     case TIMESERIES2D: {
         // Configure axes
         scopeGadgetWidget->setAxisScaleDraw(QwtPlot::xBottom, new TimeScaleDraw());
-        uint NOW = QDateTime::currentDateTime().toTime_t();
+        double NOW = scopeGadgetWidget->getPlotTime();
         scopeGadgetWidget->setAxisScale(QwtPlot::xBottom, NOW - timeHorizon / 1000, NOW);
         break;
     }
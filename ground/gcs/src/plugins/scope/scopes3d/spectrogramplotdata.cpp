@@ -132,8 +132,6 @@ void SpectrogramData::plotNewData(PlotData *plot3dData, ScopeConfig *scopeConfig
  */
 bool SpectrogramData::append(UAVObject* multiObj)
 {
-    QDateTime NOW = QDateTime::currentDateTime(); //TODO: Upgrade this to show UAVO time and not system time
-
     // Check to make sure it's the correct UAVO
     if (uavObjectName == multiObj->getName()) {
 
@@ -167,7 +165,16 @@ bool SpectrogramData::append(UAVObject* multiObj)
         //Initialize vector where we will read out an entire row of multiple instance UAVO
         QVector<double> values;
 
-        timeDataHistory->append(NOW.toTime_t() + NOW.time().msec() / 1000.0);
+        double timestamp = multiObj->getTimestamp() / 1000.0;
+
+        //Time went backwards, as when a log replay is rewound. Start over,
+        //the history is evicted in time order.
+        if (!timeDataHistory->isEmpty() && timestamp < timeDataHistory->back()) {
+            timeDataHistory->clear();
+            zDataHistory->clear();
+        }
+
+        timeDataHistory->append(timestamp);
         UAVObjectField* multiField =  multiObj->getField(uavFieldName);
         Q_ASSERT(multiField);
         if (multiField ) {
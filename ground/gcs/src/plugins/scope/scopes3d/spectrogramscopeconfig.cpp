@@ -265,9 +265,11 @@ void SpectrogramScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetWid
 
     // Initial raster data
 
-    QDateTime NOW = QDateTime::currentDateTime(); //TODO: Upgrade this to show UAVO time and not system time
+    //Blank rows over the seconds leading up to now, so that received rows
+    //follow them in time order
+    double NOW = scopeGadgetWidget->getPlotTime();
     for ( uint i = 0; i < timeHorizon; i++ ){
-        spectrogramData->timeDataHistory->append(NOW.toTime_t() + NOW.time().msec() / 1000.0 + i);
+        spectrogramData->timeDataHistory->append(NOW - timeHorizon + 1 + i);
     }
 
     if (((double) windowWidth) * timeHorizon < (double) 10000000.0 * sizeof(spectrogramData->zDataHistory->front())){ //Don't exceed 10MB for memory
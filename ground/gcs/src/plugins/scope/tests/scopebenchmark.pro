@@ -0,0 +1,20 @@
+# -------------------------------------------------
+# QtTest benchmarks of the scope ingestion path, the
+# UAVObject updates appended to the plot data.
+# Build against an existing GCS build tree, then run
+# ./scopebenchmark (add -callgrind or -tickcounter as needed)
+# -------------------------------------------------
+TEMPLATE = app
+TARGET = scopebenchmark
+CONFIG += console qtestlib
+CONFIG -= app_bundle
+QT += testlib widgets
+
+include(../../../../gcs.pri)
+include(../scope.pri)
+
+INCLUDEPATH *= $$GCS_SOURCE_TREE/src/plugins $$GCS_SOURCE_TREE/src/libs ..
+LIBS += -L$$GCS_PLUGIN_PATH/TauLabs
+unix:!macx:QMAKE_RPATHDIR += $$GCS_PLUGIN_PATH/TauLabs $$GCS_LIBRARY_PATH
+
+SOURCES += tst_scopebenchmark.cpp
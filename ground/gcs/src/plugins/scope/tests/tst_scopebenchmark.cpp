@@ -0,0 +1,155 @@
+/**
+ ******************************************************************************
+ *
+ * @file       tst_scopebenchmark.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief      Benchmarks of the scope ingestion path
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <QtTest/QtTest>
+#include <QtCore/QObject>
+
+#include "uavobjectmanager.h"
+#include "uavobjectsinit.h"
+#include "scopes2d/scatterplotdata.h"
+
+//! Updates appended per benchmark iteration, one per millisecond
+#define SAMPLES 10000
+//! Seconds of data the time series keeps, its buffer is full after 1000 samples
+#define WINDOW_SECONDS 1
+
+class tst_ScopeBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void timeSeriesAppend_data();
+    void timeSeriesAppend();
+    void seriesAppend_data();
+    void seriesAppend();
+
+private:
+    void plottedFields();
+
+    UAVObjectManager *m_objMngr;
+};
+
+void tst_ScopeBenchmark::initTestCase()
+{
+    m_objMngr = new UAVObjectManager();
+    UAVObjectsInitialize(m_objMngr);
+}
+
+void tst_ScopeBenchmark::cleanupTestCase()
+{
+    delete m_objMngr;
+}
+
+/**
+ * A float field, and an enum field which is plotted by its numeric value.
+ */
+void tst_ScopeBenchmark::plottedFields()
+{
+    QTest::addColumn<QString>("object");
+    QTest::addColumn<QString>("field");
+
+    QTest::newRow("float") << "Accels" << "x";
+    QTest::newRow("enum") << "FlightStatus" << "Armed";
+}
+
+void tst_ScopeBenchmark::timeSeriesAppend_data()
+{
+    plottedFields();
+}
+
+/**
+ * Feed updates of an object into a time series, as the scope does for every
+ * telemetry update of the plotted object. The window is full early on, so
+ * most appends also evict the oldest sample.
+ */
+void tst_ScopeBenchmark::timeSeriesAppend()
+{
+    QFETCH(QString, object);
+    QFETCH(QString, field);
+    UAVObject *obj = m_objMngr->getObject(object);
+    QVERIFY(obj != NULL);
+
+    TimeSeriesPlotData plotData(object, field);
+    plotData.setXWindowSize(WINDOW_SECONDS);
+
+    QByteArray data(obj->getNumBytes(), 0);
+    obj->pack((quint8*)data.data());
+    qint64 timestamp = 0;
+    int appended = 0;
+
+    QBENCHMARK {
+        appended = 0;
+        for (int n = 0; n < SAMPLES; ++n) {
+            obj->unpack((const quint8*)data.constData(), ++timestamp);
+            appended += plotData.append(obj);
+        }
+    }
+
+    QCOMPARE(appended, SAMPLES);
+}
+
+void tst_ScopeBenchmark::seriesAppend_data()
+{
+    plottedFields();
+}
+
+/**
+ * Same as timeSeriesAppend() for a sequential plot, which keeps a fixed
+ * number of samples.
+ */
+void tst_ScopeBenchmark::seriesAppend()
+{
+    QFETCH(QString, object);
+    QFETCH(QString, field);
+    UAVObject *obj = m_objMngr->getObject(object);
+    QVERIFY(obj != NULL);
+
+    SeriesPlotData plotData(object, field);
+    plotData.setXWindowSize(WINDOW_SECONDS * 1000);
+
+    QByteArray data(obj->getNumBytes(), 0);
+    obj->pack((quint8*)data.data());
+    qint64 timestamp = 0;
+    int appended = 0;
+
+    QBENCHMARK {
+        appended = 0;
+        for (int n = 0; n < SAMPLES; ++n) {
+            obj->unpack((const quint8*)data.constData(), ++timestamp);
+            appended += plotData.append(obj);
+        }
+    }
+
+    QCOMPARE(appended, SAMPLES);
+}
+
+QTEST_GUILESS_MAIN(tst_ScopeBenchmark)
+
+#include "tst_scopebenchmark.moc"
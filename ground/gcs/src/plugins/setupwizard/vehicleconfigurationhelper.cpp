@@ -462,6 +462,7 @@ bool VehicleConfigurationHelper::saveChangesToController(bool save)
             if (m_transactionOK) {
                 qDebug() << "Object " << obj->getName() << " was successfully updated.";
                 if (save) {
+                    // Saved one instance at a time, the board reads each one back to verify it
                     m_transactionOK = false;
                     m_currentTransactionObjectID = obj->getObjID();
                     // Try to save until success or timeout
@@ -57,6 +57,9 @@ UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool useScientificNotati
     m_highlightManager(NULL),
     isInitialized(false)
 {
+    connect(&m_updateCoalescer, SIGNAL(objectsUpdated(QList<UAVObjectCoalescer::Update>)),
+            this, SLOT(highlightUpdatedObjects(QList<UAVObjectCoalescer::Update>)));
+
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     objManager = pm->getObject<UAVObjectManager>();
 
@@ -144,6 +147,8 @@ void UAVObjectTreeModel::instanceRemove(UAVObject *obj)
     if(!dobj)
         return;
 
+    m_updateCoalescer.removeObject(obj);
+
     TopTreeItem *root = dobj->isSettings() ? m_settingsTree : m_nonSettingsTree;
 
     ObjectTreeItem* existing = root->findDataObjectTreeItemByObjectId(obj->getObjID());
@@ -210,7 +215,7 @@ TreeItem* UAVObjectTreeModel::createCategoryItems(QStringList categoryPath, Tree
 
 MetaObjectTreeItem* UAVObjectTreeModel::addMetaObject(UAVMetaObject *obj, TreeItem *parent)
 {
-    connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(highlightUpdatedObject(UAVObject*)));
+    m_updateCoalescer.addObject(obj);
     MetaObjectTreeItem *meta = new MetaObjectTreeItem(obj, tr("Meta Data"));
 
     meta->setHighlightManager(m_highlightManager);
@@ -228,7 +233,7 @@ MetaObjectTreeItem* UAVObjectTreeModel::addMetaObject(UAVMetaObject *obj, TreeIt
 
 void UAVObjectTreeModel::addInstance(UAVObject *obj, TreeItem *parent)
 {
-    connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(highlightUpdatedObject(UAVObject*)));
+    m_updateCoalescer.addObject(obj);
     TreeItem *item;
     DataObjectTreeItem *p = static_cast<DataObjectTreeItem*>(parent);
     if (obj->isSingleInstance()) {
@@ -528,6 +533,13 @@ void UAVObjectTreeModel::highlightUpdatedObject(UAVObject *obj)
     }
 }
 
+void UAVObjectTreeModel::highlightUpdatedObjects(const QList<UAVObjectCoalescer::Update> &updates)
+{
+    foreach (const UAVObjectCoalescer::Update &update, updates) {
+        highlightUpdatedObject(update.obj);
+    }
+}
+
 ObjectTreeItem* UAVObjectTreeModel::findObjectTreeItem(UAVObject *object)
 {
     UAVDataObject *dataObject = qobject_cast<UAVDataObject*>(object);
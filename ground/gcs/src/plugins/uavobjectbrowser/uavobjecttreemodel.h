@@ -30,6 +30,7 @@
 #define UAVOBJECTTREEMODEL_H
 
 #include "treeitem.h"
+#include "uavobjectcoalescer.h"
 #include <QAbstractItemModel>
 #include <QtCore/QMap>
 #include <QtCore/QList>
@@ -89,6 +90,7 @@ public slots:
     void instanceRemove(UAVObject*);
 private slots:
     void highlightUpdatedObject(UAVObject *obj);
+    void highlightUpdatedObjects(const QList<UAVObjectCoalescer::Update> &updates);
     void updateHighlight(TreeItem*);
     void updateCurrentTime();
     void presentOnHardwareChangedCB(UAVDataObject*);
@@ -123,6 +125,8 @@ private:
     bool m_hideNotPresent;
     bool m_categorize;
     QTimer m_currentTimeTimer;
+    // Batches object updates so that the tree refreshes at most once per frame
+    UAVObjectCoalescer m_updateCoalescer;
     QTime m_currentTime;
     UAVObjectManager *objManager;
     // Highlight manager to handle highlighting of tree items.
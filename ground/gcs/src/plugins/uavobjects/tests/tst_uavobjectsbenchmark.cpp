@@ -0,0 +1,437 @@
+/**
+ ******************************************************************************
+ *
+ * @file       tst_uavobjectsbenchmark.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      Benchmarks of the UAVObject and UAVTalk hot paths
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <extensionsystem/pluginmanager.h>
+
+#include <QtTest/QtTest>
+#include <QtCore/QBuffer>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QObject>
+#include <QtCore/QThread>
+
+#include "uavobjectmanager.h"
+#include "uavobjectsinit.h"
+#include "uavtalk/uavtalk.h"
+
+/**
+ * Decodes recorded frames over and over until stopped, as the telemetry
+ * thread does while the gadgets look objects up.
+ */
+class TelemetryFeeder : public QThread
+{
+public:
+    TelemetryFeeder(UAVObjectManager *objMngr, const QByteArray &frames) :
+        m_objMngr(objMngr), m_frames(frames), m_rxObjects(0) {}
+
+    void stop()
+    {
+        m_stop.storeRelease(1);
+        wait();
+    }
+
+    quint32 rxObjects() const { return m_rxObjects; }
+
+protected:
+    void run()
+    {
+        QBuffer link;
+        link.open(QIODevice::ReadOnly);
+        UAVTalk rx(&link, m_objMngr, false);
+        const quint8 *data = (const quint8*)m_frames.constData();
+
+        while (!m_stop.loadAcquire())
+            rx.processInputBuffer(data, m_frames.size());
+
+        m_rxObjects = rx.getStats().rxObjects;
+    }
+
+private:
+    UAVObjectManager *m_objMngr;
+    QByteArray m_frames;
+    QAtomicInt m_stop;
+    quint32 m_rxObjects;
+};
+
+class tst_UAVObjectsBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void parseFrames();
+    void parseLog_data();
+    void parseLog();
+    void getObjectById_data();
+    void getObjectById();
+    void getObjectByName_data();
+    void getObjectByName();
+    void getValue();
+    void getDouble();
+    void getDoubles();
+    void getFloats();
+    void enumsAsNumbers();
+
+private:
+    quint32 decodeLog(bool perByte);
+
+    ExtensionSystem::PluginManager *m_pm;
+    UAVObjectManager *m_objMngr;
+    QByteArray m_frames;
+    QList<QByteArray> m_logPackets;
+    QList<quint32> m_objIds;
+    QStringList m_objNames;
+    QList<UAVObjectField*> m_fields;
+    quint32 m_elements;
+    quint32 m_maxElements;
+};
+
+void tst_UAVObjectsBenchmark::initTestCase()
+{
+    m_pm = new ExtensionSystem::PluginManager();
+    m_objMngr = new UAVObjectManager();
+    UAVObjectsInitialize(m_objMngr);
+
+    // Record one update of every data object, as it would come off the link
+    QBuffer link(&m_frames);
+    link.open(QIODevice::WriteOnly);
+    UAVTalk tx(&link, m_objMngr);
+    foreach (QVector<UAVDataObject*> instances, m_objMngr->getDataObjectsVector()) {
+        QVERIFY(tx.sendObject(instances.first(), false, false));
+        m_objIds.append(instances.first()->getObjID());
+        m_objNames.append(instances.first()->getName());
+    }
+    QVERIFY(m_frames.size() > 0);
+
+    // Every numeric field of every object, as a plot of all of them reads
+    m_elements = 0;
+    m_maxElements = 0;
+    foreach (QVector<UAVDataObject*> instances, m_objMngr->getDataObjectsVector()) {
+        foreach (UAVObjectField *field, instances.first()->getFields()) {
+            if (!field->isNumeric())
+                continue;
+            m_fields.append(field);
+            m_elements += field->getNumElements();
+            m_maxElements = qMax(m_maxElements, field->getNumElements());
+        }
+    }
+    QVERIFY(!m_fields.isEmpty());
+
+    // A recorded .tll log for parseLog(), split into the packets it was
+    // received as. The packets follow the text header ending in a "##" line.
+    QFile log(QString::fromLocal8Bit(qgetenv("TAULABS_BENCHMARK_LOG")));
+    if (!log.fileName().isEmpty() && log.open(QIODevice::ReadOnly)) {
+        QByteArray contents = log.readAll();
+        int pos = contents.left(4096).indexOf("\n##\n");
+        pos = (pos < 0) ? 0 : pos + 4;
+
+        quint32 timestamp;
+        qint64 dataSize;
+        const int headerSize = sizeof(timestamp) + sizeof(dataSize);
+        while (contents.size() - pos >= headerSize) {
+            memcpy(&dataSize, contents.constData() + pos + sizeof(timestamp), sizeof(dataSize));
+            if ((dataSize & 0xFFFFFFFFFFFF0000) != 0 || dataSize < 1 || contents.size() - pos - headerSize < dataSize) {
+                pos++;
+                continue;
+            }
+            m_logPackets.append(contents.mid(pos + headerSize, dataSize));
+            pos += headerSize + dataSize;
+        }
+    }
+}
+
+void tst_UAVObjectsBenchmark::cleanupTestCase()
+{
+    delete m_objMngr;
+    delete m_pm;
+}
+
+/**
+ * Decode a block holding a frame of every object, the way a burst of
+ * telemetry arrives from the serial or USB device.
+ */
+void tst_UAVObjectsBenchmark::parseFrames()
+{
+    QBuffer link;
+    link.open(QIODevice::ReadOnly);
+    UAVTalk rx(&link, m_objMngr);
+    const quint8 *data = (const quint8*)m_frames.constData();
+
+    QBENCHMARK {
+        rx.processInputBuffer(data, m_frames.size());
+    }
+
+    QCOMPARE(rx.getStats().rxErrors, (quint32)0);
+}
+
+/**
+ * The lookups run alone, then while another thread decodes telemetry into
+ * the same manager and so looks objects up as well.
+ */
+static void lookupData()
+{
+    QTest::addColumn<bool>("feeding");
+
+    QTest::newRow("idle") << false;
+    QTest::newRow("feeding telemetry") << true;
+}
+
+void tst_UAVObjectsBenchmark::getObjectById_data()
+{
+    lookupData();
+}
+
+/**
+ * Decode the recorded log once
+ * \param[in] perByte Feed the packets a byte at a time, as the parser was
+ * fed before processInputBuffer()
+ * \return Number of objects decoded
+ */
+quint32 tst_UAVObjectsBenchmark::decodeLog(bool perByte)
+{
+    QBuffer link;
+    link.open(QIODevice::ReadOnly);
+    UAVTalk rx(&link, m_objMngr, false);
+
+    foreach (const QByteArray &packet, m_logPackets) {
+        const quint8 *data = (const quint8*)packet.constData();
+        if (perByte) {
+            for (int n = 0; n < packet.size(); ++n)
+                rx.processInputByte(data[n]);
+        } else {
+            rx.processInputBuffer(data, packet.size());
+        }
+    }
+
+    return rx.getStats().rxObjects;
+}
+
+void tst_UAVObjectsBenchmark::parseLog_data()
+{
+    QTest::addColumn<bool>("perByte");
+
+    QTest::newRow("per byte") << true;
+    QTest::newRow("block") << false;
+}
+
+/**
+ * Decode a recorded log given by the TAULABS_BENCHMARK_LOG environment
+ * variable, reported in decoded frames per second.
+ */
+void tst_UAVObjectsBenchmark::parseLog()
+{
+    if (m_logPackets.isEmpty())
+        QSKIP("Set TAULABS_BENCHMARK_LOG to a recorded .tll log");
+
+    QFETCH(bool, perByte);
+
+    // Both ways of feeding the parser decode the same frames
+    const quint32 frames = decodeLog(true);
+    QVERIFY(frames > 0);
+    QCOMPARE(decodeLog(false), frames);
+
+    QElapsedTimer timer;
+    quint64 decoded = 0;
+    timer.start();
+    do {
+        decoded += decodeLog(perByte);
+    } while (timer.elapsed() < 2000);
+
+    QTest::setBenchmarkResult(decoded * 1000.0 / timer.elapsed(), QTest::FramesPerSecond);
+}
+
+/**
+ * Look up every object by ID, as the telemetry decoder does for each frame.
+ */
+void tst_UAVObjectsBenchmark::getObjectById()
+{
+    QFETCH(bool, feeding);
+    TelemetryFeeder feeder(m_objMngr, m_frames);
+    if (feeding)
+        feeder.start();
+
+    int found = 0;
+
+    QBENCHMARK {
+        found = 0;
+        foreach (quint32 objId, m_objIds)
+            found += m_objMngr->getObject(objId) != NULL;
+    }
+
+    if (feeding) {
+        feeder.stop();
+        QVERIFY(feeder.rxObjects() > 0);
+    }
+    QCOMPARE(found, m_objIds.size());
+}
+
+void tst_UAVObjectsBenchmark::getObjectByName_data()
+{
+    lookupData();
+}
+
+/**
+ * Look up every object by name, as the gadgets do when they are configured.
+ */
+void tst_UAVObjectsBenchmark::getObjectByName()
+{
+    QFETCH(bool, feeding);
+    TelemetryFeeder feeder(m_objMngr, m_frames);
+    if (feeding)
+        feeder.start();
+
+    int found = 0;
+
+    QBENCHMARK {
+        found = 0;
+        foreach (const QString &name, m_objNames)
+            found += m_objMngr->getObject(name) != NULL;
+    }
+
+    if (feeding) {
+        feeder.stop();
+        QVERIFY(feeder.rxObjects() > 0);
+    }
+    QCOMPARE(found, m_objNames.size());
+}
+
+/**
+ * Read every numeric element through the QVariant accessor, the baseline the
+ * typed accessors below are compared against.
+ */
+void tst_UAVObjectsBenchmark::getValue()
+{
+    double sum = 0;
+
+    QBENCHMARK {
+        foreach (UAVObjectField *field, m_fields)
+            for (quint32 n = 0; n < field->getNumElements(); ++n)
+                sum += field->getValue(n).toDouble();
+    }
+
+    Q_UNUSED(sum);
+}
+
+/**
+ * Read every numeric element one at a time through the typed accessor.
+ */
+void tst_UAVObjectsBenchmark::getDouble()
+{
+    double sum = 0;
+
+    QBENCHMARK {
+        foreach (UAVObjectField *field, m_fields)
+            for (quint32 n = 0; n < field->getNumElements(); ++n)
+                sum += field->getDouble(n);
+    }
+
+    Q_UNUSED(sum);
+}
+
+/**
+ * Read every numeric field as a block of doubles.
+ */
+void tst_UAVObjectsBenchmark::getDoubles()
+{
+    QVector<double> values(m_maxElements);
+    quint32 read = 0;
+
+    QBENCHMARK {
+        read = 0;
+        foreach (UAVObjectField *field, m_fields)
+            read += field->getDoubles(values.data(), 0, field->getNumElements());
+    }
+
+    QCOMPARE(read, m_elements);
+}
+
+/**
+ * Read every numeric field as a block of floats.
+ */
+void tst_UAVObjectsBenchmark::getFloats()
+{
+    QVector<float> values(m_maxElements);
+    quint32 read = 0;
+
+    QBENCHMARK {
+        read = 0;
+        foreach (UAVObjectField *field, m_fields)
+            read += field->getFloats(values.data(), 0, field->getNumElements());
+    }
+
+    QCOMPARE(read, m_elements);
+}
+
+/**
+ * Not a benchmark: the accessors above must agree on enums, which are read
+ * and written as their numeric value, with or without a typed accessor.
+ */
+void tst_UAVObjectsBenchmark::enumsAsNumbers()
+{
+    UAVObject *flightStatus = m_objMngr->getObject(QString("FlightStatus"));
+    QVERIFY(flightStatus != NULL);
+    UAVObjectField *armed = flightStatus->getField("Armed");
+    QVERIFY(armed != NULL);
+    QCOMPARE(armed->getType(), UAVObjectField::ENUM);
+
+    double value = -1;
+    float floatValue = -1;
+    armed->setValue("Armed");
+    QCOMPARE(armed->getDouble(), 2.0);
+    QCOMPARE(armed->getDoubles(&value, 0, 1), (quint32)1);
+    QCOMPARE(value, 2.0);
+    QCOMPARE(armed->getFloats(&floatValue, 0, 1), (quint32)1);
+    QCOMPARE(floatValue, 2.0f);
+
+    armed->setDouble(1);
+    QCOMPARE(armed->getValue().toString(), QString("Arming"));
+    armed->setValue("Disarmed");
+
+    // Fields built at runtime have no typed accessor
+    UAVObjectField field("Test", "", UAVObjectField::ENUM, 2,
+                         QStringList() << "Zero" << "One" << "Two");
+    quint8 data[2];
+    field.initialize(data, 0, flightStatus);
+    field.setValue("Two", 0);
+    field.setValue("One", 1);
+
+    double values[2];
+    float floatValues[2];
+    QCOMPARE(field.getDouble(0), 2.0);
+    QCOMPARE(field.getDoubles(values, 0, 2), (quint32)2);
+    QCOMPARE(values[0], 2.0);
+    QCOMPARE(values[1], 1.0);
+    QCOMPARE(field.getFloats(floatValues, 0, 2), (quint32)2);
+    QCOMPARE(floatValues[0], 2.0f);
+    QCOMPARE(floatValues[1], 1.0f);
+}
+
+QTEST_GUILESS_MAIN(tst_UAVObjectsBenchmark)
+
+#include "tst_uavobjectsbenchmark.moc"
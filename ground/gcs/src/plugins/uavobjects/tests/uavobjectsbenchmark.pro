@@ -0,0 +1,20 @@
+# -------------------------------------------------
+# QtTest benchmarks of the UAVObject and UAVTalk hot paths.
+# Build against an existing GCS build tree, then run
+# ./uavobjectsbenchmark (add -callgrind or -tickcounter as needed)
+# parseLog decodes the .tll log named by TAULABS_BENCHMARK_LOG
+# -------------------------------------------------
+TEMPLATE = app
+TARGET = uavobjectsbenchmark
+CONFIG += console qtestlib
+CONFIG -= app_bundle
+QT += testlib network
+
+include(../../../../gcs.pri)
+include(../../uavtalk/uavtalk.pri)
+
+INCLUDEPATH *= $$GCS_SOURCE_TREE/src/plugins
+LIBS += -L$$GCS_PLUGIN_PATH/TauLabs
+unix:!macx:QMAKE_RPATHDIR += $$GCS_PLUGIN_PATH/TauLabs $$GCS_LIBRARY_PATH
+
+SOURCES += tst_uavobjectsbenchmark.cpp
@@ -93,6 +93,7 @@ void UAVMetaObject::setData(const Metadata& mdata)
 {
     QMutexLocker locker(mutex);
     parentMetadata = mdata;
+    timestamp = currentTimestamp();
     emit objectUpdatedAuto(this); // trigger object updated event
     emit objectUpdated(this);
 }
@@ -28,6 +28,8 @@
  */
 #include "uavobject.h"
 #include <QtEndian>
+#include <QDateTime>
+#include <QElapsedTimer>
 #include <QDebug>
 
 // Constants
@@ -54,6 +56,7 @@ UAVObject::UAVObject(quint32 objID, bool isSingleInst, const QString& name)
     this->instID = 0;
     this->isSingleInst = isSingleInst;
     this->name = name;
+    this->timestamp = 0;
     this->mutex = new QMutex(QMutex::Recursive);
 }
 
@@ -192,6 +195,7 @@ void UAVObject::requestUpdateAllInstances()
  */
 void UAVObject::updated()
 {
+    setTimestamp(currentTimestamp());
     emit objectUpdatedManual(this);
     emit objectUpdated(this);
 }
@@ -284,12 +288,23 @@ qint32 UAVObject::pack(quint8* dataOut)
 }
 
 /**
- * Unpack the object data from a byte array
+ * Unpack the object data from a byte array, timestamped with the current time
  * @returns The number of bytes copied
  */
 qint32 UAVObject::unpack(const quint8* dataIn)
+{
+    return unpack(dataIn, currentTimestamp());
+}
+
+/**
+ * Unpack the object data from a byte array
+ * @param timestamp Time the data was received, see currentTimestamp()
+ * @returns The number of bytes copied
+ */
+qint32 UAVObject::unpack(const quint8* dataIn, qint64 timestamp)
 {
     QMutexLocker locker(mutex);
+    this->timestamp = timestamp;
     qint32 offset = 0;
     for (QList<UAVObjectField*>::iterator iter = fields.begin(); iter != fields.end(); ++iter)
     {
@@ -303,6 +318,44 @@ qint32 UAVObject::unpack(const quint8* dataIn)
     return numBytes;
 }
 
+/**
+ * Get the time of the last update of this object
+ * @returns Time in ms since the epoch, see currentTimestamp()
+ */
+qint64 UAVObject::getTimestamp()
+{
+    QMutexLocker locker(mutex);
+    return timestamp;
+}
+
+/**
+ * Set the time of the last update of this object
+ */
+void UAVObject::setTimestamp(qint64 timestamp)
+{
+    QMutexLocker locker(mutex);
+    this->timestamp = timestamp;
+}
+
+namespace {
+struct TimestampClock {
+    TimestampClock() : epoch(QDateTime::currentMSecsSinceEpoch()) { timer.start(); }
+    qint64 epoch;
+    QElapsedTimer timer;
+};
+}
+
+/**
+ * Clock used to timestamp object updates, in ms since the epoch. The wall
+ * clock is only read once, later readings come from a monotonic timer so they
+ * are cheap and never jump when the system time changes.
+ */
+qint64 UAVObject::currentTimestamp()
+{
+    static const TimestampClock clock;
+    return clock.epoch + clock.timer.elapsed();
+}
+
 /**
  * Save the object data to the file.
  * The file will be created in the current directory
@@ -109,6 +109,9 @@ public:
     quint32 getNumBytes(); 
     qint32 pack(quint8* dataOut);
     qint32 unpack(const quint8* dataIn);
+    qint32 unpack(const quint8* dataIn, qint64 timestamp);
+    qint64 getTimestamp();
+    void setTimestamp(qint64 timestamp);
     bool save();
     bool save(QFile& file);
     bool load();
@@ -145,6 +148,8 @@ public:
     static void SetFlightTelemetryUpdateMode(Metadata& meta, UpdateMode val);
     static UpdateMode GetGcsTelemetryUpdateMode(const Metadata& meta);
     static void SetGcsTelemetryUpdateMode(Metadata& meta, UpdateMode val);
+
+    static qint64 currentTimestamp();
 		
 public slots:
     void requestUpdate();
@@ -239,6 +244,7 @@ protected:
     quint32 numBytes;
     QMutex* mutex;
     quint8* data;
+    qint64 timestamp; // Time of the last update, in ms since the epoch
     QList<UAVObjectField*> fields;
     void initializeFields(QList<UAVObjectField*>& fields, quint8* data, quint32 numBytes);
     void setDescription(const QString& description);
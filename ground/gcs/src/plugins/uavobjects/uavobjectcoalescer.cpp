@@ -0,0 +1,110 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjectcoalescer.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      Batched delivery of object updates
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify 
+ * it under the terms of the GNU General Public License as published by 
+ * the Free Software Foundation; either version 3 of the License, or 
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but 
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY 
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License 
+ * for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "uavobjectcoalescer.h"
+
+/**
+ * Constructor
+ * @param intervalMs Minimum time between two batches
+ */
+UAVObjectCoalescer::UAVObjectCoalescer(int intervalMs, QObject* parent) :
+    QObject(parent)
+{
+    timer.setSingleShot(true);
+    timer.setInterval(intervalMs);
+    connect(&timer, SIGNAL(timeout()), this, SLOT(deliver()));
+}
+
+/**
+ * Start coalescing the updates of an object. Adding an object twice has no effect.
+ */
+void UAVObjectCoalescer::addObject(UAVObject* obj)
+{
+    connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(objectUpdated(UAVObject*)), Qt::UniqueConnection);
+}
+
+/**
+ * Stop coalescing the updates of an object, pending updates are dropped.
+ */
+void UAVObjectCoalescer::removeObject(UAVObject* obj)
+{
+    disconnect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(objectUpdated(UAVObject*)));
+    if (updateCounts.remove(obj) > 0)
+        dirty.removeOne(obj);
+}
+
+/**
+ * Change the minimum time between two batches
+ */
+void UAVObjectCoalescer::setInterval(int intervalMs)
+{
+    timer.setInterval(intervalMs);
+}
+
+/**
+ * Mark an object as updated. The first update after a batch arms the timer,
+ * so nothing runs while the objects are idle.
+ */
+void UAVObjectCoalescer::objectUpdated(UAVObject* obj)
+{
+    QHash<UAVObject*, quint32>::iterator i = updateCounts.find(obj);
+    if (i == updateCounts.end())
+    {
+        updateCounts.insert(obj, 1);
+        dirty.append(obj);
+    }
+    else
+    {
+        ++i.value();
+    }
+
+    if (!timer.isActive())
+        timer.start();
+}
+
+/**
+ * Emit the batch of objects updated since the last one
+ */
+void UAVObjectCoalescer::deliver()
+{
+    if (dirty.isEmpty())
+        return;
+
+    QList<Update> updates;
+    updates.reserve(dirty.size());
+    foreach (UAVObject* obj, dirty)
+    {
+        Update update;
+        update.obj = obj;
+        update.skipped = updateCounts.value(obj) - 1;
+        updates.append(update);
+    }
+    dirty.clear();
+    updateCounts.clear();
+
+    emit objectsUpdated(updates);
+}
@@ -0,0 +1,81 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjectcoalescer.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      Batched delivery of object updates
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify 
+ * it under the terms of the GNU General Public License as published by 
+ * the Free Software Foundation; either version 3 of the License, or 
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but 
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY 
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License 
+ * for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef UAVOBJECTCOALESCER_H
+#define UAVOBJECTCOALESCER_H
+
+#include "uavobjects_global.h"
+#include "uavobject.h"
+#include <QTimer>
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+
+/**
+ * Collects objectUpdated() signals from a set of objects and delivers them
+ * as a single batch at most once per interval. Each object appears once in
+ * a batch, the consumer reads the latest data from the object itself.
+ *
+ * This is meant for displays that refresh at a fixed rate. Consumers that
+ * need every sample, like logging, should keep connecting to objectUpdated().
+ * The coalescer must live in the thread the objects are updated from.
+ */
+class UAVOBJECTS_EXPORT UAVObjectCoalescer: public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef struct {
+        UAVObject* obj;
+        quint32 skipped; /** Number of updates since the last batch that were not delivered */
+    } Update;
+
+    explicit UAVObjectCoalescer(int intervalMs = 33, QObject* parent = 0);
+    void addObject(UAVObject* obj);
+    void removeObject(UAVObject* obj);
+    void setInterval(int intervalMs);
+
+signals:
+    /**
+     * @brief objectsUpdated: emitted once per interval with every object
+     * that was updated since the previous batch, in order of first update.
+     */
+    void objectsUpdated(const QList<UAVObjectCoalescer::Update>& updates);
+
+private slots:
+    void objectUpdated(UAVObject* obj);
+    void deliver();
+
+private:
+    QTimer timer;
+    QList<UAVObject*> dirty;
+    QHash<UAVObject*, quint32> updateCounts;
+};
+
+Q_DECLARE_METATYPE(UAVObjectCoalescer::Update)
+
+#endif // UAVOBJECTCOALESCER_H
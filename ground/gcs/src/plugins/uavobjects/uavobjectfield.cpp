@@ -58,6 +58,7 @@ void UAVObjectField::constructorInitialize(const QString& name, const QString& u
     this->offset = 0;
     this->data = NULL;
     this->obj = NULL;
+    this->accessor = NULL;
     this->elementNames = elementNames;
     // Set field size
     switch (type)
@@ -1034,13 +1035,101 @@ void UAVObjectField::setValue(const QVariant& value, quint32 index)
     }
 }
 
+/**
+ * Read an element as a double. Enum fields are read as their numeric value,
+ * like getDoubles() does.
+ */
 double UAVObjectField::getDouble(quint32 index)
 {
+    double value = 0;
+    getDoubles(&value, index, 1);
+    return value;
+}
+
+/**
+ * Attach the typed accessor generated for this field. It is used by
+ * getDouble(), getDoubles() and getFloats() to read the field data
+ * without going through QVariant.
+ */
+void UAVObjectField::setAccessor(const Accessor* accessor)
+{
+    Q_ASSERT(accessor == NULL || (accessor->type == type && accessor->offset == offset));
+    this->accessor = accessor;
+}
+
+/**
+ * Copy a range of elements into an array of doubles. Enum fields are
+ * copied as their numeric value.
+ * @param out Output array, must hold at least count elements
+ * @param first Index of the first element to copy
+ * @param count Number of elements to copy
+ * @return The number of elements copied, 0 if the range is out of bounds
+ */
+quint32 UAVObjectField::getDoubles(double* out, quint32 first, quint32 count)
+{
+    if (first >= numElements || count > numElements - first)
+        return 0;
+
+    if (accessor == NULL)
+    {
+        for (quint32 n = 0; n < count; ++n)
+            out[n] = elementAsDouble(first + n);
+        return count;
+    }
+
+    QMutexLocker locker(obj->getMutex());
+    accessor->toDouble(&data[accessor->offset + numBytesPerElement*first], count, out);
+    return count;
+}
+
+/**
+ * Same as getDoubles() but converts the elements to floats.
+ */
+quint32 UAVObjectField::getFloats(float* out, quint32 first, quint32 count)
+{
+    if (first >= numElements || count > numElements - first)
+        return 0;
+
+    if (accessor == NULL)
+    {
+        for (quint32 n = 0; n < count; ++n)
+            out[n] = elementAsDouble(first + n);
+        return count;
+    }
+
+    QMutexLocker locker(obj->getMutex());
+    accessor->toFloat(&data[accessor->offset + numBytesPerElement*first], count, out);
+    return count;
+}
+
+/**
+ * Read an element without a typed accessor. getValue() returns enums as
+ * their option string, they are read as their numeric value instead.
+ */
+double UAVObjectField::elementAsDouble(quint32 index)
+{
+    if (type == ENUM)
+    {
+        QMutexLocker locker(obj->getMutex());
+        return data[offset + numBytesPerElement*index];
+    }
+
     return getValue(index).toDouble();
 }
 
+/**
+ * Set an element from a double. Enum fields are set by their numeric value,
+ * the way getDouble() returns them.
+ */
 void UAVObjectField::setDouble(double value, quint32 index)
 {
+    if (type == ENUM)
+    {
+        if (value >= 0 && value < options.length())
+            setValue(options.at((int)value), index);
+        return;
+    }
+
     setValue(QVariant(value), index);
 }
 
@@ -34,6 +34,7 @@
 #include <QVariant>
 #include <QList>
 #include <QMap>
+#include <string.h>
 
 class UAVObject;
 
@@ -51,9 +52,35 @@ public:
         int board;
     } LimitStruct;
 
+    /**
+     * Typed access to the elements of a field, generated by uavobjgenerator.
+     * The readers convert count elements starting at data into the output array.
+     */
+    typedef void (*DoubleReader)(const quint8* data, quint32 count, double* out);
+    typedef void (*FloatReader)(const quint8* data, quint32 count, float* out);
+    typedef struct
+    {
+        quint32 offset;
+        FieldType type;
+        DoubleReader toDouble;
+        FloatReader toFloat;
+    } Accessor;
+
+    template <typename From, typename To>
+    static void convertElements(const quint8* data, quint32 count, To* out)
+    {
+        for (quint32 n = 0; n < count; ++n)
+        {
+            From value;
+            memcpy(&value, &data[n*sizeof(From)], sizeof(From));
+            out[n] = value;
+        }
+    }
+
     UAVObjectField(const QString& name, const QString& units, FieldType type, quint32 numElements, const QStringList& options,const QString& limits=QString());
     UAVObjectField(const QString& name, const QString& units, FieldType type, const QStringList& elementNames, const QStringList& options,const QString& limits=QString());
     void initialize(quint8* data, quint32 dataOffset, UAVObject* obj);
+    void setAccessor(const Accessor* accessor);
     UAVObject* getObject();
     FieldType getType();
     QString getTypeAsString();
@@ -69,6 +96,8 @@ public:
     void setValue(const QVariant& data, quint32 index = 0);
     double getDouble(quint32 index = 0);
     void setDouble(double value, quint32 index = 0);
+    quint32 getDoubles(double* out, quint32 first, quint32 count);
+    quint32 getFloats(float* out, quint32 first, quint32 count);
     quint32 getDataOffset();
     quint32 getNumBytes();
     bool isNumeric();
@@ -92,8 +121,10 @@ protected:
     quint32 offset;
     quint8* data;
     UAVObject* obj;
+    const Accessor* accessor;
     QMap<quint32, QList<LimitStruct> > elementLimits;
     void clear();
+    double elementAsDouble(quint32 index);
     void constructorInitialize(const QString& name, const QString& units, FieldType type, const QStringList& elementNames, const QStringList& options, const QString &limits);
     void limitsInitialize(const QString &limits);
 
@@ -34,13 +34,58 @@
 UAVObjectManager::UAVObjectManager()
 {
     mutex = new QMutex(QMutex::Recursive);
+    registry.storeRelease(new Registry());
 }
 
 UAVObjectManager::~UAVObjectManager()
 {
+    releaseRegistries();
+    delete registry.loadAcquire();
     delete mutex;
 }
 
+/**
+ * Find the instances of an object given either its name or its ID
+ * @returns The instance vector or NULL if the object is not registered
+ */
+const QVector<UAVObject*>* UAVObjectManager::Registry::find(const QString* name, quint32 objId) const
+{
+    if(name != NULL)
+    {
+        QHash<QString, quint32>::const_iterator n = names.constFind(*name);
+        if(n == names.constEnd())
+            return NULL;
+        objId = n.value();
+    }
+    QHash<quint32, QVector<UAVObject*> >::const_iterator i = instances.constFind(objId);
+    if(i == instances.constEnd())
+        return NULL;
+    return &i.value();
+}
+
+UAVObjectManager::RegistryReader::RegistryReader(UAVObjectManager* mngr)
+{
+    // Registrations only mark the snapshot stale, so that registering all the
+    // objects at startup builds it once instead of once per object
+    if (mngr->registryStale.loadAcquire())
+    {
+        QMutexLocker locker(mngr->mutex);
+        if (mngr->registryStale.loadAcquire())
+            mngr->publishRegistry();
+    }
+
+    mngr->registryAcquirers.ref();
+    registry = mngr->registry.loadAcquire();
+    registry->refs.ref();
+    mngr->registryAcquirers.deref();
+}
+
+UAVObjectManager::RegistryReader::~RegistryReader()
+{
+    if (!registry->refs.deref())
+        delete registry;
+}
+
 /**
  * Register an object with the manager. This function must be called for all newly created instances.
  * A new instance can be created directly by instantiating a new object or by calling clone() of
@@ -75,19 +120,22 @@ bool UAVObjectManager::registerObject(UAVDataObject* obj)
                 QMap<quint32,UAVObject*> ppp;
                 ppp.insert(instidx,cobj);
                 objects[objID].insert(instidx,cobj);
-                getObject(cobj->getObjID())->emitNewInstance(cobj);//TODO??
+                registryStale.storeRelease(1);
+                // Through the map, a lookup would rebuild the snapshot for every clone
+                objects[objID].first()->emitNewInstance(cobj);
                 emit newInstance(cobj);
             }
         }
         else if (obj->getInstID() == 0)
-            obj->initialize(objects.value(objID).last()->getObjID() + 1, mobj);
+            obj->initialize(objects.value(objID).last()->getInstID() + 1, mobj);
         else
         {
             return false;
         }
         // Add the actual object instance in the list
         objects[objID].insert(obj->getInstID(),obj);
-        getObject(objID)->emitNewInstance(obj);
+        registryStale.storeRelease(1);
+        objects[objID].first()->emitNewInstance(obj);
         emit newInstance(obj);
         return true;
     }
@@ -127,6 +175,7 @@ bool UAVObjectManager::unRegisterObject(UAVDataObject* obj)
         emit instanceRemoved(objects.value(objID).value(x));
         objects[objID].remove(x);
     }
+    registryStale.storeRelease(1);
     return true;
 }
 
@@ -136,9 +185,57 @@ void UAVObjectManager::addObject(UAVObject* obj)
     QMap<quint32,UAVObject*> list;
     list.insert(obj->getInstID(),obj);
     objects.insert(obj->getObjID(),list);
+    registryStale.storeRelease(1);
     emit newObject(obj);
 }
 
+/**
+ * Replace the registry snapshot with one built from the current objects.
+ * Must be called with the mutex held. The replaced snapshot is freed by
+ * whoever drops the last reference to it, once no reader can still be about
+ * to take one.
+ */
+void UAVObjectManager::publishRegistry()
+{
+    registryStale.storeRelease(0);
+
+    Registry* next = new Registry();
+    for (QHash<quint32, ObjectMap>::const_iterator o = objects.constBegin(); o != objects.constEnd(); ++o)
+    {
+        const ObjectMap& map = o.value();
+        if (map.isEmpty())
+            continue;
+        QVector<UAVObject*> instances(map.lastKey() + 1, NULL);
+        for (ObjectMap::const_iterator i = map.constBegin(); i != map.constEnd(); ++i)
+            instances[i.key()] = i.value();
+        next->instances.insert(o.key(), instances);
+        next->names.insert(map.first()->getName(), o.key());
+    }
+
+    retiredRegistries.append(registry.fetchAndStoreOrdered(next));
+
+    // A reader may have loaded a replaced pointer without referencing it yet.
+    // Rather than waiting for that window to close, the replaced snapshots
+    // are kept until a publish finds no reader inside it.
+    if (registryAcquirers.loadAcquire() == 0)
+        releaseRegistries();
+}
+
+/**
+ * Drop the manager's reference to the replaced snapshots. Must be called with
+ * the mutex held and no reader between loading the snapshot pointer and
+ * referencing it.
+ */
+void UAVObjectManager::releaseRegistries()
+{
+    foreach (const Registry* prev, retiredRegistries)
+    {
+        if (!prev->refs.deref())
+            delete prev;
+    }
+    retiredRegistries.clear();
+}
+
 /**
  * Get all objects. A two dimentional QVector is returned. Objects are grouped by
  * instances of the same object type.
@@ -233,18 +330,11 @@ UAVObject* UAVObjectManager::getObject(quint32 objId, quint32 instId)
  */
 UAVObject* UAVObjectManager::getObject(const QString* name, quint32 objId, quint32 instId)
 {
-    QMutexLocker locker(mutex);
-    if(name != NULL)
-    {
-        foreach(ObjectMap map,objects)
-        {
-            if(map.first()->getName().compare(name) == 0)
-                return map.value(instId,NULL);
-        }
-    }
-    else if(objects.contains(objId))
-        return objects.value(objId).value(instId);
-    return NULL;
+    RegistryReader reader(this);
+    const QVector<UAVObject*>* instances = reader->find(name, objId);
+    if(instances == NULL || instId >= (quint32)instances->size())
+        return NULL;
+    return instances->at(instId);
 }
 
 /**
@@ -268,18 +358,11 @@ QVector<UAVObject*> UAVObjectManager::getObjectInstancesVector(quint32 objId)
  */
 QVector<UAVObject*> UAVObjectManager::getObjectInstancesVector(const QString* name, quint32 objId)
 {
-    QMutexLocker locker(mutex);
-    if(name != NULL)
-    {
-        foreach(ObjectMap map,objects)
-        {
-            if(map.first()->getName().compare(name) == 0)
-                return map.values().toVector();
-        }
-    }
-    else if(objects.contains(objId))
-        return objects.value(objId).values().toVector();
-    return  QVector<UAVObject*>();
+    RegistryReader reader(this);
+    const QVector<UAVObject*>* instances = reader->find(name, objId);
+    if(instances == NULL)
+        return QVector<UAVObject*>();
+    return *instances;
 }
 
 /**
@@ -303,16 +386,9 @@ qint32 UAVObjectManager::getNumInstances(quint32 objId)
  */
 qint32 UAVObjectManager::getNumInstances(const QString* name, quint32 objId)
 {
-    QMutexLocker locker(mutex);
-    if(name != NULL)
-    {
-        foreach(ObjectMap map,objects)
-        {
-            if(map.first()->getName().compare(name) == 0)
-                return map.count();
-        }
-    }
-    else if(objects.contains(objId))
-        return objects.value(objId).count();
-    return -1;
+    RegistryReader reader(this);
+    const QVector<UAVObject*>* instances = reader->find(name, objId);
+    if(instances == NULL)
+        return -1;
+    return instances->size();
 }
@@ -37,6 +37,9 @@
 #include <QMutexLocker>
 #include <QVector>
 #include <QHash>
+#include <QList>
+#include <QAtomicPointer>
+#include <QAtomicInt>
 
 class UAVOBJECTS_EXPORT UAVObjectManager: public QObject
 {
@@ -64,10 +67,49 @@ signals:
     void instanceRemoved(UAVObject* obj);
 private:
     static const quint32 MAX_INSTANCES = 1000;
+
+    /**
+     * Immutable snapshot of the registered objects used by the lookup functions.
+     * Instances are stored in a flat vector indexed by instance ID. A snapshot
+     * is referenced by the manager while it is current and by each reader
+     * using it, and is freed when the last reference is dropped.
+     */
+    struct Registry {
+        Registry() : refs(1) {}
+
+        QHash<quint32, QVector<UAVObject*> > instances;
+        QHash<QString, quint32> names;
+        mutable QAtomicInt refs;
+
+        const QVector<UAVObject*>* find(const QString* name, quint32 objId) const;
+    };
+
+    /**
+     * Scoped access to the current registry snapshot. Holds a reference on
+     * the snapshot so it outlives a replacement published meanwhile.
+     */
+    class RegistryReader {
+    public:
+        RegistryReader(UAVObjectManager* mngr);
+        ~RegistryReader();
+        const Registry* operator->() const { return registry; }
+    private:
+        const Registry* registry;
+    };
+
     QHash<quint32, QMap<quint32,UAVObject*> > objects;
     QMutex* mutex;
+    QAtomicPointer<const Registry> registry;
+    // Readers between loading the snapshot pointer and referencing it
+    QAtomicInt registryAcquirers;
+    // Set when the objects changed since the snapshot was built
+    QAtomicInt registryStale;
+    // Replaced snapshots a reader may still be about to reference
+    QList<const Registry*> retiredRegistries;
 
     void addObject(UAVObject* obj);
+    void publishRegistry();
+    void releaseRegistries();
     UAVObject* getObject(const QString* name, quint32 objId, quint32 instId);
     QVector<UAVObject*> getObjectInstancesVector(const QString* name, quint32 objId);
     qint32 getNumInstances(const QString* name, quint32 objId);
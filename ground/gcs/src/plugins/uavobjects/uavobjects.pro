@@ -8,6 +8,7 @@ HEADERS += uavobjects_global.h \
     uavobject.h \
     uavmetaobject.h \
     uavobjectmanager.h \
+    uavobjectcoalescer.h \
     uavdataobject.h \
     uavobjectfield.h \
     uavobjectsinit.h \
@@ -16,6 +17,7 @@ HEADERS += uavobjects_global.h \
 SOURCES += uavobject.cpp \
     uavmetaobject.cpp \
     uavobjectmanager.cpp \
+    uavobjectcoalescer.cpp \
     uavdataobject.cpp \
     uavobjectfield.cpp \
     uavobjectsplugin.cpp
@@ -90,6 +92,7 @@ HEADERS += $$UAVOBJECT_SYNTHETICS/accels.h \
     $$UAVOBJECT_SYNTHETICS/loitercommand.h \
     $$UAVOBJECT_SYNTHETICS/loggingsettings.h \
     $$UAVOBJECT_SYNTHETICS/loggingstats.h \
+    $$UAVOBJECT_SYNTHETICS/looplatency.h \
     $$UAVOBJECT_SYNTHETICS/magbias.h \
     $$UAVOBJECT_SYNTHETICS/magnetometer.h \
     $$UAVOBJECT_SYNTHETICS/manualcontrolsettings.h \
@@ -211,6 +214,7 @@ SOURCES += $$UAVOBJECT_SYNTHETICS/accels.cpp \
     $$UAVOBJECT_SYNTHETICS/loitercommand.cpp \
     $$UAVOBJECT_SYNTHETICS/loggingsettings.cpp \
     $$UAVOBJECT_SYNTHETICS/loggingstats.cpp \
+    $$UAVOBJECT_SYNTHETICS/looplatency.cpp \
     $$UAVOBJECT_SYNTHETICS/magbias.cpp \
     $$UAVOBJECT_SYNTHETICS/magnetometer.cpp \
     $$UAVOBJECT_SYNTHETICS/manualcontrolsettings.cpp \
@@ -32,11 +32,19 @@
  */
 #include "$(NAMELC).h"
 #include "uavobjectfield.h"
+#include <stddef.h>
 
 const QString $(NAME)::NAME = QString("$(NAME)");
 const QString $(NAME)::DESCRIPTION = QString("$(DESCRIPTION)");
 const QString $(NAME)::CATEGORY = QString("$(CATEGORY)");
 
+/**
+ * Typed field accessors, in the same order as the fields
+ */
+static const UAVObjectField::Accessor accessors[] = {
+$(FIELDACCESSORS)
+};
+
 /**
  * Constructor
  */
@@ -47,6 +55,8 @@ $(NAME)::$(NAME)(): UAVDataObject(OBJID, ISSINGLEINST, ISSETTINGS, NAME)
 $(FIELDSINIT)
     // Initialize object
     initializeFields(fields, (quint8*)&data, NUMBYTES);
+    for (int n = 0; n < fields.length(); ++n)
+        fields[n]->setAccessor(&accessors[n]);
     // Set the default field values
     setDefaultFieldValues();
     // Set the object description
@@ -109,6 +119,7 @@ void $(NAME)::setData(const DataFields& data)
     if ( UAVObject::GetGcsAccess(mdata) == ACCESS_READWRITE )
     {
         this->data = data;
+        timestamp = currentTimestamp();
         emit objectUpdatedAuto(this); // trigger object updated event
         emit objectUpdated(this);
     }
@@ -0,0 +1,163 @@
+/**
+ ******************************************************************************
+ * @file       logbatchdecoder.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Decodes a whole GCS log as fast as possible, without replaying it
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "logbatchdecoder.h"
+#include "uavtalk.h"
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <string.h>
+
+/**
+ * Constructor
+ * \param[in] fileName Log to decode
+ * \param[in] objMngr Object manager receiving the decoded objects
+ */
+LogBatchDecoder::LogBatchDecoder(const QString &fileName, UAVObjectManager *objMngr, QObject *parent) :
+    QThread(parent),
+    fileName(fileName),
+    objMngr(objMngr),
+    aborted(0),
+    success(false),
+    packetCount(0),
+    bytesDecoded(0),
+    elapsedMs(0)
+{
+}
+
+/**
+ * Decode the log on the calling thread. Packets with a corrupted header are
+ * skipped by searching for the next plausible header, as replay does.
+ * \return Success (true), Failure (false)
+ */
+bool LogBatchDecoder::decode()
+{
+    success = false;
+    packetCount = 0;
+    bytesDecoded = 0;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "LogBatchDecoder: unable to open" << fileName;
+        return false;
+    }
+
+    const qint64 size = file.size();
+    const uchar *log = file.map(0, size);
+    if (log == NULL) {
+        qDebug() << "LogBatchDecoder: unable to map" << fileName;
+        return false;
+    }
+
+    // The packets start after the text header, which ends with a "##" line.
+    // Headerless logs are decoded from the start, like replay does.
+    qint64 pos = 0;
+    const char separator[] = "\n##\n";
+    const qint64 headerLimit = qMin(size, (qint64)4096);
+    for (qint64 i = 0; i + 4 <= headerLimit; i++) {
+        if (memcmp(&log[i], separator, 4) == 0) {
+            pos = i + 4;
+            break;
+        }
+    }
+
+    // The parser needs a device, but is only fed through processInputBuffer().
+    // Decoding a log is not link traffic, keep it off the UDP mirror.
+    QBuffer idle;
+    UAVTalk uavTalk(&idle, objMngr, false);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    quint32 timestamp;
+    qint64 dataSize;
+    const qint64 headerSize = sizeof(timestamp) + sizeof(dataSize);
+    int lastPercent = -1;
+
+    while (size - pos >= headerSize && !aborted.load()) {
+        memcpy(&timestamp, &log[pos], sizeof(timestamp));
+        memcpy(&dataSize, &log[pos + sizeof(timestamp)], sizeof(dataSize));
+
+        //Check if dataSize sync bytes are correct.
+        if ((dataSize & 0xFFFFFFFFFFFF0000) != 0 || dataSize < 1 || size - pos - headerSize < dataSize) {
+            pos++;
+            continue;
+        }
+
+        uavTalk.setReceiveTimestamp(timestamp);
+        uavTalk.processInputBuffer(&log[pos + headerSize], dataSize);
+
+        pos += headerSize + dataSize;
+        packetCount++;
+
+        int percent = pos * 100 / size;
+        if (percent != lastPercent) {
+            lastPercent = percent;
+            emit progress(percent);
+        }
+    }
+
+    elapsedMs = timer.elapsed();
+    bytesDecoded = pos;
+
+    file.unmap((uchar *)log);
+    file.close();
+
+    success = !aborted.load();
+
+    qDebug() << "LogBatchDecoder: decoded" << packetCount << "packets," << bytesDecoded << "bytes in" << elapsedMs << "ms," << getThroughput() << "MB/s";
+
+    return success;
+}
+
+/**
+ * Stop decoding as soon as possible. Safe to call from any thread.
+ */
+void LogBatchDecoder::abort()
+{
+    aborted.store(1);
+}
+
+/**
+ * Throughput of the last decode
+ * \return Decoded log size per second, in MB/s
+ */
+double LogBatchDecoder::getThroughput()
+{
+    if (elapsedMs <= 0)
+        return 0;
+
+    return bytesDecoded / 1048576.0 / (elapsedMs / 1000.0);
+}
+
+/**
+ * Decode on the thread started by start()
+ */
+void LogBatchDecoder::run()
+{
+    decode();
+}
@@ -0,0 +1,78 @@
+/**
+ ******************************************************************************
+ * @file       logbatchdecoder.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Decodes a whole GCS log as fast as possible, without replaying it
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LOGBATCHDECODER_H
+#define LOGBATCHDECODER_H
+
+#include <QThread>
+#include <QFile>
+#include <QAtomicInt>
+#include "uavobjectmanager.h"
+#include "uavtalk_global.h"
+
+/**
+ * Batch decoder for GCS logs (.tll). The log is memory mapped and every packet
+ * is handed straight to a UAVTalk parser attached to the given object manager,
+ * with no timer or event loop in between. The objects are stamped with the
+ * time the packet was logged, in ms since the start of the log.
+ *
+ * Use a detached UAVObjectManager and connect consumers to its objects with
+ * Qt::DirectConnection: when started as a thread, the object updates are
+ * emitted from the decoder thread.
+ */
+class UAVTALK_EXPORT LogBatchDecoder : public QThread
+{
+    Q_OBJECT
+
+public:
+    LogBatchDecoder(const QString &fileName, UAVObjectManager *objMngr, QObject *parent = 0);
+
+    bool decode();
+    void abort();
+
+    bool getSuccess() { return success; }
+    quint32 getPacketCount() { return packetCount; }
+    qint64 getBytesDecoded() { return bytesDecoded; }
+    double getThroughput();
+
+signals:
+    void progress(int percent);
+
+protected:
+    void run();
+
+private:
+    QString fileName;
+    UAVObjectManager *objMngr;
+    QAtomicInt aborted;
+
+    bool success;
+    quint32 packetCount;
+    qint64 bytesDecoded;
+    qint64 elapsedMs;
+};
+
+#endif // LOGBATCHDECODER_H
@@ -65,7 +65,7 @@ public:
 
     bool operator<(const TransactionKey & rhs) const {
         return objId < rhs.objId || (objId == rhs.objId && instId < rhs.instId) ||
-                (objId == rhs.objId && instId == rhs.instId && req != rhs.req);
+                (objId == rhs.objId && instId == rhs.instId && !req && rhs.req);
     }
 
     quint32 objId;
@@ -276,6 +276,21 @@ void Telemetry::updateObject(UAVObject* obj, quint32 eventType)
  */
 void Telemetry::transactionSuccess(UAVObject* obj)
 {
+    // The object changed again while waiting for this ack, send it once more
+    // rather than completing with stale data on the other end
+    QMap<TransactionKey, ObjectTransactionInfo*>::iterator itr = transMap.find(TransactionKey(obj, false));
+    if (itr != transMap.end() && itr.value()->updatePending) {
+        ObjectTransactionInfo *transInfo = itr.value();
+        transInfo->timer->stop();
+        transInfo->updatePending = false;
+        transInfo->retriesRemaining = MAX_RETRIES;
+        processObjectTransaction(transInfo);
+        obj->emitTransactionCompleted(true);
+        obj->emitTransactionCompleted(true,false);
+        processObjectQueue();
+        return;
+    }
+
     if (updateTransactionMap(obj,false)) {
         TELEMETRY_QXTLOG_DEBUG(QString("[telemetry.cpp] Transaction succeeded:%0 Instance:%1").arg(obj->getName() + QString(QString(" 0x") + QString::number(obj->getObjID(), 16).toUpper())).arg(obj->getInstID()));
         obj->emitTransactionCompleted(true);
@@ -368,6 +383,8 @@ void Telemetry::transactionTimeout(ObjectTransactionInfo *transInfo)
     {
         TELEMETRY_QXTLOG_DEBUG(QString("[telemetry.cpp] Transaction timeout:%0 Instance:%1 Retrying").arg(transInfo->obj->getName() + QString(QString(" 0x") + QString::number(transInfo->obj->getObjID(), 16).toUpper())).arg(transInfo->obj->getInstID()));
         --transInfo->retriesRemaining;
+        // The retry sends the latest data
+        transInfo->updatePending = false;
         processObjectTransaction(transInfo);
         ++txRetries;
     }
@@ -499,10 +516,16 @@ void Telemetry::processObjectQueue()
     UAVObject::UpdateMode updateMode = UAVObject::GetGcsTelemetryUpdateMode(metadata);
     if ( ( objInfo.event != EV_UNPACKED ) && ( ( objInfo.event != EV_UPDATED_PERIODIC ) || ( updateMode != UAVObject::UPDATEMODE_THROTTLED ) ) )
     {
-        // We are either going to send an object, or are requesting one:
-        if (transMap.contains(TransactionKey(objInfo.obj, objInfo.event == EV_UPDATE_REQ))) {
+        // We are either going to send an object, or are requesting one.
+        // Transactions of different objects are all in flight at once,
+        // only one per object instance and direction is outstanding.
+        QMap<TransactionKey, ObjectTransactionInfo*>::iterator itr = transMap.find(TransactionKey(objInfo.obj, objInfo.event == EV_UPDATE_REQ));
+        if (itr != transMap.end()) {
             TELEMETRY_QXTLOG_DEBUG(QString("[telemetry.cpp] Warning: Got request for %0 for which a request is already in progress. Not doing it").arg(objInfo.obj->getName()));
-            // We will not re-request it, then, we should wait for a timeout or success...
+            // We will not re-request it, then, we should wait for a timeout or success.
+            // An update is sent again once the pending one is acked though.
+            if (objInfo.event != EV_UPDATE_REQ)
+                itr.value()->updatePending = true;
         } else
         {
             UAVObject::Metadata metadata = objInfo.obj->getMetadata();
@@ -700,6 +723,7 @@ ObjectTransactionInfo::ObjectTransactionInfo(QObject* parent):QObject(parent)
     objRequest = false;
     retriesRemaining = 0;
     acked = false;
+    updatePending = false;
     telem = 0;
     // Setup transaction timer
     timer = new QTimer(this);
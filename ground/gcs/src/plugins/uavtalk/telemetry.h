@@ -52,6 +52,7 @@ public:
     bool objRequest;
     qint32 retriesRemaining;
     bool acked;
+    bool updatePending;
     QPointer<class Telemetry>telem;
     QTimer* timer;
 private slots:
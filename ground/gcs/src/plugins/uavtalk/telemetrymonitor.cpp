@@ -248,8 +248,10 @@ void TelemetryMonitor::retrieveNextObject()
             TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 connectionStatus set to CON_CONNECTED_MANAGED( %1 )").arg(Q_FUNC_INFO).arg(connectionStatus));
             connectionStatus = CON_CONNECTED_UNMANAGED;
         }
-        //restart periodic updates on the FC
+        //restart periodic updates on the FC, and have it batch and delta encode them from now on
         sessionObj->setObjectOfInterestIndex(0xFF);
+        sessionObj->setFrameBatching(SessionManaging::FRAMEBATCHING_ENABLED);
+        sessionObj->setDeltaEncoding(SessionManaging::DELTAENCODING_ENABLED);
         sessionObj->updated();
         foreach (UAVDataObject * uavo, delayedUpdate) {
             uavo->setIsPresentOnHardware(true);
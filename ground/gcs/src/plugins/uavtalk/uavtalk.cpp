@@ -27,6 +27,7 @@
  */
 #include "uavtalk.h"
 #include <QtEndian>
+#include <string.h>
 #include <QDebug>
 #include <extensionsystem/pluginmanager.h>
 #include <coreplugin/generalsettings.h>
@@ -59,27 +60,75 @@ const quint8 UAVTalk::crc_table[256] = {
     0xde, 0xd9, 0xd0, 0xd7, 0xc2, 0xc5, 0xcc, 0xcb, 0xe6, 0xe1, 0xe8, 0xef, 0xfa, 0xfd, 0xf4, 0xf3
 };
 
+// CRC-16 of the deltas, the same as PIOS_CRC16_updateCRC() (HDLC polynomial)
+const quint16 UAVTalk::crc16_table[256] = {
+    0x0000, 0x1189, 0x2312, 0x329b, 0x4624, 0x57ad, 0x6536, 0x74bf,
+    0x8c48, 0x9dc1, 0xaf5a, 0xbed3, 0xca6c, 0xdbe5, 0xe97e, 0xf8f7,
+    0x1081, 0x0108, 0x3393, 0x221a, 0x56a5, 0x472c, 0x75b7, 0x643e,
+    0x9cc9, 0x8d40, 0xbfdb, 0xae52, 0xdaed, 0xcb64, 0xf9ff, 0xe876,
+    0x2102, 0x308b, 0x0210, 0x1399, 0x6726, 0x76af, 0x4434, 0x55bd,
+    0xad4a, 0xbcc3, 0x8e58, 0x9fd1, 0xeb6e, 0xfae7, 0xc87c, 0xd9f5,
+    0x3183, 0x200a, 0x1291, 0x0318, 0x77a7, 0x662e, 0x54b5, 0x453c,
+    0xbdcb, 0xac42, 0x9ed9, 0x8f50, 0xfbef, 0xea66, 0xd8fd, 0xc974,
+    0x4204, 0x538d, 0x6116, 0x709f, 0x0420, 0x15a9, 0x2732, 0x36bb,
+    0xce4c, 0xdfc5, 0xed5e, 0xfcd7, 0x8868, 0x99e1, 0xab7a, 0xbaf3,
+    0x5285, 0x430c, 0x7197, 0x601e, 0x14a1, 0x0528, 0x37b3, 0x263a,
+    0xdecd, 0xcf44, 0xfddf, 0xec56, 0x98e9, 0x8960, 0xbbfb, 0xaa72,
+    0x6306, 0x728f, 0x4014, 0x519d, 0x2522, 0x34ab, 0x0630, 0x17b9,
+    0xef4e, 0xfec7, 0xcc5c, 0xddd5, 0xa96a, 0xb8e3, 0x8a78, 0x9bf1,
+    0x7387, 0x620e, 0x5095, 0x411c, 0x35a3, 0x242a, 0x16b1, 0x0738,
+    0xffcf, 0xee46, 0xdcdd, 0xcd54, 0xb9eb, 0xa862, 0x9af9, 0x8b70,
+    0x8408, 0x9581, 0xa71a, 0xb693, 0xc22c, 0xd3a5, 0xe13e, 0xf0b7,
+    0x0840, 0x19c9, 0x2b52, 0x3adb, 0x4e64, 0x5fed, 0x6d76, 0x7cff,
+    0x9489, 0x8500, 0xb79b, 0xa612, 0xd2ad, 0xc324, 0xf1bf, 0xe036,
+    0x18c1, 0x0948, 0x3bd3, 0x2a5a, 0x5ee5, 0x4f6c, 0x7df7, 0x6c7e,
+    0xa50a, 0xb483, 0x8618, 0x9791, 0xe32e, 0xf2a7, 0xc03c, 0xd1b5,
+    0x2942, 0x38cb, 0x0a50, 0x1bd9, 0x6f66, 0x7eef, 0x4c74, 0x5dfd,
+    0xb58b, 0xa402, 0x9699, 0x8710, 0xf3af, 0xe226, 0xd0bd, 0xc134,
+    0x39c3, 0x284a, 0x1ad1, 0x0b58, 0x7fe7, 0x6e6e, 0x5cf5, 0x4d7c,
+    0xc60c, 0xd785, 0xe51e, 0xf497, 0x8028, 0x91a1, 0xa33a, 0xb2b3,
+    0x4a44, 0x5bcd, 0x6956, 0x78df, 0x0c60, 0x1de9, 0x2f72, 0x3efb,
+    0xd68d, 0xc704, 0xf59f, 0xe416, 0x90a9, 0x8120, 0xb3bb, 0xa232,
+    0x5ac5, 0x4b4c, 0x79d7, 0x685e, 0x1ce1, 0x0d68, 0x3ff3, 0x2e7a,
+    0xe70e, 0xf687, 0xc41c, 0xd595, 0xa12a, 0xb0a3, 0x8238, 0x93b1,
+    0x6b46, 0x7acf, 0x4854, 0x59dd, 0x2d62, 0x3ceb, 0x0e70, 0x1ff9,
+    0xf78f, 0xe606, 0xd49d, 0xc514, 0xb1ab, 0xa022, 0x92b9, 0x8330,
+    0x7bc7, 0x6a4e, 0x58d5, 0x495c, 0x3de3, 0x2c6a, 0x1ef1, 0x0f78
+};
+
 
 /**
  * Constructor
+ * \param[in] iodev Device the frames are read from and written to
+ * \param[in] objMngr Object manager the objects are decoded into
+ * \param[in] allowUDPMirror Whether to mirror the traffic over UDP when the
+ * general settings ask for it, off for decoders that are not a link
  */
-UAVTalk::UAVTalk(QIODevice* iodev, UAVObjectManager* objMngr)
+UAVTalk::UAVTalk(QIODevice* iodev, UAVObjectManager* objMngr, bool allowUDPMirror)
 {
     io = iodev;
 
     this->objMngr = objMngr;
 
-    rxState = STATE_SYNC;
-    rxPacketLength = 0;
+    rxStreamLength = 0;
+    rxInProgress = false;
+    rxTimestamp = 0;
+    externalRxTimestamp = 0;
+    useExternalRxTimestamp = false;
 
     mutex = new QMutex(QMutex::Recursive);
 
     memset(&stats, 0, sizeof(ComStats));
 
     connect(io, SIGNAL(readyRead()), this, SLOT(processInputStream()));
+
+    // Devices replaying recorded data report when it was originally received
+    if (io->metaObject()->indexOfSignal("receiveTimestamp(qint64)") >= 0)
+        connect(io, SIGNAL(receiveTimestamp(qint64)), this, SLOT(setReceiveTimestamp(qint64)));
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     Core::Internal::GeneralSettings * settings=pm->getObject<Core::Internal::GeneralSettings>();
-    useUDPMirror=settings->useUDPMirror();
+    // Standalone users, like the benchmarks, run without the core plugin
+    useUDPMirror=allowUDPMirror && settings ? settings->useUDPMirror() : false;
     UAVTALK_QXTLOG_DEBUG(QString("[uavtalk.cpp  ] Use UDP:%0").arg(useUDPMirror));
     if(useUDPMirror)
     {
@@ -123,17 +172,44 @@ UAVTalk::ComStats UAVTalk::getStats()
  */
 void UAVTalk::processInputStream()
 {
-    quint8 tmp;
+    // A slot connected to an object update may spin the event loop. Leave the
+    // new data in the device, the outer loop below will drain it.
+    if (rxInProgress)
+        return;
 
     if (io && io->isReadable()) {
+        rxInProgress = true;
         while (io->bytesAvailable() > 0)
         {
-            io->read((char*)&tmp, 1);
-            processInputByte(tmp);
+            // Drain as much as fits straight into the receive stream
+            qint64 bytesRead = io->read((char*)&rxStream[rxStreamLength], RX_STREAM_SIZE - rxStreamLength);
+            if (bytesRead <= 0)
+                break;
+
+            rxStreamLength += bytesRead;
+            stats.rxBytes += bytesRead;
+
+            // Everything in one read arrived together, read the clock once
+            rxTimestamp = useExternalRxTimestamp ? externalRxTimestamp : UAVObject::currentTimestamp();
+
+            parseRxStream();
         }
+        receivePending();
+        rxInProgress = false;
     }
 }
 
+/**
+ * Use the given receive time for the data that follows, instead of reading the
+ * clock. Connected to devices that replay recorded data.
+ * \param[in] timestamp Time in ms, see UAVObject::currentTimestamp()
+ */
+void UAVTalk::setReceiveTimestamp(qint64 timestamp)
+{
+    externalRxTimestamp = timestamp;
+    useExternalRxTimestamp = true;
+}
+
 void UAVTalk::dummyUDPRead()
 {
     QUdpSocket *socket=qobject_cast<QUdpSocket*>(sender());
@@ -206,265 +282,328 @@ bool UAVTalk::objectTransaction(UAVObject* obj, quint8 type, bool allInstances)
  */
 bool UAVTalk::processInputByte(quint8 rxbyte)
 {
-    // Update stats
-    stats.rxBytes++;
-
-    rxPacketLength++;   // update packet byte count
-
-    if(useUDPMirror)
-        rxDataArray.append(rxbyte);
+    return processInputBuffer(&rxbyte, 1);
+}
 
-    // Receive state machine
-    switch (rxState)
+/**
+ * Process a block of bytes from the telemetry stream. The bytes are appended
+ * to the receive stream and every complete frame in it is decoded. Any partial
+ * frame at the end is kept until the remaining bytes arrive.
+ * \param[in] data Received bytes
+ * \param[in] length Number of bytes in data
+ * \return Success (true), Failure (false)
+ */
+bool UAVTalk::processInputBuffer(const quint8* data, qint32 length)
+{
+    // A slot connected to an object update may feed more data from the event
+    // loop. Keep it aside, the outer call decodes it once the current frame
+    // is done.
+    if (rxInProgress)
     {
-        case STATE_SYNC:
-
-            if (rxbyte != SYNC_VAL)
-            {
-                UAVTALK_QXTLOG_DEBUG("UAVTalk: Sync->Sync (" + QString::number(rxbyte) + " " + QString("0x%1").arg(rxbyte,2,16) + ")");
-                break;
-            }
-
-            // Initialize and update CRC
-            rxCS = updateCRC(0, rxbyte);
+        rxPending.append((const char*)data, length);
+        return true;
+    }
 
-            rxPacketLength = 1;
+    rxInProgress = true;
+    receiveBuffer(data, length);
+    receivePending();
+    rxInProgress = false;
 
-            if(useUDPMirror)
-            {
-                rxDataArray.clear();
-                rxDataArray.append(rxbyte);
-            }
+    // Done
+    return true;
+}
 
-            rxState = STATE_TYPE;
-            UAVTALK_QXTLOG_DEBUG("UAVTalk: Sync->Type");
-            break;
+/**
+ * Append bytes to the receive stream and decode the frames completed by them.
+ * \param[in] data Received bytes
+ * \param[in] length Number of bytes in data
+ */
+void UAVTalk::receiveBuffer(const quint8* data, qint32 length)
+{
+    while (length > 0)
+    {
+        // After parsing less than one packet is left over, so there is always room
+        qint32 chunk = qMin(length, RX_STREAM_SIZE - rxStreamLength);
+        memcpy(&rxStream[rxStreamLength], data, chunk);
+        rxStreamLength += chunk;
+        stats.rxBytes += chunk;
 
-        case STATE_TYPE:
+        data += chunk;
+        length -= chunk;
 
-            // Update CRC
-            rxCS = updateCRC(rxCS, rxbyte);
+        rxTimestamp = useExternalRxTimestamp ? externalRxTimestamp : UAVObject::currentTimestamp();
 
-            if ((rxbyte & TYPE_MASK) != TYPE_VER)
-            {
-                rxState = STATE_SYNC;
-                UAVTALK_QXTLOG_DEBUG("UAVTalk: Type->Sync");
-                break;
-            }
+        parseRxStream();
+    }
+}
 
-            rxType = rxbyte;
+/**
+ * Decode the bytes that were handed over while the receive stream was busy.
+ */
+void UAVTalk::receivePending()
+{
+    while (!rxPending.isEmpty())
+    {
+        QByteArray pending = rxPending;
+        rxPending.clear();
+        receiveBuffer((const quint8*)pending.constData(), pending.size());
+    }
+}
 
-            packetSize = 0;
+/**
+ * Decode all complete frames in the receive stream and move any trailing
+ * partial frame to the start of the buffer.
+ */
+void UAVTalk::parseRxStream()
+{
+    qint32 pos = 0;
 
-            rxState = STATE_SIZE;
-            UAVTALK_QXTLOG_DEBUG("UAVTalk: Type->Size");
-            rxCount = 0;
+    while (pos < rxStreamLength)
+    {
+        // Hunt for the next sync byte
+        quint8 *sync = (quint8 *)memchr(&rxStream[pos], SYNC_VAL, rxStreamLength - pos);
+        if (sync == NULL)
+        {
+            UAVTALK_QXTLOG_DEBUG("UAVTalk: no sync in " + QString::number(rxStreamLength - pos) + " bytes");
+            pos = rxStreamLength;
             break;
+        }
+        pos = sync - rxStream;
 
-        case STATE_SIZE:
-
-            // Update CRC
-            rxCS = updateCRC(rxCS, rxbyte);
+        qint32 frameLength = processFrame(&rxStream[pos], rxStreamLength - pos);
+        if (frameLength == 0)
+        {
+            // Incomplete frame, wait for more data
+            break;
+        }
+        else if (frameLength < 0)
+        {
+            // Not a valid frame, resume hunting after this sync byte
+            pos++;
+        }
+        else
+        {
+            pos += frameLength;
+        }
+    }
 
-            if (rxCount == 0)
-            {
-                packetSize += rxbyte;
-                rxCount++;
-                UAVTALK_QXTLOG_DEBUG("UAVTalk: Size->Size");
-                break;
-            }
+    if (pos > 0)
+    {
+        rxStreamLength -= pos;
+        memmove(rxStream, &rxStream[pos], rxStreamLength);
+    }
+}
 
-            packetSize += (quint32)rxbyte << 8;
+/**
+ * Validate and dispatch a single frame starting at a sync byte.
+ * \param[in] frame Pointer to the sync byte of the frame
+ * \param[in] length Number of bytes available from frame onwards
+ * \return Frame length if it was consumed, 0 if more bytes are needed to
+ *         decide, -1 if this is not a valid frame
+ */
+qint32 UAVTalk::processFrame(quint8* frame, qint32 length)
+{
+    // Reject noise as early as possible so a false sync never stalls the stream
+    if (length < 2)
+    {
+        return 0;
+    }
 
-            if (packetSize < MIN_HEADER_LENGTH || packetSize > MAX_HEADER_LENGTH + MAX_PAYLOAD_LENGTH)
-            {   // incorrect packet size
-                rxState = STATE_SYNC;
-                UAVTALK_QXTLOG_DEBUG("UAVTalk: Size->Sync");
-                break;
-            }
+    quint8 type = frame[1];
+    if ((type & TYPE_MASK) != TYPE_VER)
+    {
+        UAVTALK_QXTLOG_DEBUG("UAVTalk: bad type");
+        return -1;
+    }
 
-            rxCount = 0;
-            rxState = STATE_OBJID;
-            UAVTALK_QXTLOG_DEBUG("UAVTalk: Size->ObjID");
-            break;
+    if (length < 4)
+    {
+        return 0;
+    }
 
-        case STATE_OBJID:
+    quint16 packetSize = qFromLittleEndian<quint16>(&frame[2]);
+    if (packetSize < MIN_HEADER_LENGTH || packetSize > MAX_HEADER_LENGTH + MAX_PAYLOAD_LENGTH)
+    {   // incorrect packet size
+        UAVTALK_QXTLOG_DEBUG("UAVTalk: bad size");
+        return -1;
+    }
 
-            // Update CRC
-            rxCS = updateCRC(rxCS, rxbyte);
+    if (length < MIN_HEADER_LENGTH)
+    {
+        return 0;
+    }
 
-            rxTmpBuffer[rxCount++] = rxbyte;
-            if (rxCount < 4)
-            {
-                UAVTALK_QXTLOG_DEBUG("UAVTalk: ObjID->ObjID");
-                break;
-            }
+    // Several objects behind one header, they are looked up one by one
+    if (type == TYPE_OBJ_MULTI)
+    {
+        return processMultiFrame(frame, length, packetSize);
+    }
 
-            // Search for object, if not found reset state machine
-            rxObjId = (qint32)qFromLittleEndian<quint32>(rxTmpBuffer);
-            {
-                UAVObject *rxObj = objMngr->getObject(rxObjId);
-                if (rxObj == NULL && rxType != TYPE_OBJ_REQ)
-                {
-                    stats.rxErrors++;
-                    rxState = STATE_SYNC;
-                    UAVTALK_QXTLOG_DEBUG("UAVTalk: ObjID->Sync (badtype)");
-                    break;
-                }
-                else if (rxObj == NULL)
-                {
-                   // This is a non-existing object, just skip to checksum
-                   // and we'll send a NACK next.
-                   rxState   = STATE_CS;
-                   UAVTALK_QXTLOG_DEBUG("UAVTalk: ObjID->CSum (no obj)");
-                   rxInstId = 0;
-                   rxCount = 0;
-                   break;
-                }
+    // Search for object, if not found drop the frame
+    quint32 objId = qFromLittleEndian<quint32>(&frame[4]);
+    UAVObject *obj = objMngr->getObject(objId);
+    quint16 dataLength = 0;
+    qint32 instLength = 0;
+    if (obj == NULL)
+    {
+        if (type != TYPE_OBJ_REQ)
+        {
+            stats.rxErrors++;
+            UAVTALK_QXTLOG_DEBUG("UAVTalk: unknown object");
+            return -1;
+        }
+        // This is a request for a non-existing object, it carries no
+        // instance or data and we'll send a NACK for it.
+    }
+    else
+    {
+        instLength = (obj->isSingleInstance() ? 0 : 2);
 
-                // Determine data length
-                if (rxType == TYPE_OBJ_REQ || rxType == TYPE_ACK || rxType == TYPE_NACK)
-                {
-                    rxLength = 0;
-                }
-                else
-                {
-                    rxLength = rxObj->getNumBytes();
-                }
+        // Determine data length, deltas are as long as what changed
+        if (type == TYPE_OBJ_DELTA)
+        {
+            dataLength = qMax(packetSize - MIN_HEADER_LENGTH - instLength, 0);
+        }
+        else if (type != TYPE_OBJ_REQ && type != TYPE_ACK && type != TYPE_NACK)
+        {
+            dataLength = obj->getNumBytes();
+        }
 
-                // Check length and determine next state
-                if (rxLength >= MAX_PAYLOAD_LENGTH)
-                {
-                    stats.rxErrors++;
-                    rxState = STATE_SYNC;
-                    UAVTALK_QXTLOG_DEBUG("UAVTalk: ObjID->Sync (oversize)");
-                    break;
-                }
+        if (dataLength >= MAX_PAYLOAD_LENGTH)
+        {
+            stats.rxErrors++;
+            UAVTALK_QXTLOG_DEBUG("UAVTalk: oversize");
+            return -1;
+        }
+    }
 
-                quint8 rxInstanceLength = (rxObj->isSingleInstance() ? 0 : 2);
-                if ((rxPacketLength + rxInstanceLength + rxLength) != packetSize)
-                {   // packet error - mismatched packet size
-                    stats.rxErrors++;
-                    rxState = STATE_SYNC;
-                    UAVTALK_QXTLOG_DEBUG("UAVTalk: ObjID->Sync (length mismatch)");
-                    break;
-                }
+    if (MIN_HEADER_LENGTH + instLength + dataLength != packetSize)
+    {   // packet error - mismatched packet size
+        stats.rxErrors++;
+        UAVTALK_QXTLOG_DEBUG("UAVTalk: length mismatch");
+        return -1;
+    }
 
-                if (rxObj->isSingleInstance())
-                {   // Check if this is a single instance object (i.e. if the instance ID field is coming next)
-                    // If there is a payload get it, otherwise receive checksum
-                    if (rxLength > 0)
-                    {
-                        rxState = STATE_DATA;
-                        UAVTALK_QXTLOG_DEBUG("UAVTalk: ObjID->Data (needs data)");
-                    }
-                    else
-                    {
-                        rxState = STATE_CS;
-                        UAVTALK_QXTLOG_DEBUG("UAVTalk: ObjID->Checksum");
-                    }
-                    rxInstId = 0;
-                    rxCount = 0;
-                }
-                else
-                {
-                    rxState = STATE_INSTID;
-                    UAVTALK_QXTLOG_DEBUG("UAVTalk: ObjID->InstID");
-                    rxCount = 0;
-                }
-            }
+    qint32 frameLength = packetSize + CHECKSUM_LENGTH;
+    if (length < frameLength)
+    {
+        return 0;
+    }
 
-            break;
+    // The whole frame is contiguous, so the CRC is computed in a single pass
+    if (updateCRC(0, frame, packetSize) != frame[packetSize])
+    {   // packet error - faulty CRC
+        stats.rxErrors++;
+        UAVTALK_QXTLOG_DEBUG("UAVTalk: bad crc");
+        return -1;
+    }
 
-        case STATE_INSTID:
+    quint16 instId = 0;
+    if (instLength > 0)
+    {
+        instId = qFromLittleEndian<quint16>(&frame[MIN_HEADER_LENGTH]);
+    }
 
-            // Update CRC
-            rxCS = updateCRC(rxCS, rxbyte);
+    mutex->lock();
+        receiveObject(type, objId, instId, &frame[MIN_HEADER_LENGTH + instLength], dataLength);
+        if(useUDPMirror)
+        {
+            udpSocketTx->writeDatagram((const char*)frame, frameLength, QHostAddress::LocalHost, udpSocketRx->localPort());
+        }
+        stats.rxObjectBytes += dataLength;
+        stats.rxObjects++;
+    mutex->unlock();
 
-            rxTmpBuffer[rxCount++] = rxbyte;
-            if (rxCount < 2)
-            {
-                UAVTALK_QXTLOG_DEBUG("UAVTalk: InstID->InstID");
-                break;
-            }
+    UAVTALK_QXTLOG_DEBUG("UAVTalk: frame OK");
+    return frameLength;
+}
 
-            rxInstId = (qint16)qFromLittleEndian<quint16>(rxTmpBuffer);
+/**
+ * Validate and dispatch a multi-object frame. It holds the updates of several
+ * objects behind a single header and CRC, each as the object ID, the instance
+ * ID for multi-instance objects only and the object data. A record starting
+ * with MULTI_DELTA_RECORD instead of an object ID is a delta, followed by the
+ * object ID, the instance ID and the delta as in an OBJ_DELTA frame.
+ * \param[in] frame Pointer to the sync byte of the frame
+ * \param[in] length Number of bytes available from frame onwards
+ * \param[in] packetSize Size of the frame from its header
+ * \return Frame length if it was consumed, 0 if more bytes are needed to
+ *         decide, -1 if this is not a valid frame
+ */
+qint32 UAVTalk::processMultiFrame(quint8* frame, qint32 length, quint16 packetSize)
+{
+    qint32 frameLength = packetSize + CHECKSUM_LENGTH;
+    if (length < frameLength)
+    {
+        return 0;
+    }
 
-            rxCount = 0;
+    if (updateCRC(0, frame, packetSize) != frame[packetSize])
+    {   // packet error - faulty CRC
+        stats.rxErrors++;
+        UAVTALK_QXTLOG_DEBUG("UAVTalk: bad crc");
+        return -1;
+    }
 
-            // If there is a payload get it, otherwise receive checksum
-            if (rxLength > 0)
-            {
-                rxState = STATE_DATA;
-                UAVTALK_QXTLOG_DEBUG("UAVTalk: InstID->Data");
-            }
-            else
+    mutex->lock();
+        qint32 offset = MIN_HEADER_LENGTH;
+        while (offset < packetSize)
+        {
+            UAVObject *obj = NULL;
+            quint32 objId = 0;
+            qint32 markerLength = 0;
+            if (packetSize - offset >= 4)
             {
-                rxState = STATE_CS;
-                UAVTALK_QXTLOG_DEBUG("UAVTalk: InstID->CSum");
+                objId = qFromLittleEndian<quint32>(&frame[offset]);
+                if (objId == MULTI_DELTA_RECORD && packetSize - offset >= 8)
+                {
+                    markerLength = 4;
+                    objId = qFromLittleEndian<quint32>(&frame[offset + 4]);
+                }
+                obj = objMngr->getObject(objId);
             }
-            break;
-
-        case STATE_DATA:
-
-            // Update CRC
-            rxCS = updateCRC(rxCS, rxbyte);
-
-            rxBuffer[rxCount++] = rxbyte;
-            if (rxCount < rxLength)
+            // The length of a record comes from its object, the rest of the
+            // frame can't be parsed past an unknown one
+            if (obj == NULL)
             {
-                //UAVTALK_QXTLOG_DEBUG("UAVTalk: Data->Data");
-                break;
-            }
-
-            rxState = STATE_CS;
-            UAVTALK_QXTLOG_DEBUG("UAVTalk: Data->CSum");
-            rxCount = 0;
-            break;
-
-        case STATE_CS:
-
-            // The CRC byte
-            rxCSPacket = rxbyte;
-
-            if (rxCS != rxCSPacket)
-            {   // packet error - faulty CRC
                 stats.rxErrors++;
-                rxState = STATE_SYNC;
-                UAVTALK_QXTLOG_DEBUG("UAVTalk: CSum->Sync (badcrc)");
+                UAVTALK_QXTLOG_DEBUG("UAVTalk: unknown object in multi-object frame");
                 break;
             }
 
-            if (rxPacketLength != packetSize + 1)
+            offset += markerLength;
+            qint32 instLength = (obj->isSingleInstance() ? 0 : 2);
+            qint32 dataLength = obj->getNumBytes();
+            if (markerLength > 0 && offset + 4 + instLength <= packetSize)
+            {
+                dataLength = deltaLength(obj, &frame[offset + 4 + instLength], packetSize - offset - 4 - instLength);
+            }
+            if (dataLength < 0 || offset + 4 + instLength + dataLength > packetSize)
             {   // packet error - mismatched packet size
                 stats.rxErrors++;
-                rxState = STATE_SYNC;
-                UAVTALK_QXTLOG_DEBUG("UAVTalk: CSum->Sync (length mismatch)");
+                UAVTALK_QXTLOG_DEBUG("UAVTalk: length mismatch in multi-object frame");
                 break;
             }
 
-            mutex->lock();
-                receiveObject(rxType, rxObjId, rxInstId, rxBuffer, rxLength);
-                if(useUDPMirror)
-                {
-                    udpSocketTx->writeDatagram(rxDataArray,QHostAddress::LocalHost,udpSocketRx->localPort());
-                }
-                stats.rxObjectBytes += rxLength;
-                stats.rxObjects++;
-            mutex->unlock();
-
-            rxState = STATE_SYNC;
-            UAVTALK_QXTLOG_DEBUG("UAVTalk: CSum->Sync (OK)");
-            break;
+            quint16 instId = 0;
+            if (instLength > 0)
+            {
+                instId = qFromLittleEndian<quint16>(&frame[offset + 4]);
+            }
 
-        default:
-            rxState = STATE_SYNC;
-            stats.rxErrors++;
-            UAVTALK_QXTLOG_DEBUG("UAVTalk: \?\?\?->Sync"); //Use the escape character for '?' so that the tripgraph isn't triggered.
-    }
+            receiveObject(markerLength > 0 ? TYPE_OBJ_DELTA : TYPE_OBJ, objId, instId, &frame[offset + 4 + instLength], dataLength);
+            stats.rxObjectBytes += dataLength;
+            stats.rxObjects++;
+            offset += 4 + instLength + dataLength;
+        }
+        if(useUDPMirror)
+        {
+            udpSocketTx->writeDatagram((const char*)frame, frameLength, QHostAddress::LocalHost, udpSocketRx->localPort());
+        }
+    mutex->unlock();
 
-    // Done
-    return true;
+    UAVTALK_QXTLOG_DEBUG("UAVTalk: multi-object frame OK");
+    return frameLength;
 }
 
 /**
@@ -485,6 +624,14 @@ bool UAVTalk::receiveObject(quint8 type, quint32 objId, quint16 instId, quint8*
 
     // Process message type
     switch (type) {
+    case TYPE_OBJ_DELTA: // We have received the changes of an object.
+        obj = updateObjectDelta(objId, instId, data, length);
+        if (obj == NULL)
+        {
+            UAVTALK_QXTLOG_DEBUG(QString("[uavtalk.cpp  ] Dropped a delta for OBJID:%0 INSTID:%1, waiting for a full update").arg(QString(QString("0x") + QString::number(objId, 16).toUpper())).arg(instId));
+            error = true;
+        }
+        break;
     case TYPE_OBJ: // We have received an object.
         // All instances, not allowed for OBJ messages
         if (!allInstances)
@@ -626,17 +773,102 @@ UAVObject* UAVTalk::updateObject(quint32 objId, quint16 instId, quint8* data)
         {
             return NULL;
         }
-        instobj->unpack(data);
+        instobj->unpack(data, rxTimestamp);
         return instobj;
     }
     else
     {
         // Unpack data into object instance
-        obj->unpack(data);
+        obj->unpack(data, rxTimestamp);
         return obj;
     }
 }
 
+/**
+ * Apply the changes of a delta frame to an object instance. The payload is
+ * the CRC-16 of the resulting object data, a bitmap with a bit per
+ * DELTA_CHUNK_LENGTH bytes of the object, then the chunks that changed.
+ * A delta is only applied to an existing instance and when the result
+ * matches the CRC. Otherwise a frame was lost and the object waits for the
+ * next full update from the autopilot.
+ */
+UAVObject* UAVTalk::updateObjectDelta(quint32 objId, quint16 instId, quint8* data, qint32 length)
+{
+    UAVObject* obj = objMngr->getObject(objId, instId);
+    if (obj == NULL)
+    {
+        return NULL;
+    }
+
+    qint32 numBytes = obj->getNumBytes();
+    qint32 numChunks = (numBytes + DELTA_CHUNK_LENGTH - 1) / DELTA_CHUNK_LENGTH;
+    qint32 bitmapLength = (numChunks + 7) / 8;
+    if (length < DELTA_CRC_LENGTH + bitmapLength)
+    {
+        return NULL;
+    }
+
+    QByteArray current(numBytes, 0);
+    quint8* currentData = reinterpret_cast<quint8*>(current.data());
+    obj->pack(currentData);
+
+    const quint8* bitmap = &data[DELTA_CRC_LENGTH];
+    qint32 offset = DELTA_CRC_LENGTH + bitmapLength;
+    for (qint32 chunk = 0; chunk < numChunks; ++chunk)
+    {
+        if (!(bitmap[chunk / 8] & (1 << (chunk % 8))))
+        {
+            continue;
+        }
+        qint32 objOffset = chunk * DELTA_CHUNK_LENGTH;
+        qint32 chunkLength = qMin(DELTA_CHUNK_LENGTH, numBytes - objOffset);
+        if (offset + chunkLength > length)
+        {
+            return NULL;
+        }
+        memcpy(&currentData[objOffset], &data[offset], chunkLength);
+        offset += chunkLength;
+    }
+
+    quint16 crc = data[0] | (data[1] << 8);
+    if (offset != length || updateCRC16(0, currentData, numBytes) != crc)
+    {
+        return NULL;
+    }
+
+    obj->unpack(currentData, rxTimestamp);
+    return obj;
+}
+
+/**
+ * Find the length of a delta from its bitmap, records inside a multi-object
+ * frame carry no length of their own.
+ * \param[in] obj Object the delta is for
+ * \param[in] data Delta as in an OBJ_DELTA frame
+ * \param[in] available Number of bytes from data to the end of the frame
+ * \return Length of the delta, -1 if it runs past the end of the frame
+ */
+qint32 UAVTalk::deltaLength(UAVObject* obj, const quint8* data, qint32 available)
+{
+    qint32 numBytes = obj->getNumBytes();
+    qint32 numChunks = (numBytes + DELTA_CHUNK_LENGTH - 1) / DELTA_CHUNK_LENGTH;
+    qint32 bitmapLength = (numChunks + 7) / 8;
+    if (available < DELTA_CRC_LENGTH + bitmapLength)
+    {
+        return -1;
+    }
+
+    const quint8* bitmap = &data[DELTA_CRC_LENGTH];
+    qint32 length = DELTA_CRC_LENGTH + bitmapLength;
+    for (qint32 chunk = 0; chunk < numChunks; ++chunk)
+    {
+        if (bitmap[chunk / 8] & (1 << (chunk % 8)))
+        {
+            length += qMin(DELTA_CHUNK_LENGTH, numBytes - chunk * DELTA_CHUNK_LENGTH);
+        }
+    }
+    return (length <= available ? length : -1);
+}
 
 /**
  * Send an object through the telemetry link.
@@ -859,3 +1091,17 @@ quint8 UAVTalk::updateCRC(quint8 crc, const quint8* data, qint32 length)
         crc = crc_table[crc ^ *data++];
     return crc;
 }
+
+/**
+ * Update the CRC-16 that checks deltas with new data.
+ * \param crc      The current crc value.
+ * \param data     Pointer to a buffer of \a data_len bytes.
+ * \param length   Number of bytes in the \a data buffer.
+ * \return         The updated crc value.
+ */
+quint16 UAVTalk::updateCRC16(quint16 crc, const quint8* data, qint32 length)
+{
+    while (length--)
+        crc = (crc >> 8) ^ crc16_table[(crc ^ *data++) & 0xff];
+    return crc;
+}
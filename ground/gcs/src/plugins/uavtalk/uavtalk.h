@@ -54,7 +54,7 @@ public:
         quint32 rxErrors;
     } ComStats;
 
-    UAVTalk(QIODevice* iodev, UAVObjectManager* objMngr);
+    UAVTalk(QIODevice* iodev, UAVObjectManager* objMngr, bool allowUDPMirror = true);
     ~UAVTalk();
     bool sendObject(UAVObject* obj, bool acked, bool allInstances);
     bool sendObjectRequest(UAVObject* obj, bool allInstances);
@@ -62,6 +62,7 @@ public:
     void resetStats();
 
     bool processInputByte(quint8 rxbyte);
+    bool processInputBuffer(const quint8* data, qint32 length);
 
 signals:
     // The only signals we send to the upper level are when we
@@ -69,6 +70,9 @@ signals:
     void ackReceived(UAVObject* obj);
     void nackReceived(UAVObject* obj);
 
+public slots:
+    void setReceiveTimestamp(qint64 timestamp);
+
 private slots:
     void processInputStream(void);
     void dummyUDPRead();
@@ -83,6 +87,8 @@ protected:
     static const int TYPE_OBJ_ACK = (TYPE_VER | 0x02);
     static const int TYPE_ACK = (TYPE_VER | 0x03);
     static const int TYPE_NACK = (TYPE_VER | 0x04);
+    static const int TYPE_OBJ_MULTI = (TYPE_VER | 0x05);
+    static const int TYPE_OBJ_DELTA = (TYPE_VER | 0x06);
 
     static const int MIN_HEADER_LENGTH = 8; // sync(1), type (1), size(2), object ID(4)
     static const int MAX_HEADER_LENGTH = 10; // sync(1), type (1), size(2), object ID (4), instance ID(2, not used in single objects)
@@ -93,49 +99,58 @@ protected:
 
     static const int MAX_PACKET_LENGTH = (MAX_HEADER_LENGTH + MAX_PAYLOAD_LENGTH + CHECKSUM_LENGTH);
 
+    static const int DELTA_CHUNK_LENGTH = 4; // bytes of the object per bit of the delta bitmap
+    static const int DELTA_CRC_LENGTH = 2; // CRC-16 of the resulting data ahead of the bitmap
+    static const quint32 MULTI_DELTA_RECORD = 0; // in place of the object ID, marks a delta inside a multi-object frame
+
     static const quint16 ALL_INSTANCES = 0xFFFF;
     static const quint16 OBJID_NOTFOUND = 0x0000;
 
     static const int TX_BUFFER_SIZE = 2*1024;
+    static const int RX_STREAM_SIZE = 16*MAX_PACKET_LENGTH;
     static const quint8 crc_table[256];
-
-    // Types
-    typedef enum {STATE_SYNC, STATE_TYPE, STATE_SIZE, STATE_OBJID, STATE_INSTID, STATE_DATA, STATE_CS} RxStateType;
+    static const quint16 crc16_table[256];
 
     // Variables
     QPointer<QIODevice> io;
     UAVObjectManager* objMngr;
     QMutex* mutex;
-    quint8 rxBuffer[MAX_PACKET_LENGTH];
     quint8 txBuffer[MAX_PACKET_LENGTH];
-    // Variables used by the receive state machine
-    quint8 rxTmpBuffer[4];
-    quint8 rxType;
-    quint32 rxObjId;
-    quint16 rxInstId;
-    quint16 rxLength;
-    quint16 rxPacketLength;
-
-    quint8 rxCSPacket, rxCS;
-    qint32 rxCount;
-    qint32 packetSize;
-    RxStateType rxState;
+    // Received bytes not yet consumed by the frame parser. Only the tail of
+    // an incomplete frame is kept between reads, so this never overflows.
+    quint8 rxStream[RX_STREAM_SIZE];
+    qint32 rxStreamLength;
+    bool rxInProgress;
+    // Bytes handed to processInputBuffer() while a frame was being decoded
+    QByteArray rxPending;
+    // Time the data being parsed was received, given to the updated objects
+    qint64 rxTimestamp;
+    // Set when the device reports its own receive times, as log replay does
+    qint64 externalRxTimestamp;
+    bool useExternalRxTimestamp;
     ComStats stats;
 
     bool useUDPMirror;
     QUdpSocket * udpSocketTx;
     QUdpSocket * udpSocketRx;
-    QByteArray rxDataArray;
 
     // Methods
+    void receiveBuffer(const quint8* data, qint32 length);
+    void receivePending();
+    void parseRxStream();
+    qint32 processFrame(quint8* frame, qint32 length);
+    qint32 processMultiFrame(quint8* frame, qint32 length, quint16 packetSize);
     bool objectTransaction(UAVObject* obj, quint8 type, bool allInstances);
     virtual bool receiveObject(quint8 type, quint32 objId, quint16 instId, quint8* data, qint32 length);
     UAVObject* updateObject(quint32 objId, quint16 instId, quint8* data);
+    UAVObject* updateObjectDelta(quint32 objId, quint16 instId, quint8* data, qint32 length);
+    qint32 deltaLength(UAVObject* obj, const quint8* data, qint32 available);
     bool transmitNack(quint32 objId);
     bool transmitObject(UAVObject* obj, quint8 type, bool allInstances);
     bool transmitSingleObject(UAVObject* obj, quint8 type, bool allInstances);
     quint8 updateCRC(quint8 crc, const quint8 data);
     quint8 updateCRC(quint8 crc, const quint8* data, qint32 length);
+    quint16 updateCRC16(quint16 crc, const quint8* data, qint32 length);
 };
 
 #endif // UAVTALK_H
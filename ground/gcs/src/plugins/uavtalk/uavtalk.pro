@@ -9,12 +9,14 @@ HEADERS += uavtalk.h \
     telemetrymonitor.h \
     telemetrymanager.h \
     uavtalk_global.h \
-    telemetry.h
+    telemetry.h \
+    logbatchdecoder.h
 SOURCES += uavtalk.cpp \
     uavtalkplugin.cpp \
     telemetrymonitor.cpp \
     telemetrymanager.cpp \
-    telemetry.cpp
+    telemetry.cpp \
+    logbatchdecoder.cpp
 DEFINES += UAVTALK_LIBRARY
 OTHER_FILES += UAVTalk.pluginspec \
     UAVTalk.json
\ No newline at end of file
@@ -282,6 +282,21 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
     }
     outCode.replace(QString("$(FIELDSINIT)"), finit);
 
+    // Replace the $(FIELDACCESSORS) tag
+    QString accessors;
+    for (int n = 0; n < info->fields.length(); ++n)
+    {
+        type = fieldTypeStrCPP[info->fields[n]->type];
+        accessors.append( QString("    { offsetof(%1::DataFields, %2), UAVObjectField::%3, "
+                                  "&UAVObjectField::convertElements<%4, double>, "
+                                  "&UAVObjectField::convertElements<%4, float> },\n")
+                          .arg(info->name)
+                          .arg(info->fields[n]->name)
+                          .arg(fieldTypeStrCPPClass[info->fields[n]->type])
+                          .arg(type) );
+    }
+    outCode.replace(QString("$(FIELDACCESSORS)"), accessors);
+
     // Replace the $(DATAFIELDINFO) tag
     QString name;
     // To be populated with the enums definition
@@ -19,7 +19,8 @@ __all__ = [ "send_object", "process_stream" ]
 (SYNC_VAL) = (0x3C)
 (TYPE_MASK, TYPE_VER) = (0x78, 0x20)
 (TIMESTAMPED) = (0x80)
-(TYPE_OBJ, TYPE_OBJ_REQ, TYPE_OBJ_ACK, TYPE_ACK, TYPE_NACK, TYPE_OBJ_TS, TYPE_OBJ_ACK_TS) = (0x00, 0x01, 0x02, 0x03, 0x04, 0x80, 0x82)
+(TYPE_OBJ, TYPE_OBJ_REQ, TYPE_OBJ_ACK, TYPE_ACK, TYPE_NACK, TYPE_OBJ_MULTI, TYPE_OBJ_DELTA, TYPE_OBJ_TS, TYPE_OBJ_ACK_TS) = (0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x80, 0x82)
+(DELTA_CHUNK_LENGTH, DELTA_CRC_LENGTH) = (4, 2)
 
 # Serialization of header elements
 
@@ -28,6 +29,7 @@ header_fmt = struct.Struct("<BBHL")
 logheader_fmt = struct.Struct("<IQ")
 timestamp_fmt = struct.Struct("<H")
 instance_fmt = struct.Struct("<H")
+objid_fmt = struct.Struct("<L")
 
 # CRC lookup table
 crc_table = [
@@ -62,6 +64,9 @@ def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=False):
 
     received = 0
 
+    # Last data of each object instance, which deltas apply to
+    last_data = {}
+
     buf = ''
     buf_offset = 0
 
@@ -164,6 +169,10 @@ def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=False):
         else:
             instance_len = 0
 
+        if pack_type == TYPE_OBJ_DELTA and obj is not None:
+            # deltas are as long as what changed
+            obj_len = pack_len - header_fmt.size - instance_len
+
         # Check length and determine next state
         if obj_len >= MAX_PAYLOAD_LENGTH:
             print "bad len-- bad xml?"
@@ -236,9 +245,60 @@ def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=False):
         if gcs_timestamps:
             timestamp = overrideTimestamp
 
-        if obj is not None:
+        if pack_type == TYPE_OBJ_MULTI:
+            # Several objects behind one header, each as its object id, the
+            # instance id for multi-instance objects only and the data
+            offset = header_fmt.size + buf_offset
+            end = calc_size + buf_offset
+            while offset + objid_fmt.size <= end:
+                sub_key = '{0:08x}'.format(objid_fmt.unpack_from(buf, offset)[0])
+                if not sub_key in uavo_defs:
+                    # the record length is unknown, so is the rest of the frame
+                    print "Unknown object 0x%s in multi-object frame"%(sub_key)
+                    break
+                sub_obj = uavo_defs[sub_key]
+                offset += objid_fmt.size
+
+                instance_id = None
+                if not sub_obj._single:
+                    instance_id = instance_fmt.unpack_from(buf, offset)[0]
+                    offset += instance_fmt.size
+
+                if offset + sub_obj.get_size_of_data() > end:
+                    print "mismatched size in multi-object frame id=%s"%(sub_key)
+                    break
+
+                objInstance = sub_obj.from_bytes(buf, timestamp, instance_id, offset=offset)
+                last_data[(sub_key, instance_id)] = buf[offset:offset + sub_obj.get_size_of_data()]
+                offset += sub_obj.get_size_of_data()
+                received += 1
+
+                next_recv = yield objInstance
+                if next_recv is not None and next_recv != '':
+                    pending_pieces.append(next_recv)
+
+            buf_offset += calc_size + 1
+            continue
+
+        if obj is not None and pack_type == TYPE_OBJ_DELTA:
+            offset = header_fmt.size + instance_len + buf_offset
+            data = apply_delta(last_data.get((uavo_key, instance_id)),
+                buf[offset:offset + obj_len], obj.get_size_of_data())
+
+            if data is not None:
+                last_data[(uavo_key, instance_id)] = data
+                objInstance = obj.from_bytes(data, timestamp, instance_id)
+            else:
+                # lost a frame, wait for the next full update
+                objInstance = None
+        elif obj is not None:
             offset = header_fmt.size + instance_len + timestamp_len + buf_offset
             objInstance = obj.from_bytes(buf, timestamp, instance_id, offset=offset)
+            last_data[(uavo_key, instance_id)] = buf[offset:offset + obj_len]
+        else:
+            objInstance = None
+
+        if objInstance is not None:
             received += 1
             if not (received % 20000):
                 print "received %d objs"%(received)
@@ -285,3 +345,53 @@ def calcCRC(str):
         cs = crc_table[cs ^ ord(c)]
 
     return chr(cs)
+
+def calcCRC16(str):
+    """
+    Calculate the CRC-16 of a delta like PIOS_CRC16_updateCRC (HDLC polynomial)
+    """
+
+    cs = 0
+
+    for c in str:
+        cs ^= ord(c)
+        for bit in xrange(8):
+            cs = (cs >> 1) ^ 0x8408 if cs & 1 else cs >> 1
+
+    return cs
+
+def apply_delta(base, delta, size):
+    """
+    Applies the payload of a delta frame to the last data of the object.
+
+    The payload is the CRC-16 of the resulting data, a bitmap with a bit per
+    DELTA_CHUNK_LENGTH bytes of the object, then the chunks that changed.
+    Returns None when there is no base or the result doesn't match the CRC.
+    """
+
+    if base is None or len(base) != size:
+        return None
+
+    num_chunks = (size + DELTA_CHUNK_LENGTH - 1) // DELTA_CHUNK_LENGTH
+    bitmap_len = (num_chunks + 7) // 8
+    if len(delta) < DELTA_CRC_LENGTH + bitmap_len:
+        return None
+
+    pieces = []
+    offset = DELTA_CRC_LENGTH + bitmap_len
+    for chunk in xrange(num_chunks):
+        start = chunk * DELTA_CHUNK_LENGTH
+        end = min(start + DELTA_CHUNK_LENGTH, size)
+
+        if ord(delta[DELTA_CRC_LENGTH + chunk // 8]) & (1 << (chunk % 8)):
+            pieces.append(delta[offset:offset + end - start])
+            offset += end - start
+        else:
+            pieces.append(base[start:end])
+
+    data = ''.join(pieces)
+    crc = ord(delta[0]) | (ord(delta[1]) << 8)
+    if offset != len(delta) or len(data) != size or calcCRC16(data) != crc:
+        return None
+
+    return data